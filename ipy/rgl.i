@@ -46,6 +46,11 @@ func current_include_dir(nil)
 if (is_func(h_new) != 2) include, "yeti.i", 1;
 if (! is_func(linop_new)) include, current_include_dir() + "linop.i", 1;
 
+/* Compiled kernels for some regularizers are provided by recent versions of
+   Yeti.  They compute the penalty and the gradient in a single pass and the
+   Hessian-vector products. */
+_RGL_KERNELS = (is_func(rgl_totvar_fg) != 0);
+
 /*---------------------------------------------------------------------------*/
 /* PUBLIC INTERFACE */
 
@@ -1078,9 +1083,36 @@ func _rgl_xsmooth_setup(this)
                isotropic = 1n);
 }
 
+func _rgl_xsmooth_kernel_cost(this)
+{
+  /* Yield the name of the cost function if compiled kernels can be used. */
+  if (_RGL_KERNELS) {
+    cost = name_of_symlink(this.cost);
+    if (cost == "cost_l2" || cost == "cost_l2l1" || cost == "cost_l2l0") {
+      return cost;
+    }
+  }
+}
+
+func _rgl_xsmooth_check_dims(this, x)
+{
+  local dimlist; eq_nocopy, dimlist, this.dimlist;
+  dims = dimsof(x);
+  if (numberof(dims) != numberof(dimlist) || anyof(dims != dimlist)) {
+    error, "incompatible dimensions";
+  }
+}
+
 func _rgl_xsmooth_update(this, x)
 {
   local g;
+  cost = _rgl_xsmooth_kernel_cost(this);
+  if (cost) {
+    _rgl_xsmooth_check_dims, this, x;
+    f = rgl_xsmooth_fg([this.mu, this.threshold], cost, this.isotropic, x, g);
+    h_set, this, f = f, g = g, state = 2;
+    return;
+  }
   if (is_void(this.a)) {
     _rgl_xsmooth_make_matrix, this;
   }
@@ -1108,8 +1140,18 @@ func _rgl_xsmooth_get_gradient(this, x)
 }
 
 
+func _rgl_xsmooth_apply_hessian(this, x, s)
+{
+  cost = _rgl_xsmooth_kernel_cost(this);
+  if (! cost) {
+    error, _rgl_bogus_not_implemented(this, "apply_hessian");
+  }
+  _rgl_xsmooth_check_dims, this, x;
+  return rgl_xsmooth_hv([this.mu, this.threshold], cost, this.isotropic,
+                        x, s);
+}
+
 #if 0
-func _rgl_xsmooth_apply_hessian(this, x, s) {}
 func _rgl_xsmooth_get_hessian(this, x) {}
 func _rgl_xsmooth_get_diagonal_of_hessian(this, x) {}
 #endif
@@ -1344,7 +1386,7 @@ func rgl_make_2d_finite_difference_matrix(dimlist, which, ..)
   }
 
   return sparse_matrix(coef_list, [1, count], indgen(count)(-:1:2,),
-                       dimlist, index_list);
+                       dimlist, index_list, compressed=1);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -1502,6 +1544,12 @@ func _rgl_hyperbolic_update(self, x)
 
 func _rgl_hyperbolic_state1(self, x)
 {
+  if (_RGL_KERNELS) {
+    local g;
+    err = rgl_hyperbolic_fg([self.mu, self.tau], self.eta, x, self.mask, g);
+    h_set, self, state=2, err=err, grd=g;
+    return;
+  }
   local mask; eq_nocopy, mask, self.mask;
   rank = self.rank;
   mu = self.mu;
@@ -1568,6 +1616,7 @@ func _rgl_hyperbolic_state1(self, x)
 func _rgl_hyperbolic_state2(self, x)
 {
   if (self.state < 1) _rgl_hyperbolic_state1, self, x;
+  if (self.state >= 2) return; // computed by the compiled kernel
   g = array(double, dimsof(x));
   local r; eq_nocopy, r, self.r;
   local w; eq_nocopy, w, self.w;
@@ -1635,8 +1684,15 @@ func _rgl_hyperbolic_get_gradient(self, x)
   return self.grd;
 }
 
+func _rgl_hyperbolic_apply_hessian(self, x, s)
+{
+  if (! _RGL_KERNELS) {
+    error, _rgl_bogus_not_implemented(self, "apply_hessian");
+  }
+  return rgl_hyperbolic_hv([self.mu, self.tau], self.eta, x, self.mask, s);
+}
+
 #if 0
-func _rgl_hyperbolic_apply_hessian(self, x, s) {}
 func _rgl_hyperbolic_get_hessian(self, x) {}
 func _rgl_hyperbolic_get_diagonal_of_hessian(self, x) {}
 #endif
@@ -1736,6 +1792,13 @@ func _rgl_totvar_update(self, x)
 
 func _rgl_totvar_state1(self, x)
 {
+  if (_RGL_KERNELS) {
+    local g;
+    err = rgl_totvar_fg([self.mu, self.epsilon], self.isotropic, x,
+                        self.mask, g);
+    h_set, self, state=2, err=err, grd=g;
+    return;
+  }
   local mask; eq_nocopy, mask, self.mask;
   w = self.mu/sqrt(2.0);
   eps = abs(self.epsilon);
@@ -1776,6 +1839,7 @@ func _rgl_totvar_state1(self, x)
 func _rgl_totvar_state2(self, x)
 {
   if (self.state < 1) _rgl_totvar_state1, self, x;
+  if (self.state >= 2) return; // computed by the compiled kernel
   g = array(double, dimsof(x));
   q = self.w/self.r;
   r0 = 1:-1;
@@ -1809,8 +1873,16 @@ func _rgl_totvar_get_gradient(self, x)
   return self.grd;
 }
 
+func _rgl_totvar_apply_hessian(self, x, s)
+{
+  if (! _RGL_KERNELS) {
+    error, _rgl_bogus_not_implemented(self, "apply_hessian");
+  }
+  return rgl_totvar_hv([self.mu, self.epsilon], self.isotropic, x,
+                       self.mask, s);
+}
+
 #if 0
-func _rgl_totvar_apply_hessian(self, x, s) {}
 func _rgl_totvar_get_hessian(self, x) {}
 func _rgl_totvar_get_diagonal_of_hessian(self, x) {}
 #endif
@@ -2099,7 +2171,12 @@ func _rgl_entropy_finalize(this)
       id = (this.normalized ? 7 : 6);
     }
   }
-  ops = symlink_to_name(swrite(format="_rgl_entropy%d_ops", id));
+  if (_RGL_KERNELS && id <= 5) {
+    /* Compiled penalty, gradient and diagonal of the Hessian. */
+    ops = symlink_to_name("_rgl_entropy0_ops");
+  } else {
+    ops = symlink_to_name(swrite(format="_rgl_entropy%d_ops", id));
+  }
   h_set, this, id = id, ops = ops, state = 1;
   h_delete, this, "log_x", "log_x_over_p",
     "Ax", "x_over_Ax", "log_x_over_Ax";
@@ -2225,6 +2302,48 @@ func _rgl_build_ops(update, get_penalty, get_gradient, apply_hessian,
                get_diagonal_of_hessian = symlink_to_name(get_diagonal_of_hessian));
 }
 
+func _rgl_entropy0_update(this, x)
+{
+  nil = [];
+  h_set, this, _fx = nil, _gx = nil, _hx = nil;
+}
+
+func _rgl_entropy0_get_penalty(this, x)
+{
+  if (is_void(this._fx)) {
+    local g;
+    h_set, this,
+      _fx = rgl_entropy_fg([this.mu, this.epsilon], this.id, x,
+                           (this.id >= 4 ? this.prior : []), g),
+      _gx = g;
+  }
+  return this._fx;
+}
+
+func _rgl_entropy0_get_gradient(this, x)
+{
+  if (is_void(this._gx)) _rgl_entropy0_get_penalty, this, x;
+  return this._gx;
+}
+
+func _rgl_entropy0_apply_hessian(this, x, s)
+{
+  return _rgl_entropy0_get_diagonal_of_hessian(this, x)*s;
+}
+
+func _rgl_entropy0_get_diagonal_of_hessian(this, x)
+{
+  if (is_void(this._hx)) {
+    h_set, this, _hx = rgl_entropy_diag([this.mu, this.epsilon], this.id, x);
+  }
+  return this._hx;
+}
+_rgl_entropy0_ops = _rgl_build_ops("_rgl_entropy0_update",
+                                   "_rgl_entropy0_get_penalty",
+                                   "_rgl_entropy0_get_gradient",
+                                   "_rgl_entropy0_apply_hessian",
+                                   "_rgl_entropy0_get_diagonal_of_hessian");
+
 func _rgl_entropy1_update(this, x)
 {
   nil = [];
@@ -2440,7 +2559,7 @@ func _rgl_entropy5_update(this, x)
 func _rgl_entropy5_preamble(this, x)
 {
   x = unref(x) + this.epsilon;
-  h_set, this, state = 5,
+  h_set, this, state = 1,
     _x = x,
     _lx = log(x/(this.prior + this.epsilon));
 }
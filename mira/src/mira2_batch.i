@@ -138,6 +138,13 @@ _MIRA_CL_OPTS = _lst\
         "Recenter result of bootstrapping iterations"),
    _lst("threshold", [], "FRACTION", OPT_REAL,
         "Level for soft-thresholding input image(s)"),
+   "\nParameter sweep:",
+   _lst("sweep", [], "FILE", OPT_STRING,
+        "Text file with the settings of each run (one per line)"),
+   _lst("workers", [], "COUNT", OPT_INTEGER,
+        "Number of worker processes for the runs of the sweep"),
+   _lst("warmstart", [], [], OPT_FLAG,
+        "Start each run of the sweep from the previous result"),
    "\nMessages:",
    _lst("quiet", [], [], OPT_FLAG,
         "Suppress most messages"),
@@ -443,7 +450,7 @@ func mira_main(argv0, argv)
   if (! opt.debug) {
     error = opt_error;
   }
-  if (! opt.overwrite && open(final_filename, "r", 1)) {
+  if (is_void(opt.sweep) && ! opt.overwrite && open(final_filename, "r", 1)) {
     opt_error, ("output file \""+final_filename+"\" already exists");
   }
 
@@ -503,58 +510,13 @@ func mira_main(argv0, argv)
              " <https://github.com/emmt/MiRA>");
   grow, history, "Arguments: "+arguments;
 
-  /* Setup the regularization. */
-  regul_post = FALSE;
-  regul_name = opt.regul;
-  if (! is_void(regul_name)) {
-    if (min(opt.mu) < 0.0) {
-      opt_error, "Value(s) of `-mu` must be >= 0.0";
-    }
-    if (regul_name == "hyperbolic") {
-      /* Quadratic or edge-preserving smoothness prior. */
-      regul = rgl_new("hyperbolic");
-      if (opt.tau <= 0.0) {
-        opt_error, "Value of `-tau` must be > 0.0";
-      }
-      if (min(opt.eta) <= 0.0) {
-        opt_error, "Values of `-eta` must be > 0.0";
-      }
-      rgl_config, regul, tau=opt.tau, eta=opt.eta; //, loss=regul_loss;
-      grow, history,
-        swrite(format="Regularization: \"%s\" with MU=%s, TAU=%g, ETA=%s",
-               regul_name, mira_format(opt.mu), opt.tau, mira_format(opt.eta));
-    } else if (regul_name == "compactness") {
-      /* Compactness prior. */
-      if (is_void(opt.gamma)) {
-        opt_error, ("Option `-gamma=...` must be specified with " +
-                    "\"compactness\" regularization");
-      }
-      value = get_angle(opt, "gamma", strictly_positive);
-      grow, history,
-        swrite(format="Regularization: \"%s\" with MU=%s and GAMMA=%s",
-               regul_name, mira_format(opt.mu), mira_format( opt.gamma));
-      h_set, opt, gamma=value;
-      regul_post = TRUE;
-    } else {
-      opt_error, "Unsupported regularization \""+regul_name+"\"";
-    }
-  }
+  /* Check the settings of the regularization and of the reconstruction
+     strategy. */
+  _mira_batch_regul, opt;
+  _mira_batch_mu, opt;
 
   /* Initial image. */
-  if (is_void(opt.initial)) {
-    if (! opt.oi_imaging || is_void(opt.initialhdu)) {
-      opt_error, ("An initial image must be specified, e.g. with " +
-                  "`--initial=Dirac|random|FILENAME`");
-    }
-    h_set, opt, initial = mira_batch_read_initial_image(argv(1),
-                                                        opt.initialhdu);
-  }
-  if (is_string(opt.initial)) {
-    if (opt.initial != "random" && opt.initial != "Dirac") {
-      /* Read initial image. */
-      h_set, opt, initial = mira_read_image(opt.initial);
-    }
-  }
+  _mira_batch_load_initial, opt, argv;
 
   /* Get image dimensions and pixel size, if specified. */
   local dim1, dim2, dims, pixelsize, imagesize, fov;
@@ -597,12 +559,213 @@ func mira_main(argv0, argv)
                 "`-fov=...`, `-pixelsize=...` or `-imagesize=...`");
   }
 
-  /* Check some options. */
+  /* Fix/generate initial image. */
+  image = _mira_batch_make_initial(opt, pixelsize, dims, fov);
+  h_set, opt, initial = image;
+
+  /* Parse wavelenght settings. */
+  wavemin = get_length(opt, "wavemin", strictly_positive);
+  wavemax = get_length(opt, "wavemax", strictly_positive);
+  effwave = get_length(opt, "effwave", strictly_positive);
+  effband = get_length(opt, "effband", nonnegative);
+  choice = ((is_void(effwave) ? 0 : 1) |
+            (is_void(effband) ? 0 : 2) |
+            (is_void(wavemin) ? 0 : 4) |
+            (is_void(wavemax) ? 0 : 8));
+  if (choice == 3) {
+    if (2*effband > effwave) {
+      opt_error, "Too large value for `-effband=...`";
+    }
+    wavemin = effwave - effband/2.0;
+    wavemax = effwave + effband/2.0;
+  } else if (choice == 12) {
+    if (wavemin > wavemax) {
+      opt_error, "Incompatible values for `-wavemin=...` and `-wavemax=...` ";
+    }
+  } else if (choice != 0 && choice != 4 && choice != 8) {
+    opt_error, ("Specify `-effwave` and `-effband`, "+
+                "or `-wavemin` and/or `-wavemax`");
+  }
+  h_pop, opt, "effwave";
+  h_pop, opt, "effband";
+  h_set, opt, wavemin=wavemin, wavemax=wavemax;
+
+  /* Read input data. */
+  master = mira_new(argv(1:-1),
+                    plugin = opt.plugin_obj,
+                    target = opt.target,
+                    wavemin = opt.wavemin,
+                    wavemax = opt.wavemax,
+                    quiet = opt.quiet,
+                    pixelsize = pixelsize,
+                    dims = dims,
+                    flags = flags,
+                    xform = opt.xform,
+                    nthreads = opt.nthreads,
+                    smearingfunction = opt.smearingfunction,
+                    smearingfactor = opt.smearingfactor);
+  inform, "flags = "+mira_format_flags(master.flags);
+
+  if (is_void(opt.sweep)) {
+    /* Run a single image reconstruction. */
+    regul = _mira_batch_regul(opt, master, history);
+    _mira_batch_reconstruct, master, opt, image, regul, history,
+      final_filename;
+  } else {
+    /* Run a sequence of image reconstructions. */
+    _mira_batch_sweep, master, opt, options, image, pixelsize, dims, argv,
+      history, final_filename;
+  }
+
+  if (opt.view && batch()) {
+    /* Just make a substancial pause? */
+    write, format="\n%s\n", "Close the graphic window to finish.";
+    while (window_exists(_mira_window)) {
+      pause, 100;
+    }
+  }
+}
+
+func _mira_batch_regul(opt, master, &history)
+/* DOCUMENT regul = _mira_batch_regul(opt, master, history);
+         or _mira_batch_regul, opt;
+
+     Private routine which yields the regularization specified by the options
+     in table OPT for the MiRA instance MASTER and which appends a description
+     of the regularization to the HISTORY.  When called as a subroutine, or if
+     MASTER is void, the options are only checked.
+
+   SEE ALSO: mira_main.
+ */
+{
+  regul_name = opt.regul;
+  if (is_void(regul_name)) {
+    return;
+  }
+  if (min(opt.mu) < 0.0) {
+    opt_error, "Value(s) of `-mu` must be >= 0.0";
+  }
+  if (regul_name == "hyperbolic") {
+    /* Quadratic or edge-preserving smoothness prior. */
+    if (opt.tau <= 0.0) {
+      opt_error, "Value of `-tau` must be > 0.0";
+    }
+    if (min(opt.eta) <= 0.0) {
+      opt_error, "Values of `-eta` must be > 0.0";
+    }
+    regul = rgl_new("hyperbolic");
+    rgl_config, regul, tau=opt.tau, eta=opt.eta; //, loss=regul_loss;
+    grow, history,
+      swrite(format="Regularization: \"%s\" with MU=%s, TAU=%g, ETA=%s",
+             regul_name, mira_format(opt.mu), opt.tau, mira_format(opt.eta));
+  } else if (regul_name == "compactness") {
+    /* Compactness prior. */
+    if (is_void(opt.gamma)) {
+      opt_error, ("Option `-gamma=...` must be specified with " +
+                  "\"compactness\" regularization");
+    }
+    gamma = mira_get_angle(opt, "gamma", _mira_is_strictly_positive);
+    grow, history,
+      swrite(format="Regularization: \"%s\" with MU=%s and GAMMA=%s",
+             regul_name, mira_format(opt.mu), mira_format(opt.gamma));
+    if (! is_void(master)) {
+      h_set, opt, gamma=gamma;
+      regul = mira_new_compactness_prior(master, gamma);
+    }
+  } else {
+    opt_error, "Unsupported regularization \""+regul_name+"\"";
+  }
+  return regul;
+}
+
+func _mira_batch_mu(opt)
+/* DOCUMENT mu = _mira_batch_mu(opt);
+
+     Private routine which checks the settings of the reconstruction strategy
+     in the options table OPT and yields the regularization weight for each
+     bootstrapping iteration.
+
+   SEE ALSO: mira_main.
+ */
+{
   if (! is_void(opt.threshold) && (opt.threshold < 0 || opt.threshold >= 1)) {
     opt_error, "Invalid value for `-threshold=...`";
   }
 
-  /* Fix/generate initial image. */
+  local mu;
+  if (is_void(opt.bootstrap)) {
+    eq_nocopy, mu, opt.mu;
+    n = numberof(mu);
+  } else {
+    if (opt.bootstrap < 0) {
+      opt_error, "Bad value for option `-bootstrap`";
+    }
+    n = opt.bootstrap + 1;
+    m = numberof(opt.mu);
+    if (m == n) {
+      eq_nocopy, mu, opt.mu;
+    } else if (m == 1) {
+      mu = array(opt.mu, n);
+    } else if (m == 2 && n >= 2) {
+      mu = spanl(opt.mu(1), opt.mu(2), n);
+    } else if (m == 3 && n >= 3) {
+      mu = grow(spanl(opt.mu(1), opt.mu(2), n - 1), opt.mu(3));
+    } else if (m == 3 && n == 2) {
+      mu = [opt.mu(1), opt.mu(3)];
+    } else {
+      opt_error, "Bad number of values for option `-mu`";
+    }
+  }
+  if (! is_void(opt.maxiter) && opt.maxiter < 0) {
+      opt_error, "Bad value for option `-maxiter`";
+  }
+  if (! is_void(opt.maxeval) && opt.maxeval < 0) {
+    opt_error, "Bad value for option `-maxeval`";
+  }
+  return mu;
+}
+
+func _mira_batch_load_initial(opt, argv)
+/* DOCUMENT _mira_batch_load_initial, opt, argv;
+
+     Private routine which reads the initial image specified by the options in
+     table OPT (if it is stored in a file) and stores it in OPT.initial.
+     ARGV is the list of positional arguments.
+
+   SEE ALSO: mira_main, _mira_batch_make_initial.
+ */
+{
+  if (is_void(opt.initial)) {
+    if (! opt.oi_imaging || is_void(opt.initialhdu)) {
+      opt_error, ("An initial image must be specified, e.g. with " +
+                  "`--initial=Dirac|random|FILENAME`");
+    }
+    h_set, opt, initial = mira_batch_read_initial_image(argv(1),
+                                                        opt.initialhdu);
+  }
+  if (is_string(opt.initial)) {
+    if (opt.initial != "random" && opt.initial != "Dirac") {
+      /* Read initial image. */
+      h_set, opt, initial = mira_read_image(opt.initial);
+    }
+  }
+}
+
+func _mira_batch_make_initial(opt, &pixelsize, &dims, fov)
+/* DOCUMENT image = _mira_batch_make_initial(opt, pixelsize, dims, fov);
+
+     Private routine which yields the initial image specified by the options in
+     table OPT resampled with the given PIXELSIZE and dimensions DIMS.  If
+     they are void on entry, PIXELSIZE and DIMS are set from the initial image
+     and the field of view FOV (if not void).  OPT.initial must have been loaded by `_mira_batch_load_initial`.
+
+   SEE ALSO: mira_main, _mira_batch_load_initial.
+ */
+{
+  if (! is_void(dims)) {
+    dim1 = dims(2);
+    dim2 = dims(3);
+  }
   if (is_string(opt.initial)) {
     image = h_new(naxis = 2,
                   naxis1 = dim1,
@@ -686,88 +849,25 @@ func mira_main(argv0, argv)
                               crval1=crval,  crval2=crval,
                               cdelt1=cdelt,  cdelt2=cdelt,
                               cunit1=cunit,  cunit2=cunit);
-  h_set, opt, initial = image;
+  return image;
+}
 
-  /* Parse wavelenght settings. */
-  wavemin = get_length(opt, "wavemin", strictly_positive);
-  wavemax = get_length(opt, "wavemax", strictly_positive);
-  effwave = get_length(opt, "effwave", strictly_positive);
-  effband = get_length(opt, "effband", nonnegative);
-  choice = ((is_void(effwave) ? 0 : 1) |
-            (is_void(effband) ? 0 : 2) |
-            (is_void(wavemin) ? 0 : 4) |
-            (is_void(wavemax) ? 0 : 8));
-  if (choice == 3) {
-    if (2*effband > effwave) {
-      opt_error, "Too large value for `-effband=...`";
-    }
-    wavemin = effwave - effband/2.0;
-    wavemax = effwave + effband/2.0;
-  } else if (choice == 12) {
-    if (wavemin > wavemax) {
-      opt_error, "Incompatible values for `-wavemin=...` and `-wavemax=...` ";
-    }
-  } else if (choice != 0 && choice != 4 && choice != 8) {
-    opt_error, ("Specify `-effwave` and `-effband`, "+
-                "or `-wavemin` and/or `-wavemax`");
-  }
-  h_pop, opt, "effwave";
-  h_pop, opt, "effband";
-  h_set, opt, wavemin=wavemin, wavemax=wavemax;
+func _mira_batch_reconstruct(master, opt, image, regul, history,
+                             final_filename)
+/* DOCUMENT arr = _mira_batch_reconstruct(master, opt, image, regul,
+                                          history, filename);
 
-  /* Read input data. */
-  master = mira_new(argv(1:-1),
-                    plugin = opt.plugin_obj,
-                    target = opt.target,
-                    wavemin = opt.wavemin,
-                    wavemax = opt.wavemax,
-                    quiet = opt.quiet,
-                    pixelsize = pixelsize,
-                    dims = dims,
-                    flags = flags,
-                    xform = opt.xform,
-                    nthreads = opt.nthreads,
-                    smearingfunction = opt.smearingfunction,
-                    smearingfactor = opt.smearingfactor);
-  inform, "flags = "+mira_format_flags(master.flags);
-
-  /* Post operations for the regularization. */
-  if (regul_post) {
-    if (regul_name == "compactness") {
-      regul = mira_new_compactness_prior(master, opt.gamma);
-    }
-  }
+     Private routine which runs an image reconstruction with MiRA instance
+     MASTER, the settings in the options table OPT, the initial image IMAGE
+     and the regularization REGUL.  The result is saved in FITS file FILENAME
+     with HISTORY.  The pixels of the final image are returned.
 
-  local mu;
-  if (is_void(opt.bootstrap)) {
-    eq_nocopy, mu, opt.mu;
-    n = numberof(mu);
-  } else {
-    if (opt.bootstrap < 0) {
-      opt_error, "Bad value for option `-bootstrap`";
-    }
-    n = opt.bootstrap + 1;
-    m = numberof(opt.mu);
-    if (m == n) {
-      eq_nocopy, mu, opt.mu;
-    } else if (m == 1) {
-      mu = array(opt.mu, n);
-    } else if (m == 2 && n >= 2) {
-      mu = spanl(opt.mu(1), opt.mu(2), n);
-    } else if (m == 3 && n >= 3) {
-      mu = grow(spanl(opt.mu(1), opt.mu(2), n - 1), opt.mu(3));
-    } else if (m == 3 && n == 2) {
-      mu = [opt.mu(1), opt.mu(3)];
-    } else {
-      opt_error, "Bad number of values for option `-mu`";
-    }
-  }
-  if (! is_void(opt.maxiter) && opt.maxiter < 0) {
-      opt_error, "Bad value for option `-maxiter`";
-  }
-  if (! is_void(opt.maxeval) && opt.maxeval < 0) {
-    opt_error, "Bad value for option `-maxeval`";
-  }
+   SEE ALSO: mira_main, _mira_batch_sweep.
+ */
+{
+  mu = _mira_batch_mu(opt);
+  n = numberof(mu);
+  image = h_copy(image); /* the members of IMAGE are changed below */
 
   /* Run image reconstruction stages. */
   local initial_arr, final_arr, misc;
@@ -883,14 +983,280 @@ func mira_main(argv0, argv)
     mira_save_visibilities, master, fh;
   }
   fits_close, fh;
+  return final_arr;
+}
 
-  if (opt.view && batch()) {
-    /* Just make a substancial pause? */
-    write, format="\n%s\n", "Close the graphic window to finish.";
-    while (window_exists(_mira_window)) {
-      pause, 100;
+/* Options which can be set for each run of a parameter sweep. */
+_MIRA_SWEEP_KEYS = ["regul", "mu", "tau", "eta", "gamma",
+                    "initial", "initialhdu", "seed",
+                    "flux", "fluxerr", "min", "max",
+                    "bootstrap", "recenter", "threshold",
+                    "mem", "ftol", "gtol", "xtol", "maxiter", "maxeval",
+                    "sftol", "sgtol", "sxtol", "verb"];
+
+func _mira_batch_read_sweep(filename)
+/* DOCUMENT runs = _mira_batch_read_sweep(filename);
+
+     Private routine which reads the settings of the runs of a parameter sweep
+     in text file FILENAME.  Each non-empty line which does not start with a
+     `#` specifies a run, the result is an array of strings with the settings
+     of each run.
+
+   SEE ALSO: _mira_batch_sweep.
+ */
+{
+  file = open(filename, "r", 1);
+  if (! file) {
+    opt_error, "Cannot read sweep file \""+filename+"\"";
+  }
+  runs = [];
+  while ((line = rdline(file))) {
+    line = strtrim(line, 3, blank=" \t\r\n");
+    if (strlen(line) > 0 && strpart(line, 1:1) != "#") {
+      grow, runs, line;
+    }
+  }
+  close, file;
+  return runs;
+}
+
+func _mira_batch_run_options(tab, opt, line)
+/* DOCUMENT ropt = _mira_batch_run_options(tab, opt, line);
+
+     Private routine which yields a copy of the options table OPT with the
+     options specified in string LINE (as on the command line) overriding the
+     global ones.  TAB is the table for parsing the options.  Only the options
+     listed in _MIRA_SWEEP_KEYS can be set for a given run.
+
+   SEE ALSO: _mira_batch_sweep.
+ */
+{
+  args = [];
+  while (line) {
+    tok = strtok(line, " \t");
+    if (! tok(1)) break;
+    grow, args, tok(1);
+    line = tok(2);
+  }
+  sel = strgrep("^--?([^=]+)", args, sub=1);
+  if (anyof(sel(2,) < 0)) {
+    opt_error, "Sweep settings must only consist in options";
+  }
+  keys = strpart(args, sel);
+  for (k = 1; k <= numberof(keys); ++k) {
+    if (noneof(keys(k) == _MIRA_SWEEP_KEYS)) {
+      opt_error, "Option `-"+keys(k)+"` cannot be set for a run of a sweep";
+    }
+  }
+  if (noneof(keys == "initial") &&
+      (anyof(keys == "initialhdu") || anyof(keys == "seed"))) {
+    opt_error, ("Options `-initialhdu` and `-seed` require `-initial` in " +
+                "the settings of a run of a sweep");
+  }
+  argv = args;
+  tmp = opt_parse(tab, argv);
+  ropt = h_copy(opt);
+  for (k = 1; k <= numberof(keys); ++k) {
+    h_set, ropt, keys(k), h_get(tmp, keys(k));
+  }
+  return ropt;
+}
+
+func _mira_batch_sweep(master, opt, tab, image, pixelsize, dims, argv,
+                       history, output)
+/* DOCUMENT _mira_batch_sweep, master, opt, tab, image, pixelsize, dims,
+                               argv, history, output;
+
+     Private routine which runs the image reconstructions of the parameter
+     sweep specified by option `-sweep=FILE` with MiRA instance MASTER.  The
+     data, the model of the Fourier transform and the image geometry (given
+     by PIXELSIZE and DIMS) are shared by all the runs.  OPT is the table of
+     the global options, TAB is the table to parse the options, IMAGE is the
+     default initial image, ARGV are the positional arguments and HISTORY is
+     the initial history of the results.
+
+     The result of the K-th run is saved in "BASE-K.fits" where BASE is
+     OUTPUT without its ".fits" extension and a summary table is written in
+     "BASE-summary.txt".
+
+     With option `-workers=N` (and N > 1), the runs are distributed among N
+     child processes which share the data of the parent process.  Otherwise,
+     the runs are executed in sequence and, with option `-warmstart`, a run
+     whose initial image is not specified starts from the result of the
+     previous run.
+
+   SEE ALSO: mira_main, fork.
+ */
+{
+  /* Read and check the settings of all runs before starting any. */
+  runs = _mira_batch_read_sweep(opt.sweep);
+  nruns = numberof(runs);
+  if (nruns < 1) {
+    opt_error, "No runs in sweep file \""+opt.sweep+"\"";
+  }
+  for (k = 1; k <= nruns; ++k) {
+    ropt = _mira_batch_run_options(tab, opt, runs(k));
+    _mira_batch_regul, ropt;
+    _mira_batch_mu, ropt;
+  }
+  nworkers = (is_void(opt.workers) ? 1 : opt.workers);
+  if (nworkers < 1) {
+    opt_error, "Bad value for option `-workers`";
+  }
+  nworkers = min(nworkers, nruns);
+  if (nworkers > 1 && opt.warmstart) {
+    opt_error, "Option `-warmstart` is not compatible with `-workers` > 1";
+  }
+  if (nworkers > 1 && ! is_func(fork)) {
+    warn, "Function `fork` (from Yeti) not available, runs are sequential";
+    nworkers = 1;
+  }
+
+  /* Names of output files. */
+  base = output;
+  if (strglob("*.fits", base)) {
+    base = strpart(base, 1:-5);
+  }
+  ndigits = max(3, long(floor(log10(nruns))) + 1);
+  fmt = swrite(format="%%s-%%0%dd.fits", ndigits);
+  outputs = swrite(format=fmt, base, indgen(nruns));
+  summary = base + "-summary.txt";
+  for (k = 1; k <= nruns; ++k) {
+    if (open(outputs(k), "r", 1)) {
+      if (! opt.overwrite) {
+        opt_error, ("output file \""+outputs(k)+"\" already exists");
+      }
+      remove, outputs(k);
+    }
+  }
+
+  if (nworkers == 1) {
+    local prev_arr;
+    /* Make sure the resources shared by all the runs (selected data, model
+       of the transform and compiled data fidelity) are built once for
+       all. */
+    mira_update, master, image.arr;
+    _mira_fidelity, master;
+    for (k = 1; k <= nruns; ++k) {
+      prev_arr = _mira_batch_sweep_run(master, opt, tab, image, pixelsize,
+                                       dims, argv, history, runs, outputs, k,
+                                       (opt.warmstart ? prev_arr : []));
+      _mira_batch_write_summary, summary, runs, outputs;
+    }
+  } else {
+    pids = array(long, nworkers);
+    for (w = 1; w <= nworkers; ++w) {
+      pid = fork();
+      if (pid == 0) {
+        /* Child process: run every NWORKERS-th reconstruction and quit (any
+           error also terminates the child).  The child of `fork` is
+           single-threaded and cannot use the threads of objects made by
+           the parent, so the shared resources are built here, with a
+           single-threaded transform. */
+        batch, 1;
+        if (master.nthreads != 1) {
+          mira_config, master, nthreads = 1;
+        }
+        mira_update, master, image.arr;
+        _mira_fidelity, master;
+        for (k = w; k <= nruns; k += nworkers) {
+          _mira_batch_sweep_run, master, opt, tab, image, pixelsize, dims,
+            argv, history, runs, outputs, k;
+        }
+        quit;
+      }
+      pids(w) = pid;
+    }
+    if (! opt.quiet) {
+      inform, "%d runs distributed among %d worker processes", nruns, nworkers;
+    }
+    for (w = 1; w <= nworkers; ++w) {
+      status = waitpid(pids(w));
+      if (status != 0) {
+        warn, "Worker process %d exited with status %d", pids(w), status;
+      }
+    }
+    _mira_batch_write_summary, summary, runs, outputs;
+  }
+  if (! opt.quiet) {
+    inform, "Summary of the sweep written in \"%s\"", summary;
+  }
+}
+
+func _mira_batch_sweep_run(master, opt, tab, image, pixelsize, dims, argv,
+                           history, runs, outputs, k, warm_arr)
+/* DOCUMENT arr = _mira_batch_sweep_run(master, opt, tab, image, pixelsize,
+                                        dims, argv, history, runs, outputs,
+                                        k, warm_arr);
+
+     Private routine which runs the K-th image reconstruction of a parameter
+     sweep and yields the resulting pixels.  If WARM_ARR is not void and the
+     run does not specify its initial image, WARM_ARR is used for the initial
+     pixels.
+
+   SEE ALSO: _mira_batch_sweep.
+ */
+{
+  ropt = _mira_batch_run_options(tab, opt, runs(k));
+  if (is_string(ropt.initial)) {
+    /* Initial image specified for this run. */
+    _mira_batch_load_initial, ropt, argv;
+    image = _mira_batch_make_initial(ropt, pixelsize, dims);
+    h_set, ropt, initial = image;
+  } else if (! is_void(warm_arr)) {
+    image = h_set(h_copy(image), arr = warm_arr);
+  }
+  if (! opt.quiet) {
+    inform, "Sweep run %d/%d: %s", k, numberof(runs), runs(k);
+  }
+  grow, history, swrite(format="Sweep run %d: %s", k, runs(k));
+  regul = _mira_batch_regul(ropt, master, history);
+  return _mira_batch_reconstruct(master, ropt, image, regul, history,
+                                 outputs(k));
+}
+
+func _mira_batch_write_summary(filename, runs, outputs)
+/* DOCUMENT _mira_batch_write_summary, filename, runs, outputs;
+
+     Private routine which writes the summary of a parameter sweep in text
+     file FILENAME.  RUNS are the settings and OUTPUTS the names of the result
+     files of the runs.  The figures are read in the output parameters of
+     the result files, runs without a result are marked as "failed".
+
+   SEE ALSO: _mira_batch_sweep.
+ */
+{
+  keys = ["RGL_WGT", "CHISQ", "FPRIOR", "GPNORM", "NITER", "NEVAL"];
+  nkeys = numberof(keys);
+  file = open(filename, "w");
+  write, file, format="# %s\n", "Summary of MiRA parameter sweep";
+  write, file, format="# %4s %-7s %13s %13s %13s %13s %6s %6s %s\n",
+    "RUN", "STATUS", keys(1), keys(2), keys(3), keys(4), keys(5), keys(6),
+    "OUTPUT SETTINGS";
+  for (k = 1; k <= numberof(runs); ++k) {
+    vals = array("-", nkeys);
+    status = "failed";
+    if (open(outputs(k), "r", 1)) {
+      fh = fits_open(outputs(k));
+      if (mira_find_fits_hdu(fh, "BINTABLE",
+                             extname="IMAGE-OI OUTPUT PARAM")) {
+        status = (fits_get(fh, "CONVERGENCE") == 'T' ? "ok" : "stopped");
+        for (i = 1; i <= nkeys; ++i) {
+          val = fits_get(fh, keys(i));
+          if (is_integer(val)) {
+            vals(i) = swrite(format="%d", val);
+          } else if (is_real(val)) {
+            vals(i) = swrite(format="%.6e", val);
+          }
+        }
+      }
+      fits_close, fh;
     }
+    write, file, format="%6d %-7s %13s %13s %13s %13s %6s %6s %s %s\n",
+      k, status, vals(1), vals(2), vals(3), vals(4), vals(5), vals(6),
+      outputs(k), runs(k);
   }
+  close, file;
 }
 
 func mira_concatenate_arguments(argv)
@@ -133,11 +133,12 @@ func mira_config(master, wavemin=, wavemax=, dims=, pixelsize=, xform=,
      Keyword `xform` is the name of the model to use for computing the
      nonuniform Fourier transform.  Possibilities are: "simple" or "nfft".
 
-     If keyword `xform` is set to "simple", keywords `smearingfactor` and
-     `smearingfunction` can be set to tune the accounting of bandwidth
-     smearing.  By default, `smearingfactor=1` and `smearingfunction=sinc`.
-     Setting `smearingfactor=0` or `xform="nfft"`, disables the accounting of
-     bandwidth smearing.
+     Keywords `smearingfactor` and `smearingfunction` can be set to tune the
+     accounting of bandwidth smearing.  By default, `smearingfactor=1` and
+     `smearingfunction=sinc`.  Setting `smearingfactor=0` disables the
+     accounting of bandwidth smearing.  With `xform="separable"` or
+     `xform="nfft"`, smearing is approximated by a weighted sum of
+     monochromatic transforms (no dense transform matrix is built).
 
      Keyword `nthreads` can be specified with the number of threads to
      use for computing the fast Fourier transform.
@@ -49,6 +49,10 @@ func mira_cost(master, x)
 {
   /* Update model and integrate cost for each datablock. */
   mira_update, master, x;
+  fidelity = _mira_fidelity(master);
+  if (! is_void(fidelity)) {
+    return fidelity(mira_model_vis(master));
+  }
   cost = 0.0;
   for (db = _mira_first(master); db; db = _mira_next(master, db)) {
     cost += db.ops.cost(master, db);
@@ -69,14 +73,35 @@ func mira_cost_and_gradient(master, x, &grd)
   if (numberof(dims) != 3 || dims(2) != 2) {
     throw, "unexpected dimensions for model complex visibilities";
   }
+  fidelity = _mira_fidelity(master);
+  if (! is_void(fidelity)) {
+    /* All terms are integrated by the compiled data fidelity. */
+    cost = fidelity(mira_model_vis(master), grd);
+  } else {
+    cost = _mira_cost_and_gradient(master, dims, grd);
+  }
+  plugin = mira_plugin(master);
+  if (is_hash(plugin)) {
+    h_set, master, tweaking_gradient=1n;
+    grd = plugin.__vops__.tweak_gradient(master, grd);
+    h_set, master, tweaking_gradient=0n;
+  }
+  grd = master.xform(grd, 1);
+  return cost;
+}
+
+func _mira_cost_and_gradient(master, dims, &grd)
+{
+  /* Integrate cost and gradient with respect to the complex visibilities for
+     each datablock. */
   tbl = h_new(nfreqs = dims(3));
   cost = 0.0;
   for (db = _mira_first(master); db; db = _mira_next(master, db)) {
     cost += db.ops.cost(master, db, tbl);
   }
 
-  /* Convert gradient with respect to the complex visibilities into gradient
-     with respect to pixel values. */
+  /* Convert gradient with respect to amplitudes, powerspectrum and phases
+     into gradient with respect to the complex visibilities. */
   increment = _mira_increment_variable;
   grd_re = h_pop(tbl, "re");
   grd_im = h_pop(tbl, "im");
@@ -105,16 +130,69 @@ func mira_cost_and_gradient(master, x, &grd)
   if (! is_void(grd_im)) {
     grd(2,) = grd_im;
   }
-  plugin = mira_plugin(master);
-  if (is_hash(plugin)) {
-    h_set, master, tweaking_gradient=1n;
-    grd = plugin.__vops__.tweak_gradient(master, grd);
-    h_set, master, tweaking_gradient=0n;
-  }
-  grd = master.xform(grd, 1);
   return cost;
 }
 
+func _mira_fidelity(master)
+/* DOCUMENT obj = _mira_fidelity(master);
+
+     Private routine which yields the compiled data fidelity (see
+     `fidelity_new`) for the data selected in MiRA instance `master`.  The
+     object is built on first use and cached in `master` until data selection
+     or the phase approximation change.  Nothing is returned if the compiled
+     data fidelity is not available (Yeti too old, unsupported phase
+     approximation or datablocks of unknown class), the interpreted cost
+     functions of the datablocks are then used.  This outcome is cached as
+     well (`master.fidelity` is set to 0) so that the datablocks are not
+     scanned again at every evaluation of the cost.
+
+   SEE ALSO: mira_cost, mira_cost_and_gradient.
+ */
+{
+  if (! is_func(fidelity_new)) {
+    return;
+  }
+  bits = (master.flags & _MIRA_PHASE_ONLY_BITS);
+  obj = master.fidelity;
+  if (! is_void(obj) && master.fidelity_bits == bits) {
+    if (is_integer(obj)) {
+      /* No compiled data fidelity for this selection. */
+      return;
+    }
+    return obj;
+  }
+  if (bits == MIRA_HANIFF_APPROX) {
+    approx = 1;
+  } else if (bits == MIRA_CONVEX_LIMIT) {
+    approx = 2;
+  } else if (bits == MIRA_VON_MISES_APPROX) {
+    approx = 3;
+  } else {
+    h_set, master, fidelity = 0, fidelity_bits = bits;
+    return;
+  }
+  obj = fidelity_new(numberof(mira_model_vis(master))/2);
+  for (db = _mira_first(master); db; db = _mira_next(master, db)) {
+    class = db.ops.class;
+    if (numberof(db.idx) < 1) {
+      continue;
+    } else if (class == "vis2" || class == "visamp" || class == "visphi" ||
+               class == "t3amp") {
+      fidelity_add, obj, class, approx, db.idx, [], db.dat, db.wgt;
+    } else if (class == "t3phi") {
+      fidelity_add, obj, class, approx, db.idx, db.sgn, db.dat, db.wgt;
+    } else if (class == "vis" || class == "t3") {
+      fidelity_add, obj, class, approx, db.idx, db.sgn,
+        db.re, db.im, db.wrr, db.wri, db.wii;
+    } else {
+      h_set, master, fidelity = 0, fidelity_bits = bits;
+      return;
+    }
+  }
+  h_set, master, fidelity = obj, fidelity_bits = bits;
+  return obj;
+}
+
 func _mira_update_gradient(tbl, key, idx, val)
 {
   if (!is_void(idx)) {
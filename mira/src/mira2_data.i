@@ -244,7 +244,7 @@ func _mira_select_data(master)
   oidata = master.oidata;
   wavemin = master.wavemin;
   wavemax = master.wavemax;
-  h_set, master, first = [], stage = 0,
+  h_set, master, first = [], stage = 0, fidelity = [],
     img_wavemin = 0.0, img_wavemax = 0.0, img_wave = 0.0,
     coords = h_new(mode = 0, u = [], v = [], wave = [], band = []);
 
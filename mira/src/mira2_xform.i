@@ -29,7 +29,7 @@ if (! is_scalar(MIRA_HOME) || ! is_string(MIRA_HOME)) {
 /*---------------------------------------------------------------------------*/
 /* MODELS OF THE IMAGE TO COMPLEX VISIBILITIES TRANSFORM */
 
-local _mira_apply_separable_xform;
+local _mira_apply_separable_xform, _mira_apply_compiled_xform;
 local _mira_apply_nonseparable_xform
 local _mira_apply_nfft_xform;
 func _mira_define_xform(master)
@@ -74,14 +74,6 @@ func _mira_define_xform(master)
 
   /* Figure out whether or not to account for spectral bandwidth smearing. */
   smearing = (smearingfunction != "none" && smearingfactor > 0);
-  if (smearing && (xform == "nfft" || xform == "separable")) {
-    if (! MIRA_QUIET) {
-      warn, ("Spectral bandwidth smearing is ignored with xform=\"%s\" "+
-           "(set smearingfunction=\"none\" or smearingfactor=0 to avoid "+
-           "this message)."), xform;
-    }
-    smearing = 0n;
-  }
   if (! MIRA_QUIET && ! smearing && xform != "nfft") {
     warn, ("When spectral bandwidth smearing is ignored, xform=\"nfft\" "+
            "is faster that xform=\""+xform+"\".");
@@ -201,14 +193,50 @@ func _mira_define_xform(master)
    * smearing is ignored or if its also separable.
    */
 
+  /*
+   * With xform="separable" or xform="nfft", the transform matrix is never
+   * built.  Spectral bandwidth smearing is then accounted for by writing the
+   * smearing function as:
+   *
+   *     s(t) ≈ sum_q w_q⋅exp(i⋅2⋅π⋅f_q⋅t)
+   *
+   * (see `_mira_smearing_quadrature`), so that each model complex visibility
+   * is a weighted sum of monochromatic complex visibilities at the scaled
+   * spatial frequencies (1 - f_q⋅γ⋅Δλ/λ)⋅(u,v)/λ.
+   */
+  local unodes, vnodes;
+  eq_nocopy, unodes, ufreq;
+  eq_nocopy, vnodes, vfreq;
+  quad = [];
+  if (smearing && xform != "nonseparable") {
+    if (smearingfactor > 0 && max(band) > 0) {
+      r = smearingfactor*band/wave;
+      tmax = max(r*(abs(ufreq)*max(abs(x)) + abs(vfreq)*max(abs(y))));
+      quad = _mira_smearing_quadrature(master.smearingfunction, tmax);
+      scl = 1.0 - quad.f*r(-,);
+      unodes = (ufreq(-,)*scl)(*);
+      vnodes = (vfreq(-,)*scl)(*);
+      scl = [];
+    } else {
+      smearing = 0n;
+    }
+  }
+
   if (xform == "separable") {
 
-    local A1re, A1im, A2re, A2im;
-    q = -2*MIRA_PI;
-    _mira_cos_sin, A1re, A1im, q*ufreq*x(-,);
-    _mira_cos_sin, A2re, A2im, q*vfreq*y(-,);
-    xform = h_new(name=xform, A1re=A1re, A1im=A1im, A2re=A2re, A2im=A2im);
-    h_evaluator, xform, "_mira_apply_separable_xform";
+    if (is_func(nudft_separable)) {
+      /* Use the compiled operator provided by Yeti. */
+      xform = h_new(name=xform,
+                    op=nudft_separable(unodes, x, vnodes, y));
+      h_evaluator, xform, "_mira_apply_compiled_xform";
+    } else {
+      local A1re, A1im, A2re, A2im;
+      q = -2*MIRA_PI;
+      _mira_cos_sin, A1re, A1im, q*unodes*x(-,);
+      _mira_cos_sin, A2re, A2im, q*vnodes*y(-,);
+      xform = h_new(name=xform, A1re=A1re, A1im=A1im, A2re=A2re, A2im=A2im);
+      h_evaluator, xform, "_mira_apply_separable_xform";
+    }
 
   } else if (xform == "nonseparable") {
 
@@ -277,9 +305,13 @@ func _mira_define_xform(master)
       n2 = ny;
     }
     flags = NFFT_SORT_NODES;
-    nodes = [pixelsize*ufreq, pixelsize*vfreq];
+    if (is_func(nfft_wisdom)) {
+      /* FFTW wisdom is persistent, measuring is only costly once. */
+      flags |= NFFT_MEASURE;
+    }
+    nodes = [pixelsize*unodes, pixelsize*vnodes];
     dims = [n1, n2];
-    xform = h_new(name = xform, ufreq = ufreq, vfreq = vfreq,
+    xform = h_new(name = xform, ufreq = unodes, vfreq = vnodes,
                   nfft = nfft_new(dims, nodes, flags=flags,
                                   nthreads=master.nthreads),
                   n1 = n1, r1 = r1,
@@ -292,6 +324,21 @@ func _mira_define_xform(master)
   }
 
 
+  /* Combine the sub-band transforms if smearing is accounted for by
+     quadrature. */
+  if (! is_void(quad)) {
+    xform = h_new(name = xform.name, base = xform, weights = quad.w,
+                  nq = numberof(quad.w), nfreqs = numberof(ufreq));
+    h_evaluator, xform, "_mira_apply_smeared_xform";
+  }
+
+  /* Report memory footprint of the transform. */
+  h_set, xform, nbytes = _mira_xform_memory(xform);
+  if (! MIRA_QUIET) {
+    inform, "Transform model \"%s\" uses about %.1f MiB.",
+      xform.name, xform.nbytes/1024.0^2;
+  }
+
   /* Install the evaluator. */
   if (smearing) {
     h_set, xform, smearingfactor=smearingfactor,
@@ -327,6 +374,31 @@ func _mira_apply_separable_xform(this, x, job)
   }
 }
 
+func _mira_apply_compiled_xform(this, x, job)
+{
+  return this.op(x, job);
+}
+
+func _mira_apply_smeared_xform(this, x, job)
+{
+  base = this.base;
+  nq = this.nq;
+  nfreqs = this.nfreqs;
+  if (! job) {
+    /* Direct transform: weighted sum of the sub-band visibilities. */
+    z = array(double, 2, nq, nfreqs);
+    z(*) = base(x)(*);
+    return (this.weights(-,)*z)(,sum,);
+  } else if (job == 1) {
+    /* Apply adjoint operator. */
+    z = array(double, 2, nq*nfreqs);
+    z(*) = (this.weights(-,)*x(,-,))(*);
+    return base(z, 1);
+  } else {
+    error, "unsupported value for JOB";
+  }
+}
+
 func _mira_fake_complex(re, im)
 {
   z = array(double, 2, dimsof(re, im));
@@ -346,19 +418,19 @@ func _mira_apply_nfft_xform(this, x, job)
   if (! job) {
     /* direct operator */
     if (this.sub) {
-      tmp = array(complex, this.n1, this.n2);
+      tmp = array(double, this.n1, this.n2);
       tmp(this.r1, this.r2) = x;
       eq_nocopy, x, tmp;
     }
     reshape, z, &this.nfft(x), double, 2, this.nfft.num_nodes;
     return z;
   } else if (job == 1) {
-    /* adjoint operator */
-    z = this.nfft(mira_cast_real_as_complex(x), 1n);
+    /* adjoint operator (real part only) */
+    z = this.nfft(mira_cast_real_as_complex(x), 2n);
     if (this.sub) {
-      return double(z)(this.r1, this.r2);
+      return z(this.r1, this.r2);
     } else {
-      return double(z);
+      return z;
     }
   } else {
     error, "unsupported value for JOB";
@@ -391,6 +463,110 @@ func mira_gaussian_smearing(t)
 MIRA_SINC_FWHM = 1.2067091288032283;
 MIRA_GAUSS_FWHM = sqrt(log(256));
 
+func _mira_smearing_quadrature(name, tmax)
+/* DOCUMENT q = _mira_smearing_quadrature(name, tmax);
+
+     Private routine which yields a quadrature rule to approximate the
+     smearing function NAME ("sinc" or "gauss") for arguments |t| ≤ TMAX by:
+
+         s(t) ≈ sum(q.w*exp(2i⋅π⋅q.f*t))
+
+     where the nodes Q.F and the weights Q.W are vectors.  The nodes are
+     symmetric so the approximation is real.  For "sinc", s(t) is the
+     Fourier transform of a uniform distribution on [-1/2,1/2] and
+     Gauss-Legendre quadrature is used.  For "gauss", s(t) is the Fourier
+     transform of a normal distribution which is truncated at 6 standard
+     deviations and integrated by Gauss-Legendre quadrature.  The number of
+     nodes is chosen so that the absolute error is less than about 1e-7.
+
+   SEE ALSO: mira_gaussian_smearing, sinc.
+ */
+{
+  if (name == "sinc") {
+    q = _mira_gauss_legendre(6 + long(ceil(2*tmax)));
+    return h_new(f = 0.5*q.x, w = 0.5*q.w);
+  } else if (name == "gauss") {
+    K = MIRA_GAUSS_FWHM/MIRA_SINC_FWHM;
+    sigma = K/(2*MIRA_PI);
+    fmax = 6*sigma;
+    q = _mira_gauss_legendre(22 + long(ceil(6*tmax)));
+    f = fmax*q.x;
+    w = q.w*exp((-0.5/(sigma*sigma))*f*f);
+    return h_new(f = f, w = w/sum(w));
+  }
+  throw, "unsupported smearing function \"%s\"", name;
+}
+
+func _mira_gauss_legendre(n)
+/* DOCUMENT q = _mira_gauss_legendre(n);
+
+     Private routine which yields the N nodes Q.X and weights Q.W of the
+     Gauss-Legendre quadrature on [-1,1].
+
+   SEE ALSO: _mira_smearing_quadrature.
+ */
+{
+  /* Newton's iterations for the positive roots of the Legendre polynomial of
+     degree N (all roots at once). */
+  m = (n + 1)/2;
+  z = cos(MIRA_PI*(indgen(m) - 0.25)/(n + 0.5));
+  for (iter = 1; iter <= 100; ++iter) {
+    p1 = array(1.0, m);
+    p2 = array(0.0, m);
+    for (j = 1; j <= n; ++j) {
+      p3 = p2;
+      p2 = p1;
+      p1 = ((2*j - 1)*z*p2 - (j - 1)*p3)/j;
+    }
+    dp = n*(z*p1 - p2)/(z*z - 1.0);
+    dz = p1/dp;
+    z -= dz;
+    if (max(abs(dz)) <= 1e-15) break;
+  }
+  w = 2.0/((1.0 - z*z)*dp*dp);
+  k = (n%2 == 0 ? m : m - 1); /* skip the null root if N is odd */
+  return h_new(x = _(-z, z(k:1:-1)), w = _(w, w(k:1:-1)));
+}
+
+func _mira_xform_memory(xform)
+/* DOCUMENT nbytes = _mira_xform_memory(xform);
+
+     Private routine which yields the approximate number of bytes used by the
+     coefficients and workspaces of the transform model XFORM.
+
+   SEE ALSO: _mira_define_xform.
+ */
+{
+  if (h_has(xform, "base")) {
+    return _mira_xform_memory(xform.base) + sizeof(xform.weights);
+  }
+  nbytes = 0;
+  if (h_has(xform, "op")) {
+    op = xform.op;
+    nbytes += 16*op.nfreqs*(op.nx + op.ny);
+  }
+  if (h_has(xform, "nfft")) {
+    /* Nodes, input and output arrays, oversampled workspaces and
+       precomputed interpolation coefficients (PRE_PSI). */
+    op = xform.nfft;
+    m = op.num_nodes;
+    rank = op.rank;
+    inp = ovr = 1;
+    for (k = 1; k <= rank; ++k) {
+      inp *= op.inp_dims(k + 1);
+      ovr *= op.ovr_dims(k + 1);
+    }
+    nbytes += (8*rank + 16)*m + 16*inp + 32*ovr + 8*rank*(2*op.cutoff + 2)*m;
+  }
+  keys = ["A", "A1re", "A1im", "A2re", "A2im"];
+  for (i = 1; i <= numberof(keys); ++i) {
+    if (h_has(xform, keys(i))) {
+      nbytes += sizeof(h_get(xform, keys(i)));
+    }
+  }
+  return nbytes;
+}
+
 func mira_no_smearing(t)
 {
   return array(1.0, dimsof(t));
@@ -23,6 +23,9 @@
 #include "pndrsSim.i"
 #include "pndrsConfig.i"
 
+/* Use the FFTW3 engine of Yeti for fft and fft_inplace, if available */
+if (is_func(fftw_override_fft)) fftw_override_fft, 1;
+
 extern pndrsVersion;
 pndrsVersion = "3.94";
 
@@ -26,9 +26,18 @@ func pndrsBatch(void)
    - pndrsBatchFindBestDark
    - pndrsBatchFindBestMatrix
    - pndrsBatchFindBestSpecCal
+   - pndrsBatchEarlyDetector
 
    - pndrsBatchMakeSilentGraphics
    - pndrsBatchProductDir
+
+   - pndrsBatchCacheKey
+   - pndrsBatchCacheIsValid
+   - pndrsBatchCacheSave
+   - pndrsBatchOiDataCacheKey
+   - pndrsBatchWorkersStart
+   - pndrsBatchWorkersClaim
+   - pndrsBatchWorkersStop
 */
 {
     local version;
@@ -47,11 +56,224 @@ func pndrsBatch(void)
 
 func pndrsBatchGetMd5(file)
 {
+    local md5;
     md5 = yocoStrSplit(rdline(popen("md5sum "+file,0))," ")(1);
     // yocoLogInfo,"md5sum of "+file+" = "+md5;
     return md5;
 }
 
+/* ************************************************************ */
+
+/* Checksums of the input files already computed by pndrsBatchCacheKey,
+   they are forgotten by pndrsBatchCacheReset. */
+_pndrsCacheFiles = _pndrsCacheMd5 = [];
+
+func pndrsBatchCacheReset(void)
+/* DOCUMENT pndrsBatchCacheReset
+
+   DESCRIPTION
+   Forget the checksums of the input files memorized by
+   pndrsBatchCacheKey.  Called at the beginning of the pndrsComputeAll*
+   functions since the products of a step are the inputs of the next
+   ones.
+*/
+{
+  extern _pndrsCacheFiles, _pndrsCacheMd5;
+  _pndrsCacheFiles = _pndrsCacheMd5 = [];
+}
+
+func pndrsBatchCacheKey(recipe, files, params)
+/* DOCUMENT key = pndrsBatchCacheKey(recipe, files, params)
+
+   DESCRIPTION
+   Return the cache key of a product: a single line with the name of
+   the RECIPE, the version of pndrs, the MD5 checksums of the input
+   FILES ("-" for a missing input, the name of a file does not matter,
+   only its content) and the strings PARAMS.  The product is up to date
+   if its key has not changed (see pndrsBatchCacheIsValid).
+
+   PARAMETERS
+   - recipe: name of the recipe (scalar string).
+   - files: names of all the input files, including the selected
+     calibrations and the script file.
+   - params: other parameters (array of strings).
+
+   SEE ALSO pndrsBatchCacheIsValid, pndrsBatchCacheSave
+*/
+{
+  extern _pndrsCacheFiles, _pndrsCacheMd5;
+  local str, i, id, chk;
+
+  str = recipe + " " + pndrsVersion;
+  for ( i=1 ; i<=numberof(files) ; i++ ) {
+    if ( !files(i) || !yocoTypeIsFile(files(i)) ) {
+      str += " -";
+      continue;
+    }
+    id = ( numberof(_pndrsCacheFiles) ? where(_pndrsCacheFiles==files(i)) : [] );
+    if ( numberof(id) ) {
+      chk = _pndrsCacheMd5(id(1));
+    } else {
+      chk = pndrsBatchGetMd5(files(i));
+      grow, _pndrsCacheFiles, files(i);
+      grow, _pndrsCacheMd5, chk;
+    }
+    str += " " + chk;
+  }
+  for ( i=1 ; i<=numberof(params) ; i++ ) str += " " + params(i);
+
+  return str;
+}
+
+func pndrsBatchCacheIsValid(product, key)
+/* DOCUMENT pndrsBatchCacheIsValid(product, key)
+
+   DESCRIPTION
+   Return 1 if the file PRODUCT exists and has been computed with the
+   cache key KEY (as saved by pndrsBatchCacheSave in PRODUCT+".key").
+*/
+{
+  local f;
+  if ( !yocoTypeIsFile(product) ) return 0;
+  f = open(product+".key","r",1);
+  if ( !f ) return 0;
+  return ( rdline(f)==key );
+}
+
+func pndrsBatchCacheSave(product, key, files)
+/* DOCUMENT pndrsBatchCacheSave, product, key, files
+
+   DESCRIPTION
+   Save the cache KEY of PRODUCT in PRODUCT+".key", followed by the
+   names of the input FILES for information.
+*/
+{
+  local f;
+  f = create(product+".key");
+  write, f, format="%s\n", key;
+  write, f, format="%s\n", files(where(files!=string(0)));
+  close, f;
+}
+
+func pndrsBatchOiDataCacheKey(scienceFile, darkFile, matrixFile, specCalFile,
+                              scriptFile, mode, &files)
+/* DOCUMENT key = pndrsBatchOiDataCacheKey(scienceFile, darkFile, matrixFile,
+                                           specCalFile, scriptFile, mode, &files)
+
+   DESCRIPTION
+   Cache key of the OIDATA product of pndrsComputeAllOiData: it depends
+   on the science file, on the selected dark, kappa-matrix and spectral
+   calibration (if any), on the script file and on the mode.  The list
+   of these input files is returned in FILES.
+*/
+{
+  if ( is_void(specCalFile) ) specCalFile = string(0);
+  files = [scienceFile, darkFile, matrixFile, specCalFile, scriptFile];
+  return pndrsBatchCacheKey("pndrsComputeSingleOiData", files, mode);
+}
+
+/* ************************************************************ */
+
+/* Worker processes of the pndrsComputeAll* functions */
+struct struct_pndrsWorkers {
+  string  dir;    // directory of the claims (string(0) if sequential)
+  long    child;  // 1 in the worker processes
+  pointer pids;   // identifiers of the workers (in the main process)
+};
+
+func pndrsBatchWorkersStart(workers, dir)
+/* DOCUMENT run = pndrsBatchWorkersStart(workers, dir)
+
+   DESCRIPTION
+   Start WORKERS-1 worker processes (with Yeti's fork) for the loop of a
+   pndrsComputeAll* function.  All the processes, including the main
+   one, run the same loop and reduce the products they have claimed
+   first with pndrsBatchWorkersClaim, so the products are distributed
+   dynamically.  The claims are kept in a temporary sub-directory of
+   DIR.  pndrsBatchWorkersStop ends the worker processes at the end of
+   the loop and waits for them in the main process.
+
+   The reduction is sequential if WORKERS<=1, if fork is not available,
+   or if the plots are displayed (pndrsBatchPlotLevel==2).
+
+   SEE ALSO pndrsBatchWorkersClaim, pndrsBatchWorkersStop
+*/
+{
+  local run, pids, pid, w, k, d;
+  run = struct_pndrsWorkers();
+  if ( is_void(workers) || workers<=1 ) return run;
+  if ( !is_func(fork) ) {
+    yocoLogWarning,"No fork function (Yeti is needed), sequential reduction.";
+    return run;
+  }
+  if ( pndrsBatchPlotLevel==2 ) {
+    yocoLogWarning,"Plots are displayed, sequential reduction.";
+    return run;
+  }
+
+  /* Private directory of the claims */
+  for ( k=1 ; k<=100 ; k++ ) {
+    d = dir + swrite(format="/.pndrsClaims-%09d", long(1e9*random()));
+    if ( mkdir(d)==0 ) break;
+    d = [];
+  }
+  if ( is_void(d) ) {
+    yocoLogWarning,"Cannot create claims directory, sequential reduction.";
+    return run;
+  }
+  run.dir = d;
+
+  /* Fork the workers */
+  pids = array(long, workers-1);
+  for ( w=1 ; w<workers ; w++ ) {
+    pid = fork();
+    if ( pid==0 ) {
+      batch, 1;
+      run.child = 1;
+      return run;
+    }
+    pids(w) = pid;
+  }
+  run.pids = &pids;
+  yocoLogInfo,"Reduction distributed among "+pr1(workers)+" processes.";
+  return run;
+}
+
+func pndrsBatchWorkersClaim(run, i)
+/* DOCUMENT pndrsBatchWorkersClaim(run, i)
+
+   DESCRIPTION
+   Return 1 if the current process is the first one to claim the I-th
+   product of the loop (always 1 for a sequential reduction).
+*/
+{
+  if ( !run.dir ) return 1;
+  return ( mkdir(run.dir+"/"+pr1(i))==0 );
+}
+
+func pndrsBatchWorkersStop(run)
+/* DOCUMENT pndrsBatchWorkersStop, run
+
+   DESCRIPTION
+   Quit in a worker process, wait for the workers and remove the claims
+   in the main process.
+*/
+{
+  local pids, status, w, claims, k;
+  if ( run.child ) quit;
+  if ( !run.dir ) return;
+  pids = *run.pids;
+  for ( w=1 ; w<=numberof(pids) ; w++ ) {
+    status = waitpid(pids(w));
+    if ( status!=0 )
+      yocoLogWarning,"Worker process "+pr1(pids(w))+" exited with status "+
+        pr1(status);
+  }
+  claims = lsdir(run.dir);
+  for ( k=1 ; k<=numberof(claims) ; k++ ) rmdir, run.dir+"/"+claims(k);
+  rmdir, run.dir;
+}
+
 func pndrsBatchCreateDir(dir)
 {
   yocoLogTrace,"pndrsBatchCreateDir()";
@@ -364,6 +586,27 @@ func pndrsBatchFindBestDark(sciLog, allLog, &ids)
 
 /* *********************************************************** */
 
+func pndrsBatchEarlyDetector(inputScriptFile)
+/* DOCUMENT pndrsBatchEarlyDetector(inputScriptFile)
+
+   DESCRIPTION
+   Return 1 if the detector can be processed when reading the RAW files
+   (processDetector=1 of pndrsReadRawFiles) in pndrsComputeSingleOiData,
+   that is if there is no script file which could modify the raw data
+   before it is processed, and if the data are not simulated.
+
+   PARAMETERS
+   - inputScriptFile: script file of pndrsComputeSingleOiData.
+ */
+{
+  if ( yocoTypeIsStringScalar(inputScriptFile) &&
+       yocoTypeIsFile(inputScriptFile) ) return 0;
+  if ( strmatch(pndrsVersion,"sim") ) return 0;
+  return 1;
+}
+
+/* *********************************************************** */
+
 func pndrsGetCkSum(inputScriptFile)
 {
   return strtok( rdline(popen("cksum "+inputScriptFile,0),1)(1), " ", 3)(1);  
@@ -636,8 +879,8 @@ func pndrsComputeSingleMatrix(&matrix, &matLog,
 
 /* *********************************************************** */
 
-func pndrsComputeAllMatrix(inputDir=, overwrite=)
-/* DOCUMENT pndrsComputeAllMatrix(inputDir=, overwrite=)
+func pndrsComputeAllMatrix(inputDir=, overwrite=, cache=, workers=)
+/* DOCUMENT pndrsComputeAllMatrix(inputDir=, overwrite=, cache=, workers=)
 
    DESCRIPTION
    Compute all the kappa-matrix in inputDir.
@@ -646,14 +889,24 @@ func pndrsComputeAllMatrix(inputDir=, overwrite=)
 
    Results are stored in file: xxx_kappaMatrix.fits
    in an HDU called PNDRS_MATRIX.
+
+   PARAMETERS
+   - overwrite=1: re-compute existing matrices, otherwise skip them.
+   - cache=1: only re-compute the matrices which are not up to date,
+     that is whose input files (including the selected dark) have
+     changed since they were computed (see pndrsBatchCacheKey),
+     overwrite is then ignored.
+   - workers=N: distribute the matrices among N processes (see
+     pndrsBatchWorkersStart).
  */
 {
   yocoLogInfo,"pndrsComputeAllMatrix()";
   local oiLogDir, outputDir, mjd, shutters, i;
-  local tmp;
+  local tmp, run, key, inputFiles;
   
   /* Default */
   if ( is_void(overwrite) ) overwrite=0;
+  pndrsBatchCacheReset;
 
   /* Check the argument */
   if ( !pndrsCheckDirectory(inputDir,2) ) {
@@ -721,12 +974,16 @@ func pndrsComputeAllMatrix(inputDir=, overwrite=)
   /* Loop on matrix sequences */
   iMax = numberof(id);
   yocoLogInfo,"Number of matrix to be computed: "+pr1(iMax);
+  run = pndrsBatchWorkersStart(workers, outputDir);
   for ( i=1 ; i<=iMax ; i++)
     {
       /* Matrix files */
       ids = id(i) + indgen(0:nr-1);
       inputMatrixFiles = inputDir + oiLogDir(ids).fileName;
 
+      /* Each sequence is processed by a single process */
+      if ( !pndrsBatchWorkersClaim(run, i) ) continue;
+
       /* Catch errors */
       yocoLogInfo,"****";
       if ( catch(0x01+0x02+0x08) ) {
@@ -754,8 +1011,16 @@ func pndrsComputeAllMatrix(inputDir=, overwrite=)
       yocoFileSplitName, inputMatrixFiles(1), ,outputFile;
       outputFile   = outputDir + "/" + outputFile;
 
-      /* Skip if outputFile is already existing */
-      if ( overwrite==0 && yocoTypeIsFile( outputFile+"_kappaMatrix.fits" ) ) {
+      /* Skip if outputFile is already existing, or up to date */
+      inputFiles = grow(inputMatrixFiles, inputDarkFile);
+      if ( cache ) {
+        key = pndrsBatchCacheKey("pndrsComputeSingleMatrix", inputFiles);
+        if ( pndrsBatchCacheIsValid(outputFile+"_kappaMatrix.fits", key) ) {
+          yocoLogInfo,"reduced KAPPA_MATRIX file is up to date... skipped.";
+          continue;
+        }
+      }
+      else if ( overwrite==0 && yocoTypeIsFile( outputFile+"_kappaMatrix.fits" ) ) {
         yocoLogInfo,"reduced KAPPA_MATRIX file already exists... skipped.";
         continue;
       }
@@ -780,11 +1045,14 @@ func pndrsComputeAllMatrix(inputDir=, overwrite=)
         yocoLogWarning,"Cannot compute this matrix... skip it.";
         continue;
       }
+      if ( cache )
+        pndrsBatchCacheSave, outputFile+"_kappaMatrix.fits", key, inputFiles;
 
       /* End loop on kappa-matrix sequences */
       yocoLogInfo,"****";
       yocoLogSetFile;
     }
+  pndrsBatchWorkersStop, run;
   
   yocoLogTrace,"pndrsComputeAllMatrix done";
   return 1;
@@ -883,19 +1151,26 @@ func pndrsComputeSingleSpecCal(&oiWave, &specLog,
 
 /* *********************************************************** */
 
-func pndrsComputeAllSpecCal(inputDir=,overwrite=)
-/* DOCUMENT pndrsComputeAllSpecCal(inputDir=,overwrite=)
+func pndrsComputeAllSpecCal(inputDir=,overwrite=,cache=,workers=)
+/* DOCUMENT pndrsComputeAllSpecCal(inputDir=,overwrite=,cache=,workers=)
 
    DESCRIPTION
    Compute all the spectral calibration files of the input directory.
+
+   PARAMETERS
+   - overwrite=1: re-compute existing calibrations, otherwise skip them.
+   - cache=1: only re-compute the calibrations which are not up to date
+     (see pndrsComputeAllMatrix).
+   - workers=N: distribute the files among N processes.
 */
 {
   yocoLogInfo,"pndrsComputeAllSpecCal()";
   local oiLogDir, outputDir, mjd, shutters, i;
-  local tmp, success;
+  local tmp, success, run, key;
 
   /* Default */
   if ( is_void(overwrite) ) overwrite=0;
+  pndrsBatchCacheReset;
 
   /* Check the argument */
   if ( !pndrsCheckDirectory(inputDir,2) ) {
@@ -925,11 +1200,15 @@ func pndrsComputeAllSpecCal(inputDir=,overwrite=)
 
   /* Loop on spectral calibration files */
   iMax = numberof(id);
+  run = pndrsBatchWorkersStart(workers, outputDir);
   for ( i=1 ; i<=iMax ; i++)
     {
       /* Spectral calibration file */
       inputSpecCalFile = inputDir + oiLogDir(id(i)).fileName;
 
+      /* Each file is processed by a single process */
+      if ( !pndrsBatchWorkersClaim(run, i) ) continue;
+
       /* Catch errors */
       yocoLogInfo,"****";
       if ( catch(0x01+0x02+0x08) ) {
@@ -946,8 +1225,15 @@ func pndrsComputeAllSpecCal(inputDir=,overwrite=)
       yocoFileSplitName, inputSpecCalFile, ,outputFile;
       outputFile   = outputDir + "/" + outputFile;
 
-      /* Skip if outputFile is already existing */
-      if ( overwrite==0 && yocoTypeIsFile( outputFile+"_spectralCalib.fits" ) ) {
+      /* Skip if outputFile is already existing, or up to date */
+      if ( cache ) {
+        key = pndrsBatchCacheKey("pndrsComputeSingleSpecCal", inputSpecCalFile);
+        if ( pndrsBatchCacheIsValid(outputFile+"_spectralCalib.fits", key) ) {
+          yocoLogInfo,"reduced SPECTRAL_CALIBRATION file is up to date... skipped.";
+          continue;
+        }
+      }
+      else if ( overwrite==0 && yocoTypeIsFile( outputFile+"_spectralCalib.fits" ) ) {
         yocoLogInfo,"reduced SPECTRAL_CALIBRATION file already exists... skipped.";
         continue;
       }
@@ -967,11 +1253,14 @@ func pndrsComputeAllSpecCal(inputDir=,overwrite=)
         yocoLogWarning,"Cannot compute this specCal... skip it.";
         continue;
       }
+      if ( cache )
+        pndrsBatchCacheSave, outputFile+"_spectralCalib.fits", key, inputSpecCalFile;
 
       /* End loop on spectral calibs */
       yocoLogInfo,"****";
       yocoLogSetFile;
     }
+  pndrsBatchWorkersStop, run;
   
   yocoLogTrace,"pndrsComputeAllSpecCal done";
   return 1;
@@ -1060,9 +1349,14 @@ func pndrsComputeSingleOiData(&oiVis2, &oiT3, &oiVis, &oiWave,
   /* Read the KAPPA_MATRIX file */
   if( !pndrsReadKappaMatrix(matrix, inputMatrixFile=inputMatrixFile, readExtension=0) ) return 0;
 
+  /* Without script file, the detector is processed when reading the
+     files (possibly in advance, see pndrsPrefetchRawFiles) */
+  early = pndrsBatchEarlyDetector(inputScriptFile);
+
   /* Read the fringe file */
   yocoLogInfo,"Read the fringe file:", inputScienceFile;
-  if( !pndrsReadRawFiles(inputScienceFile, imgData, imgLog) ) return 0;
+  if( !pndrsReadRawFiles(inputScienceFile, imgData, imgLog,
+                         processDetector=early) ) return 0;
   if( !pndrsCheckOiLog(imgLog) ) return 0;
 
   /* Check the abcd mode, change to ac if not possible */
@@ -1077,7 +1371,8 @@ func pndrsComputeSingleOiData(&oiVis2, &oiT3, &oiVis, &oiWave,
 
   /* Read the dark file */
   yocoLogInfo,"Read the dark file:", inputDarkFile;
-  if( !pndrsReadRawFiles(inputDarkFile, darkData, darkLog) ) return 0;
+  if( !pndrsReadRawFiles(inputDarkFile, darkData, darkLog,
+                         processDetector=early) ) return 0;
   if( !pndrsCheckOiLog(darkLog) ) return 0;
 
   /* Associate the logs into a single array */
@@ -1105,8 +1400,10 @@ func pndrsComputeSingleOiData(&oiVis2, &oiT3, &oiVis, &oiWave,
   }
 
   /* Process detector */
-  if( !pndrsProcessDetector(imgData, imgLog) ) return 0;
-  if( !pndrsProcessDetector(darkData, imgLog) ) return 0;
+  if ( !early ) {
+    if( !pndrsProcessDetector(imgData, imgLog) ) return 0;
+    if( !pndrsProcessDetector(darkData, imgLog) ) return 0;
+  }
 
   /* Reform data */
   if( !pndrsReformData(imgData, imgLog) ) return 0;
@@ -1445,8 +1742,8 @@ func pndrsComputeSingleOiData(&oiVis2, &oiT3, &oiVis, &oiWave,
 
 /* ********************************************************************* */
 
-func pndrsComputeAllOiData(inputDir=, overwrite=, mode=, inspect=, inputScriptFile=)
-/* DOCUMENT pndrsComputeAllOiData(inputDir=, overwrite=, mode=, inspect=)
+func pndrsComputeAllOiData(inputDir=, overwrite=, mode=, inspect=, inputScriptFile=, prefetch=, cache=, workers=)
+/* DOCUMENT pndrsComputeAllOiData(inputDir=, overwrite=, mode=, inspect=, prefetch=, cache=, workers=)
 
    DESCRIPTION
    Run pndrsComputeSingleOiData in loop over all the observations contained
@@ -1460,9 +1757,20 @@ func pndrsComputeAllOiData(inputDir=, overwrite=, mode=, inspect=, inputScriptFi
    - inputDir: scalar string
    - mode="abcd", "ac", "abcdfaint", "abcdfaintnc"...
    - overwrite=1: re-compute existing OIFITS, otherwise skip (default is 0).
+   - prefetch=N: read (and process the detector of) the next RAW files
+     with N worker processes while the current observation is reduced,
+     see pndrsPrefetchRawFiles (default is 0, no prefetching).
+   - cache=1: only re-compute the OIFITS which are not up to date, that
+     is whose science file, selected dark, kappa-matrix or spectral
+     calibration, script file or mode have changed since they were
+     computed (see pndrsBatchOiDataCacheKey), overwrite is then ignored.
+   - workers=N: reduce the observations with N processes (see
+     pndrsBatchWorkersStart), prefetching is then disabled.
 
    EXAMPLES
    > pndrsComputeAllOiData, ".", overwrite=0, mode="abcd";
+   > pndrsComputeAllOiData, ".", mode="abcd", prefetch=2;
+   > pndrsComputeAllOiData, ".", mode="abcd", cache=1, workers=4;
  */
 {
   yocoLogInfo,"pndrsComputeAllOiData()";
@@ -1470,8 +1778,10 @@ func pndrsComputeAllOiData(inputDir=, overwrite=, mode=, inspect=, inputScriptFi
   local oiVis2, oiVis, oiT3, oiWave, oiLog, oiArray, oiTarget;
   local inputSpecCalFile, inputMatrixFiles, inputScienceFile;
   local oiLogCal, calibDir;
-  local fwhm, tau0;
+  local fwhm, tau0, pre, run, key, inputFiles, idc;
   if ( is_void(overwrite) ) overwrite=0;
+  if ( !is_void(workers) && workers>1 ) prefetch=0;
+  pndrsBatchCacheReset;
 
   /* Mode: "faint, bright, test" */
   if ( is_void(mode) ) mode="abcd";
@@ -1527,11 +1837,43 @@ func pndrsComputeAllOiData(inputDir=, overwrite=, mode=, inspect=, inputScriptFi
   }
 
   
-  /* Loop on science files */
+  /* Prefetch the science and dark files of the observations which will
+     be reduced, in the order they are read */
   iMax = numberof(idSci);
+  if ( prefetch ) {
+    pre = [];
+    for ( i=1 ; i<=iMax ; i++) {
+      ids = idSci(i);
+      yocoFileSplitName, oiLogDir(ids).fileName, ,outputFile;
+      outputFile = outputDir + "/" + outputFile + "_oidata.fits";
+      if ( !cache && overwrite==0 && yocoTypeIsFile(outputFile) ) continue;
+      if ( !pndrsBatchFindBestDark( oiLogDir(ids), oiLogDir, idm) ) continue;
+      if ( cache ) {
+        if ( !pndrsBatchFindBestMatrix(oiLogDir(ids), oiLogCal, idc) ) continue;
+        inputMatrixFile = calibDir + oiLogCal(idc).fileName;
+        inputSpecCalFile = [];
+        if ( pndrsBatchFindBestSpecCal(oiLogDir(ids), oiLogCal, idc) )
+          inputSpecCalFile = calibDir + oiLogCal(idc).fileName;
+        key = pndrsBatchOiDataCacheKey(inputDir + oiLogDir(ids).fileName,
+                                       inputDir + oiLogDir(idm).fileName,
+                                       inputMatrixFile, inputSpecCalFile,
+                                       inputScriptFile, mode);
+        if ( pndrsBatchCacheIsValid(outputFile, key) ) continue;
+      }
+      grow, pre, inputDir + oiLogDir([ids,idm]).fileName;
+    }
+    pndrsPrefetchRawFiles, pre, workers=prefetch,
+      processDetector=pndrsBatchEarlyDetector(inputScriptFile);
+  }
+
+  /* Loop on science files */
+  run = pndrsBatchWorkersStart(workers, outputDir);
   for ( i=1 ; i<=iMax ; i++)
     {
 
+      /* Each observation is reduced by a single process */
+      if ( !pndrsBatchWorkersClaim(run, i) ) continue;
+
       /* Catch errors: report it, close logging file,
          and continue with next file */
       yocoLogInfo,"****";
@@ -1559,8 +1901,9 @@ func pndrsComputeAllOiData(inputDir=, overwrite=, mode=, inspect=, inputScriptFi
       yocoFileSplitName, oiLogDir(ids).fileName, ,outputFile;
       outputFile   = outputDir + "/" + outputFile;
       
-      /* Skip if outputFile is already existing */
-      if ( overwrite==0 && yocoTypeIsFile( outputFile+"_oidata.fits" ) ) {
+      /* Skip if outputFile is already existing (up to date products
+         are only known once the calibrations have been selected) */
+      if ( !cache && overwrite==0 && yocoTypeIsFile( outputFile+"_oidata.fits" ) ) {
         yocoLogInfo,"reduced TARGET_OIDATA_RAW already exists (oidata.fits)... skipped.";
         continue;
       }
@@ -1613,6 +1956,18 @@ func pndrsComputeAllOiData(inputDir=, overwrite=, mode=, inspect=, inputScriptFi
       else {
         inputSpecCalFile = [];
       }
+
+      /* Skip if outputFile is up to date */
+      if ( cache ) {
+        key = pndrsBatchOiDataCacheKey(inputScienceFile, inputDarkFile,
+                                       inputMatrixFile, inputSpecCalFile,
+                                       inputScriptFile, mode, inputFiles);
+        if ( pndrsBatchCacheIsValid(outputFile+"_oidata.fits", key) ) {
+          yocoLogInfo,"reduced TARGET_OIDATA_RAW is up to date (oidata.fits)... skipped.";
+          yocoLogSetFile;
+          continue;
+        }
+      }
       
       /* Reduce these files */
       if ( !pndrsComputeSingleOiData(inputScienceFile=inputScienceFile,
@@ -1625,12 +1980,16 @@ func pndrsComputeAllOiData(inputDir=, overwrite=, mode=, inspect=, inputScriptFi
         yocoLogWarning,"Cannot reduce this file... skip it.";
         continue;
       }
+      if ( cache )
+        pndrsBatchCacheSave, outputFile+"_oidata.fits", key, inputFiles;
 
       /* Stop logging in file */
       yocoLogInfo,"****";
       yocoLogSetFile;
     }
+  pndrsBatchWorkersStop, run;
 
+  if ( prefetch ) pndrsPrefetchStop;
   yocoLogInfo,"pndrsComputeAllOiData done"; 
   return 1;
 
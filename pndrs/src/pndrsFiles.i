@@ -7,6 +7,7 @@ func pndrsFiles(void)
 
    USER ORIENTED FUNCTIONS:
    - pndrsReadRawFiles
+   - pndrsPrefetchRawFiles
    - pndrsReadClockPattern
 
    SPECIFIC FUNCTIONS:
@@ -1076,6 +1077,163 @@ func pndrsCheckOiLog(&oiLog)
 
 /* ********************************************************* */
 
+func pndrsReadRawFile(file, &_imgData, &_imgLog, processDetector=)
+/* DOCUMENT pndrsReadRawFile(file, &imgData, &imgLog, processDetector=)
+
+   DESCRIPTION
+   Read a single RAW PIONIER FITS file and fill the structures imgData
+   and imgLog (the logId is not set).  This is the part of
+   pndrsReadRawFiles which is done for each file, possibly by the
+   prefetching workers (see pndrsPrefetchRawFiles).
+
+   PARAMETERS:
+   - file : file to be read
+   - processDetector=1, run pndrsProcessDetector on the data.
+
+   SEE ALSO pndrsReadRawFiles, pndrsPrefetchRawFiles
+*/
+{
+  local fh, y0, mjd, nd, woll, prism, dy, x0, lopd, opd;
+
+  /* Read the file */
+  fh = cfitsio_open( file );
+  _imgLog  = pndrsReadPnrLog(fh);
+  _imgData = imgFitsReadImgData(fh,force_array=1);
+  cfitsio_close_file, fh;
+
+  /* If MJD-OBS available in header, recompute the MJD
+     Recombpute MJD for data (FIXME: bug in PIONIER OS) */
+  if ( _imgData.mjdObs > 55000.0 ) {
+    mjd = *_imgData.time;
+    // mjd = ( mjd - median(mjd) ) + _imgData.mjdObs;
+    mjd = ( mjd - mjd(1) ) + _imgData.mjdObs;
+    _imgData.time = &(mjd);
+  }
+
+  /* eventually already process the detector, to save memory space */
+  if (processDetector) {
+    pndrsProcessDetector, _imgData, _imgLog;
+  }
+
+  /* Find the correlation map,
+     Case ABCD or AC beam combiner in H-band
+     Also deal with the polarisation. */
+  y0   = pndrsParseSubwin(_imgLog.detSubwin1)(0);
+  woll = pndrsGetWoll(_imgLog);
+
+  /* Determine the number of DARK window,
+     in the case of RAPID detector generaly */
+  nd = (_imgLog.detSubwins % 12);
+  yocoLogTrace,"Number of DARK window: "+pr1(nd);
+  _imgLog.nbDarkWins = nd;
+  
+  if ( _imgLog.obc == string() || _imgLog.obc == "" ||
+       strmatch(_imgLog.obc,"ABCD-H") ) {
+    if (_imgLog.detSubwins == (24+nd) && woll=="FREE") {
+      _imgLog.correlation = &mapABCD_H; }
+    else if (_imgLog.detSubwins == (48+nd) && woll=="WOLL")
+      _imgLog.correlation = &mapABCD_Hpol;
+    else if (_imgLog.detSubwins == (24+nd) && woll=="WOLL" && y0 >= _imgLog.detYref)
+      _imgLog.correlation = &mapABCD_Hup;
+    else if (_imgLog.detSubwins == (24+nd) && woll=="WOLL" && y0 < _imgLog.detYref)
+      _imgLog.correlation = &mapABCD_Hdown;
+    else if (_imgLog.detSubwins == (12+nd) && woll=="FREE")
+      _imgLog.correlation = &mapABCD_H_AC;
+    else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && y0 >= _imgLog.detYref)
+      _imgLog.correlation = &mapABCD_H_ACup;
+    else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && y0 < _imgLog.detYref)
+    _imgLog.correlation = &mapABCD_H_ACdown;
+  }
+  else if ( strmatch(_imgLog.obc,"AC-H") &&
+            strmatch(_imgLog.detName,"RAPID") ) {
+    x0   = pndrsParseSubwin(_imgLog.detSubwin1)(0);
+    if (_imgLog.detSubwins == (12+nd) && woll=="FREE")
+      _imgLog.correlation = &(mapACbeti_H);
+    else if (_imgLog.detSubwins == (24+nd) && woll=="WOLL")
+      _imgLog.correlation = &(mapACbeti_Hpol);
+    else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && x0 >= _imgLog.detXref)
+      _imgLog.correlation = &(mapACbeti_Hup);
+    else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && x0 < _imgLog.detXref)
+      _imgLog.correlation = &(mapACbeti_Hdown);
+  }
+  else if ( strmatch(_imgLog.obc,"AC-H") ) {
+    if (_imgLog.detSubwins == (12+nd) && woll=="FREE")
+      _imgLog.correlation = &mapAC_H;
+    else if (_imgLog.detSubwins == (24+nd) && woll=="WOLL")
+      _imgLog.correlation = &mapAC_Hpol;
+    else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && y0 >= _imgLog.detYref)
+      _imgLog.correlation = &mapAC_Hup;
+    else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && y0 < _imgLog.detYref)
+      _imgLog.correlation = &mapAC_Hdown;
+  }
+  else if ( strmatch(_imgLog.obc,"ABCD-K") ) {
+    if (_imgLog.detSubwins == (24+nd) && woll=="FREE")
+      _imgLog.correlation = &mapABCD_K;
+    else if (_imgLog.detSubwins == (48+nd) && woll=="WOLL")
+      _imgLog.correlation = &mapABCD_Kpol;
+    else if (_imgLog.detSubwins == (24+nd) && woll=="WOLL" && y0 >= _imgLog.detYref)
+      _imgLog.correlation = &mapABCD_Kup;
+    else if (_imgLog.detSubwins == (24+nd) && woll=="WOLL" && y0 < _imgLog.detYref)
+      _imgLog.correlation = &mapABCD_Kdown;
+    else if (_imgLog.detSubwins == (12+nd) && woll=="FREE")
+      _imgLog.correlation = &mapABCD_K_AC;
+    else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && y0 >= _imgLog.detYref)
+      _imgLog.correlation = &mapABCD_K_ACup;
+    else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && y0 < _imgLog.detYref)
+    _imgLog.correlation = &mapABCD_K_ACdown;
+  }
+
+  /* If correlation in not known */
+  if (is_void( *_imgLog.correlation )) {
+    yocoLogWarning,"Cannot recover the correlation map.";
+    yocoLogInfo,"detSubwins="+pr1(_imgLog.detSubwins);
+    yocoLogInfo,"nDarkWin="+pr1(nd);
+    yocoLogInfo,"obc="+pr1(_imgLog.obc);
+    yocoLogInfo,"detName="+pr1(_imgLog.detName);
+  }
+
+  /* Hack for the case of observation with SMALL but with
+     the 7-channels, not SMALL-3 */
+  prism = pndrsGetPrism(_imgLog);
+  dy = pndrsParseSubwin(_imgLog.detSubwin1)(2);
+  if (prism=="SMALL" && dy==7) {
+    yocoLogWarning,"SMALL prism with 7 channels -> replaced by SMALL-3";
+    _imgData.regdata = &( (*_imgData.regdata)(,3:5,) );
+  }
+
+  /* Hack for the data from IPAG */
+  if ( strmatch(_imgLog.detName,"RAPID") && _imgLog.origin=="TEST"  ) {
+    yocoLogInfo,"Change target to INTERNAL";
+    _imgLog.target="INTERNAL";
+  }
+
+  /* Hack the LOCALOPD which was stored in OPD before 2015-08-25.
+     Thus swap them. The correct place is LOCALOPD. */
+  if ( _imgLog.mjdObs < 57261.9 || _imgLog.instrument == "BETI") {
+    yocoLogTrace,"LOCALOPD was stored in OPD";
+    lopd = _imgData.localopd;
+    opd  = _imgData.opd;
+    _imgData.localopd = opd;
+    _imgData.opd = lopd;
+  } else {
+    yocoLogTrace,"LOCALOPD is now stored in LOCALOPD";
+  }
+
+  /* Test LOCALOPD */
+  if ( max(*_imgData.localopd)==0 )
+    yocoLogWarning,"LOCALOPD is zero.";
+  
+  /* Simulate DATA */
+  if ( strmatch( pndrsVersion,"sim") ) {
+    yocoLogWarning,"!!! SIMULATE DATA !!!";
+    pndrsSimImgData, _imgData, _imgLog;
+  }
+
+  return 1;
+}
+
+/* ********************************************************* */
+
 func pndrsReadRawFiles(files, &imgData, &imgLog, append=, processDetector=)
 /* DOCUMENT pndrsReadRawFiles(files, &imgData, &imgLog, append=, processDetector=)
 
@@ -1123,144 +1281,15 @@ func pndrsReadRawFiles(files, &imgData, &imgLog, append=, processDetector=)
     if (_yocoLogLevel>1 && n>1)
     write,format="\r read file %i over %i",i,n;
 
-    /* read the file  */
-    fh = cfitsio_open( files(i) );
-    _imgLog  = pndrsReadPnrLog(fh);
-    _imgData = imgFitsReadImgData(fh,force_array=1);
-    cfitsio_close_file, fh;
-
-    /* If MJD-OBS available in header, recompute the MJD
-       Recombpute MJD for data (FIXME: bug in PIONIER OS) */
-    if ( _imgData.mjdObs > 55000.0 ) {
-      mjd = *_imgData.time;
-      // mjd = ( mjd - median(mjd) ) + _imgData.mjdObs;
-      mjd = ( mjd - mjd(1) ) + _imgData.mjdObs;
-      _imgData.time = &(mjd);
-    }
-
-    /* eventually already process the detector, to save memory space */
-    if (processDetector) {
-      pndrsProcessDetector, _imgData, _imgLog;
-    }
+    /* read the file, or take it from the prefetching workers */
+    if ( !_pndrsPrefetchTake(files(i), processDetector, _imgData, _imgLog) &&
+         !pndrsReadRawFile(files(i), _imgData, _imgLog,
+                           processDetector=processDetector) ) continue;
 
     /* ensure logId is unique and grow */
     _imgLog.logId  = ( is_array(imgLog) ? max(imgLog.logId) : 0 ) + 1;
     _imgData.hdr.logId  = _imgLog.logId;
 
-    /* Find the correlation map,
-       Case ABCD or AC beam combiner in H-band
-       Also deal with the polarisation. */
-    y0   = pndrsParseSubwin(_imgLog.detSubwin1)(0);
-    woll = pndrsGetWoll(_imgLog);
-
-    /* Determine the number of DARK window,
-       in the case of RAPID detector generaly */
-    nd = (_imgLog.detSubwins % 12);
-    yocoLogTrace,"Number of DARK window: "+pr1(nd);
-    _imgLog.nbDarkWins = nd;
-    
-    if ( _imgLog.obc == string() || _imgLog.obc == "" ||
-         strmatch(_imgLog.obc,"ABCD-H") ) {
-      if (_imgLog.detSubwins == (24+nd) && woll=="FREE") {
-        _imgLog.correlation = &mapABCD_H; }
-      else if (_imgLog.detSubwins == (48+nd) && woll=="WOLL")
-        _imgLog.correlation = &mapABCD_Hpol;
-      else if (_imgLog.detSubwins == (24+nd) && woll=="WOLL" && y0 >= _imgLog.detYref)
-        _imgLog.correlation = &mapABCD_Hup;
-      else if (_imgLog.detSubwins == (24+nd) && woll=="WOLL" && y0 < _imgLog.detYref)
-        _imgLog.correlation = &mapABCD_Hdown;
-      else if (_imgLog.detSubwins == (12+nd) && woll=="FREE")
-        _imgLog.correlation = &mapABCD_H_AC;
-      else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && y0 >= _imgLog.detYref)
-        _imgLog.correlation = &mapABCD_H_ACup;
-      else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && y0 < _imgLog.detYref)
-      _imgLog.correlation = &mapABCD_H_ACdown;
-    }
-    else if ( strmatch(_imgLog.obc,"AC-H") &&
-              strmatch(_imgLog.detName,"RAPID") ) {
-      x0   = pndrsParseSubwin(_imgLog.detSubwin1)(0);
-      if (_imgLog.detSubwins == (12+nd) && woll=="FREE")
-        _imgLog.correlation = &(mapACbeti_H);
-      else if (_imgLog.detSubwins == (24+nd) && woll=="WOLL")
-        _imgLog.correlation = &(mapACbeti_Hpol);
-      else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && x0 >= _imgLog.detXref)
-        _imgLog.correlation = &(mapACbeti_Hup);
-      else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && x0 < _imgLog.detXref)
-        _imgLog.correlation = &(mapACbeti_Hdown);
-    }
-    else if ( strmatch(_imgLog.obc,"AC-H") ) {
-      if (_imgLog.detSubwins == (12+nd) && woll=="FREE")
-        _imgLog.correlation = &mapAC_H;
-      else if (_imgLog.detSubwins == (24+nd) && woll=="WOLL")
-        _imgLog.correlation = &mapAC_Hpol;
-      else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && y0 >= _imgLog.detYref)
-        _imgLog.correlation = &mapAC_Hup;
-      else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && y0 < _imgLog.detYref)
-        _imgLog.correlation = &mapAC_Hdown;
-    }
-    else if ( strmatch(_imgLog.obc,"ABCD-K") ) {
-      if (_imgLog.detSubwins == (24+nd) && woll=="FREE")
-        _imgLog.correlation = &mapABCD_K;
-      else if (_imgLog.detSubwins == (48+nd) && woll=="WOLL")
-        _imgLog.correlation = &mapABCD_Kpol;
-      else if (_imgLog.detSubwins == (24+nd) && woll=="WOLL" && y0 >= _imgLog.detYref)
-        _imgLog.correlation = &mapABCD_Kup;
-      else if (_imgLog.detSubwins == (24+nd) && woll=="WOLL" && y0 < _imgLog.detYref)
-        _imgLog.correlation = &mapABCD_Kdown;
-      else if (_imgLog.detSubwins == (12+nd) && woll=="FREE")
-        _imgLog.correlation = &mapABCD_K_AC;
-      else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && y0 >= _imgLog.detYref)
-        _imgLog.correlation = &mapABCD_K_ACup;
-      else if (_imgLog.detSubwins == (12+nd) && woll=="WOLL" && y0 < _imgLog.detYref)
-      _imgLog.correlation = &mapABCD_K_ACdown;
-    }
-
-    /* If correlation in not known */
-    if (is_void( *_imgLog.correlation )) {
-      yocoLogWarning,"Cannot recover the correlation map.";
-      yocoLogInfo,"detSubwins="+pr1(_imgLog.detSubwins);
-      yocoLogInfo,"nDarkWin="+pr1(nd);
-      yocoLogInfo,"obc="+pr1(_imgLog.obc);
-      yocoLogInfo,"detName="+pr1(_imgLog.detName);
-    }
-
-    /* Hack for the case of observation with SMALL but with
-       the 7-channels, not SMALL-3 */
-    prism = pndrsGetPrism(_imgLog);
-    dy = pndrsParseSubwin(_imgLog.detSubwin1)(2);
-    if (prism=="SMALL" && dy==7) {
-      yocoLogWarning,"SMALL prism with 7 channels -> replaced by SMALL-3";
-      _imgData.regdata = &( (*_imgData.regdata)(,3:5,) );
-    }
-
-    /* Hack for the data from IPAG */
-    if ( strmatch(_imgLog.detName,"RAPID") && _imgLog.origin=="TEST"  ) {
-      yocoLogInfo,"Change target to INTERNAL";
-      _imgLog.target="INTERNAL";
-    }
-
-    /* Hack the LOCALOPD which was stored in OPD before 2015-08-25.
-       Thus swap them. The correct place is LOCALOPD. */
-    if ( _imgLog.mjdObs < 57261.9 || _imgLog.instrument == "BETI") {
-      yocoLogTrace,"LOCALOPD was stored in OPD";
-      lopd = _imgData.localopd;
-      opd  = _imgData.opd;
-      _imgData.localopd = opd;
-      _imgData.opd = lopd;
-    } else {
-      yocoLogTrace,"LOCALOPD is now stored in LOCALOPD";
-    }
-
-    /* Test LOCALOPD */
-    if ( max(*_imgData.localopd)==0 )
-      yocoLogWarning,"LOCALOPD is zero.";
-    
-    /* Simulate DATA */
-    if ( strmatch( pndrsVersion,"sim") ) {
-      yocoLogWarning,"!!! SIMULATE DATA !!!";
-      pndrsSimImgData, _imgData, _imgLog;
-    }
-
     /* Append to already load data */
     grow, imgLog, _imgLog;
     grow, imgData, _imgData;
@@ -1281,6 +1310,252 @@ func pndrsReadRawFiles(files, &imgData, &imgLog, append=, processDetector=)
   yocoLogTrace,"pndrsReadRawFiles done";
   return 1;
 }
+
+/* ********************************************************* */
+
+/* Queue of the prefetched RAW files: name of the files, flag for
+   processDetector, pid of the workers (0 if not yet started) and name
+   of the spool files. */
+_pndrsPrefetchFiles = _pndrsPrefetchFlags = [];
+_pndrsPrefetchPids = _pndrsPrefetchSpool = [];
+_pndrsPrefetchWorkers = 0;
+_pndrsPrefetchDir = [];
+
+func pndrsPrefetchRawFiles(files, workers=, processDetector=, spoolDir=)
+/* DOCUMENT pndrsPrefetchRawFiles(files, workers=, processDetector=, spoolDir=)
+
+   DESCRIPTION
+   Announce that the RAW PIONIER FITS files will be read, in this order,
+   by pndrsReadRawFiles.  A pool of worker processes (forked with
+   Yeti's fork) reads the next files, and processes the detector if
+   processDetector=1, while the main process is busy with the current
+   one.  The results are passed back through binary files in a spool
+   directory (in shared memory if /dev/shm exists), their log messages
+   are replayed when the file is taken by pndrsReadRawFiles.
+
+   A file is only taken from the workers by pndrsReadRawFiles when it
+   is the next one (or a later one) in the list and is read with the
+   same processDetector flag.  Files which are passed over are
+   discarded, and if a worker fails the file is simply read again by
+   the main process, so the results never depend on the prefetching.
+   Calling pndrsPrefetchRawFiles again, or with no files, first
+   terminates the pending prefetching (see pndrsPrefetchStop).
+
+   PARAMETERS:
+   - files : list of files to be read in the future.
+   - workers= : number of worker processes, which is also the number of
+     files read in advance (default 2).
+   - processDetector=1, run pndrsProcessDetector in the workers (the
+     files must then be read with processDetector=1).
+   - spoolDir= : directory for the spool files.
+
+   RETURN 1 if the prefetching is active, 0 otherwise.
+
+   EXAMPLES
+   > pndrsPrefetchRawFiles, files, workers=3;
+   > for (i=1;i<=numberof(files);i++) {
+   >   pndrsReadRawFiles, files(i), imgData, imgLog;
+   >   ...
+   > }
+   > pndrsPrefetchStop;
+
+   SEE ALSO pndrsReadRawFiles, pndrsPrefetchStop, fork
+*/
+{
+  extern _pndrsPrefetchFiles, _pndrsPrefetchFlags, _pndrsPrefetchPids;
+  extern _pndrsPrefetchSpool, _pndrsPrefetchWorkers, _pndrsPrefetchDir;
+  local dir, k;
+
+  pndrsPrefetchStop;
+  if ( is_void(workers) ) workers = 2;
+  if ( numberof(files)<1 || workers<1 ) return 0;
+  if ( !is_func(fork) ) {
+    yocoLogWarning,"No fork function (Yeti is needed), no prefetching.";
+    return 0;
+  }
+
+  /* Create a private spool directory */
+  if ( is_void(spoolDir) )
+    spoolDir = ( typeof(lsdir("/dev/shm"))!="long" ? "/dev/shm/" :
+                 ( get_env("TMPDIR") ? get_env("TMPDIR") : "/tmp" ) );
+  if ( strpart(spoolDir,0:0)!="/" ) spoolDir += "/";
+  for ( k=1 ; k<=100 ; k++ ) {
+    dir = spoolDir + swrite(format="pndrs-prefetch-%09d",
+                            long(1e9*random()));
+    if ( mkdir(dir)==0 ) break;
+    dir = [];
+  }
+  if ( is_void(dir) ) {
+    yocoLogWarning,"Cannot create spool directory in "+spoolDir+
+      ", no prefetching.";
+    return 0;
+  }
+
+  _pndrsPrefetchDir     = dir;
+  _pndrsPrefetchWorkers = long(workers);
+  _pndrsPrefetchFiles   = files(*);
+  _pndrsPrefetchFlags   = array((processDetector ? 1 : 0), numberof(files));
+  _pndrsPrefetchPids    = array(long, numberof(files));
+  _pndrsPrefetchSpool   = swrite(format=dir+"/%d", indgen(numberof(files)));
+  yocoLogInfo,"Prefetch "+pr1(numberof(files))+" RAW files with "+
+    pr1(workers)+" worker(s).";
+  _pndrsPrefetchLaunch;
+  return 1;
+}
+
+func pndrsPrefetchStop(void)
+/* DOCUMENT pndrsPrefetchStop
+
+   DESCRIPTION
+   Wait for the prefetching workers which are still running, discard
+   the files they have read and remove the spool directory.
+
+   SEE ALSO pndrsPrefetchRawFiles
+*/
+{
+  extern _pndrsPrefetchFiles, _pndrsPrefetchFlags, _pndrsPrefetchPids;
+  extern _pndrsPrefetchSpool, _pndrsPrefetchDir;
+  _pndrsPrefetchDrop, numberof(_pndrsPrefetchFiles);
+  if ( !is_void(_pndrsPrefetchDir) ) rmdir, _pndrsPrefetchDir;
+  _pndrsPrefetchFiles = _pndrsPrefetchFlags = [];
+  _pndrsPrefetchPids = _pndrsPrefetchSpool = [];
+  _pndrsPrefetchDir = [];
+}
+
+func _pndrsPrefetchLaunch(void)
+/* DOCUMENT _pndrsPrefetchLaunch
+
+   DESCRIPTION
+   Start workers for the next files of the queue, so that at most
+   _pndrsPrefetchWorkers are running.  The worker reads the file with
+   pndrsReadRawFile, saves the result in the spool file and quits; its
+   log messages are kept in the spool file with ".log" appended.
+*/
+{
+  extern _pndrsPrefetchFiles, _pndrsPrefetchFlags, _pndrsPrefetchPids;
+  extern _pndrsPrefetchSpool, _pndrsPrefetchWorkers;
+  extern _yocoLogInTerm;
+  local k, pid, _imgData, _imgLog;
+
+  for ( k=1 ; k<=numberof(_pndrsPrefetchFiles) ; k++ ) {
+    if ( _pndrsPrefetchPids(k)!=0 ) continue;
+    if ( numberof(where(_pndrsPrefetchPids>0))>=_pndrsPrefetchWorkers ) break;
+
+    pid = fork();
+    if ( pid==0 ) {
+      /* Worker process: any error terminates it */
+      batch, 1;
+      yocoLogSetFile, _pndrsPrefetchSpool(k)+".log", overwrite=1;
+      _yocoLogInTerm = _pndrsPrefetchNoTerm;
+      if ( pndrsReadRawFile(_pndrsPrefetchFiles(k), _imgData, _imgLog,
+                            processDetector=_pndrsPrefetchFlags(k)) )
+        _pndrsPrefetchSave, _pndrsPrefetchSpool(k), _imgData, _imgLog;
+      quit;
+    }
+    _pndrsPrefetchPids(k) = pid;
+  }
+}
+
+func _pndrsPrefetchNoTerm(str) { }
+
+func _pndrsPrefetchSave(file, imgData, imgLog)
+{
+  local f, s, i;
+  f = createb(file+".tmp");
+  /* The structures of the pointees must be installed in the file */
+  for ( i=1 ; i<=numberof(imgLog) ; i++ ) {
+    if ( is_array(*imgLog(i).correlation) ) {
+      s = structof(*imgLog(i).correlation);
+      save, f, s;
+    }
+  }
+  save, f, imgData, imgLog;
+  close, f;
+  rename, file+".tmp", file;
+}
+
+func _pndrsPrefetchDrop(n)
+/* DOCUMENT _pndrsPrefetchDrop, n
+
+   DESCRIPTION
+   Remove the N first files of the queue, waiting for their workers
+   and removing their spool files.
+*/
+{
+  extern _pndrsPrefetchFiles, _pndrsPrefetchFlags, _pndrsPrefetchPids;
+  extern _pndrsPrefetchSpool;
+  local k;
+  for ( k=1 ; k<=n ; k++ ) {
+    if ( _pndrsPrefetchPids(k)>0 ) {
+      waitpid, _pndrsPrefetchPids(k);
+      remove, _pndrsPrefetchSpool(k);
+      remove, _pndrsPrefetchSpool(k)+".tmp";
+      remove, _pndrsPrefetchSpool(k)+".log";
+    }
+  }
+  if ( n<numberof(_pndrsPrefetchFiles) ) {
+    _pndrsPrefetchFiles = _pndrsPrefetchFiles(n+1:);
+    _pndrsPrefetchFlags = _pndrsPrefetchFlags(n+1:);
+    _pndrsPrefetchPids  = _pndrsPrefetchPids(n+1:);
+    _pndrsPrefetchSpool = _pndrsPrefetchSpool(n+1:);
+  } else {
+    _pndrsPrefetchFiles = _pndrsPrefetchFlags = [];
+    _pndrsPrefetchPids = _pndrsPrefetchSpool = [];
+  }
+}
+
+func _pndrsPrefetchTake(file, processDetector, &imgData, &imgLog)
+/* DOCUMENT _pndrsPrefetchTake(file, processDetector, &imgData, &imgLog)
+
+   DESCRIPTION
+   Take FILE from the prefetching workers: wait for the worker, restore
+   the structures imgData and imgLog from its spool file and replay its
+   log messages.  Return 1 on success, 0 if FILE has not been prefetched
+   (it must then be read by pndrsReadRawFile).
+*/
+{
+  extern _pndrsPrefetchFiles, _pndrsPrefetchFlags, _pndrsPrefetchPids;
+  extern _pndrsPrefetchSpool;
+  local k, f, flag, line, spool, status, ok;
+
+  if ( !numberof(_pndrsPrefetchFiles) ) return 0;
+  flag = (processDetector ? 1 : 0);
+  k = where(_pndrsPrefetchFiles==file & _pndrsPrefetchFlags==flag);
+  if ( !numberof(k) ) return 0;
+  k = k(1);
+
+  /* Files before this one will not be taken */
+  _pndrsPrefetchDrop, k-1;
+  ok = 0;
+  if ( _pndrsPrefetchPids(1)>0 ) {
+    spool  = _pndrsPrefetchSpool(1);
+    status = waitpid(_pndrsPrefetchPids(1));
+    _pndrsPrefetchPids(1) = -1;
+    if ( status==0 && open(spool,"rb",1) ) {
+      f = openb(spool);
+      restore, f, imgData, imgLog;
+      close, f;
+      ok = 1;
+    } else {
+      yocoLogWarning,"Prefetching failed (status "+pr1(status)+
+        "), read the file again.";
+    }
+    f = open(spool+".log","r",1);
+    if ( ok && f ) {
+      while ( (line = rdline(f)) ) {
+        _yocoLogInTerm, line;
+        _yocoLogInFile, line;
+      }
+    }
+    f = [];
+    remove, spool;
+    remove, spool+".tmp";
+    remove, spool+".log";
+  }
+  _pndrsPrefetchDrop, 1;
+  _pndrsPrefetchLaunch;
+  return ok;
+}
 /* ********************************************************* */
 
 func pndrsReadKappaMatrix(&matrix, &sig2matrix, &matrixRaw, &sig2matrixRaw,
@@ -1092,7 +1092,7 @@ func pndrsComputeCoherentFluxMatrix(imgData, matrix, &imgLog, &coherData, &flux,
 */
 {
   yocoLogInfo,"pndrsComputeCoherentFluxMatrix()";
-  local i, data, id, nbase, opd, map, out;
+  local i, data, id, nbase, opd, map, out, p2vm;
   local dataC, dataI, coher, incoh, olog, t1, t2;
   extern pndrsFilterWide;
 
@@ -1142,11 +1142,13 @@ func pndrsComputeCoherentFluxMatrix(imgData, matrix, &imgLog, &coherData, &flux,
   }
 
   /* Solve to estimate telescopes fluxes and coherent fluxes.
-     This is done independently for each channel */
-  out  = array(0.0,nlbd,nstep,nscan,ntel+2*nbase);
+     This is done independently for each channel: the least-square
+     inverse of the v2pm is applied to all the samples */
+  p2vm = array(0.0,nlbd,ntel+2*nbase,nwin);
   for(i=1;i<=nlbd;i++) {
-    out(i,) = QRsolve(v2pm(i,,),data(i,),which=0);
+    p2vm(i,,) = QRsolve(v2pm(i,,),unit(nwin));
   }
+  out = pndrsSignalApplyMatrix(p2vm, data);
 
   /* Get telescope fluxes and coherent fluxes.
      These are part of the output vector */
@@ -1166,9 +1168,7 @@ func pndrsComputeCoherentFluxMatrix(imgData, matrix, &imgLog, &coherData, &flux,
 
   /* Computation of the flux per win by
      re-injecting the input fluxes into the v2pm */
-  cont = array(0.0,nlbd,nstep,nscan,nwin);
-  for(i=1;i<=nlbd;i++)
-    cont(i,) = flux(i,,,+) * (v2pm(i,,1:ntel))(,+);
+  cont = pndrsSignalApplyMatrix(v2pm(,,1:ntel), flux);
 
   /* Default gui */
   if (gui && pndrsBatchPlotLevel) {
@@ -1610,13 +1610,9 @@ func pndrsScanComputeClosurePhases(coherData, imgLog, norm2, pos, &oiT3, &clo, &
             grow, polId, p;
           }
 
-  /* Compute the bispectrum (x,y,nopd,nscan,closure) */
-  d = dimsof(data);
-  bispectrum = dataf(,,,baseId(1,)) * dataf(,,,baseId(2,)) * conj( dataf(,,,baseId(3,)) );
-
-  /* Average over the opds. Now dimension is
-     [lbd, scan, bispectrum]   */
-  bispectrum  = bispectrum(,avg,,);
+  /* Compute the bispectrum averaged over the opds.
+     Dimension is [lbd, scan, bispectrum]   */
+  bispectrum = pndrsSignalBispectrum(dataf, baseId);
 
   /* Compute the phase average and errors */
   pndrsSignalComputePhase, bispectrum,
@@ -1626,9 +1622,7 @@ func pndrsScanComputeClosurePhases(coherData, imgLog, norm2, pos, &oiT3, &clo, &
   opd = opd - opd(avg,-,) - pos(-,);
   env = exp(- (pi*opd(-,)/lbd0^2*lbdB)^2 / 5.0);
   norm2env = env^2 * norm2;
-  bispnorm = sqrt(abs(norm2env(,,,baseId(1,)) * norm2env(,,,baseId(2,)) *
-                      norm2env(,,,baseId(3,))));
-  bispnorm = bispnorm(,avg,,);
+  bispnorm = pndrsSignalBispectrum(norm2env, baseId);
 
   /* Use a coherent estimator for the bispectrum */
   bispectrum_re = ( bispectrum * exp( -2.i*pi * clo(,-,) / 360.0 ) ).re;
@@ -2009,6 +2003,7 @@ func pndrsScanComputeOpdAbcd(coherData, &imgLog, &pos, &snr, &snr0, gui=, useFil
 {
   local data, opd, map, ft, freq, df, nbase, posAvg, olog, delta;
   local snr0, pos0, id, i, b, b1, b2, b3, x, y, dist, id0, filtIn, opdRef;
+  local spec;
   yocoLogInfo,"pndrsScanComputeOpdAbcd()";
   
   /* Currently not support arrays */
@@ -2036,14 +2031,7 @@ func pndrsScanComputeOpdAbcd(coherData, &imgLog, &pos, &snr, &snr0, gui=, useFil
   if ( is_void(weight) ) weight = array(1.0,nlbd);
   weight /= weight(sum);
   yocoLogInfo," weighted average over lbd", weight;
-  ft = (ft*weight)(sum,);
-  
-  /* PSD */
-  psd0 = power(ft);
-
-  /* The PSD of the BIAS is estimated with the opposite frequencies */
-  psdbias = psd0;
-  psdbias(2:,,) = psdbias(:2:-1,,);
+  ft = ft(+,..) * weight(+);
 
   /* Get the frequencies step and direction, then norm only
      We use abs(df) and not df because FFT is "re-ordered".
@@ -2087,17 +2075,20 @@ func pndrsScanComputeOpdAbcd(coherData, &imgLog, &pos, &snr, &snr0, gui=, useFil
     filtInP  = (freq>filtIn(1,-,))  & (freq<filtIn(2,-,));
   }
   
+  /* Power, power of the BIAS (estimated with the opposite
+     frequencies) and cross-spectrum of the filtered FFT */
+  spec = pndrsSignalSpectrum(ft(-,..), filtInP(-,..))(,1,,);
+
   /* Piston with the IOTA method (validated), using integration of
      cross-spectrum of filtered FFT */
-  fftIn = ft*filtInP(,-,);
-  pos   = -(fftIn(1:-1,,) * conj(fftIn(2:0,,)))(sum,,);
+  pos   = -(spec(3,,) + 1.i*spec(4,,));
   pos   = oiFitsArg(pos) / (2.*pi * df);
   
   /* Power in the signal and in the noise.
      For the noise, we use the average power as it seems
      to stabilise the SNR at low flux */
-  in  = (psd0*filtInP(,-,))(sum,,);
-  out = average( (psdbias*filtInP(,-,))(sum,), 1)(-,);
+  in  = spec(1,,);
+  out = average( spec(2,,), 1)(-,);
 
   /* SNR as averaged power ratio */
   snr = in / (out + 1e-10);
@@ -3070,6 +3061,7 @@ func pndrsScanComputeAmp2PerScanAbcd(coherData, &imgLog, norm2, pos, &oiVis2, &a
   local i, data, opd, nbase, nstep, map, ntel, dx, ft, psd, freq, tau0, fwhm, idm;
   local boot, psdbias, nIn, log, npol, pol, x, y, yf, sta, lbd0, lbdB, env;
   local psd0, crop, n2, isRejected, mask, time, vel, tauB, predWidth, time;
+  local spec, psdClean;
   oiVis2 = [];
 
   /* Get the data and the opds */
@@ -3089,16 +3081,11 @@ func pndrsScanComputeAmp2PerScanAbcd(coherData, &imgLog, norm2, pos, &oiVis2, &a
   /* Default Wave */
   pndrsGetDefaultWave, oLog, lbd0, lbdB, sig0;
 
-  /* Perform FFT and PSD */
+  /* Perform FFT */
   pndrsSignalFourierTransform, data, opd, ft, freq;
-  psd0    = power(ft);
   freq    = abs(freq)(,1,);
   id0     = abs(freq(-,) - sig0)(,mnx,);
 
-  /* The PSD of the BIAS is estimated with the opposite frequencies */
-  psdbias = psd0;
-  psdbias(,2:,,) = psdbias(,:2:-1,,);
-
   /* Compute the predicted width of the pic based on
      the tau0 and scanning speed */
   predWidth = pndrsGetPicWidth(oLog, checkUTs=1);
@@ -3152,12 +3139,11 @@ func pndrsScanComputeAmp2PerScanAbcd(coherData, &imgLog, norm2, pos, &oiVis2, &a
     }
   }
 
-  /* Remove the PSD of the BIAS. Keep the null scans at 0 */
-  psdClean  = psd0 - psdbias;
-  psdClean *= (abs(data)(sum,sum,-,-,)!=0);
-
-  /* Compute the unbiased amplitude per scan. */
-  amp2 = 4 * ( psdClean * idsi(,,-,) )(,sum,,);
+  /* Compute the unbiased amplitude per scan: integrate the PSD and
+     remove the PSD of the BIAS, estimated with the opposite frequencies.
+     Keep the null scans at 0 */
+  spec = pndrsSignalSpectrum(ft, idsi);
+  amp2 = 4 * (spec(1,..) - spec(2,..)) * (abs(data)(sum,sum,-,)!=0);
   
   /* Check the pos array */
   if (is_void(pos) || allof(pos==0)) {
@@ -3213,6 +3199,12 @@ func pndrsScanComputeAmp2PerScanAbcd(coherData, &imgLog, norm2, pos, &oiVis2, &a
 
   /* Plot the outputs PSD to have a data quality estimate */
   if (gui && pndrsBatchPlotLevel) {
+    psd0    = power(ft);
+    psdbias = psd0;
+    psdbias(,2:,,) = psdbias(,:2:-1,,);
+    psdClean  = psd0 - psdbias;
+    psdClean *= (abs(data)(sum,sum,-,-,)!=0);
+
     window,gui+1;
     sta  = pndrsPlotGetBaseName(oLog);
     main = swrite(format="%s - %.4f", oLog.target, (*coherData.time)(*)(avg));
@@ -20,6 +20,10 @@ func pndrsSignal(void)
    - pndrsSignalRephase
    
    - pndrsSignalComputeAmp2Ratio
+
+   - pndrsSignalApplyMatrix
+   - pndrsSignalSpectrum
+   - pndrsSignalBispectrum
 */
 {
     local version;
@@ -331,6 +335,85 @@ func pndrsSignalSquareFiltering(data, opd, filter, &dataf, &ft0)
   return 1;
 }
 
+func pndrsSignalApplyMatrix(m, x)
+/* DOCUMENT y = pndrsSignalApplyMatrix(m, x)
+
+   DESCRIPTION
+   Apply independently to each spectral channel the matrix
+   m(nlbd,nout,nin) to x(nlbd,..,nin):
+   y(l,..,j) = sum_k m(l,j,k) * x(l,..,k)
+
+   The compiled kernel abcd_apply of Yeti is used if available.
+
+   SEE ALSO abcd_apply
+ */
+{
+  local y, d, l;
+  if (is_func(abcd_apply)) return abcd_apply(m, x);
+
+  d = dimsof(x);
+  d(0) = dimsof(m)(3);
+  y = array(0.0, d);
+  for (l=1;l<=d(2);l++) y(l,..) = x(l,..,+) * m(l,,+);
+  return y;
+}
+
+func pndrsSignalSpectrum(ft, mask)
+/* DOCUMENT spec = pndrsSignalSpectrum(ft, mask)
+
+   DESCRIPTION
+   Integrate the power of the Fourier transform ft(nlbd,nstep,nscan,nbase)
+   over the frequencies selected by mask(nlbd,nstep,nbase). Return
+   spec(4,nlbd,nscan,nbase) with:
+   - spec(1,..): power,
+   - spec(2,..): power at the opposite frequencies (bias),
+   - spec(3,..) + 1.i*spec(4,..): cross-spectrum of the filtered
+     transform, (fin(,1:-1,,) * conj(fin(,2:0,,)))(,sum,,)
+     with fin = ft*mask(,,-,).
+
+   The compiled kernel abcd_spectrum of Yeti is used if available.
+
+   SEE ALSO abcd_spectrum
+ */
+{
+  local spec, psd, bias, fin, cross;
+  if (is_func(abcd_spectrum)) return abcd_spectrum(ft, mask);
+
+  psd  = power(ft);
+  bias = psd;
+  bias(,2:,,) = bias(,:2:-1,,);
+  fin   = ft*mask(,,-,);
+  cross = (fin(,1:-1,,) * conj(fin(,2:0,,)))(,sum,,);
+  spec = array(0.0, 4, dimsof(cross));
+  spec(1,..) = (psd*mask(,,-,))(,sum,,);
+  spec(2,..) = (bias*mask(,,-,))(,sum,,);
+  spec(3,..) = cross.re;
+  spec(4,..) = cross.im;
+  return spec;
+}
+
+func pndrsSignalBispectrum(x, idx)
+/* DOCUMENT bisp = pndrsSignalBispectrum(x, idx)
+
+   DESCRIPTION
+   Average over the opd steps of the bispectrum of the complex coherent
+   flux x(nlbd,nstep,nscan,nbase) for the triplets of baselines
+   idx(3,nclo). If x is real, the average of sqrt(abs(x1*x2*x3)) is
+   returned instead (normalisation of the bispectrum).
+   The result is bisp(nlbd,nscan,nclo).
+
+   The compiled kernel abcd_bispectrum of Yeti is used if available.
+
+   SEE ALSO abcd_bispectrum
+ */
+{
+  if (is_func(abcd_bispectrum)) return abcd_bispectrum(x, idx);
+
+  if (structof(x)==complex)
+    return (x(,,,idx(1,)) * x(,,,idx(2,)) * conj(x(,,,idx(3,))))(,avg,,);
+  return sqrt(abs(x(,,,idx(1,)) * x(,,,idx(2,)) * x(,,,idx(3,))))(,avg,,);
+}
+
 func pndrsSignalComputePhase(bisp, &phases, &phasesErr, gui=)
 {
   yocoLogInfo,"pndrsSignalComputePhase()";
@@ -241,6 +241,8 @@ func optm_conjgrad(A, b, x0, &status, precond=, maxiter=, restart=, verb=,
         restarting = (k == 0 || (restart > 0 && (k%restart) == 0));
 
         // Compute residuals and their squared norm.
+        oldrho = rho;
+        rho = [];
         if (restarting) {
             // Compute residuals.
             if (x_is_zero) {
@@ -251,9 +253,12 @@ func optm_conjgrad(A, b, x0, &status, precond=, maxiter=, restart=, verb=,
                 // Compute `r = b - A*x`.
                 r = b - A(x); // FIXME: optm_combine, r, +1, b, -1, A(x);
             }
-        } else {
+        } else if (preconditioned) {
             // Update residuals: `r -= alpha*q`.
             optm_update, r, -alpha, q;
+        } else {
+            // Update residuals and compute `rho = ‖r‖^2` in a single pass.
+            rho = optm_update_norm2(r, -alpha, q)^2;
         }
         if (preconditioned) {
             // Apply preconditioner `z = M⋅r`.
@@ -262,8 +267,9 @@ func optm_conjgrad(A, b, x0, &status, precond=, maxiter=, restart=, verb=,
             // No preconditioner `z = I⋅r = r`.
             eq_nocopy, z, r;
         }
-        oldrho = rho;
-        rho = optm_inner(r, z); // rho = ‖r‖_M^2
+        if (is_void(rho)) {
+            rho = optm_inner(r, z); // rho = ‖r‖_M^2
+        }
         if (k == 0) {
             // Pre-compute the minimal Mahalanobis norm of the gradient for
             // convergence. The Mahalanobis norm of the gradient is equal to
@@ -291,7 +297,7 @@ func optm_conjgrad(A, b, x0, &status, precond=, maxiter=, restart=, verb=,
         } else {
             // Apply recurrence.
             beta = rho/oldrho;
-            p = z + beta*p; // FIXME: optm_combine, p, +1, z, beta, p;
+            optm_combine, p, 1, z, beta, p; // p = z + beta*p
         }
 
         // Compute optimal step size `alpha` along search direction `p`.
@@ -655,10 +661,21 @@ func optm_new_lbfgs(m)
 
      Create a new L-BFGS instance for storing up to `m` previous steps.
 
-   SEE ALSO: optm_update_lbfgs, optm_apply_lbfgs.
+     If fast vectorized operations are in use (see `optm_override_functions`)
+     and the `vops.i` plug-in provides it, the instance is an L-BFGS memory
+     object (see `vops_lbfgs`) which stores the memorized steps in contiguous
+     memory and applies the recursion in compiled code.  Otherwise, the
+     instance is an `OptmLBFGS` structure.  In both cases, the instance is
+     to be used with `optm_update_lbfgs`, `optm_apply_lbfgs`, and
+     `optm_reset_lbfgs`.
+
+   SEE ALSO: optm_update_lbfgs, optm_apply_lbfgs, vops_lbfgs.
  */
 {
     if (m < 0) error, "invalid number of previous step to memorize";
+    if (_optm_fast_lbfgs) {
+        return vops_lbfgs(m);
+    }
     lbfgs = OptmLBFGS(m = m, mp = 0, mrk = 0);
     if (m > 0) {
         lbfgs.S   = &array(pointer, m);
@@ -678,6 +695,10 @@ func optm_reset_lbfgs(&lbfgs)
    SEE ALSO: optm_update_lbfgs, optm_apply_lbfgs.
  */
 {
+    if (typeof(lbfgs) != "struct_instance") {
+        vops_lbfgs_reset, lbfgs;
+        return lbfgs;
+    }
     lbfgs.mp = 0;
     lbfgs.mrk = 0;
     lbfgs.gamma = 0.0;
@@ -708,6 +729,9 @@ func optm_update_lbfgs(lbfgs, s, y)
    SEE ALSO: optm_new_lbfgs, optm_apply_lbfgs, optm_inner.
  */
 {
+    if (typeof(lbfgs) != "struct_instance") {
+        return vops_lbfgs_update(lbfgs, s, y);
+    }
     sty = optm_inner(s, y);
     accept = (sty > 0);
     if (accept) {
@@ -762,6 +786,15 @@ func optm_apply_lbfgs(lbfgs, d, &scaled, freevars)
         }
     }
 
+    if (typeof(lbfgs) != "struct_instance") {
+        // Compiled recursion with contiguous storage of the memorized steps.
+        d = vops_lbfgs_apply(lbfgs, d, scaled, (regular ? [] : freevars));
+        if (OPTM_DEBUG && !regular && anyof(d(where(!freevars)))) {
+            error, "non-zero search direction for some blocked variables";
+        }
+        return d;
+    }
+
     // Apply the 2-loop L-BFGS recursion algorithm by Matthies & Strang.
     mp = lbfgs.mp;
     if (mp >= 1) {
@@ -777,19 +810,37 @@ func optm_apply_lbfgs(lbfgs, d, &scaled, freevars)
             eq_nocopy, rho, *lbfgs.rho;
         }
         gamma = lbfgs.gamma;
+        // In both loops, the inner product needed by the next step is
+        // computed while updating `d`.
+        if (mp >= 1) {
+            dot = optm_inner(d, *S((off - 1)%m + 1));
+        }
         for (j = 1; j <= mp; ++j) {
             i = (off - j)%m + 1;
-            alpha_i = optm_inner(d, *S(i))/rho(i);
-            optm_update, d, -alpha_i, *Y(i);
+            alpha_i = dot/rho(i);
+            if (j < mp) {
+                dot = optm_update_inner(d, -alpha_i, *Y(i),
+                                        *S((off - j - 1)%m + 1));
+            } else {
+                optm_update, d, -alpha_i, *Y(i);
+            }
             alpha(i) = alpha_i;
         }
         if (gamma > 0 && gamma != 1) {
             optm_scale, d, gamma;
         }
+        if (mp >= 1) {
+            dot = optm_inner(d, *Y((off - mp)%m + 1));
+        }
         for (j = mp; j >= 1; --j) {
             i = (off - j)%m + 1;
-            beta = optm_inner(d, *Y(i))/rho(i);
-            optm_update, d, alpha(i) - beta, *S(i);
+            beta = dot/rho(i);
+            if (j > 1) {
+                dot = optm_update_inner(d, alpha(i) - beta, *S(i),
+                                        *Y((off - j + 1)%m + 1));
+            } else {
+                optm_update, d, alpha(i) - beta, *S(i);
+            }
         }
     } else {
         // L-BFGS recursion on a subset of free variables specified by a
@@ -1671,6 +1722,53 @@ func _optm_update(&y, alpha, x)
     y += alpha*x;
 }
 
+local optm_update_inner;
+func _optm_update_inner(&y, alpha, x, z)
+/* DOCUMENT res = optm_update_inner(y, alpha, x, z);
+
+     Compute `y += alpha*x` as `optm_update` does and yield the inner product
+     of the updated `y` and `z`.  With the fast version of the algebra
+     functions (see `optm_override_functions`), both operations are done in a
+     single pass through memory.
+
+   SEE ALSO: optm_update, optm_inner, optm_update_norm2.
+ */
+{
+    alpha = (structof(x) == float ? float : double)(alpha);
+    y += alpha*x;
+    return sum(y*z);
+}
+
+local optm_update_norm2;
+func _optm_update_norm2(&y, alpha, x)
+/* DOCUMENT res = optm_update_norm2(y, alpha, x);
+
+     Compute `y += alpha*x` as `optm_update` does and yield the Euclidean norm
+     of the updated `y`.  With the fast version of the algebra functions (see
+     `optm_override_functions`), both operations are done in a single pass
+     through memory.
+
+   SEE ALSO: optm_update, optm_norm2, optm_update_inner.
+ */
+{
+    alpha = (structof(x) == float ? float : double)(alpha);
+    y += alpha*x;
+    return sqrt(sum(y*y));
+}
+
+local optm_combine;
+func _optm_combine(&dst, alpha, x, beta, y)
+/* DOCUMENT optm_combine, dst, alpha, x, beta, y;
+
+     Compute `dst = alpha*x + beta*y` efficiently and taking care of
+     preserving the floating-point type of `x` and `y`.  Any of `x` or `y`
+     may be `dst` itself.
+ */
+{
+    T = (structof(x) == float && structof(y) == float ? float : double);
+    dst = T(alpha)*x + T(beta)*y;
+}
+
 func optm_tolerance(x, atol, rtol)
 /* DOCUMENT tol = optm_tolerance(x, atol, rtol);
 
@@ -1806,7 +1904,9 @@ func optm_override_functions(mode)
 /* DOCUMENT optm_override_functions, mode;
 
      If `mode = "fast"`, attempt to load `vops.i` plug-in and use fast
-     vectorized functions to perform basic linear algebra operations.
+     vectorized functions to perform basic linear algebra operations.  New
+     L-BFGS instances created by `optm_new_lbfgs` are then compiled L-BFGS
+     memory objects if the plug-in provides them.
 
      If `mode = "slow"`, use slower interpreted functions to perform basic
      linear algebra operations.
@@ -1815,7 +1915,8 @@ func optm_override_functions(mode)
      plug-in is available and the slow version is used otherwise.
 
    SEE ALSO: optm_inner, optm_norm1, optm_norm2, optm_norminf, optm_scale,
-             optm_update.
+             optm_update, optm_update_inner, optm_update_norm2,
+             optm_combine, optm_new_lbfgs.
  */
 {
     extern optm_inner;
@@ -1824,6 +1925,10 @@ func optm_override_functions(mode)
     extern optm_norminf;
     extern optm_scale;
     extern optm_update;
+    extern optm_update_inner;
+    extern optm_update_norm2;
+    extern optm_combine;
+    extern _optm_fast_lbfgs;
     if (mode == "fast" || mode == "tryfast") {
         // Try to use optimized operations (this must be done last).
         if (is_func(vops_inner) == 3) {
@@ -1837,6 +1942,14 @@ func optm_override_functions(mode)
             optm_norminf = vops_norminf;
             optm_scale   = vops_scale;
             optm_update  = vops_update;
+            optm_combine = vops_combine;
+            // Fused operations are not provided by older versions of the
+            // plug-in.
+            optm_update_inner = (is_func(vops_update_inner) ?
+                                 vops_update_inner : _optm_update_inner);
+            optm_update_norm2 = (is_func(vops_update_norm2) ?
+                                 vops_update_norm2 : _optm_update_norm2);
+            _optm_fast_lbfgs = (is_func(vops_lbfgs) != 0);
             return;
         }
         mesg = "cannot load \"vops.i\"";
@@ -1853,6 +1966,10 @@ func optm_override_functions(mode)
         optm_norminf = _optm_norminf;
         optm_scale   = _optm_scale;
         optm_update  = _optm_update;
+        optm_update_inner = _optm_update_inner;
+        optm_update_norm2 = _optm_update_norm2;
+        optm_combine = _optm_combine;
+        _optm_fast_lbfgs = 0n;
     } else {
         error, "argument must be \"fast\" or \"slow\"";
     }
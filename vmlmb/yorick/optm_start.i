@@ -1,6 +1,7 @@
 autoload, "optm.i",
     optm_apply_lbfgs,
     optm_clamp,
+    optm_combine,
     optm_conjgrad,
     optm_conjgrad_status,
     optm_floating_point,
@@ -24,5 +25,7 @@ autoload, "optm.i",
     optm_steepest_descent_step,
     optm_tolerance,
     optm_update,
+    optm_update_inner,
     optm_update_lbfgs,
+    optm_update_norm2,
     optm_vmlmb;
@@ -33,6 +33,17 @@ CFG_WITH_FFTW = "no";
 CFG_WITH_FFTW_DEFS = "";
 CFG_WITH_FFTW_LIBS = "-lrfftw -lfftw";
 
+/* Settings for FFTW3 engine of fft (in FFTW plugin): */
+local CFG_WITH_FFTW3, CFG_WITH_FFTW3_DEFS, CFG_WITH_FFTW3_LIBS;
+CFG_WITH_FFTW3 = "no";
+CFG_WITH_FFTW3_DEFS = "";
+CFG_WITH_FFTW3_LIBS = "-lfftw3";
+
+/* Settings for OpenMP multi-threading (core plugin): */
+local CFG_WITH_OPENMP, CFG_WITH_OPENMP_FLAGS;
+CFG_WITH_OPENMP = "yes";
+CFG_WITH_OPENMP_FLAGS = "-fopenmp";
+
 /* Settings for REGEX plugin: */
 local CFG_WITH_REGEX, CFG_WITH_REGEX_DEFS, CFG_WITH_REGEX_LIBS;
 CFG_WITH_REGEX = "yes";
@@ -64,6 +75,13 @@ func cfg_help {
   w, "  --with-fftw-defs=DEFS   preprocessor options for FFTW [%s]", CFG_WITH_FFTW_DEFS;
   w, "  --with-fftw-libs=LIBS   library specification for FFTW [%s]", CFG_WITH_FFTW_LIBS;
   w, "";
+  w, "  --with-fftw3=yes/no     use FFTW3 for fftw_fft? [%s]", CFG_WITH_FFTW3;
+  w, "  --with-fftw3-defs=DEFS  preprocessor options for FFTW3 [%s]", CFG_WITH_FFTW3_DEFS;
+  w, "  --with-fftw3-libs=LIBS  library specification for FFTW3 [%s]", CFG_WITH_FFTW3_LIBS;
+  w, "";
+  w, "  --with-openmp=yes/no    multi-threaded kernels? [%s]", CFG_WITH_OPENMP;
+  w, "  --with-openmp-flags=FLAGS  compiler flags for OpenMP [%s]", CFG_WITH_OPENMP_FLAGS;
+  w, "";
   w, "  --with-regex=yes/no     build REGEX plugin? [%s]", CFG_WITH_REGEX;
   w, "  --with-regex-defs=DEFS  preprocessor options for REGEX [%s]", CFG_WITH_REGEX_DEFS;
   w, "  --with-regex-libs=LIBS  library specification for REGEX [%s]", CFG_WITH_REGEX_LIBS;
@@ -86,6 +104,8 @@ func cfg_configure(argv)
   extern CFG_YETI_VERSION;
   extern CFG_YETI_VERSION_MAJOR, CFG_YETI_VERSION_MINOR, CFG_YETI_VERSION_MICRO;
   extern CFG_WITH_FFTW, CFG_WITH_FFTW_DEFS, CFG_WITH_FFTW_LIBS;
+  extern CFG_WITH_FFTW3, CFG_WITH_FFTW3_DEFS, CFG_WITH_FFTW3_LIBS;
+  extern CFG_WITH_OPENMP, CFG_WITH_OPENMP_FLAGS;
   extern CFG_WITH_REGEX, CFG_WITH_REGEX_DEFS, CFG_WITH_REGEX_LIBS;
   extern CFG_WITH_TIFF, CFG_WITH_TIFF_DEFS, CFG_WITH_TIFF_LIBS;
 
@@ -212,6 +232,29 @@ func cfg_configure(argv)
     CFG_YORICK_VERSION_MAJOR, CFG_YORICK_VERSION_MINOR,
     CFG_YORICK_VERSION_MICRO, CFG_YORICK_VERSION_SUFFIX;
 
+  /* OpenMP settings (for the core and FFTW plugins). */
+  with_openmp = CFG_WITH_OPENMP;
+  if (structof(with_openmp) == string) {
+    with_openmp = (strcase(0, with_openmp) == "yes");
+  }
+  openmp_flags = (with_openmp ? CFG_WITH_OPENMP_FLAGS : "");
+
+  /* FFTW3 engine replaces FFTW2 in the FFTW plugin (both libraries define
+     the same symbols). */
+  with_fftw3 = CFG_WITH_FFTW3;
+  if (structof(with_fftw3) == string) {
+    with_fftw3 = (strcase(0, with_fftw3) == "yes");
+  }
+  if (with_fftw3) {
+    with_fftw = CFG_WITH_FFTW;
+    if (structof(with_fftw) == string &&
+        strcase(0, with_fftw) == "yes" && CFG_WITH_FFTW_LIBS != "") {
+      cfg_prt, "FFTW2 and FFTW3 cannot be both linked, building with FFTW3 only";
+    }
+    CFG_WITH_FFTW = "yes";
+    CFG_WITH_FFTW_LIBS = "";
+  }
+
   /* Collect list of Yeti components to build and create Makefiles. */
   components = "core";
   build = array(int, numberof(subdirs));
@@ -236,6 +279,11 @@ func cfg_configure(argv)
         defs = symbol_def("CFG_WITH_" + PKG + "_DEFS");
         libs = symbol_def("CFG_WITH_" + PKG + "_LIBS");
         if (define_have_macro) defs += " -DHAVE_" + PKG + "=1";
+        if (pkg == "fftw" && with_fftw3) {
+          defs = CFG_WITH_FFTW3_DEFS + " -DHAVE_FFTW=0 -DHAVE_FFTW3=1";
+          libs = CFG_WITH_FFTW3_LIBS;
+        }
+        if (pkg == "fftw") defs += " $(OPENMP_FLAGS)";
         cfg_prt, "Package \"%s\" will be built with the following settings:", pkg;
         cfg_prt, "  PKG_CFLAGS  = %s", defs;
         cfg_prt, "  PKG_DEPLIBS = %s", libs;
@@ -250,13 +298,23 @@ func cfg_configure(argv)
         output = cfg_join_path(dstdir, "Makefile"),
         "srcdir", srcdir,
         "PKG_CFLAGS", defs,
-        "PKG_DEPLIBS", libs;
+        "PKG_DEPLIBS", libs,
+        "OPENMP_FLAGS", openmp_flags;
     } else {
       /* Non-optional component. */
+      flags = openmp_flags;
+      cfg_prt;
+      if (with_openmp) {
+        cfg_prt, "Package \"%s\" will be multi-threaded with OpenMP:", subdir;
+        cfg_prt, "  OPENMP_FLAGS = %s", flags;
+      } else {
+        cfg_prt, "Package \"%s\" will not be multi-threaded.", subdir;
+      }
       cfg_filter, style = "make",
         input  = cfg_join_path(srcdir, "Makefile.in"),
         output = cfg_join_path(dstdir, "Makefile"),
-        "srcdir", srcdir;
+        "srcdir", srcdir,
+        "OPENMP_FLAGS", flags;
     }
   }
 
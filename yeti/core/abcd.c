@@ -0,0 +1,194 @@
+/*
+ * abcd.c -
+ *
+ * Implement the kernels of the estimators of ABCD fringe data (coherent
+ * fluxes, power spectrum, cross spectrum and bispectrum) used by PNDRS.
+ *
+ *-----------------------------------------------------------------------------
+ *
+ * This file is part of Yeti (https://github.com/emmt/Yeti) released under the
+ * MIT "Expat" license.
+ *
+ * Copyright (C) 1996-2020: Éric Thiébaut.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <yapi.h>
+#include <pstdlib.h>
+#include "yeti.h"
+
+/*
+ * The data of a scanning ABCD combiner are stored with the spectral channel
+ * varying fastest (NLBD channels), then the OPD step (NSTEP steps), the scan
+ * and the output (pixel or baseline).  All kernels run their innermost loop
+ * over the channels, that is over contiguous memory, and the outermost
+ * (parallel) loop over the scans so that the result does not depend on the
+ * number of threads.  No temporary arrays are needed.
+ */
+
+// Check that argument `iarg` is an array of rank `rank` and store its
+// dimensions in `dims`.
+static void get_dims(int iarg, int rank, long dims[], const char* name)
+{
+    yarg_dims(iarg, dims, NULL);
+    if (dims[0] != rank) y_errorq("bad number of dimensions for %s", name);
+}
+
+void Y_abcd_apply(int argc)
+{
+    long mdims[Y_DIMSIZE], xdims[Y_DIMSIZE];
+    if (argc != 2) y_error("expecting exactly two arguments");
+    yarg_dims(1, mdims, NULL);
+    if (mdims[0] < 1 || mdims[0] > 3) y_error("M must be a 3-D array");
+    while (mdims[0] < 3) mdims[++mdims[0]] = 1;
+    const long nlbd = mdims[1], nout = mdims[2], nin = mdims[3];
+    yarg_dims(0, xdims, NULL);
+    long r = xdims[0];
+    if (r < 2 || xdims[1] != nlbd || xdims[r] != nin) {
+        y_error("X must be NLBD-by-...-by-NIN");
+    }
+    long nsamples = 1;
+    for (long k = 2; k < r; ++k) nsamples *= xdims[k];
+    const double* m = ygeta_d(1, NULL, NULL);
+    const double* x = ygeta_d(0, NULL, NULL);
+    xdims[r] = nout;
+    double* y = ypush_d(xdims);
+
+    // y(l,s,j) = sum_k m(l,j,k)*x(l,s,k)
+    int nthreads = yor_nthreads((size_t)nlbd*nsamples*nout*nin);
+    if (nthreads > nsamples) nthreads = nsamples;
+    YOR_OMP(parallel for num_threads(nthreads) schedule(static) if(nthreads > 1))
+    for (long s = 0; s < nsamples; ++s) {
+        for (long j = 0; j < nout; ++j) {
+            double* dst = y + nlbd*(s + nsamples*j);
+            for (long l = 0; l < nlbd; ++l) dst[l] = 0.0;
+            for (long k = 0; k < nin; ++k) {
+                const double* a = m + nlbd*(j + nout*k);
+                const double* src = x + nlbd*(s + nsamples*k);
+                YOR_OMP(simd)
+                for (long l = 0; l < nlbd; ++l) dst[l] += a[l]*src[l];
+            }
+        }
+    }
+}
+
+void Y_abcd_spectrum(int argc)
+{
+    long zdims[Y_DIMSIZE], wdims[Y_DIMSIZE], dims[5];
+    if (argc != 2) y_error("expecting exactly two arguments");
+    if (yarg_typeid(1) != Y_COMPLEX) y_error("FT must be complex");
+    get_dims(1, 4, zdims, "FT");
+    get_dims(0, 3, wdims, "MASK");
+    const long nlbd = zdims[1], nstep = zdims[2], nscan = zdims[3],
+        nbase = zdims[4];
+    if (wdims[1] != nlbd || wdims[2] != nstep || wdims[3] != nbase) {
+        y_error("MASK must be NLBD-by-NSTEP-by-NBASE");
+    }
+    const double* z = ygeta_z(1, NULL, NULL);
+    const double* w = ygeta_d(0, NULL, NULL);
+    dims[0] = 4;
+    dims[1] = 4;
+    dims[2] = nlbd;
+    dims[3] = nscan;
+    dims[4] = nbase;
+    double* out = ypush_d(dims);
+
+    // For each scan and baseline, the power is integrated over the steps
+    // selected by the mask, the bias is the power at the opposite
+    // frequencies (step s > 1 mirrored as nstep + 2 - s) and the cross
+    // spectrum is the sum of the products of the filtered transform with
+    // the conjugate of the filtered transform at the next step.
+    const long npairs = nscan*nbase;
+    int nthreads = yor_nthreads((size_t)npairs*nstep*nlbd*8);
+    if (nthreads > npairs) nthreads = npairs;
+    YOR_OMP(parallel for num_threads(nthreads) schedule(static) if(nthreads > 1))
+    for (long p = 0; p < npairs; ++p) {
+        const double* zp = z + 2*nlbd*nstep*p;
+        const double* wp = w + nlbd*nstep*(p/nscan);
+        double* r = out + 4*nlbd*p;
+        for (long l = 0; l < 4*nlbd; ++l) r[l] = 0.0;
+        for (long s = 0; s < nstep; ++s) {
+            const double* z0 = zp + 2*nlbd*s;
+            const double* z1 = zp + 2*nlbd*(s > 0 ? nstep - s : 0);
+            const double* w0 = wp + nlbd*s;
+            for (long l = 0; l < nlbd; ++l) {
+                double re = z0[2*l], im = z0[2*l+1];
+                double bre = z1[2*l], bim = z1[2*l+1];
+                r[4*l]   += w0[l]*(re*re + im*im);
+                r[4*l+1] += w0[l]*(bre*bre + bim*bim);
+            }
+            if (s + 1 < nstep) {
+                const double* z2 = z0 + 2*nlbd;
+                const double* w2 = w0 + nlbd;
+                for (long l = 0; l < nlbd; ++l) {
+                    double re = z0[2*l], im = z0[2*l+1];
+                    double nre = z2[2*l], nim = z2[2*l+1];
+                    double q = w0[l]*w2[l];
+                    r[4*l+2] += q*(re*nre + im*nim);
+                    r[4*l+3] += q*(im*nre - re*nim);
+                }
+            }
+        }
+    }
+}
+
+void Y_abcd_bispectrum(int argc)
+{
+    long xdims[Y_DIMSIZE], idims[Y_DIMSIZE], dims[4], nidx;
+    if (argc != 2) y_error("expecting exactly two arguments");
+    int cplx = (yarg_typeid(1) == Y_COMPLEX);
+    get_dims(1, 4, xdims, "X");
+    const long nlbd = xdims[1], nstep = xdims[2], nscan = xdims[3],
+        nbase = xdims[4];
+    const long* idx = ygeta_l(0, &nidx, idims);
+    if (idims[0] < 1 || idims[1] != 3) y_error("IDX must be 3-by-NCLO");
+    const long nclo = nidx/3;
+    for (long k = 0; k < nidx; ++k) {
+        if (idx[k] < 1 || idx[k] > nbase) y_error("out of range index");
+    }
+    const double* x = (cplx ? ygeta_z(1, NULL, NULL) : ygeta_d(1, NULL, NULL));
+    dims[0] = 3;
+    dims[1] = nlbd;
+    dims[2] = nscan;
+    dims[3] = nclo;
+    double* out = (cplx ? ypush_z(dims) : ypush_d(dims));
+
+    // Average over the steps of x1*x2*conj(x3) for complex data, of
+    // sqrt(|x1*x2*x3|) for real data.
+    const long n = (cplx ? 2 : 1);
+    const long npairs = nscan*nclo;
+    const double scl = (nstep > 0 ? 1.0/nstep : 0.0);
+    int nthreads = yor_nthreads((size_t)npairs*nstep*nlbd*8);
+    if (nthreads > npairs) nthreads = npairs;
+    YOR_OMP(parallel for num_threads(nthreads) schedule(static) if(nthreads > 1))
+    for (long p = 0; p < npairs; ++p) {
+        long scan = p%nscan, c = p/nscan;
+        const double* x1 = x + n*nlbd*nstep*(scan + nscan*(idx[3*c] - 1));
+        const double* x2 = x + n*nlbd*nstep*(scan + nscan*(idx[3*c+1] - 1));
+        const double* x3 = x + n*nlbd*nstep*(scan + nscan*(idx[3*c+2] - 1));
+        double* r = out + n*nlbd*p;
+        for (long l = 0; l < n*nlbd; ++l) r[l] = 0.0;
+        for (long s = 0; s < nstep; ++s) {
+            const long off = n*nlbd*s;
+            if (cplx) {
+                for (long l = 0; l < nlbd; ++l) {
+                    double ar = x1[off+2*l], ai = x1[off+2*l+1];
+                    double br = x2[off+2*l], bi = x2[off+2*l+1];
+                    double cr = x3[off+2*l], ci = x3[off+2*l+1];
+                    double pr = ar*br - ai*bi, pi = ar*bi + ai*br;
+                    r[2*l]   += pr*cr + pi*ci;
+                    r[2*l+1] += pi*cr - pr*ci;
+                }
+            } else {
+                for (long l = 0; l < nlbd; ++l) {
+                    r[l] += sqrt(fabs(x1[off+l]*x2[off+l]*x3[off+l]));
+                }
+            }
+        }
+        for (long l = 0; l < n*nlbd; ++l) r[l] *= scl;
+    }
+}
@@ -0,0 +1,1042 @@
+/*
+ * bintable.c -
+ *
+ * Decoding of FITS binary tables and memory-mapped access to FITS files.
+ *
+ *-----------------------------------------------------------------------------
+ *
+ * This file is part of Yeti (https://github.com/emmt/Yeti) released under the
+ * MIT "Expat" license.
+ *
+ * Copyright (C) 1996-2020: Éric Thiébaut.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <yapi.h>
+#include <pstdlib.h>
+#include "yeti.h"
+
+/*
+ * The raw table is a pitch-by-nrows array of bytes (that is, the rows of the
+ * table as stored in the file).  Each column is decoded in a single pass
+ * which converts the big-endian values and stores them directly at their
+ * place in the result, so that the rows need not be read one by one nor the
+ * result be transposed.  Rows are decoded in parallel.
+ */
+typedef struct {
+    long offset;       // offset of the column in a row (bytes)
+    long repeat;       // number of values per row
+    int  code;         // format letter
+    int  size;         // size of a value in the file (bytes)
+    int  ndims;        // number of cell dimensions
+    long dims[Y_DIMSIZE]; // cell dimensions
+    void* data;        // result (NULL if column is skipped)
+} bintable_column;
+
+static void parse_tform(bintable_column* col, const char* tform, long index)
+{
+    const char* s = tform;
+    char* end;
+    if (s == NULL) goto bad;
+    while (*s == ' ') ++s;
+    col->repeat = 1;
+    if (isdigit((unsigned char)*s)) {
+        col->repeat = strtol(s, &end, 10);
+        s = end;
+    }
+    col->code = (unsigned char)*s;
+    switch (col->code) {
+    case 'L': case 'B': case 'A': col->size = 1; break;
+    case 'I': col->size = 2; break;
+    case 'J': case 'E': col->size = 4; break;
+    case 'K': case 'D': case 'C': col->size = 8; break;
+    case 'M': col->size = 16; break;
+    case 'P': col->size = 8; return; // variable length arrays are skipped
+    case 'Q': col->size = 16; return;
+    case 'X': // bit arrays are skipped, the size is rounded up to bytes
+        col->size = 1;
+        col->repeat = (col->repeat + 7)/8;
+        col->code = 0;
+        break;
+    default: goto bad;
+    }
+    for (++s; *s == ' '; ++s)
+        ;
+    if (*s == '\0') return;
+ bad:
+    y_errorn("invalid format for field %ld of FITS binary table", index);
+}
+
+static void parse_tdim(bintable_column* col, const char* tdim, long index)
+{
+    const char* s = tdim;
+    char* end;
+    long number = 1;
+    col->ndims = 0;
+    if (s != NULL) {
+        while (*s == ' ') ++s;
+    }
+    if (s == NULL || *s == '\0' || col->code == 'A') {
+        // No TDIM keyword (or character column which yields strings).
+        if (col->repeat > 1) {
+            col->ndims = 1;
+            col->dims[0] = col->repeat;
+        }
+        return;
+    }
+    if (*s++ != '(') goto bad;
+    for (;;) {
+        long dim = strtol(s, &end, 10);
+        if (end == s || dim <= 0 || col->ndims >= Y_DIMSIZE - 2) goto bad;
+        col->dims[col->ndims++] = dim;
+        number *= dim;
+        for (s = end; *s == ' '; ++s)
+            ;
+        if (*s == ',') {
+            ++s;
+        } else if (*s == ')') {
+            break;
+        } else {
+            goto bad;
+        }
+    }
+    if (number == col->repeat) return;
+ bad:
+    y_errorn("invalid TDIM for field %ld of FITS binary table", index);
+}
+
+static inline uint16_t get_u16(const unsigned char* p)
+{
+    return (uint16_t)(((unsigned)p[0] << 8) | (unsigned)p[1]);
+}
+
+static inline uint32_t get_u32(const unsigned char* p)
+{
+    return (((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+            ((uint32_t)p[2] <<  8) |  (uint32_t)p[3]);
+}
+
+static inline uint64_t get_u64(const unsigned char* p)
+{
+    return (((uint64_t)get_u32(p)) << 32) | (uint64_t)get_u32(p + 4);
+}
+
+static inline float get_f32(const unsigned char* p)
+{
+    uint32_t u = get_u32(p);
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static inline double get_f64(const unsigned char* p)
+{
+    uint64_t u = get_u64(p);
+    double d;
+    memcpy(&d, &u, sizeof(d));
+    return d;
+}
+
+/* Selection of rows (or frames), ROW(sel,r) is the 0-based index of the
+   R-th selected row. */
+typedef struct {
+    long count;        // number of selected rows
+    long first;        // first row (if no index list)
+    long step;         // increment (if no index list)
+    const long* index; // list of rows or NULL
+    int scalar;        // a single row given as a scalar?
+} row_selection;
+
+#define ROW(sel, r) ((sel)->index != NULL ? (sel)->index[r] : \
+                     (sel)->first + (r)*(sel)->step)
+
+// Decode value K of R-th selected row into the element of index R*RSTEP +
+// K*KSTEP of the result.  For complexes, the index is that of the real part.
+#define DECODE(type_t, expr)                                            \
+    do {                                                                \
+        type_t* dst = (type_t*)col->data;                               \
+        YOR_OMP(parallel for num_threads(nthreads) schedule(static) if(nthreads > 1)) \
+        for (long r = 0; r < nrows; ++r) {                              \
+            const unsigned char* p = raw + ROW(sel, r)*pitch + col->offset; \
+            type_t* q = dst + r*rstep;                                  \
+            for (long k = 0; k < n; ++k, p += col->size) {              \
+                q[k*kstep] = (expr);                                    \
+            }                                                           \
+        }                                                               \
+    } while (0)
+
+#define DECODE_COMPLEX(expr_re, expr_im)                                \
+    do {                                                                \
+        double* dst = (double*)col->data;                               \
+        YOR_OMP(parallel for num_threads(nthreads) schedule(static) if(nthreads > 1)) \
+        for (long r = 0; r < nrows; ++r) {                              \
+            const unsigned char* p = raw + ROW(sel, r)*pitch + col->offset; \
+            double* q = dst + 2*r*rstep;                                \
+            for (long k = 0; k < n; ++k, p += col->size) {              \
+                q[2*k*kstep]     = (expr_re);                           \
+                q[2*k*kstep + 1] = (expr_im);                           \
+            }                                                           \
+        }                                                               \
+    } while (0)
+
+/* Format letter 'j' is used internally for 32-bit integers stored as int's
+   (images with BITPIX = 32). */
+static void decode_column(bintable_column* col, const unsigned char* raw,
+                          long pitch, const row_selection* sel, int last)
+{
+    long n = col->repeat;
+    long nrows = sel->count;
+    long rstep = (last ? n : 1);
+    long kstep = (last ? 1 : nrows);
+    int nthreads = yor_nthreads(nrows*n);
+    switch (col->code) {
+    case 'L':
+        DECODE(int, (p[0] == 'T' ? 1 : (p[0] == 'F' ? 0 : -1)));
+        break;
+    case 'B':
+        DECODE(unsigned char, p[0]);
+        break;
+    case 'I':
+        DECODE(short, (short)(int16_t)get_u16(p));
+        break;
+    case 'j':
+        DECODE(int, (int)(int32_t)get_u32(p));
+        break;
+    case 'J':
+        DECODE(long, (long)(int32_t)get_u32(p));
+        break;
+    case 'K':
+        DECODE(long, (long)(int64_t)get_u64(p));
+        break;
+    case 'E':
+        DECODE(float, get_f32(p));
+        break;
+    case 'D':
+        DECODE(double, get_f64(p));
+        break;
+    case 'C':
+        DECODE_COMPLEX(get_f32(p), get_f32(p + 4));
+        break;
+    case 'M':
+        DECODE_COMPLEX(get_f64(p), get_f64(p + 8));
+        break;
+    }
+}
+
+static void decode_strings(bintable_column* col, const unsigned char* raw,
+                           long pitch, const row_selection* sel, int trim)
+{
+    char** dst = (char**)col->data;
+    for (long r = 0; r < sel->count; ++r) {
+        const unsigned char* p = raw + ROW(sel, r)*pitch + col->offset;
+        long len = 0;
+        while (len < col->repeat && p[len] != '\0') ++len;
+        if (trim) {
+            while (len > 0 && p[len-1] == ' ') --len;
+        }
+        if (len > 0) {
+            char* str = (char*)p_malloc(len + 1);
+            memcpy(str, p, len);
+            str[len] = '\0';
+            dst[r] = str;
+        }
+    }
+}
+
+static int is_decodable(const bintable_column* col)
+{
+    return (col->repeat > 0 && col->code != 0 &&
+            strchr("LBAIjJKEDCM", col->code) != NULL);
+}
+
+/* Push the array for the selected rows of a column on top of the stack and
+   decode them. */
+static void push_column(bintable_column* col, const unsigned char* raw,
+                        long pitch, const row_selection* sel, int last,
+                        int trim)
+{
+    long dims[Y_DIMSIZE];
+    int ndims = col->ndims;
+    int nrowdims = (sel->scalar ? 0 : 1);
+    if (col->code == 'A') {
+        dims[0] = nrowdims;
+        dims[1] = sel->count;
+    } else {
+        dims[0] = ndims + nrowdims;
+        if (last) {
+            memcpy(&dims[1], col->dims, ndims*sizeof(long));
+            dims[ndims + 1] = sel->count;
+        } else {
+            dims[1] = sel->count;
+            memcpy(&dims[1 + nrowdims], col->dims, ndims*sizeof(long));
+        }
+    }
+    switch (col->code) {
+    case 'L': col->data = ypush_i(dims); break;
+    case 'B': col->data = ypush_c(dims); break;
+    case 'A': col->data = ypush_q(dims); break;
+    case 'I': col->data = ypush_s(dims); break;
+    case 'j': col->data = ypush_i(dims); break;
+    case 'J': col->data = ypush_l(dims); break;
+    case 'K': col->data = ypush_l(dims); break;
+    case 'E': col->data = ypush_f(dims); break;
+    case 'D': col->data = ypush_d(dims); break;
+    default:  col->data = ypush_z(dims); break;
+    }
+    if (col->code == 'A') {
+        decode_strings(col, raw, pitch, sel, trim);
+    } else {
+        decode_column(col, raw, pitch, sel, last);
+    }
+}
+
+void Y_unpack_bintable(int argc)
+{
+    static char* knames[] = {"last", "trim", NULL};
+    static long kglobs[3];
+    int kiargs[2];
+    int iarg_raw = -1, iarg_tform = -1, iarg_tdim = -1;
+    yarg_kw_init(knames, kglobs, kiargs);
+    for (int iarg = argc - 1; iarg >= 0; ) {
+        iarg = yarg_kw(iarg, kglobs, kiargs);
+        if (iarg < 0) break;
+        if (iarg_raw < 0) {
+            iarg_raw = iarg;
+        } else if (iarg_tform < 0) {
+            iarg_tform = iarg;
+        } else if (iarg_tdim < 0) {
+            iarg_tdim = iarg;
+        } else {
+            y_error("too many arguments");
+        }
+        --iarg;
+    }
+    if (iarg_tform < 0) y_error("expecting at least 2 arguments");
+    int last = (kiargs[0] >= 0 && yarg_true(kiargs[0]));
+    int trim = (kiargs[1] >= 0 && yarg_true(kiargs[1]));
+
+    // Raw contents of the table.
+    long dims[Y_DIMSIZE], ntot;
+    if (yarg_typeid(iarg_raw) != Y_CHAR) {
+        y_error("raw table must be an array of bytes");
+    }
+    const unsigned char* raw =
+        (const unsigned char*)ygeta_c(iarg_raw, &ntot, dims);
+    long pitch = 0, nrows = 0;
+    if (dims[0] == 2) {
+        pitch = dims[1];
+        nrows = dims[2];
+    } else if (dims[0] == 1) {
+        pitch = dims[1];
+        nrows = 1;
+    } else {
+        y_error("raw table must be a pitch-by-nrows array of bytes");
+    }
+
+    // Formats and dimensions of the fields.
+    long nfields, ntdims = 0;
+    ystring_t* tform = ygeta_q(iarg_tform, &nfields, NULL);
+    ystring_t* tdim = NULL;
+    if (iarg_tdim >= 0 && ! yarg_nil(iarg_tdim)) {
+        tdim = ygeta_q(iarg_tdim, &ntdims, NULL);
+        if (ntdims != nfields) y_error("TFORM and TDIM must have same length");
+    }
+    bintable_column* cols = (bintable_column*)ypush_scratch(
+        nfields*sizeof(bintable_column), NULL);
+    long offset = 0;
+    for (long j = 0; j < nfields; ++j) {
+        bintable_column* col = &cols[j];
+        parse_tform(col, tform[j], j + 1);
+        col->offset = offset;
+        offset += col->repeat*col->size;
+        parse_tdim(col, (tdim == NULL ? NULL : tdim[j]), j + 1);
+        col->data = NULL;
+    }
+    if (offset > pitch) y_error("inconsistent row size in FITS binary table");
+
+    // Create the result, a pointer array with one element per field.
+    row_selection sel = {nrows, 0, 1, NULL, 0};
+    long pdims[2] = {1, nfields};
+    void** ptr = ypush_p(pdims);
+    for (long j = 0; j < nfields; ++j) {
+        bintable_column* col = &cols[j];
+        if (is_decodable(col)) {
+            push_column(col, raw, pitch, &sel, last, trim);
+            // Transfer a use of the new array to the pointer array.
+            (void)yget_use(0);
+            yarg_drop(1);
+            ptr[j] = col->data;
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+/* MEMORY-MAPPED FITS FILES */
+
+/*
+ * The whole file is mapped read-only in memory and the structure of its
+ * header-data units (HDUs) is parsed once.  Nothing else is read until some
+ * data are requested: only the bytes of the selected frames of an image or
+ * of the selected rows of a column are then touched and converted, the
+ * operating system pages in the needed parts of the file and may drop them
+ * under memory pressure (they are backed by the file, not by swap).
+ */
+
+#define FITS_BLOCK 2880
+#define FITS_CARD    80
+
+typedef struct {
+    size_t header;         // offset of header
+    long   ncards;         // number of cards before END
+    size_t data;           // offset of data
+    size_t size;           // size of data without padding (bytes)
+    int    bitpix;         // BITPIX
+    int    naxis;          // NAXIS
+    long   naxes[Y_DIMSIZE]; // first dimensions
+    long   ncols;          // number of columns (-1 if not yet parsed)
+    long   nalloc;         // number of allocated columns
+    bintable_column* cols; // columns of binary table
+    char** ttype;          // names of columns (trailing spaces removed)
+} fits_hdu;
+
+typedef struct {
+    char* path;            // name of file
+    unsigned char* addr;   // address of mapped file
+    size_t size;           // size of file
+    long nhdus;            // number of HDUs
+    fits_hdu* hdus;        // HDUs
+} fits_mmap;
+
+#define FITS_MMAP_TYPE_NAME "mapped FITS file"
+
+static void free_columns(fits_hdu* hdu)
+{
+    if (hdu->ttype != NULL) {
+        for (long j = 0; j < hdu->nalloc; ++j) {
+            if (hdu->ttype[j] != NULL) p_free(hdu->ttype[j]);
+        }
+        p_free(hdu->ttype);
+        hdu->ttype = NULL;
+    }
+    if (hdu->cols != NULL) {
+        p_free(hdu->cols);
+        hdu->cols = NULL;
+    }
+    hdu->nalloc = 0;
+    hdu->ncols = -1;
+}
+
+static void fits_mmap_free(void* addr)
+{
+    fits_mmap* obj = addr;
+    if (obj->hdus != NULL) {
+        for (long i = 0; i < obj->nhdus; ++i) {
+            free_columns(&obj->hdus[i]);
+        }
+        p_free(obj->hdus);
+        obj->hdus = NULL;
+    }
+    if (obj->addr != NULL) {
+        munmap(obj->addr, obj->size);
+        obj->addr = NULL;
+    }
+    if (obj->path != NULL) {
+        p_free(obj->path);
+        obj->path = NULL;
+    }
+}
+
+static void fits_mmap_print(void* addr)
+{
+    fits_mmap* obj = addr;
+    char buffer[100];
+    snprintf(buffer, sizeof(buffer), " (nhdus = %ld, size = %ld) \"",
+             obj->nhdus, (long)obj->size);
+    buffer[sizeof(buffer)-1] = 0;
+    y_print(FITS_MMAP_TYPE_NAME, 0);
+    y_print(buffer, 0);
+    y_print(obj->path, 0);
+    y_print("\"", 1);
+}
+
+static void fits_mmap_extract(void* addr, char* name)
+{
+    fits_mmap* obj = addr;
+    if (strcmp(name, "path") == 0) {
+        *ypush_q(NULL) = p_strcpy(obj->path);
+    } else if (strcmp(name, "size") == 0) {
+        ypush_long((long)obj->size);
+    } else if (strcmp(name, "nhdus") == 0) {
+        ypush_long(obj->nhdus);
+    } else {
+        y_error("unknown mapped FITS file member");
+    }
+}
+
+static y_userobj_t fits_mmap_type = {
+    FITS_MMAP_TYPE_NAME,
+    fits_mmap_free,
+    fits_mmap_print,
+    NULL,
+    fits_mmap_extract,
+    NULL
+};
+
+/* Compare the name of a card with KEY (upper case, without trailing spaces)
+   and return the address of the value part (after the '=') or NULL.  Long
+   names are matched against HIERARCH cards. */
+static const char* match_card(const char* card, const char* key, size_t len)
+{
+    const char* end = card + FITS_CARD;
+    const char* s;
+    if (len <= 8 && strchr(key, ' ') == NULL) {
+        if (memcmp(card, key, len) != 0) return NULL;
+        for (s = card + len; s < card + 8; ++s) {
+            if (*s != ' ') return NULL;
+        }
+        return (card[8] == '=' ? card + 9 : NULL);
+    }
+    if (memcmp(card, "HIERARCH ", 9) != 0) return NULL;
+    for (s = card + 9; s < end && *s == ' '; ++s)
+        ;
+    if (s + len >= end || memcmp(s, key, len) != 0) return NULL;
+    for (s += len; s < end && *s == ' '; ++s)
+        ;
+    return (s < end && *s == '=' ? s + 1 : NULL);
+}
+
+static const char* find_card(const fits_mmap* obj, const fits_hdu* hdu,
+                             const char* key)
+{
+    const char* card = (const char*)obj->addr + hdu->header;
+    size_t len = strlen(key);
+    for (long i = 0; i < hdu->ncards; ++i, card += FITS_CARD) {
+        const char* val = match_card(card, key, len);
+        if (val != NULL) return val;
+    }
+    return NULL;
+}
+
+/* Parse the value of a card (VAL is the address after the '=' and END the
+   end of the card).  Returns the type of the value: 0 if none, 1 for a
+   logical, 2 for an integer, 3 for a real and 4 for a string (a new string
+   allocated by p_malloc is stored in STR). */
+static int parse_value(const char* val, const char* end, long* ival,
+                       double* dval, char** str)
+{
+    const char* s = val;
+    while (s < end && *s == ' ') ++s;
+    if (s >= end || *s == '/') return 0;
+    if (*s == '\'') {
+        char* buf = p_malloc(end - s);
+        long len = 0;
+        for (++s; s < end; ++s) {
+            if (*s == '\'') {
+                if (s + 1 < end && s[1] == '\'') {
+                    ++s;
+                } else {
+                    break;
+                }
+            }
+            buf[len++] = *s;
+        }
+        while (len > 0 && buf[len-1] == ' ') --len;
+        buf[len] = '\0';
+        *str = buf;
+        return 4;
+    }
+    if ((*s == 'T' || *s == 'F') &&
+        (s + 1 >= end || s[1] == ' ' || s[1] == '/')) {
+        *ival = (*s == 'T');
+        return 1;
+    }
+    char buf[FITS_CARD + 1];
+    long len = 0;
+    int real = 0;
+    while (s < end && *s != ' ' && *s != '/') {
+        char c = *s++;
+        if (c == 'D' || c == 'd') c = 'E';
+        if (c == '.' || c == 'E' || c == 'e') real = 1;
+        buf[len++] = c;
+    }
+    buf[len] = '\0';
+    char* stop;
+    if (real) {
+        *dval = strtod(buf, &stop);
+    } else {
+        *ival = strtol(buf, &stop, 10);
+    }
+    if (*stop != '\0') {
+        *str = p_strcpy(buf);
+        return 4;
+    }
+    return (real ? 3 : 2);
+}
+
+static long get_integer(const fits_mmap* obj, const fits_hdu* hdu,
+                        const char* key, long def)
+{
+    const char* val = find_card(obj, hdu, key);
+    if (val != NULL) {
+        long ival;
+        double dval;
+        char* str = NULL;
+        const char* card = (const char*)obj->addr + hdu->header;
+        const char* end = card + FITS_CARD*(1 + (val - card)/FITS_CARD);
+        int type = parse_value(val, end, &ival, &dval, &str);
+        if (str != NULL) p_free(str);
+        if (type == 2) return ival;
+    }
+    return def;
+}
+
+/* Get a string value, the result must be freed by p_free. */
+static char* get_string(const fits_mmap* obj, const fits_hdu* hdu,
+                        const char* key)
+{
+    const char* val = find_card(obj, hdu, key);
+    if (val != NULL) {
+        long ival;
+        double dval;
+        char* str = NULL;
+        const char* card = (const char*)obj->addr + hdu->header;
+        const char* end = card + FITS_CARD*(1 + (val - card)/FITS_CARD);
+        if (parse_value(val, end, &ival, &dval, &str) == 4) return str;
+        if (str != NULL) p_free(str);
+    }
+    return NULL;
+}
+
+/* Check whether CARD is the END card (the rest of the card must be blank).
+   The mapped file is not NUL-terminated, so only the FITS_CARD bytes of the
+   card are read. */
+static int is_end_card(const char* card)
+{
+    if (memcmp(card, "END", 3) != 0) return 0;
+    for (int i = 3; i < FITS_CARD; ++i) {
+        if (card[i] != ' ') return 0;
+    }
+    return 1;
+}
+
+/* Parse the structure of the mapped file, returns NULL on success or an
+   error message. */
+static const char* parse_hdus(fits_mmap* obj)
+{
+    size_t offset = 0;
+    long nmax = 0;
+    while (offset + FITS_BLOCK <= obj->size) {
+        const char* first = (const char*)obj->addr + offset;
+        if (memcmp(first, (obj->nhdus == 0 ? "SIMPLE  =" : "XTENSION="),
+                   9) != 0) {
+            if (obj->nhdus == 0) return "not a FITS file";
+            break; // ignore trailing bytes
+        }
+        long ncards = 0, maxcards = (obj->size - offset)/FITS_CARD;
+        const char* card = first;
+        while (ncards < maxcards && ! is_end_card(card)) {
+            ++ncards;
+            card += FITS_CARD;
+        }
+        if (ncards >= maxcards) return "missing END card in FITS header";
+        if (obj->nhdus >= nmax) {
+            nmax = (nmax > 0 ? 2*nmax : 8);
+            fits_hdu* hdus = p_malloc(nmax*sizeof(fits_hdu));
+            if (obj->nhdus > 0) {
+                memcpy(hdus, obj->hdus, obj->nhdus*sizeof(fits_hdu));
+            }
+            if (obj->hdus != NULL) p_free(obj->hdus);
+            obj->hdus = hdus;
+        }
+        fits_hdu* hdu = &obj->hdus[obj->nhdus++];
+        memset(hdu, 0, sizeof(fits_hdu));
+        hdu->ncols = -1;
+        hdu->header = offset;
+        hdu->ncards = ncards;
+        long nblocks = ((ncards + 1)*FITS_CARD + FITS_BLOCK - 1)/FITS_BLOCK;
+        hdu->data = offset + nblocks*FITS_BLOCK;
+        hdu->bitpix = (int)get_integer(obj, hdu, "BITPIX", 0);
+        hdu->naxis = (int)get_integer(obj, hdu, "NAXIS", 0);
+        int elsize = (hdu->bitpix >= 0 ? hdu->bitpix : -hdu->bitpix)/8;
+        if (elsize == 0 || hdu->naxis < 0 || hdu->naxis > 999) {
+            return "invalid BITPIX or NAXIS in FITS header";
+        }
+        long number = (hdu->naxis > 0 ? 1 : 0);
+        for (int k = 1; k <= hdu->naxis; ++k) {
+            char key[32];
+            sprintf(key, "NAXIS%d", k);
+            long dim = get_integer(obj, hdu, key, -1);
+            if (dim < 0) return "missing or invalid NAXISn in FITS header";
+            if (k < Y_DIMSIZE) hdu->naxes[k-1] = dim;
+            // The first dimension of random groups is zero.
+            if (! (k == 1 && dim == 0 && hdu->naxis > 1)) number *= dim;
+        }
+        number = get_integer(obj, hdu, "GCOUNT", 1)*
+            (get_integer(obj, hdu, "PCOUNT", 0) + number);
+        hdu->size = (size_t)elsize*number;
+        if (hdu->data + hdu->size > obj->size) return "truncated FITS file";
+        offset = hdu->data + ((hdu->size + FITS_BLOCK - 1)/FITS_BLOCK)*FITS_BLOCK;
+    }
+    if (obj->nhdus == 0) return "not a FITS file";
+    return NULL;
+}
+
+void Y_fits_mmap(int argc)
+{
+    static char* knames[] = {"quiet", NULL};
+    static long kglobs[2];
+    int kiargs[1];
+    int iarg_path = -1;
+    yarg_kw_init(knames, kglobs, kiargs);
+    for (int iarg = argc - 1; iarg >= 0; ) {
+        iarg = yarg_kw(iarg, kglobs, kiargs);
+        if (iarg < 0) break;
+        if (iarg_path >= 0) y_error("too many arguments");
+        iarg_path = iarg--;
+    }
+    if (iarg_path < 0) y_error("expecting a file name");
+    int quiet = (kiargs[0] >= 0 && yarg_true(kiargs[0]));
+    char* path = p_native(ygets_q(iarg_path));
+    fits_mmap* obj = ypush_obj(&fits_mmap_type, sizeof(fits_mmap));
+    obj->path = path;
+    const char* mesg = NULL;
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        mesg = "cannot open file";
+    } else if (fstat(fd, &st) != 0 || ! S_ISREG(st.st_mode)) {
+        mesg = "not a regular file";
+    } else if (st.st_size < FITS_BLOCK) {
+        mesg = "not a FITS file";
+    } else {
+        void* addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            mesg = "cannot map file in memory";
+        } else {
+            obj->addr = addr;
+            obj->size = st.st_size;
+            mesg = parse_hdus(obj);
+        }
+    }
+    if (fd >= 0) close(fd);
+    if (mesg != NULL) {
+        if (! quiet) y_errorq("%s (fits_mmap)", mesg);
+        ypush_nil();
+    }
+}
+
+void Y_is_fits_mmap(int argc)
+{
+    if (argc != 1) y_error("expecting exactly one argument");
+    const char* name = yget_obj(0, NULL);
+    ypush_int(name == fits_mmap_type.type_name ? 1 : 0);
+}
+
+/* Get HDU given by its 1-based number or by its EXTNAME. */
+static fits_hdu* get_hdu(fits_mmap* obj, int iarg)
+{
+    if (yarg_string(iarg) == 1) {
+        const char* name = ygets_q(iarg);
+        for (long i = 0; i < obj->nhdus; ++i) {
+            char* extname = get_string(obj, &obj->hdus[i], "EXTNAME");
+            int found = (extname != NULL && name != NULL &&
+                         strcmp(extname, name) == 0);
+            if (extname != NULL) p_free(extname);
+            if (found) return &obj->hdus[i];
+        }
+        y_errorq("no HDU with EXTNAME='%s'", name);
+    }
+    long i = ygets_l(iarg);
+    if (i < 1 || i > obj->nhdus) y_error("out of range HDU number");
+    return &obj->hdus[i-1];
+}
+
+/* Get selection of rows among NROWS at IARG (nil for all, scalar, index
+   range or list of 1-based indices).  A list of indices is converted in a
+   scratch buffer pushed on top of the stack. */
+static void get_rows(int iarg, long nrows, row_selection* sel)
+{
+    long mms[3];
+    memset(sel, 0, sizeof(row_selection));
+    sel->step = 1;
+    if (iarg < 0 || yarg_nil(iarg)) {
+        sel->count = nrows;
+        return;
+    }
+    int flags = yget_range(iarg, mms);
+    if (flags != 0) {
+        if ((flags & ~(Y_MIN_DFLT|Y_MAX_DFLT)) != 1) y_error("bad index range");
+        long step = mms[2];
+        long first = (flags & Y_MIN_DFLT) ? (step > 0 ? 1 : nrows) : mms[0];
+        long last = (flags & Y_MAX_DFLT) ? (step > 0 ? nrows : 1) : mms[1];
+        if (first <= 0) first += nrows;
+        if (last <= 0) last += nrows;
+        if (first < 1 || first > nrows || last < 1 || last > nrows) {
+            y_error("out of range row index");
+        }
+        sel->first = first - 1;
+        sel->step = step;
+        sel->count = (last - first)/step + 1;
+        if (sel->count < 0) sel->count = 0;
+        return;
+    }
+    int type = yarg_typeid(iarg);
+    if (type < Y_CHAR || type > Y_LONG) y_error("bad row index");
+    long ntot, dims[Y_DIMSIZE];
+    long* src = ygeta_l(iarg, &ntot, dims);
+    long* idx = ypush_scratch(ntot*sizeof(long), NULL);
+    for (long r = 0; r < ntot; ++r) {
+        long i = src[r];
+        if (i <= 0) i += nrows;
+        if (i < 1 || i > nrows) y_error("out of range row index");
+        idx[r] = i - 1;
+    }
+    sel->count = ntot;
+    sel->index = idx;
+    sel->scalar = (dims[0] == 0);
+}
+
+/* Copy string value of KEY in BUF (of FITS_CARD + 1 bytes), returns BUF or
+   NULL if KEY is not found. */
+static char* copy_string(const fits_mmap* obj, const fits_hdu* hdu,
+                         const char* key, char* buf)
+{
+    char* str = get_string(obj, hdu, key);
+    if (str == NULL) return NULL;
+    strncpy(buf, str, FITS_CARD);
+    buf[FITS_CARD] = '\0';
+    p_free(str);
+    return buf;
+}
+
+/* Parse the columns of a binary table (once).  In case of errors, the
+   columns are parsed again on next access. */
+static void parse_columns(fits_mmap* obj, fits_hdu* hdu)
+{
+    char key[32], buf[FITS_CARD + 1];
+    if (hdu->ncols >= 0) return;
+    free_columns(hdu);
+    char* xtension = copy_string(obj, hdu, "XTENSION", buf);
+    if (xtension == NULL || strcmp(xtension, "BINTABLE") != 0 ||
+        hdu->naxis != 2 || hdu->bitpix != 8) {
+        y_error("HDU is not a FITS binary table");
+    }
+    long tfields = get_integer(obj, hdu, "TFIELDS", -1);
+    if (tfields < 0) y_error("missing TFIELDS in FITS binary table");
+    hdu->cols = p_malloc((tfields + 1)*sizeof(bintable_column));
+    hdu->ttype = p_malloc((tfields + 1)*sizeof(char*));
+    memset(hdu->ttype, 0, (tfields + 1)*sizeof(char*));
+    hdu->nalloc = tfields;
+    long offset = 0;
+    for (long j = 0; j < tfields; ++j) {
+        bintable_column* col = &hdu->cols[j];
+        sprintf(key, "TTYPE%ld", j + 1);
+        hdu->ttype[j] = get_string(obj, hdu, key);
+        sprintf(key, "TFORM%ld", j + 1);
+        if (copy_string(obj, hdu, key, buf) == NULL) {
+            y_errorn("missing TFORM%ld in FITS binary table", j + 1);
+        }
+        parse_tform(col, buf, j + 1);
+        col->offset = offset;
+        offset += col->repeat*col->size;
+        sprintf(key, "TDIM%ld", j + 1);
+        parse_tdim(col, copy_string(obj, hdu, key, buf), j + 1);
+    }
+    if (offset > hdu->naxes[0]) {
+        y_error("inconsistent row size in FITS binary table");
+    }
+    hdu->ncols = tfields;
+}
+
+/* Get column given by its 1-based number or by its name. */
+static long get_column(fits_hdu* hdu, int iarg)
+{
+    if (yarg_string(iarg) == 1) {
+        const char* name = ygets_q(iarg);
+        for (long j = 0; j < hdu->ncols; ++j) {
+            if (hdu->ttype[j] != NULL && name != NULL &&
+                strcasecmp(hdu->ttype[j], name) == 0) {
+                return j;
+            }
+        }
+        y_errorq("no column named '%s' in FITS binary table", name);
+    }
+    long j = ygets_l(iarg);
+    if (j < 1 || j > hdu->ncols) y_error("out of range column number");
+    return j - 1;
+}
+
+void Y_fits_mmap_get(int argc)
+{
+    if (argc != 3) y_error("fits_mmap_get takes exactly 3 arguments");
+    fits_mmap* obj = yget_obj(2, &fits_mmap_type);
+    fits_hdu* hdu = get_hdu(obj, 1);
+    const char* key = ygets_q(0);
+    char upper[FITS_CARD + 1];
+    long len = (key == NULL ? 0 : strlen(key));
+    if (len < 1 || len > FITS_CARD - 11) y_error("invalid FITS keyword");
+    for (long i = 0; i <= len; ++i) {
+        upper[i] = toupper((unsigned char)key[i]);
+    }
+    while (len > 0 && upper[len-1] == ' ') upper[--len] = '\0';
+    const char* val = find_card(obj, hdu, upper);
+    if (val == NULL) {
+        ypush_nil();
+        return;
+    }
+    const char* card = (const char*)obj->addr + hdu->header;
+    const char* end = card + FITS_CARD*(1 + (val - card)/FITS_CARD);
+    long ival;
+    double dval;
+    char* str = NULL;
+    switch (parse_value(val, end, &ival, &dval, &str)) {
+    case 1: ypush_int((int)ival); break;
+    case 2: ypush_long(ival); break;
+    case 3: ypush_double(dval); break;
+    case 4: *ypush_q(NULL) = str; break;
+    default: ypush_nil();
+    }
+}
+
+void Y_fits_mmap_header(int argc)
+{
+    if (argc != 2) y_error("fits_mmap_header takes exactly 2 arguments");
+    fits_mmap* obj = yget_obj(1, &fits_mmap_type);
+    fits_hdu* hdu = get_hdu(obj, 0);
+    long dims[2] = {1, hdu->ncards};
+    ystring_t* cards = ypush_q(dims);
+    const char* card = (const char*)obj->addr + hdu->header;
+    for (long i = 0; i < hdu->ncards; ++i, card += FITS_CARD) {
+        cards[i] = p_strncat(NULL, card, FITS_CARD);
+    }
+}
+
+void Y_fits_mmap_image(int argc)
+{
+    if (argc < 2 || argc > 3) y_error("fits_mmap_image takes 2 or 3 arguments");
+    fits_mmap* obj = yget_obj(argc - 1, &fits_mmap_type);
+    fits_hdu* hdu = get_hdu(obj, argc - 2);
+    if (hdu->naxis < 1 || hdu->naxes[0] == 0) y_error("HDU has no image");
+    if (hdu->naxis >= Y_DIMSIZE) y_error("too many dimensions");
+    bintable_column col;
+    memset(&col, 0, sizeof(col));
+    switch (hdu->bitpix) {
+    case   8: col.code = 'B'; col.size = 1; break;
+    case  16: col.code = 'I'; col.size = 2; break;
+    case  32: col.code = 'j'; col.size = 4; break;
+    case  64: col.code = 'K'; col.size = 8; break;
+    case -32: col.code = 'E'; col.size = 4; break;
+    case -64: col.code = 'D'; col.size = 8; break;
+    default: y_error("invalid BITPIX");
+    }
+    // An image is decoded as a table with one column and one row per frame
+    // (the last dimension).
+    long nframes = hdu->naxes[hdu->naxis - 1];
+    col.ndims = hdu->naxis - 1;
+    col.repeat = 1;
+    for (int k = 0; k < col.ndims; ++k) {
+        col.dims[k] = hdu->naxes[k];
+        col.repeat *= hdu->naxes[k];
+    }
+    row_selection sel;
+    get_rows(argc > 2 ? 0 : -1, nframes, &sel);
+    push_column(&col, obj->addr + hdu->data, col.repeat*col.size, &sel, 1, 0);
+}
+
+void Y_fits_mmap_column(int argc)
+{
+    static char* knames[] = {"last", "trim", NULL};
+    static long kglobs[3];
+    int kiargs[2];
+    int iargs[4] = {-1, -1, -1, -1}, nargs = 0;
+    yarg_kw_init(knames, kglobs, kiargs);
+    for (int iarg = argc - 1; iarg >= 0; ) {
+        iarg = yarg_kw(iarg, kglobs, kiargs);
+        if (iarg < 0) break;
+        if (nargs >= 4) y_error("too many arguments");
+        iargs[nargs++] = iarg--;
+    }
+    if (nargs < 3) y_error("expecting at least 3 arguments");
+    int last = (kiargs[0] >= 0 && yarg_true(kiargs[0]));
+    int trim = (kiargs[1] >= 0 && yarg_true(kiargs[1]));
+    fits_mmap* obj = yget_obj(iargs[0], &fits_mmap_type);
+    fits_hdu* hdu = get_hdu(obj, iargs[1]);
+    parse_columns(obj, hdu);
+    long j = get_column(hdu, iargs[2]);
+    bintable_column col = hdu->cols[j];
+    if (! is_decodable(&col)) {
+        ypush_nil();
+        return;
+    }
+    row_selection sel;
+    get_rows(iargs[3], hdu->naxes[1], &sel);
+    push_column(&col, obj->addr + hdu->data, hdu->naxes[0], &sel, last, trim);
+}
+
+void Y_fits_mmap_advise(int argc)
+{
+    if (argc < 2 || argc > 4) y_error("fits_mmap_advise takes 2 to 4 arguments");
+    fits_mmap* obj = yget_obj(argc - 1, &fits_mmap_type);
+    const char* name = ygets_q(argc - 2);
+    int advice = POSIX_MADV_NORMAL;
+    if (name == NULL) {
+        y_error("invalid advice");
+    } else if (strcmp(name, "normal") == 0) {
+        advice = POSIX_MADV_NORMAL;
+    } else if (strcmp(name, "sequential") == 0) {
+        advice = POSIX_MADV_SEQUENTIAL;
+    } else if (strcmp(name, "random") == 0) {
+        advice = POSIX_MADV_RANDOM;
+    } else if (strcmp(name, "willneed") == 0) {
+        advice = POSIX_MADV_WILLNEED;
+    } else if (strcmp(name, "dontneed") == 0) {
+        advice = POSIX_MADV_DONTNEED;
+    } else {
+        y_errorq("unknown advice \"%s\"", name);
+    }
+    size_t first = 0, last = obj->size; // byte range
+    if (argc > 2 && ! yarg_nil(argc - 3)) {
+        fits_hdu* hdu = get_hdu(obj, argc - 3);
+        first = hdu->data;
+        last = hdu->data + hdu->size;
+        if (argc > 3 && ! yarg_nil(0) && hdu->naxis >= 1) {
+            // Range of rows (frames for an image).
+            if (hdu->naxis >= Y_DIMSIZE) y_error("too many dimensions");
+            size_t pitch = (hdu->bitpix >= 0 ? hdu->bitpix : -hdu->bitpix)/8;
+            for (int k = 0; k < hdu->naxis - 1; ++k) pitch *= hdu->naxes[k];
+            long nrows = hdu->naxes[hdu->naxis - 1];
+            row_selection sel;
+            get_rows(0, nrows, &sel);
+            if (sel.count > 0) {
+                long rmin = ROW(&sel, 0), rmax = rmin;
+                for (long r = 1; r < sel.count; ++r) {
+                    long i = ROW(&sel, r);
+                    if (i < rmin) rmin = i;
+                    if (i > rmax) rmax = i;
+                }
+                first = hdu->data + rmin*pitch;
+                last = hdu->data + (rmax + 1)*pitch;
+            } else {
+                last = first;
+            }
+        }
+    }
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    first -= first%page;
+    if (last > first &&
+        posix_madvise(obj->addr + first, last - first, advice) != 0) {
+        y_error("posix_madvise failed");
+    }
+    ypush_nil();
+}
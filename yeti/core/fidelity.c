@@ -0,0 +1,486 @@
+/*
+ * fidelity.c -
+ *
+ * Implement data fidelity terms for interferometric data (powerspectrum,
+ * complex visibilities, bispectrum and their amplitudes and phases).
+ *
+ *-----------------------------------------------------------------------------
+ *
+ * This file is part of Yeti (https://github.com/emmt/Yeti) released under the
+ * MIT "Expat" license.
+ *
+ * Copyright (C) 1996-2020: Éric Thiébaut.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <yapi.h>
+#include <pstdlib.h>
+#include "yeti.h"
+
+#define TWO_PI           6.28318530717958647692528676656
+#define ONE_OVER_TWO_PI  0.159154943091895335768883763373
+
+/* Kinds of data. */
+typedef enum {
+    VIS2 = 0,  // powerspectrum
+    VIS,       // complex visibilities
+    VISAMP,    // visibility amplitudes
+    VISPHI,    // visibility phases
+    T3,        // complex bispectrum
+    T3AMP,     // bispectrum amplitudes
+    T3PHI,     // closure phases
+    NKINDS
+} term_kind;
+
+static const char* kind_names[NKINDS] = {
+    "vis2", "vis", "visamp", "visphi", "t3", "t3amp", "t3phi"
+};
+
+/* Approximations of the phase penalty (same values as in MiRA). */
+#define HANIFF_APPROX    1
+#define CONVEX_LIMIT     2
+#define VON_MISES_APPROX 3
+
+/*
+ * A term stores the data of a given kind.  For the bispectrum terms, `idx` and
+ * `sgn` are 3-by-`n` arrays, the model being the product of 3 complex
+ * visibilities whose imaginary parts are multiplied by the signs.  Otherwise,
+ * `idx` has `n` elements.  Indices are 0-based.  The complex data have members
+ * `re`, `im`, `wrr`, `wri` and `wii`, the other data have members `dat` and
+ * `wgt`.
+ */
+typedef struct term term;
+struct term {
+    term* next;
+    int kind;
+    int approx;     // phase approximation for VISPHI and T3PHI
+    long n;         // number of measurements
+    long* idx;      // indices of model complex visibilities
+    double* sgn;    // signs for T3, T3AMP and T3PHI
+    double* dat;
+    double* wgt;
+    double* re;
+    double* im;
+    double* wrr;
+    double* wri;
+    double* wii;
+};
+
+typedef struct {
+    long nfreqs;    // number of model complex visibilities
+    long nterms;    // number of terms
+    term* first;
+    term* last;
+    double* polar;  // workspace for amplitudes and phases of the model
+} fidelity;
+
+#define FIDELITY_TYPE_NAME "data fidelity"
+
+static void fidelity_free(void* addr)
+{
+    fidelity* obj = addr;
+    term* t = obj->first;
+    if (obj->polar != NULL) {
+        p_free(obj->polar);
+        obj->polar = NULL;
+    }
+    obj->first = NULL;
+    obj->last = NULL;
+    while (t != NULL) {
+        term* next = t->next;
+        p_free(t); // arrays are in the same memory block
+        t = next;
+    }
+}
+
+static void fidelity_print(void* addr)
+{
+    fidelity* obj = addr;
+    char buffer[100];
+    snprintf(buffer, sizeof(buffer), " (nfreqs = %ld, nterms = %ld)",
+             obj->nfreqs, obj->nterms);
+    buffer[sizeof(buffer)-1] = 0;
+    y_print(FIDELITY_TYPE_NAME, 0);
+    y_print(buffer, 1);
+}
+
+static inline double arc(double x)
+{
+    return x - TWO_PI*round(ONE_OVER_TWO_PI*x);
+}
+
+static inline double reciprocal(double x)
+{
+    return (x != 0.0 ? 1.0/x : 0.0);
+}
+
+/* Cost of phase error `err` with weight `wgt`, `*grd` is set to the
+   derivative of the cost with respect to the model phase. */
+static inline double phase_cost(int approx, double wgt, double err,
+                                double* grd)
+{
+    if (approx == VON_MISES_APPROX) {
+        double s = sin(0.5*err);
+        *grd = 2.0*wgt*sin(err);
+        return 4.0*wgt*s*s;
+    } else if (approx == HANIFF_APPROX) {
+        double a = arc(err);
+        *grd = 2.0*wgt*a;
+        return wgt*a*a;
+    } else /* CONVEX_LIMIT */ {
+        double s = sin(err);
+        *grd = wgt*sin(err + err);
+        return wgt*s*s;
+    }
+}
+
+/* Cost of complex residuals (`err_re`,`err_im`) with weights `wrr`, `wri` and
+   `wii`, the gradient with respect to the model is stored in `g`. */
+static inline double complex_cost(const term* t, long j,
+                                  double err_re, double err_im, double g[2])
+{
+    double tmp_re = t->wrr[j]*err_re + t->wri[j]*err_im;
+    double tmp_im = t->wri[j]*err_re + t->wii[j]*err_im;
+    g[0] = tmp_re + tmp_re;
+    g[1] = tmp_im + tmp_im;
+    return tmp_re*err_re + tmp_im*err_im;
+}
+
+/* Integrate the cost of a term and, if `grd` is not NULL, its gradient with
+   respect to the model complex visibilities `vis`.  Array `polar` has the
+   amplitudes and phases of the model complex visibilities. */
+static double term_cost(const term* t, const double* vis, const double* polar,
+                        double* grd)
+{
+    double cost = 0.0, g[2];
+    const long n = t->n;
+    const long* idx = t->idx;
+    switch (t->kind) {
+    case VIS2:
+        for (long j = 0; j < n; ++j) {
+            long k = idx[j];
+            double re = vis[2*k], im = vis[2*k+1];
+            double err = (re*re + im*im) - t->dat[j];
+            double wgt_err = t->wgt[j]*err;
+            cost += wgt_err*err;
+            if (grd != NULL) {
+                double fct = 4.0*wgt_err;
+                grd[2*k] += fct*re;
+                grd[2*k+1] += fct*im;
+            }
+        }
+        break;
+    case VIS:
+        for (long j = 0; j < n; ++j) {
+            long k = idx[j];
+            cost += complex_cost(t, j, vis[2*k] - t->re[j],
+                                 vis[2*k+1] - t->im[j], g);
+            if (grd != NULL) {
+                grd[2*k] += g[0];
+                grd[2*k+1] += g[1];
+            }
+        }
+        break;
+    case VISAMP:
+        for (long j = 0; j < n; ++j) {
+            long k = idx[j];
+            double re = vis[2*k], im = vis[2*k+1];
+            double amp = polar[2*k];
+            double err = amp - t->dat[j];
+            double wgt_err = t->wgt[j]*err;
+            cost += wgt_err*err;
+            if (grd != NULL) {
+                double fct = 2.0*wgt_err*reciprocal(amp);
+                grd[2*k] += fct*re;
+                grd[2*k+1] += fct*im;
+            }
+        }
+        break;
+    case VISPHI:
+        for (long j = 0; j < n; ++j) {
+            long k = idx[j];
+            double re = vis[2*k], im = vis[2*k+1];
+            cost += phase_cost(t->approx, t->wgt[j], polar[2*k+1] - t->dat[j],
+                               &g[0]);
+            if (grd != NULL) {
+                double fct = g[0]*reciprocal(re*re + im*im);
+                grd[2*k] -= fct*im;
+                grd[2*k+1] += fct*re;
+            }
+        }
+        break;
+    case T3:
+        for (long j = 0; j < n; ++j) {
+            const long* k = idx + 3*j;
+            const double* s = t->sgn + 3*j;
+            double re1 = vis[2*k[0]], im1 = s[0]*vis[2*k[0]+1];
+            double re2 = vis[2*k[1]], im2 = s[1]*vis[2*k[1]+1];
+            double re3 = vis[2*k[2]], im3 = s[2]*vis[2*k[2]+1];
+            double re12 = re1*re2 - im1*im2;
+            double im12 = re1*im2 + im1*re2;
+            double mdl_re = re12*re3 - im12*im3;
+            double mdl_im = re12*im3 + im12*re3;
+            cost += complex_cost(t, j, mdl_re - t->re[j],
+                                 mdl_im - t->im[j], g);
+            if (grd != NULL) {
+                /* The gradient w.r.t. the 1st complex visibility is
+                   conj(z2*z3)*g and similarly for the others. */
+                double wre, wim;
+                wre = re2*re3 - im2*im3;
+                wim = re2*im3 + im2*re3;
+                grd[2*k[0]] += wre*g[0] + wim*g[1];
+                grd[2*k[0]+1] += (wre*g[1] - wim*g[0])*s[0];
+                wre = re1*re3 - im1*im3;
+                wim = re1*im3 + im1*re3;
+                grd[2*k[1]] += wre*g[0] + wim*g[1];
+                grd[2*k[1]+1] += (wre*g[1] - wim*g[0])*s[1];
+                grd[2*k[2]] += re12*g[0] + im12*g[1];
+                grd[2*k[2]+1] += (re12*g[1] - im12*g[0])*s[2];
+            }
+        }
+        break;
+    case T3AMP:
+        for (long j = 0; j < n; ++j) {
+            const long* k = idx + 3*j;
+            double mdl = polar[2*k[0]]*polar[2*k[1]]*polar[2*k[2]];
+            double err = mdl - t->dat[j];
+            double wgt_err = t->wgt[j]*err;
+            cost += wgt_err*err;
+            if (grd != NULL) {
+                double q = 2.0*wgt_err*mdl;
+                for (int l = 0; l < 3; ++l) {
+                    double amp = polar[2*k[l]];
+                    double fct = q*reciprocal(amp*amp);
+                    grd[2*k[l]] += fct*vis[2*k[l]];
+                    grd[2*k[l]+1] += fct*vis[2*k[l]+1];
+                }
+            }
+        }
+        break;
+    case T3PHI:
+        for (long j = 0; j < n; ++j) {
+            const long* k = idx + 3*j;
+            const double* s = t->sgn + 3*j;
+            double mdl = (s[0]*polar[2*k[0]+1] + s[1]*polar[2*k[1]+1] +
+                          s[2]*polar[2*k[2]+1]);
+            cost += phase_cost(t->approx, t->wgt[j], mdl - t->dat[j], &g[0]);
+            if (grd != NULL) {
+                for (int l = 0; l < 3; ++l) {
+                    double re = vis[2*k[l]], im = vis[2*k[l]+1];
+                    double fct = s[l]*g[0]*reciprocal(re*re + im*im);
+                    grd[2*k[l]] -= fct*im;
+                    grd[2*k[l]+1] += fct*re;
+                }
+            }
+        }
+        break;
+    }
+    return cost;
+}
+
+static void fidelity_eval(void* addr, int argc)
+{
+    fidelity* obj = addr;
+    long dims[Y_DIMSIZE], ntot, ref = -1;
+
+    if (argc == 2) {
+        ref = yget_ref(0);
+        if (ref < 0) y_error("expecting a simple variable reference for GRD");
+        yarg_drop(1);
+    } else if (argc != 1) {
+        y_error("syntax: obj(vis) or obj(vis, grd) with obj a data fidelity");
+    }
+    const double* vis = ygeta_d(0, &ntot, dims);
+    if (dims[0] != 2 || dims[1] != 2 || dims[2] != obj->nfreqs) {
+        y_error("expecting a 2-by-NFREQS array of complex visibilities");
+    }
+    double* grd = NULL;
+    if (ref >= 0) {
+        grd = ypush_d(dims);
+        memset(grd, 0, ntot*sizeof(double));
+    }
+
+    /* Compute the amplitudes and phases of the model once for all terms. */
+    const double* polar = NULL;
+    for (const term* t = obj->first; t != NULL; t = t->next) {
+        if (t->kind != VIS2 && t->kind != VIS && t->kind != T3) {
+            if (obj->polar == NULL) {
+                obj->polar = p_malloc(2*obj->nfreqs*sizeof(double));
+                if (obj->polar == NULL) y_error("insufficient memory");
+            }
+            for (long k = 0; k < obj->nfreqs; ++k) {
+                double re = vis[2*k], im = vis[2*k+1];
+                obj->polar[2*k] = sqrt(re*re + im*im);
+                obj->polar[2*k+1] = ((re != 0.0 || im != 0.0) ?
+                                     atan2(im, re) : 0.0);
+            }
+            polar = obj->polar;
+            break;
+        }
+    }
+
+    double cost = 0.0;
+    for (const term* t = obj->first; t != NULL; t = t->next) {
+        cost += term_cost(t, vis, polar, grd);
+    }
+    if (ref >= 0) {
+        yput_global(ref, 0);
+    }
+    ypush_double(cost);
+}
+
+static void fidelity_extract(void* addr, char* name)
+{
+    fidelity* obj = addr;
+    int c0 = name[0];
+    if (c0 == 'n' && strcmp(name, "nfreqs") == 0) {
+        ypush_long(obj->nfreqs);
+    } else if (c0 == 'n' && strcmp(name, "nterms") == 0) {
+        ypush_long(obj->nterms);
+    } else if (c0 == 'n' && strcmp(name, "ndata") == 0) {
+        long ndata = 0;
+        for (const term* t = obj->first; t != NULL; t = t->next) {
+            ndata += ((t->kind == VIS || t->kind == T3) ? 2*t->n : t->n);
+        }
+        ypush_long(ndata);
+    } else {
+        y_error("unknown data fidelity member");
+    }
+}
+
+static y_userobj_t fidelity_type = {
+    FIDELITY_TYPE_NAME,
+    fidelity_free,
+    fidelity_print,
+    fidelity_eval,
+    fidelity_extract,
+    NULL
+};
+
+void Y_fidelity_new(int argc)
+{
+    if (argc != 1) y_error("expecting exactly one argument");
+    long nfreqs = ygets_l(0);
+    if (nfreqs < 1) y_error("invalid number of complex visibilities");
+    fidelity* obj = ypush_obj(&fidelity_type, sizeof(fidelity));
+    obj->nfreqs = nfreqs;
+}
+
+/* Get the `n` values of argument `iarg`. */
+static const double* get_values(int iarg, long n, const char* name)
+{
+    long ntot;
+    const double* src = ygeta_d(iarg, &ntot, NULL);
+    if (ntot != n) {
+        y_errorq("bad number of elements for %s", name);
+    }
+    return src;
+}
+
+void Y_fidelity_add(int argc)
+{
+    static const char* names[] = {"RE", "IM", "WRR", "WRI", "WII"};
+    const double* vals[5];
+
+    if (argc != 7 && argc != 10) {
+        y_error("expecting 7 or 10 arguments");
+    }
+    fidelity* obj = yget_obj(argc - 1, &fidelity_type);
+    const char* kind_name = ygets_q(argc - 2);
+    int kind = -1;
+    for (int i = 0; i < NKINDS; ++i) {
+        if (kind_name != NULL && strcmp(kind_name, kind_names[i]) == 0) {
+            kind = i;
+            break;
+        }
+    }
+    if (kind < 0) y_error("unknown kind of data");
+    int complex_data = (kind == VIS || kind == T3);
+    int triple = (kind == T3 || kind == T3AMP || kind == T3PHI);
+    if (argc != (complex_data ? 10 : 7)) {
+        y_error("bad number of arguments for this kind of data");
+    }
+    int approx = ygets_i(argc - 3);
+    if ((kind == VISPHI || kind == T3PHI) &&
+        approx != HANIFF_APPROX && approx != CONVEX_LIMIT &&
+        approx != VON_MISES_APPROX) {
+        y_error("invalid phase approximation");
+    }
+
+    /* Get and check all the arguments before creating the new term. */
+    long nidx;
+    const long* idx = ygeta_l(argc - 4, &nidx, NULL);
+    if (triple && nidx%3 != 0) {
+        y_error("number of indices must be a multiple of 3");
+    }
+    for (long j = 0; j < nidx; ++j) {
+        if (idx[j] < 1 || idx[j] > obj->nfreqs) y_error("out of range index");
+    }
+    long n = (triple ? nidx/3 : nidx);
+    const double* sgn = NULL;
+    if (! yarg_nil(argc - 5)) {
+        sgn = get_values(argc - 5, nidx, "SGN");
+    } else if (kind == T3 || kind == T3PHI) {
+        y_error("signs must be specified");
+    }
+    int nvals = (complex_data ? 5 : 2);
+    for (int i = 0; i < nvals; ++i) {
+        vals[i] = get_values(argc - 6 - i, n,
+                             (complex_data ? names[i] : i == 0 ? "DAT" : "WGT"));
+    }
+
+    /* Allocate all the arrays of the term in a single block and append the
+       term to the list. */
+    size_t size = sizeof(term) + nidx*(sizeof(long) + sizeof(double)) +
+        nvals*n*sizeof(double);
+    term* t = p_malloc(size);
+    if (t == NULL) y_error("insufficient memory");
+    memset(t, 0, sizeof(term));
+    double* buf = (double*)((char*)t + sizeof(term));
+    t->sgn = buf;
+    buf += nidx;
+    for (int i = 0; i < nvals; ++i) {
+        memcpy(buf, vals[i], n*sizeof(double));
+        if (complex_data) {
+            switch (i) {
+            case 0: t->re  = buf; break;
+            case 1: t->im  = buf; break;
+            case 2: t->wrr = buf; break;
+            case 3: t->wri = buf; break;
+            case 4: t->wii = buf; break;
+            }
+        } else if (i == 0) {
+            t->dat = buf;
+        } else {
+            t->wgt = buf;
+        }
+        buf += n;
+    }
+    t->idx = (long*)buf;
+    for (long j = 0; j < nidx; ++j) {
+        t->idx[j] = idx[j] - 1;
+        t->sgn[j] = (sgn != NULL ? sgn[j] : 1.0);
+    }
+    t->kind = kind;
+    t->approx = approx;
+    t->n = n;
+    if (obj->last == NULL) {
+        obj->first = t;
+    } else {
+        obj->last->next = t;
+    }
+    obj->last = t;
+    ++obj->nterms;
+    yarg_drop(argc - 1); // leave object on top of stack
+}
+
+void Y_is_fidelity(int argc)
+{
+    if (argc != 1) y_error("expecting exactly one argument");
+    const char* name = yget_obj(0, NULL);
+    ypush_int(name == fidelity_type.type_name ? 1 : 0);
+}
@@ -47,6 +47,7 @@ extern BuiltIn Y_nrefsof;
 extern BuiltIn Y_smooth3;
 extern BuiltIn Y_insure_temporary;
 extern BuiltIn Y_product;
+extern BuiltIn Y_yeti_nthreads;
 
 /*---------------------------------------------------------------------------*/
 /* INITIALIZATION OF YETI */
@@ -448,6 +449,19 @@ void Y_fpe_handling(int argc)
   ypush_nil();
 }
 
+/*---------------------------------------------------------------------------*/
+/* MULTI-THREADING */
+
+void Y_yeti_nthreads(int argc)
+{
+  if (argc > 1) yor_error("yeti_nthreads: takes at most one argument");
+  int nthreads = yor_get_max_threads();
+  if (argc == 1 && ! yarg_nil(0)) {
+    yor_set_max_threads(ygets_i(0));
+  }
+  ypush_int(nthreads);
+}
+
 /*---------------------------------------------------------------------------*/
 /* MACHINE DEPENDENT CONSTANTS */
 
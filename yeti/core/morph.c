@@ -18,41 +18,91 @@
 
 #include "config.h"
 #include "yeti.h"
+#include <limits.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+/* A structuring element containing the origin is decomposed into runs of
+   consecutive offsets along the 1st dimension.  The dilation (erosion) by a
+   run is computed by the van Herk/Gil-Werman algorithm at a cost of 3
+   comparisons per voxel whatever the length of the run.  If all runs are
+   identical and form a box, the operation is separable; otherwise, the
+   results for the runs are combined with the proper offsets along the 2nd
+   and 3rd dimensions. */
+typedef struct morph_run {
+  long x0, x1; /* first and last offsets along 1st dimension */
+  long dy, dz; /* offsets along 2nd and 3rd dimensions */
+} morph_run_t;
+
+typedef struct morph_plan {
+  long width, height, depth; /* dimensions (all at least 1) */
+  const morph_run_t* runs;   /* runs sorted by increasing (x0,x1) */
+  long nruns;                /* number of runs */
+  int box;                   /* structuring element is a box? */
+  long y0, y1, z0, z1;       /* bounds of the box along 2nd and 3rd dims */
+  long buflen;               /* number of voxels for one line buffer */
+  int nthreads;              /* number of threads */
+} morph_plan_t;
+
+#define MORPH_JOIN(a,b)  MORPH_JOIN_(a,b)
+#define MORPH_JOIN_(a,b) a##b
 
 #define voxel_t            unsigned char
+#define voxel_min          0
+#define voxel_max          UCHAR_MAX
 #define MORPH_DILATION     dilation_c
 #define MORPH_EROSION      erosion_c
+#define MORPH_FAST         morph_fast_c
 #include __FILE__
 
 #define voxel_t            short
+#define voxel_min          SHRT_MIN
+#define voxel_max          SHRT_MAX
 #define MORPH_DILATION     dilation_s
 #define MORPH_EROSION      erosion_s
+#define MORPH_FAST         morph_fast_s
 #include __FILE__
 
 #define voxel_t            int
+#define voxel_min          INT_MIN
+#define voxel_max          INT_MAX
 #define MORPH_DILATION     dilation_i
 #define MORPH_EROSION      erosion_i
+#define MORPH_FAST         morph_fast_i
 #include __FILE__
 
 #define voxel_t            long
+#define voxel_min          LONG_MIN
+#define voxel_max          LONG_MAX
 #define MORPH_DILATION     dilation_l
 #define MORPH_EROSION      erosion_l
+#define MORPH_FAST         morph_fast_l
 #include __FILE__
 
 #define voxel_t            float
+#define voxel_min          (-INFINITY)
+#define voxel_max          INFINITY
 #define MORPH_DILATION     dilation_f
 #define MORPH_EROSION      erosion_f
+#define MORPH_FAST         morph_fast_f
 #include __FILE__
 
 #define voxel_t            double
+#define voxel_min          (-INFINITY)
+#define voxel_max          INFINITY
 #define MORPH_DILATION     dilation_d
 #define MORPH_EROSION      erosion_d
+#define MORPH_FAST         morph_fast_d
 #include __FILE__
 
 static void morph_op(int argc, int mop);
 static long* get_offset(Symbol* s, Dimension** dims);
+static int morph_plan(morph_plan_t* plan, morph_run_t runs[],
+                      long width, long height, long depth,
+                      const long dx[], const long dy[], const long dz[],
+                      long number);
 
 extern BuiltIn Y_morph_erosion, Y_morph_dilation;
 
@@ -175,12 +225,37 @@ static void morph_op(int argc, int mop)
     dz = (ndims >= 3 ? dy + number : NULL);
   }
 
+  /* Decompose the structuring element and allocate workspaces (must be
+     done before pushing the result). */
+  if (width < 1) width = 1;
+  if (height < 1) height = 1;
+  if (depth < 1) depth = 1;
+  CheckStack(3);
+  morph_run_t* runs = yor_push_workspace(number*sizeof(morph_run_t));
+  morph_plan_t plan;
+  char* buf = NULL;
+  char* tmp = NULL;
+  int fast = morph_plan(&plan, runs, width, height, depth,
+                        dx, dy, dz, number);
+  if (fast) {
+    size_t elsize = op.type.base->size;
+    size_t nbuf = 2*(size_t)plan.nthreads*plan.buflen;
+    size_t ntmp = (plan.box ? 0 : (size_t)width*height*depth);
+    buf = yor_push_workspace((nbuf + ntmp)*elsize);
+    tmp = buf + nbuf*elsize;
+  }
+
   /* Allocate output array and apply the operation. */
   Array* ap = ((Array*)PushDataBlock(NewArray(op.type.base, op.type.dims)));
   switch (op.ops->typeID) {
 #undef _
-#define _(T) (mop ? dilation_##T : erosion_##T)((void*)ap->value.T, \
-              op.value, width, height, depth, dx, dy, dz, number); break
+#define _(T) if (fast) {                                                \
+                morph_fast_##T(mop, (void*)ap->value.T, op.value,       \
+                               (void*)tmp, (void*)buf, &plan);          \
+              } else {                                                  \
+                (mop ? dilation_##T : erosion_##T)((void*)ap->value.T,  \
+                      op.value, width, height, depth, dx, dy, dz, number); \
+              } break
   case YOR_CHAR:   _(c);
   case YOR_SHORT:  _(s);
   case YOR_INT:    _(i);
@@ -193,6 +268,109 @@ static void morph_op(int argc, int mop)
   }
 }
 
+static int compare_offsets(const void* p1, const void* p2)
+{
+  const morph_run_t* a = p1;
+  const morph_run_t* b = p2;
+  if (a->dz != b->dz) return (a->dz < b->dz ? -1 : 1);
+  if (a->dy != b->dy) return (a->dy < b->dy ? -1 : 1);
+  if (a->x0 != b->x0) return (a->x0 < b->x0 ? -1 : 1);
+  return 0;
+}
+
+static int compare_runs(const void* p1, const void* p2)
+{
+  const morph_run_t* a = p1;
+  const morph_run_t* b = p2;
+  if (a->x0 != b->x0) return (a->x0 < b->x0 ? -1 : 1);
+  if (a->x1 != b->x1) return (a->x1 < b->x1 ? -1 : 1);
+  return compare_offsets(p1, p2);
+}
+
+/* Decompose the structuring element given by the NUMBER offsets DX, DY and
+   DZ into runs along the 1st dimension (RUNS must have NUMBER elements) and
+   fill PLAN.  Offsets along dimensions that are ignored by the brute force
+   algorithm are ignored.  Returns whether the fast algorithm is applicable
+   (the structuring element must contain the origin) and expected to be
+   faster. */
+static int morph_plan(morph_plan_t* plan, morph_run_t runs[],
+                      long width, long height, long depth,
+                      const long dx[], const long dy[], const long dz[],
+                      long number)
+{
+  int use_dy = (dy != NULL && (depth > 1 || height > 1));
+  int use_dz = (dz != NULL && depth > 1);
+  long i, n, ngroups, nlines, cost, buflen;
+  int origin = 0;
+
+  if (number < 1) return 0;
+  for (i = 0; i < number; ++i) {
+    runs[i].x0 = runs[i].x1 = dx[i];
+    runs[i].dy = (use_dy ? dy[i] : 0);
+    runs[i].dz = (use_dz ? dz[i] : 0);
+    if (runs[i].x0 == 0 && runs[i].dy == 0 && runs[i].dz == 0) origin = 1;
+  }
+  if (! origin) return 0;
+
+  /* Merge consecutive offsets (and duplicates) into runs. */
+  qsort(runs, number, sizeof(morph_run_t), compare_offsets);
+  n = 0;
+  for (i = 1; i < number; ++i) {
+    if (runs[i].dy == runs[n].dy && runs[i].dz == runs[n].dz &&
+        runs[i].x0 <= runs[n].x1 + 1) {
+      runs[n].x1 = runs[i].x0;
+    } else {
+      runs[++n] = runs[i];
+    }
+  }
+  plan->nruns = ++n;
+
+  /* Group identical runs and check whether they form a box. */
+  qsort(runs, n, sizeof(morph_run_t), compare_runs);
+  ngroups = 0;
+  nlines = 0;
+  buflen = 0;
+  for (i = 0; i < n; ++i) {
+    if (i == 0 || runs[i].x0 != runs[i-1].x0 || runs[i].x1 != runs[i-1].x1) {
+      ++ngroups;
+      if (runs[i].x0 != 0 || runs[i].x1 != 0) ++nlines;
+      if (buflen < width + runs[i].x1 - runs[i].x0) {
+        buflen = width + runs[i].x1 - runs[i].x0;
+      }
+    }
+  }
+  plan->y0 = plan->y1 = plan->z0 = plan->z1 = 0;
+  for (i = 0; i < n; ++i) {
+    if (runs[i].dy < plan->y0) plan->y0 = runs[i].dy;
+    if (runs[i].dy > plan->y1) plan->y1 = runs[i].dy;
+    if (runs[i].dz < plan->z0) plan->z0 = runs[i].dz;
+    if (runs[i].dz > plan->z1) plan->z1 = runs[i].dz;
+  }
+  plan->box = (ngroups == 1 &&
+               n == (plan->y1 - plan->y0 + 1)*(plan->z1 - plan->z0 + 1));
+
+  /* Approximate number of comparisons per voxel. */
+  if (plan->box) {
+    cost = 3*(nlines + (plan->y0 < plan->y1) + (plan->z0 < plan->z1));
+    if (buflen < height + plan->y1 - plan->y0) {
+      buflen = height + plan->y1 - plan->y0;
+    }
+    if (buflen < depth + plan->z1 - plan->z0) {
+      buflen = depth + plan->z1 - plan->z0;
+    }
+  } else {
+    cost = 3*nlines + n;
+  }
+  if (cost >= number) return 0;
+  plan->width = width;
+  plan->height = height;
+  plan->depth = depth;
+  plan->runs = runs;
+  plan->buflen = buflen;
+  plan->nthreads = yor_nthreads((size_t)width*height*depth*cost);
+  return 1;
+}
+
 /* almost the same as YGet_L */
 static long* get_offset(Symbol* s, Dimension** dims)
 {
@@ -403,9 +581,158 @@ static void MORPH_EROSION _(<)
 #endif /* MORPH_EROSION */
 #undef _
 
+#ifdef MORPH_FAST
+
+/* Dilation (erosion) of the N voxels of a line separated by STRIDE by the
+   window of offsets A to B (with A <= B) using the van Herk/Gil-Werman
+   algorithm.  Out of range voxels are replaced by PAD, the neutral element
+   of the operation.  Buffers G and H must have at least N + B - A elements.
+   DST and SRC may be the same. */
+#define _(CMP, PAD) (voxel_t dst[], const voxel_t src[],			\
+                     long n, long stride, long a, long b,		\
+                     voxel_t g[], voxel_t h[])				\
+{									\
+  long k = b - a + 1, len = n + k - 1;					\
+  long i, j, j0, j1, lo, hi;						\
+  voxel_t v;								\
+									\
+  /* Padded line in H. */						\
+  lo = (a < 0 ? (-a < len ? -a : len) : 0);				\
+  hi = (n - a < len ? n - a : len);					\
+  if (hi < lo) hi = lo;							\
+  for (j = 0; j < lo; ++j) h[j] = PAD;					\
+  for (j = lo; j < hi; ++j) h[j] = src[(j + a)*stride];			\
+  for (j = hi; j < len; ++j) h[j] = PAD;				\
+									\
+  /* Forward (in G) and backward (in H) running extrema by blocks of K	\
+     voxels. */								\
+  for (j0 = 0; j0 < len; j0 = j1) {					\
+    j1 = (j0 + k < len ? j0 + k : len);					\
+    v = h[j0];								\
+    g[j0] = v;								\
+    for (j = j0 + 1; j < j1; ++j) {					\
+      if (h[j] CMP v) v = h[j];						\
+      g[j] = v;								\
+    }									\
+    v = h[j1 - 1];							\
+    for (j = j1 - 2; j >= j0; --j) {					\
+      if (v CMP h[j]) h[j] = v; else v = h[j];				\
+    }									\
+  }									\
+									\
+  /* A window of K voxels overlaps at most 2 blocks. */			\
+  for (i = 0; i < n; ++i) {						\
+    v = h[i];								\
+    if (g[i + k - 1] CMP v) v = g[i + k - 1];				\
+    dst[i*stride] = v;							\
+  }									\
+}
+static void MORPH_JOIN(MORPH_FAST,_dilation_line) _(>, voxel_min)
+static void MORPH_JOIN(MORPH_FAST,_erosion_line) _(<, voxel_max)
+#undef _
+
+#define _(CMP) (voxel_t dst[], const voxel_t src[], long n)		\
+{									\
+  for (long i = 0; i < n; ++i) {					\
+    if (src[i] CMP dst[i]) dst[i] = src[i];				\
+  }									\
+}
+static void MORPH_JOIN(MORPH_FAST,_dilation_combine) _(>)
+static void MORPH_JOIN(MORPH_FAST,_erosion_combine) _(<)
+#undef _
+
+/* Apply the plan (see morph_plan) to SRC.  TMP has as many voxels as SRC
+   (it is only used if the structuring element is not a box) and BUF has
+   2*NTHREADS*BUFLEN voxels. */
+static void MORPH_FAST(int mop, voxel_t dst[], const voxel_t src[],
+                       voxel_t tmp[], voxel_t buf[], const morph_plan_t* plan)
+{
+  void (*line)(voxel_t*, const voxel_t*, long, long, long, long,
+               voxel_t*, voxel_t*) =
+    (mop ? MORPH_JOIN(MORPH_FAST,_dilation_line) :
+     MORPH_JOIN(MORPH_FAST,_erosion_line));
+  void (*combine)(voxel_t*, const voxel_t*, long) =
+    (mop ? MORPH_JOIN(MORPH_FAST,_dilation_combine) :
+     MORPH_JOIN(MORPH_FAST,_erosion_combine));
+  const morph_run_t* runs = plan->runs;
+  long width = plan->width, height = plan->height, depth = plan->depth;
+  long nrows = height*depth, buflen = plan->buflen;
+  long i0, i1, t, x0, x1;
+  int nthreads = plan->nthreads;
+
+  /* Each thread processes a contiguous range of lines with its own part of
+     the buffer. */
+#define MORPH_LINES(NLINES, CODE)					\
+  YOR_OMP(parallel for num_threads(nthreads) schedule(static) if(nthreads > 1)) \
+  for (t = 0; t < nthreads; ++t) {					\
+    voxel_t* g = buf + 2*t*buflen;					\
+    voxel_t* h = g + buflen;						\
+    long l1 = ((NLINES)*(t + 1))/nthreads;				\
+    for (long l = ((NLINES)*t)/nthreads; l < l1; ++l) {		\
+      CODE;								\
+    }									\
+    (void)g; (void)h;							\
+  }
+
+  if (plan->box) {
+    /* Separable structuring element. */
+    x0 = runs[0].x0;
+    x1 = runs[0].x1;
+    MORPH_LINES(nrows, line(dst + l*width, src + l*width, width, 1,
+                            x0, x1, g, h));
+    if (plan->y0 < plan->y1) {
+      MORPH_LINES(width*depth,
+                  line(dst + (l/width)*width*height + l%width,
+                       dst + (l/width)*width*height + l%width,
+                       height, width, plan->y0, plan->y1, g, h));
+    }
+    if (plan->z0 < plan->z1) {
+      MORPH_LINES(width*height,
+                  line(dst + l, dst + l, depth, width*height,
+                       plan->z0, plan->z1, g, h));
+    }
+    return;
+  }
+
+  /* Combine the results for all runs.  The structuring element contains
+     the origin, so every voxel is at least the source voxel. */
+  memcpy(dst, src, width*nrows*sizeof(voxel_t));
+  for (i0 = 0; i0 < plan->nruns; i0 = i1) {
+    const voxel_t* T;
+    x0 = runs[i0].x0;
+    x1 = runs[i0].x1;
+    for (i1 = i0 + 1; i1 < plan->nruns &&
+           runs[i1].x0 == x0 && runs[i1].x1 == x1; ++i1)
+      ;
+    if (x0 == 0 && x1 == 0) {
+      T = src;
+    } else {
+      MORPH_LINES(nrows, line(tmp + l*width, src + l*width, width, 1,
+                              x0, x1, g, h));
+      T = tmp;
+    }
+    MORPH_LINES(nrows,
+                long y = l%height;
+                long z = l/height;
+                for (long i = i0; i < i1; ++i) {
+                  long yp = y + runs[i].dy;
+                  long zp = z + runs[i].dz;
+                  if (yp >= 0 && yp < height && zp >= 0 && zp < depth) {
+                    combine(dst + l*width, T + (zp*height + yp)*width, width);
+                  }
+                });
+  }
+#undef MORPH_LINES
+}
+
+#endif /* MORPH_FAST */
+
 #undef MORPH_SEGMENTATION
 #undef MORPH_DILATION
 #undef MORPH_EROSION
+#undef MORPH_FAST
+#undef voxel_min
+#undef voxel_max
 #undef voxel_t
 
 #endif /* _YETI_MORPH_C -----------------------------------------------------*/
@@ -0,0 +1,231 @@
+/*
+ * nudft.c -
+ *
+ * Implement separable nonuniform discrete Fourier transform.
+ *
+ *-----------------------------------------------------------------------------
+ *
+ * This file is part of Yeti (https://github.com/emmt/Yeti) released under the
+ * MIT "Expat" license.
+ *
+ * Copyright (C) 1996-2020: Éric Thiébaut.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <yapi.h>
+#include <pstdlib.h>
+#include "yeti.h"
+
+/*
+ * The operator implements the 2-D transform:
+ *
+ *     z(k) = sum_{i,j} A1(k,i)*A2(k,j)*a(i,j)
+ *
+ * with A1(k,i) = exp(-2*i*pi*u(k)*x(i)) and A2(k,j) = exp(-2*i*pi*v(k)*y(j)).
+ * The coefficients are stored as interleaved complexes with the frequency
+ * index varying slowest, so that the innermost loops (over i for A1 and over
+ * j for A2) run over contiguous memory.  The result z is stored as a 2-by-m
+ * real array (real and imaginary parts).
+ */
+typedef struct {
+    long m;      // number of frequencies
+    long nx;     // length of 1st dimension of the image
+    long ny;     // length of 2nd dimension of the image
+    double* a1;  // A1 coefficients (2-by-nx-by-m)
+    double* a2;  // A2 coefficients (2-by-ny-by-m)
+} nudft;
+
+#define NUDFT_TYPE_NAME "separable DFT operator"
+
+static void nudft_free(void* addr)
+{
+    nudft* op = addr;
+    if (op->a1 != NULL) p_free(op->a1);
+    if (op->a2 != NULL) p_free(op->a2);
+}
+
+static void nudft_print(void* addr)
+{
+    nudft* op = addr;
+    char buffer[100];
+    snprintf(buffer, sizeof(buffer), " (nx = %ld, ny = %ld, nfreqs = %ld)",
+             op->nx, op->ny, op->m);
+    buffer[sizeof(buffer)-1] = 0;
+    y_print(NUDFT_TYPE_NAME, 0);
+    y_print(buffer, 1);
+}
+
+// Direct transform of real image `a` (nx-by-ny) into `z` (2-by-m).
+static void nudft_direct(const nudft* op, double* z, const double* a)
+{
+    const long m = op->m, nx = op->nx, ny = op->ny;
+    int nthreads = yor_nthreads((size_t)m*nx*ny);
+    YOR_OMP(parallel for num_threads(nthreads) schedule(static) if(nthreads > 1))
+    for (long k = 0; k < m; ++k) {
+        const double* a1 = op->a1 + 2*nx*k;
+        const double* a2 = op->a2 + 2*ny*k;
+        double zre = 0.0, zim = 0.0;
+        for (long j = 0; j < ny; ++j) {
+            const double* col = a + nx*j;
+            double sre = 0.0, sim = 0.0;
+            YOR_OMP(simd reduction(+:sre,sim))
+            for (long i = 0; i < nx; ++i) {
+                sre += a1[2*i]*col[i];
+                sim += a1[2*i+1]*col[i];
+            }
+            double a2re = a2[2*j], a2im = a2[2*j+1];
+            zre += a2re*sre - a2im*sim;
+            zim += a2re*sim + a2im*sre;
+        }
+        z[2*k] = zre;
+        z[2*k+1] = zim;
+    }
+}
+
+// Real part of the adjoint transform of `z` (2-by-m) into `a` (nx-by-ny).
+static void nudft_adjoint(const nudft* op, double* a, const double* z)
+{
+    const long m = op->m, nx = op->nx, ny = op->ny;
+    int nthreads = yor_nthreads((size_t)m*nx*ny);
+    if (nthreads > ny) nthreads = ny;
+    YOR_OMP(parallel for num_threads(nthreads) schedule(static) if(nthreads > 1))
+    for (long j = 0; j < ny; ++j) {
+        double* col = a + nx*j;
+        memset(col, 0, nx*sizeof(double));
+        for (long k = 0; k < m; ++k) {
+            const double* a1 = op->a1 + 2*nx*k;
+            double a2re = op->a2[2*(ny*k + j)];
+            double a2im = op->a2[2*(ny*k + j) + 1];
+            double zre = z[2*k], zim = z[2*k+1];
+            double wre = a2re*zre + a2im*zim;
+            double wim = a2re*zim - a2im*zre;
+            YOR_OMP(simd)
+            for (long i = 0; i < nx; ++i) {
+                col[i] += a1[2*i]*wre + a1[2*i+1]*wim;
+            }
+        }
+    }
+}
+
+static void nudft_eval(void* addr, int argc)
+{
+    nudft* op = addr;
+    long dims[Y_DIMSIZE];
+    long ntot;
+    int job = 0;
+
+    if (argc == 2) {
+        if (! yarg_nil(0)) job = ygets_i(0);
+        yarg_drop(1);
+    } else if (argc != 1) {
+        y_error("syntax: op(a) or op(a, job) with op a separable DFT operator");
+    }
+    const double* src = ygeta_d(0, &ntot, dims);
+    if (job == 0) {
+        if (ntot != op->nx*op->ny || dims[0] > 2 ||
+            (dims[0] >= 1 && dims[1] != op->nx)) {
+            y_error("bad dimensions for the direct transform");
+        }
+        dims[0] = 2;
+        dims[1] = 2;
+        dims[2] = op->m;
+        nudft_direct(op, ypush_d(dims), src);
+    } else if (job == 1) {
+        if (dims[0] != 2 || dims[1] != 2 || dims[2] != op->m) {
+            y_error("expecting a 2-by-NFREQS array for the adjoint transform");
+        }
+        dims[0] = 2;
+        dims[1] = op->nx;
+        dims[2] = op->ny;
+        nudft_adjoint(op, ypush_d(dims), src);
+    } else {
+        y_error("unsupported value for JOB");
+    }
+}
+
+// Push the coefficients of a table as a 2-by-n-by-m array.
+static void push_coefs(const double* coefs, long n, long m)
+{
+    long dims[4];
+    dims[0] = 3;
+    dims[1] = 2;
+    dims[2] = n;
+    dims[3] = m;
+    memcpy(ypush_d(dims), coefs, 2*n*m*sizeof(double));
+}
+
+static void nudft_extract(void* addr, char* name)
+{
+    nudft* op = addr;
+    int c0 = name[0];
+    if (c0 == 'n' && strcmp(name, "nx") == 0) {
+        ypush_long(op->nx);
+    } else if (c0 == 'n' && strcmp(name, "ny") == 0) {
+        ypush_long(op->ny);
+    } else if (c0 == 'n' && strcmp(name, "nfreqs") == 0) {
+        ypush_long(op->m);
+    } else if (c0 == 'A' && strcmp(name, "A1") == 0) {
+        push_coefs(op->a1, op->nx, op->m);
+    } else if (c0 == 'A' && strcmp(name, "A2") == 0) {
+        push_coefs(op->a2, op->ny, op->m);
+    } else {
+        y_error("unknown separable DFT operator member");
+    }
+}
+
+static y_userobj_t nudft_type = {
+    NUDFT_TYPE_NAME,
+    nudft_free,
+    nudft_print,
+    nudft_eval,
+    nudft_extract,
+    NULL
+};
+
+// Compute the coefficients exp(-2*i*pi*u(k)*x(i)) into `coefs`.
+static void make_coefs(double* coefs, const double* u, long m,
+                       const double* x, long n)
+{
+    const double q = -2.0*M_PI;
+    int nthreads = yor_nthreads((size_t)m*n);
+    YOR_OMP(parallel for num_threads(nthreads) schedule(static) if(nthreads > 1))
+    for (long k = 0; k < m; ++k) {
+        double* c = coefs + 2*n*k;
+        for (long i = 0; i < n; ++i) {
+            double phi = q*u[k]*x[i];
+            c[2*i] = cos(phi);
+            c[2*i+1] = sin(phi);
+        }
+    }
+}
+
+void Y_nudft_separable(int argc)
+{
+    long m, mv, nx, ny;
+    if (argc != 4) y_error("expecting exactly four arguments");
+    const double* u = ygeta_d(3, &m, NULL);
+    const double* x = ygeta_d(2, &nx, NULL);
+    const double* v = ygeta_d(1, &mv, NULL);
+    const double* y = ygeta_d(0, &ny, NULL);
+    if (mv != m) y_error("U and V must have the same number of elements");
+    nudft* op = ypush_obj(&nudft_type, sizeof(nudft));
+    op->m = m;
+    op->nx = nx;
+    op->ny = ny;
+    op->a1 = p_malloc(2*nx*m*sizeof(double));
+    op->a2 = p_malloc(2*ny*m*sizeof(double));
+    if (op->a1 == NULL || op->a2 == NULL) y_error("not enough memory");
+    make_coefs(op->a1, u, m, x, nx);
+    make_coefs(op->a2, v, m, y, ny);
+}
+
+void Y_is_nudft(int argc)
+{
+    if (argc != 1) y_error("expecting exactly one argument");
+    const char* name = yget_obj(0, NULL);
+    ypush_int(name == nudft_type.type_name ? 1 : 0);
+}
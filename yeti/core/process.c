@@ -0,0 +1,70 @@
+/*
+ * process.c -
+ *
+ * Built-in functions to fork and wait for child processes.
+ *
+ *-----------------------------------------------------------------------------
+ *
+ * This file is part of Yeti (https://github.com/emmt/Yeti) released under the
+ * MIT "Expat" license.
+ *
+ * Copyright (C) 1996-2020: Éric Thiébaut.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <yapi.h>
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+#include "yeti.h"
+
+void Y_fork(int argc)
+{
+    if (argc != 1 || ! yarg_nil(0)) y_error("fork takes no arguments");
+    // Flush buffered output so that it is not written twice.
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid < 0) y_error("fork failed to create a new process");
+    if (pid == 0) {
+        // Only the calling thread survives in the child.  The thread pool
+        // of the OpenMP runtime (and those of FFTW or NFFT) still believes
+        // its workers exist, so the first parallel region with more than
+        // one thread would wait for them forever.  A region with a single
+        // thread does not involve the pool, hence make the child
+        // single-threaded for Yeti kernels and for libraries which query
+        // the OpenMP runtime.
+        yor_set_max_threads(1);
+#ifdef _OPENMP
+        omp_set_num_threads(1);
+#endif
+    }
+    ypush_long(pid);
+}
+
+void Y_waitpid(int argc)
+{
+    if (argc != 1) y_error("waitpid takes exactly one argument");
+    pid_t pid = ygets_l(0);
+    if (pid <= 0) y_error("invalid process identifier");
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) y_error("waitpid failed");
+    }
+    long result;
+    if (WIFEXITED(status)) {
+        result = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        result = -WTERMSIG(status);
+    } else {
+        result = -1;
+    }
+    ypush_long(result);
+}
@@ -24,6 +24,15 @@
  *		however be applicable for more than RGL_MAX_NDIMS
  *		dimensions.
  *
+ *	Tiling: The penalty is computed by tiles of about RGL_TILE_SIZE
+ *		elements (default 16384, that is 128 kB of data) along the
+ *		slowest varying "compact" dimension.  Compile with
+ *		-DRGL_TILE_SIZE=n to change this value.  The tiles are
+ *		processed in parallel if the code is compiled with OpenMP
+ *		support.  The splitting in tiles only depends on the
+ *		dimensions and offsets so that the result does not depend on
+ *		the number of threads.
+ *
  *-----------------------------------------------------------------------------
  */
 
@@ -35,6 +44,9 @@
 #include <stdio.h>
 #ifdef YORICK
 # include <yapi.h> /* for Yorick interface */
+# include "yeti.h" /* for multi-threading */
+#elif defined(_OPENMP)
+# include <omp.h>
 #endif
 
 #ifndef NULL
@@ -45,6 +57,28 @@
 # define RGL_MAX_NDIMS 8
 #endif
 
+#ifndef RGL_TILE_SIZE
+# define RGL_TILE_SIZE 16384
+#endif
+
+/* Maximum number of tiles (must be even). */
+#define RGL_MAX_TILES 1024
+
+#ifdef _OPENMP
+# define RGL_STRINGIFY(x) # x
+# define RGL_OMP(args) _Pragma(RGL_STRINGIFY(omp args))
+#else
+# define RGL_OMP(args)
+#endif
+
+#ifdef YORICK
+# define rgl_nthreads(work) yor_nthreads(work)
+#elif defined(_OPENMP)
+# define rgl_nthreads(work) omp_get_max_threads()
+#else
+# define rgl_nthreads(work) 1
+#endif
+
 /*---------------------------------------------------------------------------*/
 /* DEFINITIONS */
 
@@ -69,6 +103,27 @@ extern rgl_roughness_penalty_t rgl_roughness_cauchy_periodic;
 #define integer_t long
 #define real_t double
 
+/* Prototype of the functions computing the penalty for a tile, that is a
+   range FIRST to LAST - 1 of iterations along the last "compact"
+   dimension. */
+typedef double rgl_tile_penalty_t(const double hyper[],
+                                  const integer_t n,
+                                  const integer_t dim_c[],
+                                  const integer_t off_c[],
+                                  const integer_t first,
+                                  const integer_t last,
+                                  const real_t arr[],
+                                  real_t grd[]);
+
+static double rgl_tiled(rgl_tile_penalty_t* tile, const int periodic,
+                        const double hyper[], const integer_t n,
+                        const integer_t dim_c[], const integer_t off_c[],
+                        const real_t arr[], real_t grd[]);
+
+#define RGL_JOIN(a,b)  RGL_JOIN_(a,b)
+#define RGL_JOIN_(a,b) a##b
+#define RGL_TILE       RGL_JOIN(RGL_ROUGHNESS,_tile)
+
 /* Error codes: */
 #define RGL_ERROR_BAD_ADDRESS   -1
 #define RGL_ERROR_BAD_DIMENSION -2
@@ -138,6 +193,82 @@ extern rgl_roughness_penalty_t rgl_roughness_cauchy_periodic;
 #define RGL_ROUGHNESS rgl_roughness_l2l0_periodic
 #include __FILE__
 
+/*---------------------------------------------------------------------------*/
+/* TILED COMPUTATION */
+
+/*
+ * The iterations along the last compact dimension are split in NTILES
+ * tiles.  Each tile is at least as long as the offset along this dimension
+ * (the "reach"), hence a tile only updates the gradient in itself and in
+ * one of its neighbours.  When the gradient is required, the tiles with
+ * even indices are processed in parallel first, then those with odd
+ * indices: no two concurrent tiles write the same gradient entries and no
+ * atomic operations are needed.  In the periodic case, the number of tiles
+ * is even so that this also holds for the first and last tiles.  The
+ * partial penalties are summed in the order of the tiles.
+ */
+static double rgl_tiled(rgl_tile_penalty_t* tile, const int periodic,
+                        const double hyper[], const integer_t n,
+                        const integer_t dim_c[], const integer_t off_c[],
+                        const real_t arr[], real_t grd[])
+{
+  double part[RGL_MAX_TILES];
+  double penalty;
+  integer_t len, reach, stride, width, ntiles, k;
+  int nthreads, parity;
+
+  /* Number of iterations along the last compact dimension. */
+  stride = 1;
+  for (k = 0; k < n - 1; ++k) {
+    stride *= dim_c[k];
+  }
+  len = dim_c[n - 1];
+  if (periodic) {
+    reach = RGL_MIN(off_c[n - 1], len - off_c[n - 1]);
+  } else {
+    reach = (off_c[n - 1] >= 0 ? off_c[n - 1] : -off_c[n - 1]);
+    len -= reach;
+  }
+  if (len <= 0) {
+    return 0.0;
+  }
+
+  /* Number of tiles. */
+  width = RGL_MAX((RGL_TILE_SIZE + stride - 1)/stride, 1);
+  if (grd != NULL) {
+    width = RGL_MAX(width, reach);
+  }
+  ntiles = RGL_MIN(len/width, RGL_MAX_TILES);
+  if (grd != NULL && periodic && (ntiles & 1) != 0) {
+    --ntiles;
+  }
+  if (ntiles <= 1) {
+    return tile(hyper, n, dim_c, off_c, 0, len, arr, grd);
+  }
+
+  nthreads = rgl_nthreads((size_t)len*(size_t)stride);
+  if (grd == NULL) {
+    RGL_OMP(parallel for num_threads(nthreads) schedule(static) if(nthreads > 1))
+    for (k = 0; k < ntiles; ++k) {
+      part[k] = tile(hyper, n, dim_c, off_c, (k*len)/ntiles,
+                     ((k + 1)*len)/ntiles, arr, grd);
+    }
+  } else {
+    for (parity = 0; parity < 2; ++parity) {
+      RGL_OMP(parallel for num_threads(nthreads) schedule(static) if(nthreads > 1))
+      for (k = parity; k < ntiles; k += 2) {
+        part[k] = tile(hyper, n, dim_c, off_c, (k*len)/ntiles,
+                       ((k + 1)*len)/ntiles, arr, grd);
+      }
+    }
+  }
+  penalty = 0.0;
+  for (k = 0; k < ntiles; ++k) {
+    penalty += part[k];
+  }
+  return penalty;
+}
+
 
 /*---------------------------------------------------------------------------*/
 /* YORICK INTERFACE */
@@ -356,6 +487,8 @@ MAKE_BUILTIN(cauchy_periodic, 2)
  */
 
 #ifdef RGL_ROUGHNESS
+static rgl_tile_penalty_t RGL_TILE;
+
 double RGL_ROUGHNESS(const double hyper[],  /* hyper-parameters */
                      const integer_t ndims, /* number of dimensions */
                      const integer_t dim[], /* dimensions */
@@ -364,36 +497,6 @@ double RGL_ROUGHNESS(const double hyper[],  /* hyper-parameters */
                      real_t grd[])          /* gradient (can be NULL) */
 {
   const double ZERO = 0.0;
-#if (RGL_COST == RGL_COST_L2)
-  double w ,r;
-#endif
-#if (RGL_COST == RGL_COST_L1)
-  double w;
-#endif
-#if (RGL_COST == RGL_COST_L2L1)
-  const double ONE = 1.0;
-  double q, r, s, w;
-#endif
-#if (RGL_COST == RGL_COST_L2L0)
-  const double ONE = 1.0;
-  double q, r, s, w;
-#endif
-#if (RGL_COST == RGL_COST_CAUCHY)
-  const double ONE = 1.0;
-  double q, r, s, w;
-#endif
-  double penalty;
-#undef s1
-#define s1 1 /* fisrt stride is always equal to 1 */
-  integer_t j1, e1, lo1, hi1;
-  integer_t j2, e2, lo2, hi2, s2;
-  integer_t j3, e3, lo3, hi3, s3;
-  integer_t j4, e4, lo4, hi4, s4;
-  integer_t j5, e5, lo5, hi5, s5;
-  integer_t j6, e6, lo6, hi6, s6;
-  integer_t j7, e7, lo7, hi7, s7;
-  integer_t j8, e8, lo8, hi8, s8;
-  integer_t j9,               s9;
   integer_t n, j, jc;
   integer_t dim_c[RGL_MAX_NDIMS]; /* compact offsets */
   integer_t off_c[RGL_MAX_NDIMS]; /* compact dimensions */
@@ -446,6 +549,49 @@ double RGL_ROUGHNESS(const double hyper[],  /* hyper-parameters */
   }
 #endif /* RGL_PERIODIC */
 
+  return rgl_tiled(RGL_TILE, RGL_PERIODIC, hyper, n, dim_c, off_c, arr, grd);
+}
+
+static double RGL_TILE(const double hyper[],   /* hyper-parameters */
+                       const integer_t n,      /* number of compact dims */
+                       const integer_t dim_c[],/* compact dimensions */
+                       const integer_t off_c[],/* compact offsets */
+                       const integer_t first,  /* first iteration of tile */
+                       const integer_t last,   /* last iteration + 1 */
+                       const real_t arr[],     /* model array */
+                       real_t grd[])           /* gradient (can be NULL) */
+{
+#if (RGL_COST == RGL_COST_L2)
+  double w ,r;
+#endif
+#if (RGL_COST == RGL_COST_L1)
+  double w;
+#endif
+#if (RGL_COST == RGL_COST_L2L1)
+  const double ONE = 1.0;
+  double q, r, s, w;
+#endif
+#if (RGL_COST == RGL_COST_L2L0)
+  const double ONE = 1.0;
+  double q, r, s, w;
+#endif
+#if (RGL_COST == RGL_COST_CAUCHY)
+  const double ONE = 1.0;
+  double q, r, s, w;
+#endif
+  double penalty;
+#undef s1
+#define s1 1 /* fisrt stride is always equal to 1 */
+  integer_t j1, e1, lo1, hi1;
+  integer_t j2, e2, lo2, hi2, s2;
+  integer_t j3, e3, lo3, hi3, s3;
+  integer_t j4, e4, lo4, hi4, s4;
+  integer_t j5, e5, lo5, hi5, s5;
+  integer_t j6, e6, lo6, hi6, s6;
+  integer_t j7, e7, lo7, hi7, s7;
+  integer_t j8, e8, lo8, hi8, s8;
+  integer_t j9,               s9;
+  integer_t j;
 
   /* Macros for spk = (k+1)-th stride, jpk = (k+1)-th index. */
 #undef jp1
@@ -495,7 +641,7 @@ double RGL_ROUGHNESS(const double hyper[],  /* hyper-parameters */
   /* Macro definitions and constants for
      L1 (absolute value) cost function. */
 #if (RGL_COST == RGL_COST_L1)
-  w = (grd ? hyper[0] : ZERO);
+  w = (grd ? hyper[0] : 0.0);
 
 # define BODY_1(a1, a2)  penalty += fabs(arr[a2] - arr[a1]);
 # define FINAL_1         penalty *= hyper[0];
@@ -518,7 +664,7 @@ double RGL_ROUGHNESS(const double hyper[],  /* hyper-parameters */
   /* Macro definitions and constants for
      L2 (quadratic) cost function. */
 #if (RGL_COST == RGL_COST_L2)
-  w = (grd ? 2.0*hyper[0] : ZERO);
+  w = (grd ? 2.0*hyper[0] : 0.0);
 
 # define BODY_1(a1, a2)  r = arr[a2] - arr[a1]; \
                          penalty += r*r;
@@ -638,7 +784,7 @@ double RGL_ROUGHNESS(const double hyper[],  /* hyper-parameters */
    */
 
 # define LOOP(k)					\
-  for (e##k = lo##k, j##k = jp##k + e##k;		\
+  for (e##k = lo##k, j##k = jp##k + (e##k % sp##k);	\
        e##k < hi##k;					\
        e##k += s##k, j##k = jp##k + (e##k % sp##k))
 
@@ -647,6 +793,9 @@ double RGL_ROUGHNESS(const double hyper[],  /* hyper-parameters */
   lo##k =  off_c[k-1]*s##k;				\
   hi##k = (off_c[k-1] + dim_c[k-1])*s##k;		\
   if (n == k) {						\
+    j = first*s##k; /* restrict to the tile */		\
+    hi##k = lo##k + last*s##k;				\
+    lo##k += j;						\
     jp##k = 0; /* let the optimizer do the job */	\
     if (grd) {						\
       LOOPS {						\
@@ -678,6 +827,8 @@ double RGL_ROUGHNESS(const double hyper[],  /* hyper-parameters */
     return 0.0;								\
   }									\
   if (n == k) {								\
+    hi##k = lo##k + last*s##k; /* restrict to the tile */		\
+    lo##k += first*s##k;						\
     jp##k = 0; /* let the optimizer do the job */			\
     if (grd) {								\
       LOOPS {								\
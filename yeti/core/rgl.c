@@ -0,0 +1,782 @@
+/*
+ * rgl.c -
+ *
+ * Compiled kernels for the regularizers of IPY's "rgl.i": total variation,
+ * hyperbolic edge-preserving smoothness, general smoothness and entropy.
+ * Each kernel computes the penalty and its gradient in a single pass without
+ * temporary arrays, Hessian-vector products (or diagonal of the Hessian) are
+ * provided by separate kernels.
+ *
+ *-----------------------------------------------------------------------------
+ *
+ * This file is part of Yeti (https://github.com/emmt/Yeti) released under the
+ * MIT "Expat" license.
+ *
+ * Copyright (C) 1996-2020: Éric Thiébaut.
+ *
+ *-----------------------------------------------------------------------------
+ *
+ * The kernels are written once for a generic floating-point type REAL and
+ * this file includes itself to instantiate them for float and double arrays
+ * (suffixes _flt and _dbl).  Whatever the type of the arrays, the penalty is
+ * accumulated in double precision.
+ */
+
+#ifndef _RGL_KERNELS
+#define _RGL_KERNELS 1
+
+#include <math.h>
+#include <string.h>
+#include <yapi.h>
+
+/* Cost functions for the "xsmooth" regularizer. */
+#define RGL_COST_L2    0
+#define RGL_COST_L2L1  1
+#define RGL_COST_L2L0  2
+
+#define REAL float
+#define SUFFIX(name) name##_flt
+#include __FILE__
+
+#define REAL double
+#define SUFFIX(name) name##_dbl
+#include __FILE__
+
+/*---------------------------------------------------------------------------*/
+/* YORICK INTERFACE */
+
+/* Get real array argument, converted to float if TYPE is Y_FLOAT or to
+   double otherwise.  If DIMS is not NULL, the dimension list of the argument
+   must be the same. */
+static void* get_real_array(int iarg, int type, long* ntot, long dims[],
+                            const long ref[], const char* name)
+{
+  int id = yarg_typeid(iarg);
+  if (id < Y_CHAR || id > Y_DOUBLE) {
+    y_errorq("argument %s must be a real-valued array", name);
+  }
+  long tmp[Y_DIMSIZE];
+  if (dims == NULL) dims = tmp;
+  void* ptr = (type == Y_FLOAT ? (void*)ygeta_f(iarg, ntot, dims)
+               : (void*)ygeta_d(iarg, ntot, dims));
+  if (ref != NULL) {
+    for (long j = 0; j <= ref[0]; ++j) {
+      if (dims[j] != ref[j]) {
+        y_errorq("argument %s has incompatible dimensions", name);
+      }
+    }
+  }
+  return ptr;
+}
+
+/* Get the array X of unknowns and figure out the type of the computations. */
+static void* get_variables(int iarg, int* type, long* ntot, long dims[])
+{
+  int id = yarg_typeid(iarg);
+  if (id < Y_CHAR || id > Y_DOUBLE || yarg_rank(iarg) < 1) {
+    y_error("variables must be a real-valued array");
+  }
+  *type = (id == Y_FLOAT ? Y_FLOAT : Y_DOUBLE);
+  return get_real_array(iarg, *type, ntot, dims, NULL, "X");
+}
+
+/* Get optional mask (or prior) argument. */
+static void* get_optional_array(int iarg, int type, const long dims[],
+                                const char* name)
+{
+  if (yarg_nil(iarg)) return NULL;
+  return get_real_array(iarg, type, NULL, NULL, dims, name);
+}
+
+/* Get hyper-parameters. */
+static const double* get_hyper(int iarg, long n)
+{
+  long ntot;
+  int id = yarg_typeid(iarg);
+  if (id < Y_CHAR || id > Y_DOUBLE || yarg_rank(iarg) > 1) {
+    y_error("hyper-parameters must be a vector of reals");
+  }
+  const double* hyper = ygeta_d(iarg, &ntot, NULL);
+  if (ntot != n) y_error("bad number of hyper-parameters");
+  return hyper;
+}
+
+/* Get reference to the caller's variable to store the gradient. */
+static long get_gradient_ref(int iarg)
+{
+  if (iarg < 0) return -1L;
+  long ref = yget_ref(iarg);
+  if (ref < 0L) {
+    y_error("expecting a simple variable reference for the gradient");
+  }
+  return ref;
+}
+
+/* Push a new array of given type and dimensions. */
+static void* push_real_array(int type, long dims[])
+{
+  return (type == Y_FLOAT ? (void*)ypush_f(dims) : (void*)ypush_d(dims));
+}
+
+/* Store gradient on top of the stack into the caller's variable and push
+   the penalty. */
+static void finalize(long ref, double penalty)
+{
+  if (ref >= 0L) {
+    yput_global(ref, 0);
+  }
+  ypush_double(penalty);
+}
+
+static void check_2d(const long dims[])
+{
+  if (dims[0] != 2 || dims[1] < 2 || dims[2] < 2) {
+    y_error("expecting a 2-D array with at least 2 elements per dimension");
+  }
+}
+
+void Y_rgl_totvar_fg(int argc)
+{
+  int type;
+  long dims[Y_DIMSIZE];
+  if (argc < 4 || argc > 5) y_error("rgl_totvar_fg takes 4 or 5 arguments");
+  long ref = get_gradient_ref(argc - 5);
+  const double* hyper = get_hyper(argc - 1, 2);
+  int iso = yarg_true(argc - 2);
+  void* x = get_variables(argc - 3, &type, NULL, dims);
+  check_2d(dims);
+  void* msk = get_optional_array(argc - 4, type, dims, "MASK");
+  void* g = (ref >= 0L ? push_real_array(type, dims) : NULL);
+  double f = (type == Y_FLOAT ?
+              totvar_fg_flt(hyper, iso, dims[1], dims[2], x, msk, g) :
+              totvar_fg_dbl(hyper, iso, dims[1], dims[2], x, msk, g));
+  finalize(ref, f);
+}
+
+void Y_rgl_totvar_hv(int argc)
+{
+  int type;
+  long dims[Y_DIMSIZE];
+  if (argc != 5) y_error("rgl_totvar_hv takes exactly 5 arguments");
+  const double* hyper = get_hyper(argc - 1, 2);
+  int iso = yarg_true(argc - 2);
+  void* x = get_variables(argc - 3, &type, NULL, dims);
+  check_2d(dims);
+  void* msk = get_optional_array(argc - 4, type, dims, "MASK");
+  void* s = get_real_array(argc - 5, type, NULL, NULL, dims, "S");
+  void* h = push_real_array(type, dims);
+  if (type == Y_FLOAT) {
+    totvar_hv_flt(hyper, iso, dims[1], dims[2], x, msk, s, h);
+  } else {
+    totvar_hv_dbl(hyper, iso, dims[1], dims[2], x, msk, s, h);
+  }
+}
+
+/* Compute the weights of the hyperbolic regularization along the dimensions
+   of X. */
+static void hyperbolic_weights(double w[2], const double hyper[],
+                               int iarg, const long dims[])
+{
+  long ntot;
+  long rank = dims[0];
+  if (rank != 1 && rank != 2) y_error("unsupported number of dimensions");
+  if (dims[1] < 2 || (rank == 2 && dims[2] < 2)) {
+    y_error("expecting at least 2 elements per dimension");
+  }
+  int id = yarg_typeid(iarg);
+  if (id < Y_CHAR || id > Y_DOUBLE || yarg_rank(iarg) > 1) {
+    y_error("ETA must be a real scalar or vector");
+  }
+  const double* eta = ygeta_d(iarg, &ntot, NULL);
+  if (ntot != 1 && ntot != rank) y_error("bad number of dimensions/scales");
+  double mu = hyper[0];
+  double s = (rank == 2 ? 0.5 : 1.0); // each direction appears twice in 2-D
+  for (long k = 0; k < rank; ++k) {
+    double t = mu*eta[ntot > 1 ? k : 0];
+    w[k] = s*t*t;
+  }
+  if (rank == 1) w[1] = 0.0;
+}
+
+void Y_rgl_hyperbolic_fg(int argc)
+{
+  int type;
+  long dims[Y_DIMSIZE];
+  double w[2];
+  if (argc < 4 || argc > 5) {
+    y_error("rgl_hyperbolic_fg takes 4 or 5 arguments");
+  }
+  long ref = get_gradient_ref(argc - 5);
+  const double* hyper = get_hyper(argc - 1, 2);
+  void* x = get_variables(argc - 3, &type, NULL, dims);
+  hyperbolic_weights(w, hyper, argc - 2, dims);
+  double t = fabs(hyper[0]*hyper[1]);
+  long nx = dims[1], ny = (dims[0] == 2 ? dims[2] : 1);
+  void* msk = get_optional_array(argc - 4, type, dims, "MASK");
+  void* g = (ref >= 0L ? push_real_array(type, dims) : NULL);
+  double f = (type == Y_FLOAT ?
+              hyperbolic_fg_flt(w, t, dims[0], nx, ny, x, msk, g) :
+              hyperbolic_fg_dbl(w, t, dims[0], nx, ny, x, msk, g));
+  finalize(ref, f);
+}
+
+void Y_rgl_hyperbolic_hv(int argc)
+{
+  int type;
+  long dims[Y_DIMSIZE];
+  double w[2];
+  if (argc != 5) y_error("rgl_hyperbolic_hv takes exactly 5 arguments");
+  const double* hyper = get_hyper(argc - 1, 2);
+  void* x = get_variables(argc - 3, &type, NULL, dims);
+  hyperbolic_weights(w, hyper, argc - 2, dims);
+  double t = fabs(hyper[0]*hyper[1]);
+  long nx = dims[1], ny = (dims[0] == 2 ? dims[2] : 1);
+  void* msk = get_optional_array(argc - 4, type, dims, "MASK");
+  void* s = get_real_array(argc - 5, type, NULL, NULL, dims, "S");
+  void* h = push_real_array(type, dims);
+  if (type == Y_FLOAT) {
+    hyperbolic_hv_flt(w, t, dims[0], nx, ny, x, msk, s, h);
+  } else {
+    hyperbolic_hv_dbl(w, t, dims[0], nx, ny, x, msk, s, h);
+  }
+}
+
+/* Get the cost function of the "xsmooth" regularizer. */
+static int get_cost(int iarg, const double hyper[])
+{
+  const char* name = ygets_q(iarg);
+  if (name != NULL && strncmp(name, "cost_", 5) == 0) name += 5;
+  if (hyper[0] < 0.0 || hyper[1] < 0.0) {
+    y_error("invalid hyper-parameter value(s)");
+  }
+  int cost;
+  if (name == NULL) {
+    cost = -1;
+  } else if (strcmp(name, "l2") == 0) {
+    cost = RGL_COST_L2;
+  } else if (strcmp(name, "l2l1") == 0) {
+    cost = RGL_COST_L2L1;
+  } else if (strcmp(name, "l2l0") == 0) {
+    cost = RGL_COST_L2L0;
+  } else {
+    cost = -1;
+  }
+  if (cost < 0) y_error("unsupported cost function");
+  /* L2-L1 and L2-L0 costs are quadratic for a zero threshold. */
+  return (hyper[1] > 0.0 ? cost : RGL_COST_L2);
+}
+
+static void check_xsmooth_dims(const long dims[])
+{
+  if (dims[0] < 2) y_error("expecting at least 2-D array");
+}
+
+void Y_rgl_xsmooth_fg(int argc)
+{
+  int type;
+  long ntot, dims[Y_DIMSIZE];
+  if (argc < 4 || argc > 5) y_error("rgl_xsmooth_fg takes 4 or 5 arguments");
+  long ref = get_gradient_ref(argc - 5);
+  const double* hyper = get_hyper(argc - 1, 2);
+  int cost = get_cost(argc - 2, hyper);
+  int iso = yarg_true(argc - 3);
+  void* x = get_variables(argc - 4, &type, &ntot, dims);
+  check_xsmooth_dims(dims);
+  long n1 = dims[1], n2 = dims[2], nb = ntot/(n1*n2);
+  void* g = (ref >= 0L ? push_real_array(type, dims) : NULL);
+  double f = (type == Y_FLOAT ?
+              xsmooth_fg_flt(hyper, cost, iso, n1, n2, nb, x, g) :
+              xsmooth_fg_dbl(hyper, cost, iso, n1, n2, nb, x, g));
+  finalize(ref, f);
+}
+
+void Y_rgl_xsmooth_hv(int argc)
+{
+  int type;
+  long ntot, dims[Y_DIMSIZE];
+  if (argc != 5) y_error("rgl_xsmooth_hv takes exactly 5 arguments");
+  const double* hyper = get_hyper(argc - 1, 2);
+  int cost = get_cost(argc - 2, hyper);
+  int iso = yarg_true(argc - 3);
+  void* x = get_variables(argc - 4, &type, &ntot, dims);
+  check_xsmooth_dims(dims);
+  long n1 = dims[1], n2 = dims[2], nb = ntot/(n1*n2);
+  void* s = get_real_array(argc - 5, type, NULL, NULL, dims, "S");
+  void* h = push_real_array(type, dims);
+  if (type == Y_FLOAT) {
+    xsmooth_hv_flt(hyper, cost, iso, n1, n2, nb, x, s, h);
+  } else {
+    xsmooth_hv_dbl(hyper, cost, iso, n1, n2, nb, x, s, h);
+  }
+}
+
+static int get_entropy_id(int iarg)
+{
+  long id = ygets_l(iarg);
+  if (id < 1 || id > 5) y_error("unsupported entropy type");
+  return (int)id;
+}
+
+void Y_rgl_entropy_fg(int argc)
+{
+  int type;
+  long ntot, dims[Y_DIMSIZE];
+  if (argc < 4 || argc > 5) y_error("rgl_entropy_fg takes 4 or 5 arguments");
+  long ref = get_gradient_ref(argc - 5);
+  const double* hyper = get_hyper(argc - 1, 2);
+  int id = get_entropy_id(argc - 2);
+  void* x = get_variables(argc - 3, &type, &ntot, dims);
+  void* p = get_optional_array(argc - 4, type, dims, "PRIOR");
+  if (p == NULL && id >= 4) y_error("missing prior");
+  void* g = (ref >= 0L ? push_real_array(type, dims) : NULL);
+  double f = (type == Y_FLOAT ?
+              entropy_fg_flt(hyper, id, ntot, x, p, g) :
+              entropy_fg_dbl(hyper, id, ntot, x, p, g));
+  finalize(ref, f);
+}
+
+void Y_rgl_entropy_diag(int argc)
+{
+  int type;
+  long ntot, dims[Y_DIMSIZE];
+  if (argc != 3) y_error("rgl_entropy_diag takes exactly 3 arguments");
+  const double* hyper = get_hyper(argc - 1, 2);
+  int id = get_entropy_id(argc - 2);
+  void* x = get_variables(argc - 3, &type, &ntot, dims);
+  void* h = push_real_array(type, dims);
+  if (type == Y_FLOAT) {
+    entropy_diag_flt(hyper, id, ntot, x, h);
+  } else {
+    entropy_diag_dbl(hyper, id, ntot, x, h);
+  }
+}
+
+#else /* _RGL_KERNELS is defined */
+
+/*---------------------------------------------------------------------------*/
+/* TOTAL VARIATION (2-D)
+ *
+ * For each 2-by-2 cell of the NX-by-NY array X with corners X00 = X(i,j),
+ * X10 = X(i+1,j), X01 = X(i,j+1) and X11 = X(i+1,j+1), the finite
+ * differences are:
+ *
+ *     D1 = X11 - X00
+ *     D2 = X10 - X01
+ *     D3 = X00 - X01 - X10 + X11   (only if isotropic)
+ *
+ * (multiplied by the product of the mask values of the involved pixels) and
+ * the penalty is:
+ *
+ *     W*sum(R - EPS)   with   R = sqrt(D1^2 + D2^2 + D3^2/3 + 2*EPS^2)
+ *
+ * and W = MU/sqrt(2).
+ */
+
+static double SUFFIX(totvar_fg)(const double hyper[], int iso,
+                                long nx, long ny, const REAL* x,
+                                const REAL* msk, REAL* g)
+{
+  const double w = hyper[0]/sqrt(2.0);
+  const double eps = fabs(hyper[1]);
+  const double c = 2.0*eps*eps;
+  const double third = 1.0/3.0;
+  double sum = 0.0;
+  if (g != NULL) memset(g, 0, nx*ny*sizeof(REAL));
+  for (long j = 0; j < ny - 1; ++j) {
+    const REAL* x0 = x + nx*j;
+    const REAL* x1 = x0 + nx;
+    const REAL* m0 = (msk != NULL ? msk + nx*j : NULL);
+    const REAL* m1 = (msk != NULL ? m0 + nx : NULL);
+    REAL* g0 = (g != NULL ? g + nx*j : NULL);
+    REAL* g1 = (g != NULL ? g0 + nx : NULL);
+    for (long i = 0; i < nx - 1; ++i) {
+      double x00 = x0[i], x10 = x0[i+1], x01 = x1[i], x11 = x1[i+1];
+      double k1 = 1.0, k2 = 1.0;
+      if (msk != NULL) {
+        k1 = m1[i+1]*m0[i];
+        k2 = m0[i+1]*m1[i];
+      }
+      double k3 = k1*k2;
+      double d1 = k1*(x11 - x00);
+      double d2 = k2*(x10 - x01);
+      double d3 = (iso ? k3*(x00 - x01 - x10 + x11) : 0.0);
+      double r = sqrt(d1*d1 + d2*d2 + third*d3*d3 + c);
+      sum += r;
+      if (g != NULL) {
+        double q = w/r;
+        double a1 = q*k1*d1;
+        double a2 = q*k2*d2;
+        double a3 = q*third*k3*d3;
+        g0[i]   -= a1 - a3;
+        g0[i+1] += a2 - a3;
+        g1[i]   -= a2 + a3;
+        g1[i+1] += a1 + a3;
+      }
+    }
+  }
+  return w*(sum - (nx - 1)*(ny - 1)*eps);
+}
+
+static void SUFFIX(totvar_hv)(const double hyper[], int iso,
+                              long nx, long ny, const REAL* x,
+                              const REAL* msk, const REAL* s, REAL* h)
+{
+  const double w = hyper[0]/sqrt(2.0);
+  const double eps = fabs(hyper[1]);
+  const double c = 2.0*eps*eps;
+  const double third = 1.0/3.0;
+  memset(h, 0, nx*ny*sizeof(REAL));
+  for (long j = 0; j < ny - 1; ++j) {
+    const REAL* x0 = x + nx*j;
+    const REAL* x1 = x0 + nx;
+    const REAL* s0 = s + nx*j;
+    const REAL* s1 = s0 + nx;
+    const REAL* m0 = (msk != NULL ? msk + nx*j : NULL);
+    const REAL* m1 = (msk != NULL ? m0 + nx : NULL);
+    REAL* h0 = h + nx*j;
+    REAL* h1 = h0 + nx;
+    for (long i = 0; i < nx - 1; ++i) {
+      double k1 = 1.0, k2 = 1.0;
+      if (msk != NULL) {
+        k1 = m1[i+1]*m0[i];
+        k2 = m0[i+1]*m1[i];
+      }
+      double k3 = (iso ? k1*k2 : 0.0);
+      double d1 = k1*(x1[i+1] - x0[i]);
+      double d2 = k2*(x0[i+1] - x1[i]);
+      double d3 = k3*(x0[i] - x1[i] - x0[i+1] + x1[i+1]);
+      double e1 = k1*(s1[i+1] - s0[i]);
+      double e2 = k2*(s0[i+1] - s1[i]);
+      double e3 = k3*(s0[i] - s1[i] - s0[i+1] + s1[i+1]);
+      double r2 = d1*d1 + d2*d2 + third*d3*d3 + c;
+      double r = sqrt(r2);
+      double q = w/r;
+      double p = q*(d1*e1 + d2*e2 + third*d3*e3)/r2;
+      double b1 = k1*(q*e1 - p*d1);
+      double b2 = k2*(q*e2 - p*d2);
+      double b3 = third*k3*(q*e3 - p*d3);
+      h0[i]   -= b1 - b3;
+      h0[i+1] += b2 - b3;
+      h1[i]   -= b2 + b3;
+      h1[i+1] += b1 + b3;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/* HYPERBOLIC EDGE-PRESERVING SMOOTHNESS (1-D or 2-D)
+ *
+ * In 1-D, the penalty is sum(R - T) with R = sqrt(W1*D^2 + T^2) where D is
+ * the (masked) difference between consecutive elements.
+ *
+ * In 2-D, for each 2-by-2 cell with corners X1 = X(i,j), X2 = X(i,j+1),
+ * X3 = X(i+1,j) and X4 = X(i+1,j+1), the (masked) finite differences are:
+ *
+ *     D1 = X2 - X1,   D2 = X4 - X3,   D3 = X3 - X1,   D4 = X4 - X2,
+ *
+ * and the penalty is sum(R - T) with:
+ *
+ *     R = sqrt(W1*(D1^2 + D2^2) + W2*(D3^2 + D4^2) + T^2)
+ */
+
+static double SUFFIX(hyperbolic_fg)(const double w[2], double t, long rank,
+                                    long nx, long ny, const REAL* x,
+                                    const REAL* msk, REAL* g)
+{
+  const double w1 = w[0], w2 = w[1], tt = t*t;
+  double sum = 0.0;
+  long n;
+  if (g != NULL) memset(g, 0, nx*ny*sizeof(REAL));
+  if (rank == 1) {
+    n = nx - 1;
+    if (w1 <= 0.0) return 0.0;
+    for (long i = 0; i < n; ++i) {
+      double k = (msk != NULL ? msk[i]*msk[i+1] : 1.0);
+      double d = k*(x[i+1] - x[i]);
+      double r = sqrt(w1*d*d + tt);
+      sum += r;
+      if (g != NULL) {
+        double a = w1*k*d/r;
+        g[i]   -= a;
+        g[i+1] += a;
+      }
+    }
+  } else {
+    n = (nx - 1)*(ny - 1);
+    if (w1 <= 0.0 && w2 <= 0.0) return 0.0;
+    for (long j = 0; j < ny - 1; ++j) {
+      const REAL* x0 = x + nx*j;
+      const REAL* x1 = x0 + nx;
+      const REAL* m0 = (msk != NULL ? msk + nx*j : NULL);
+      const REAL* m1 = (msk != NULL ? m0 + nx : NULL);
+      REAL* g0 = (g != NULL ? g + nx*j : NULL);
+      REAL* g1 = (g != NULL ? g0 + nx : NULL);
+      for (long i = 0; i < nx - 1; ++i) {
+        double k1 = 1.0, k2 = 1.0, k3 = 1.0, k4 = 1.0;
+        if (msk != NULL) {
+          k1 = m1[i]*m0[i];
+          k2 = m1[i+1]*m0[i+1];
+          k3 = m0[i+1]*m0[i];
+          k4 = m1[i+1]*m1[i];
+        }
+        double d1 = k1*(x1[i] - x0[i]);
+        double d2 = k2*(x1[i+1] - x0[i+1]);
+        double d3 = k3*(x0[i+1] - x0[i]);
+        double d4 = k4*(x1[i+1] - x1[i]);
+        double r = sqrt(w1*(d1*d1 + d2*d2) + w2*(d3*d3 + d4*d4) + tt);
+        sum += r;
+        if (g != NULL) {
+          double q1 = w1/r, q2 = w2/r;
+          double a1 = q1*k1*d1;
+          double a2 = q1*k2*d2;
+          double a3 = q2*k3*d3;
+          double a4 = q2*k4*d4;
+          g0[i]   -= a1 + a3;
+          g1[i]   += a1 - a4;
+          g0[i+1] += a3 - a2;
+          g1[i+1] += a2 + a4;
+        }
+      }
+    }
+  }
+  return sum - n*t;
+}
+
+static void SUFFIX(hyperbolic_hv)(const double w[2], double t, long rank,
+                                  long nx, long ny, const REAL* x,
+                                  const REAL* msk, const REAL* s, REAL* h)
+{
+  const double w1 = w[0], w2 = w[1], tt = t*t;
+  memset(h, 0, nx*ny*sizeof(REAL));
+  if (rank == 1) {
+    if (w1 <= 0.0) return;
+    for (long i = 0; i < nx - 1; ++i) {
+      double k = (msk != NULL ? msk[i]*msk[i+1] : 1.0);
+      double d = k*(x[i+1] - x[i]);
+      double e = k*(s[i+1] - s[i]);
+      double r2 = w1*d*d + tt;
+      double r = sqrt(r2);
+      double b = k*w1*(e - d*w1*d*e/r2)/r;
+      h[i]   -= b;
+      h[i+1] += b;
+    }
+  } else {
+    if (w1 <= 0.0 && w2 <= 0.0) return;
+    for (long j = 0; j < ny - 1; ++j) {
+      const REAL* x0 = x + nx*j;
+      const REAL* x1 = x0 + nx;
+      const REAL* s0 = s + nx*j;
+      const REAL* s1 = s0 + nx;
+      const REAL* m0 = (msk != NULL ? msk + nx*j : NULL);
+      const REAL* m1 = (msk != NULL ? m0 + nx : NULL);
+      REAL* h0 = h + nx*j;
+      REAL* h1 = h0 + nx;
+      for (long i = 0; i < nx - 1; ++i) {
+        double k1 = 1.0, k2 = 1.0, k3 = 1.0, k4 = 1.0;
+        if (msk != NULL) {
+          k1 = m1[i]*m0[i];
+          k2 = m1[i+1]*m0[i+1];
+          k3 = m0[i+1]*m0[i];
+          k4 = m1[i+1]*m1[i];
+        }
+        double d1 = k1*(x1[i] - x0[i]);
+        double d2 = k2*(x1[i+1] - x0[i+1]);
+        double d3 = k3*(x0[i+1] - x0[i]);
+        double d4 = k4*(x1[i+1] - x1[i]);
+        double e1 = k1*(s1[i] - s0[i]);
+        double e2 = k2*(s1[i+1] - s0[i+1]);
+        double e3 = k3*(s0[i+1] - s0[i]);
+        double e4 = k4*(s1[i+1] - s1[i]);
+        double r2 = w1*(d1*d1 + d2*d2) + w2*(d3*d3 + d4*d4) + tt;
+        double r = sqrt(r2);
+        double p = (w1*(d1*e1 + d2*e2) + w2*(d3*e3 + d4*e4))/r2;
+        double b1 = k1*w1*(e1 - p*d1)/r;
+        double b2 = k2*w1*(e2 - p*d2)/r;
+        double b3 = k3*w2*(e3 - p*d3)/r;
+        double b4 = k4*w2*(e4 - p*d4)/r;
+        h0[i]   -= b1 + b3;
+        h1[i]   += b1 - b4;
+        h0[i+1] += b3 - b2;
+        h1[i+1] += b2 + b4;
+      }
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/* GENERAL PURPOSE SMOOTHNESS
+ *
+ * The penalty is the sum of COST(R) for all the finite differences
+ * R = C*(X(i+o1,j+o2,..) - X(i,j,..)) along the 2 first dimensions of X for
+ * offsets (o1,o2) = (1,0) and (0,1) with C = 1 and, if isotropic, (1,1) and
+ * (1,-1) with C = 1/sqrt(2).  The cost functions are those of cost_l2,
+ * cost_l2l1 and cost_l2l0 with hyper-parameters [MU,THRESHOLD].
+ */
+
+/* Compute the cost, its first derivative (in *DF) and, if D2F is not NULL,
+   its second derivative for residual R. */
+static inline double SUFFIX(xsmooth_cost)(int cost, double mu, double t,
+                                          double r, double* df, double* d2f)
+{
+  if (cost == RGL_COST_L2L1) {
+    double q = fabs(r)/t;
+    double u = 1.0/(1.0 + q);
+    *df = 2.0*mu*r*u;
+    if (d2f != NULL) *d2f = 2.0*mu*u*u;
+    return 2.0*mu*t*t*(q - log(1.0 + q));
+  } else if (cost == RGL_COST_L2L0) {
+    double q = r/t;
+    double u = 1.0/(1.0 + q*q);
+    double a = atan(q);
+    *df = 2.0*mu*t*a*u;
+    if (d2f != NULL) *d2f = 2.0*mu*(1.0 - 2.0*q*a)*u*u;
+    return mu*t*t*a*a;
+  } else {
+    *df = 2.0*mu*r;
+    if (d2f != NULL) *d2f = 2.0*mu;
+    return mu*r*r;
+  }
+}
+
+static double SUFFIX(xsmooth_fg)(const double hyper[], int cost, int iso,
+                                 long n1, long n2, long nb, const REAL* x,
+                                 REAL* g)
+{
+  static const long off1[] = {1, 0, 1,  1};
+  static const long off2[] = {0, 1, 1, -1};
+  const double scl[] = {1.0, 1.0, sqrt(0.5), sqrt(0.5)};
+  const double mu = hyper[0], t = hyper[1];
+  const int ndifs = (iso ? 4 : 2);
+  const long n = n1*n2;
+  double sum = 0.0;
+  if (g != NULL) memset(g, 0, n*nb*sizeof(REAL));
+  for (long b = 0; b < nb; ++b) {
+    const REAL* xb = x + n*b;
+    REAL* gb = (g != NULL ? g + n*b : NULL);
+    for (int k = 0; k < ndifs; ++k) {
+      const long o1 = off1[k], o2 = off2[k];
+      const long off = o1 + n1*o2;
+      const double c = scl[k];
+      const long i0 = (o1 < 0 ? -o1 : 0), i1 = (o1 > 0 ? n1 - o1 : n1);
+      const long j0 = (o2 < 0 ? -o2 : 0), j1 = (o2 > 0 ? n2 - o2 : n2);
+      for (long j = j0; j < j1; ++j) {
+        for (long i = i0; i < i1; ++i) {
+          long l = i + n1*j;
+          double df;
+          double r = c*(xb[l + off] - xb[l]);
+          sum += SUFFIX(xsmooth_cost)(cost, mu, t, r, &df, NULL);
+          if (gb != NULL) {
+            df *= c;
+            gb[l + off] += df;
+            gb[l] -= df;
+          }
+        }
+      }
+    }
+  }
+  return sum;
+}
+
+static void SUFFIX(xsmooth_hv)(const double hyper[], int cost, int iso,
+                               long n1, long n2, long nb, const REAL* x,
+                               const REAL* s, REAL* h)
+{
+  static const long off1[] = {1, 0, 1,  1};
+  static const long off2[] = {0, 1, 1, -1};
+  const double scl[] = {1.0, 1.0, sqrt(0.5), sqrt(0.5)};
+  const double mu = hyper[0], t = hyper[1];
+  const int ndifs = (iso ? 4 : 2);
+  const long n = n1*n2;
+  memset(h, 0, n*nb*sizeof(REAL));
+  for (long b = 0; b < nb; ++b) {
+    const REAL* xb = x + n*b;
+    const REAL* sb = s + n*b;
+    REAL* hb = h + n*b;
+    for (int k = 0; k < ndifs; ++k) {
+      const long o1 = off1[k], o2 = off2[k];
+      const long off = o1 + n1*o2;
+      const double c = scl[k];
+      const long i0 = (o1 < 0 ? -o1 : 0), i1 = (o1 > 0 ? n1 - o1 : n1);
+      const long j0 = (o2 < 0 ? -o2 : 0), j1 = (o2 > 0 ? n2 - o2 : n2);
+      for (long j = j0; j < j1; ++j) {
+        for (long i = i0; i < i1; ++i) {
+          long l = i + n1*j;
+          double df, d2f;
+          double r = c*(xb[l + off] - xb[l]);
+          SUFFIX(xsmooth_cost)(cost, mu, t, r, &df, &d2f);
+          double v = c*c*d2f*(sb[l + off] - sb[l]);
+          hb[l + off] += v;
+          hb[l] -= v;
+        }
+      }
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/* ENTROPY
+ *
+ * With Y = X + EPS and Q = P + EPS, P being the prior:
+ *
+ *     ID = 1:  F = -MU*sum(sqrt(Y))
+ *     ID = 2:  F = -MU*sum(log(Y))
+ *     ID = 3:  F =  MU*sum(Y*log(Y))
+ *     ID = 4:  F =  MU*sum(P - X + Y*log(Y/Q))
+ *     ID = 5:  F =  MU*sum(Y*log(Y/Q))
+ */
+
+static double SUFFIX(entropy_fg)(const double hyper[], int id, long n,
+                                 const REAL* x, const REAL* p, REAL* g)
+{
+  const double mu = hyper[0], eps = hyper[1];
+  double sum = 0.0;
+  for (long i = 0; i < n; ++i) {
+    double y = x[i] + eps;
+    double f, df;
+    if (id == 1) {
+      double r = sqrt(y);
+      f = -r;
+      df = -0.5/r;
+    } else if (id == 2) {
+      f = -log(y);
+      df = -1.0/y;
+    } else if (id == 3) {
+      double l = log(y);
+      f = y*l;
+      df = 1.0 + l;
+    } else {
+      double l = log(y/(p[i] + eps));
+      f = y*l;
+      df = l;
+      if (id == 4) {
+        f += p[i] - x[i];
+      } else {
+        df += 1.0;
+      }
+    }
+    sum += f;
+    if (g != NULL) g[i] = mu*df;
+  }
+  return mu*sum;
+}
+
+static void SUFFIX(entropy_diag)(const double hyper[], int id, long n,
+                                 const REAL* x, REAL* h)
+{
+  const double mu = hyper[0], eps = hyper[1];
+  for (long i = 0; i < n; ++i) {
+    double y = x[i] + eps;
+    if (id == 1) {
+      h[i] = 0.25*mu/(y*sqrt(y));
+    } else if (id == 2) {
+      h[i] = mu/(y*y);
+    } else {
+      h[i] = mu/y;
+    }
+  }
+}
+
+#undef REAL
+#undef SUFFIX
+
+#endif /* _RGL_KERNELS */
@@ -5,7 +5,7 @@ write, "*** TODO: optimize (1) add coefficients with same indices";
 write, "*** TODO: optimize (2) only keep non-zero coefficients (==> sparse_shrink becomes trivial)";
 write, "*** TODO: optimize (3) sort coefficients according to transpose or not";
 
-func sparse_test(row_dimlist, col_dimlist)
+func sparse_test(row_dimlist, col_dimlist, compressed)
 {
   a = random(row_dimlist, col_dimlist) - 0.5;
   dims = dimsof(a);
@@ -14,7 +14,8 @@ func sparse_test(row_dimlist, col_dimlist)
   nonzero = where(a);
   s = sparse_matrix(a(nonzero),
                     row_dimlist, 1 + (nonzero - 1)%stride,
-                    col_dimlist, 1 + (nonzero - 1)/stride);
+                    col_dimlist, 1 + (nonzero - 1)/stride,
+                    compressed=compressed);
 
   /* make A a 2-D matrix. */
   (ap = array(double, stride, numberof(a)/stride))(*) = a(*);
@@ -38,7 +39,35 @@ func sparse_test(row_dimlist, col_dimlist)
   //error;
 
 }
+
+func mvmult_test(m, n)
+{
+  a = random_n(m, n);
+  x = random_n(n);
+  u = random_n(m);
+  y0 = a(,+)*x(+);
+  v0 = a(+,)*u(+);
+  nthreads = yeti_nthreads();
+  for (k = 1; k <= 4; k *= 2) {
+    yeti_nthreads, k;
+    y1 = mvmult(a, x);
+    v1 = mvmult(a, u, 1);
+    y2 = mvmult(float(a), float(x));
+    v2 = mvmult(float(a), float(u), 1);
+    write, format="%dx%d (%d thread(s)): %g %g (double), %g %g (%s)\n",
+      m, n, k, max(abs(y1 - y0)), max(abs(v1 - v0)),
+      max(abs(y2 - y0))/max(abs(y0)), max(abs(v2 - v0))/max(abs(v0)),
+      typeof(y2);
+  }
+  yeti_nthreads, nthreads;
+}
+
 #if 1
 sparse_test,[2,8,5],[3,11,2,3];
 sparse_test,[3,8,5,11],[4,1,2,2,3];
+sparse_test,[2,8,5],[3,11,2,3],1;
+sparse_test,[3,8,5,11],[4,1,2,2,3],1;
+mvmult_test, 7, 3;
+mvmult_test, 5, 20000;
+mvmult_test, 1500, 900;
 #endif
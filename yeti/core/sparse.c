@@ -13,7 +13,11 @@
  *-----------------------------------------------------------------------------
  */
 
+#ifndef _YETI_SPARSE_C
+#define _YETI_SPARSE_C 1
+
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include "pstdlib.h"
 #include "yeti.h"
@@ -68,20 +72,42 @@ Operations sparseOps = {
  * The 'sparse' structure describes a sparse matrix.
  *
  * The 'index' structure describes the row/column index of a matrix.
+ *
+ * The 'compressed' structure describes the compressed storage of the
+ * non-zero coefficients by rows (CSR) or by columns (CSC).
  */
 
 typedef struct index index_t;
 
+typedef struct compressed compressed_t;
+
 typedef struct sparse sparse_t;
 
 struct index {
   size_t    nelem; /* number of elements in indexed array */
   size_t    ndims; /* number of dimensions in DIMLIST */
   size_t* dimlist; /* list of dimensions */
-  size_t* indices; /* indices of non-zero elements along this dimension */
+  size_t* indices; /* indices of non-zero elements along this dimension
+                      (NULL if matrix is compressed) */
+};
+
+/* In compressed storage, the non-zero coefficients of the i-th row (or
+   column) are COEFS[k] for k = PTR[i], ..., PTR[i+1]-1 and their column (or
+   row) indices are IDX32[k] if the indices fit in 32 bits, IDX[k]
+   otherwise. */
+struct compressed {
+  size_t*      ptr; /* offsets of rows/columns (NELEM + 1 elements) */
+  uint32_t*  idx32; /* 32-bit indices or NULL */
+  size_t*      idx; /* indices if IDX32 is NULL */
+  double*    coefs; /* non-zero coefficients */
 };
 
-/* A sparse matrix is stored in sparse compressed coordinate (COO) format. */
+/* A sparse matrix is stored in sparse compressed coordinate (COO) format,
+   or, if it is compressed, in both compressed sparse row (CSR) and
+   compressed sparse column (CSC) formats so that the direct and the
+   transposed products can be computed in parallel with contiguous
+   accesses and no write conflicts.  In the latter case, COEFS is the same
+   as CSR.COEFS and the COO indices are computed from the CSR storage. */
 struct sparse {
   int  references; /* reference counter */
   Operations* ops; /* virtual function table */
@@ -89,6 +115,9 @@ struct sparse {
   index_t     row; /* row indices of structural non-zero elements */
   index_t     col; /* column indices of structural non-zero elements */
   void*     coefs; /* structural non-zero elements of the sparse matrix */
+  int  compressed; /* matrix is stored in CSR and CSC formats */
+  compressed_t csr; /* storage by rows (for the direct product) */
+  compressed_t csc; /* storage by columns (for the transposed product) */
 };
 
 static void sparse_print(Operand* op)
@@ -120,29 +149,57 @@ static unsigned int get_flags(Symbol* s, unsigned int default_value);
 static Array* push_new_array(StructDef* base, size_t n,
                              const size_t dimlist[]);
 
+/** Fill compressed storage DST of the NUMBER coefficients COEFS by
+    'rows' given the 0-based 'row' indices I and 'column' indices J, N is
+    the number of 'rows'.  The order of the coefficients in a given 'row' is
+    preserved. */
+static void compress(compressed_t* dst, size_t n, size_t number,
+                     const long i[], const long j[], const double coefs[]);
+
+/** Multiply 'vector' X by compressed matrix A with N 'rows' and store the
+    result into Y. */
+static void compressed_product(const compressed_t* a, size_t n,
+                               const double x[], double y[]);
+
 /** Pop topmost stack element in place of OWNER.  If CLEANUP is true,
     drop symbols from top of the stack until OWNER is the topmost one. */
 static void pop_to(Symbol* owner, int cleanup);
 
 /* usage: sparse_matrix(coefs, row_dimlist, row_indices,
- *                             col_dimlist, col_indices)
+ *                             col_dimlist, col_indices, compressed=)
  */
 void Y_sparse_matrix(int argc)
 {
   /* Parse the arguments. */
-  if (argc != 5) {
+  static char* knames[] = {"compressed", NULL};
+  Symbol* kargs[1];
+  Symbol* args[5];
+  int nargs = 0;
+  YGetKeywords(sp - argc + 1, argc, knames, kargs);
+  for (Symbol* s = sp - argc + 1; s <= sp; ++s) {
+    if (s->ops == NULL) {
+      ++s; /* skip keyword value */
+    } else if (nargs < 5) {
+      args[nargs++] = s;
+    } else {
+      nargs = -1;
+      break;
+    }
+  }
+  if (nargs != 5) {
     yor_error("sparse_matrix takes exactly 5 arguments");
   }
+  int compressed = (kargs[0] != NULL && yor_get_boolean(kargs[0]));
   size_t number;
-  double* nonzero = get_array_d(sp - 4, &number);
+  double* nonzero = get_array_d(args[0], &number);
   size_t ndims1, nelem1;
-  long* dims1 = get_dimlist(sp - 3, &ndims1, &nelem1);
+  long* dims1 = get_dimlist(args[1], &ndims1, &nelem1);
   size_t len1;
-  long* idx1 = get_array_l(sp - 2, &len1);
+  long* idx1 = get_array_l(args[2], &len1);
   size_t ndims2, nelem2;
-  long* dims2 = get_dimlist(sp - 1, &ndims2, &nelem2);
+  long* dims2 = get_dimlist(args[3], &ndims2, &nelem2);
   size_t len2;
-  long* idx2 = get_array_l(sp, &len2);
+  long* idx2 = get_array_l(args[4], &len2);
 
   /* Check row (1st) indices. */
   if (len1 != number) {
@@ -164,42 +221,128 @@ void Y_sparse_matrix(int argc)
     }
   }
 
+  /* Compute the layout of the sparse matrix which is allocated as a single
+     memory chunk: header, dimension lists, arrays of size_t (COO indices or
+     CSR/CSC offsets and indices), arrays of double (coefficients) and arrays
+     of uint32_t (compacted CSR/CSC indices). */
+  int csr32 = (nelem2 <= UINT32_MAX); /* CSR stores column indices */
+  int csc32 = (nelem1 <= UINT32_MAX); /* CSC stores row indices */
+  size_t nint = ndims1 + ndims2;
+  size_t nreal, nidx32;
+  if (compressed) {
+    nint += (nelem1 + 1) + (nelem2 + 1) +
+      (csr32 ? 0 : number) + (csc32 ? 0 : number);
+    nreal = 2*number;
+    nidx32 = (csr32 ? number : 0) + (csc32 ? number : 0);
+  } else {
+    nint += 2*number;
+    nreal = number;
+    nidx32 = 0;
+  }
+  size_t off1 = YOR_ROUND_UP(sizeof(sparse_t), sizeof(size_t));
+  size_t off2 = YOR_ROUND_UP(off1 + nint*sizeof(size_t), sizeof(double));
+  size_t off3 = off2 + nreal*sizeof(double);
+  size_t size = YOR_ROUND_UP(off3 + nidx32*sizeof(uint32_t), sizeof(double));
+
   /* Allocate memory for the sparse matrix. Push the opaque object as soon
      as possible onto the stack to limit memory leak in case of
      interrupt. */
-  size_t off1 = YOR_ROUND_UP(sizeof(sparse_t), sizeof(size_t));
-  size_t nint = ndims1 + number + ndims2 + number;
-  size_t off2 = YOR_ROUND_UP(off1 + nint*sizeof(size_t), sizeof(double));
-  size_t size = YOR_ROUND_UP(off2 + number*sizeof(double), sizeof(double));
   sparse_t* sparse = p_malloc(size);
+  memset(sparse, 0, sizeof(sparse_t));
   sparse->references = 0;
   sparse->ops = &sparseOps;
   PushDataBlock(sparse); /* early push */
   sparse->number = number;
+  sparse->compressed = compressed;
+  size_t* ibuf = (size_t*)((char*)sparse + off1);
+  double* rbuf = (double*)((char*)sparse + off2);
+  uint32_t* ubuf = (uint32_t*)((char*)sparse + off3);
   sparse->row.nelem = nelem1;
   sparse->row.ndims = ndims1;
-  sparse->row.dimlist = (size_t*)((char*)sparse + off1);
-  sparse->row.indices = sparse->row.dimlist + ndims1;
+  sparse->row.dimlist = ibuf;
+  ibuf += ndims1;
   sparse->col.nelem = nelem2;
   sparse->col.ndims = ndims2;
-  sparse->col.dimlist = sparse->row.indices + number;
-  sparse->col.indices = sparse->col.dimlist + ndims2;
-  sparse->coefs = (double*)((char*)sparse + off2);
-
-  /* Fill up coefficients and list of row/column indices (beware that
-     Yorick uses 1-based indices). */
+  sparse->col.dimlist = ibuf;
+  ibuf += ndims2;
   for (size_t i = 0; i < ndims1; ++i) {
     sparse->row.dimlist[i] = dims1[i];
   }
   for (size_t i = 0; i < ndims2; ++i) {
     sparse->col.dimlist[i] = dims2[i];
   }
-  double* coefs = sparse->coefs;
-  size_t* row_indices = sparse->row.indices;
-  size_t* col_indices = sparse->col.indices;
-  for (size_t i = 0; i < number; ++i) row_indices[i] = idx1[i] - 1;
-  for (size_t i = 0; i < number; ++i) col_indices[i] = idx2[i] - 1;
-  for (size_t i = 0; i < number; ++i) coefs[i] = nonzero[i];
+
+  if (compressed) {
+    /* Fill up compressed storage by rows and by columns (compress takes
+       the 1-based Yorick indices and converts them itself). */
+    sparse->csr.ptr = ibuf;
+    ibuf += nelem1 + 1;
+    sparse->csc.ptr = ibuf;
+    ibuf += nelem2 + 1;
+    if (csr32) {
+      sparse->csr.idx32 = ubuf;
+      ubuf += number;
+    } else {
+      sparse->csr.idx = ibuf;
+      ibuf += number;
+    }
+    if (csc32) {
+      sparse->csc.idx32 = ubuf;
+      ubuf += number;
+    } else {
+      sparse->csc.idx = ibuf;
+      ibuf += number;
+    }
+    sparse->csr.coefs = rbuf;
+    sparse->csc.coefs = rbuf + number;
+    sparse->coefs = sparse->csr.coefs;
+    compress(&sparse->csr, nelem1, number, idx1, idx2, nonzero);
+    compress(&sparse->csc, nelem2, number, idx2, idx1, nonzero);
+  } else {
+    /* Fill up coefficients and list of row/column indices (beware that
+       Yorick uses 1-based indices). */
+    sparse->row.indices = ibuf;
+    ibuf += number;
+    sparse->col.indices = ibuf;
+    ibuf += number;
+    sparse->coefs = rbuf;
+    double* coefs = sparse->coefs;
+    size_t* row_indices = sparse->row.indices;
+    size_t* col_indices = sparse->col.indices;
+    for (size_t i = 0; i < number; ++i) row_indices[i] = idx1[i] - 1;
+    for (size_t i = 0; i < number; ++i) col_indices[i] = idx2[i] - 1;
+    for (size_t i = 0; i < number; ++i) coefs[i] = nonzero[i];
+  }
+}
+
+static void compress(compressed_t* dst, size_t n, size_t number,
+                     const long i[], const long j[], const double coefs[])
+{
+  /* Counting sort of the coefficients by 'rows', indices I and J are
+     1-based.  PTR[r+1] is first used to count the number of coefficients in
+     the r-th 'row', then PTR[r] is the position where to store the next
+     coefficient of the r-th 'row'. */
+  size_t* ptr = dst->ptr;
+  memset(ptr, 0, (n + 1)*sizeof(size_t));
+  for (size_t k = 0; k < number; ++k) {
+    ++ptr[i[k]];
+  }
+  for (size_t r = 1; r <= n; ++r) {
+    ptr[r] += ptr[r-1];
+  }
+  for (size_t r = n; r >= 1; --r) {
+    ptr[r] = ptr[r-1];
+  }
+  for (size_t k = 0; k < number; ++k) {
+    size_t l = ptr[i[k]]++;
+    dst->coefs[l] = coefs[k];
+    if (dst->idx32 != NULL) {
+      dst->idx32[l] = j[k] - 1;
+    } else {
+      dst->idx[l] = j[k] - 1;
+    }
+  }
+  ptr[0] = 0;
 }
 
 void Y_is_sparse_matrix(int argc)
@@ -406,21 +549,64 @@ static void sparse_eval(Operand* op0)
 
   /* Create the output 'vector' and perform the matrix multiplication. */
   y = push_new_array(&doubleStruct, out->ndims, out->dimlist)->value.d;
-  memset(y, 0, out->nelem*sizeof(*y));
-  i = out->indices;
-  j = inp->indices;
-  number = sparse->number;
-  a = sparse->coefs;
-  for (k=0 ; k<number ; ++k) {
-    y[i[k]] += a[k]*x[j[k]];
+  if (sparse->compressed) {
+    compressed_product(flags ? &sparse->csc : &sparse->csr,
+                       out->nelem, x, y);
+  } else {
+    memset(y, 0, out->nelem*sizeof(*y));
+    i = out->indices;
+    j = inp->indices;
+    number = sparse->number;
+    a = sparse->coefs;
+    for (k=0 ; k<number ; ++k) {
+      y[i[k]] += a[k]*x[j[k]];
+    }
   }
 
   /* Pop result in place of sparse matrix and cleanup the stack. */
   pop_to(op0->owner, 1);
 }
 
+/* Number of 'rows' processed at a time by a thread in sparse matrix
+   products. */
+#define SPARSE_CHUNK 256
+
+static void compressed_product(const compressed_t* a, size_t n,
+                               const double x[], double y[])
+{
+  const size_t* ptr = a->ptr;
+  const double* c = a->coefs;
+  int nthreads = yor_nthreads(ptr[n]);
+  long r, nr = n;
+
+  if (a->idx32 != NULL) {
+    const uint32_t* idx = a->idx32;
+    YOR_OMP(parallel for num_threads(nthreads) schedule(dynamic, SPARSE_CHUNK) if(nthreads > 1))
+    for (r = 0; r < nr; ++r) {
+      double s = 0.0;
+      for (size_t k = ptr[r]; k < ptr[r+1]; ++k) {
+        s += c[k]*x[idx[k]];
+      }
+      y[r] = s;
+    }
+  } else {
+    const size_t* idx = a->idx;
+    YOR_OMP(parallel for num_threads(nthreads) schedule(dynamic, SPARSE_CHUNK) if(nthreads > 1))
+    for (r = 0; r < nr; ++r) {
+      double s = 0.0;
+      for (size_t k = ptr[r]; k < ptr[r+1]; ++k) {
+        s += c[k]*x[idx[k]];
+      }
+      y[r] = s;
+    }
+  }
+}
+
 static void push_indices(const index_t* p, size_t number);
 
+static void push_compressed_indices(const compressed_t* p, size_t n,
+                                    size_t number, int by_row);
+
 static void push_dimlist(const index_t* p);
 
 static void sparse_get_member(Operand* op, char* name)
@@ -430,14 +616,16 @@ static void sparse_get_member(Operand* op, char* name)
   static long col_dimlist_id = -1L;
   static long col_indices_id = -1L;
   static long coefs_id = -1L;
+  static long compressed_id = -1L;
   sparse_t* this = (sparse_t*)op->value;
 
-  if (coefs_id < 0) {
+  if (compressed_id < 0) {
     row_dimlist_id = Globalize("row_dimlist", 0L);
     row_indices_id = Globalize("row_indices", 0L);
     col_dimlist_id = Globalize("col_dimlist", 0L);
     col_indices_id = Globalize("col_indices", 0L);
     coefs_id = Globalize("coefs", 0L);
+    compressed_id = Globalize("compressed", 0L);
   }
   if (name) {
     long id = Globalize(name, 0L);
@@ -451,13 +639,26 @@ static void sparse_get_member(Operand* op, char* name)
       push_dimlist(&this->row);
       ok = 1;
     } else if (id == row_indices_id) {
-      push_indices(&this->row, this->number);
+      if (this->compressed) {
+        push_compressed_indices(&this->csr, this->row.nelem,
+                                this->number, 1);
+      } else {
+        push_indices(&this->row, this->number);
+      }
       ok = 1;
     } else if (id == col_dimlist_id) {
       push_dimlist(&this->col);
       ok = 1;
     } else if (id == col_indices_id) {
-      push_indices(&this->col, this->number);
+      if (this->compressed) {
+        push_compressed_indices(&this->csr, this->row.nelem,
+                                this->number, 0);
+      } else {
+        push_indices(&this->col, this->number);
+      }
+      ok = 1;
+    } else if (id == compressed_id) {
+      PushIntValue(this->compressed);
       ok = 1;
     }
     if (ok) {
@@ -507,6 +708,30 @@ static void push_indices(const index_t* p, size_t number)
   }
 }
 
+/* Push the 1-based 'row' (BY_ROW true) or 'column' (BY_ROW false) indices
+   of the coefficients of a matrix compressed by rows, N is the number of
+   rows. */
+static void push_compressed_indices(const compressed_t* p, size_t n,
+                                    size_t number, int by_row)
+{
+  long* ptr = push_new_array(&longStruct, number, NULL)->value.l;
+  if (by_row) {
+    for (size_t r = 0; r < n; ++r) {
+      for (size_t k = p->ptr[r]; k < p->ptr[r+1]; ++k) {
+        ptr[k] = r + 1;
+      }
+    }
+  } else if (p->idx32 != NULL) {
+    for (size_t k = 0; k < number; ++k) {
+      ptr[k] = p->idx32[k] + 1;
+    }
+  } else {
+    for (size_t k = 0; k < number; ++k) {
+      ptr[k] = p->idx[k] + 1;
+    }
+  }
+}
+
 static Array* push_new_array(StructDef* base, size_t n,
                              const size_t dimlist[])
 {
@@ -525,22 +750,42 @@ static Array* push_new_array(StructDef* base, size_t n,
 }
 
 /*---------------------------------------------------------------------------*/
+/* DENSE MATRIX-VECTOR MULTIPLICATION */
+
+/* Number of output elements processed per block by the dense kernels.  For
+   the direct product, a block of the output vector shall fit into the level 1
+   cache while the columns of the matrix are streamed. */
+#define MVMULT_BLOCK 512
+
+#define MVMULT_MIN(a,b) ((a) <= (b) ? (a) : (b))
+
+static void mvmult_d(int job, double y[], const double a[], const double x[],
+                     size_t ny, size_t nx, int nthreads, double ws[]);
+static void mvmult_f(int job, float y[], const float a[], const float x[],
+                     size_t ny, size_t nx, int nthreads, float ws[]);
+
+#define REAL   double
+#define SUFFIX d
+#include __FILE__
+
+#define REAL   float
+#define SUFFIX f
+#include __FILE__
 
 static size_t pack_dimlist(const Dimension* dims, size_t dimlist[],
                            size_t maxdims);
 
 void Y_mvmult(int argc)
 {
-  const double zero = 0.0;
-  double s;
   Operand op;
   unsigned int flags;
   Symbol* stack;
   Dimension* dims;
-  const double* a, *x;
-  double* y;
-  size_t i, j, nx, ny;
+  const void* a, *x;
+  void* y, *ws;
+  size_t i, nx, ny, nblocks;
   size_t ndims_a, ndims_x, ndims_y;
+  int type_a, type_x, nthreads;
 #define MAXDIMS 32
   size_t dimlist_a[MAXDIMS], dimlist_x[MAXDIMS];
 
@@ -557,42 +802,38 @@ void Y_mvmult(int argc)
       yor_error("unsupported job value (should be 0 or 1)");
     }
 
-    /* Get the 'matrix' A. */
-    switch (op.ops->typeID) {
-    case YOR_CHAR:
-    case YOR_SHORT:
-    case YOR_INT:
-    case YOR_LONG:
-    case YOR_FLOAT:
-      op.ops->ToDouble(&op);
-    case YOR_DOUBLE:
-      ndims_a = pack_dimlist(op.type.dims, dimlist_a, MAXDIMS);
-      a = op.value;
-      break;
-    default:
+    /* Get the 'matrix' A and the 'vector' X.  Computations are done in
+       single precision if A is a float array and X is not a double array,
+       in double precision otherwise. */
+    type_a = op.ops->typeID;
+    if (type_a < YOR_CHAR || type_a > YOR_DOUBLE) {
       yor_error("expecting array of reals for the 'matrix'");
-      return; /* avoid compiler warnings */
     }
-
-    /* Get the 'vector' X. */
     ++stack;
     if (stack->ops == NULL) yor_unexpected_keyword_argument();
-    stack->ops->FormOperand(stack, &op);
-    switch (op.ops->typeID) {
-    case YOR_CHAR:
-    case YOR_SHORT:
-    case YOR_INT:
-    case YOR_LONG:
-    case YOR_FLOAT:
-      op.ops->ToDouble(&op);
-    case YOR_DOUBLE:
-      ndims_x = pack_dimlist(op.type.dims, dimlist_x, MAXDIMS);
-      x = op.value;
-      break;
-    default:
+    type_x = stack->ops->FormOperand(stack, &op)->ops->typeID;
+    if (type_x < YOR_CHAR || type_x > YOR_DOUBLE) {
       yor_error("expecting array of reals for the 'vector'");
-      return; /* avoid compiler warnings */
     }
+    if (type_a == YOR_FLOAT && type_x != YOR_DOUBLE) {
+      if (type_x != YOR_FLOAT) op.ops->ToFloat(&op);
+    } else {
+      if (type_x != YOR_DOUBLE) op.ops->ToDouble(&op);
+    }
+    type_x = op.ops->typeID;
+    ndims_x = pack_dimlist(op.type.dims, dimlist_x, MAXDIMS);
+    x = op.value;
+    --stack;
+    stack->ops->FormOperand(stack, &op);
+    if (type_a != type_x) {
+      if (type_x == YOR_FLOAT) {
+        op.ops->ToFloat(&op);
+      } else {
+        op.ops->ToDouble(&op);
+      }
+    }
+    ndims_a = pack_dimlist(op.type.dims, dimlist_a, MAXDIMS);
+    a = op.value;
 
     /* Cleanup temporary dimension list. */
     dims = tmpDims;
@@ -631,25 +872,28 @@ void Y_mvmult(int argc)
       }
     }
 
+    /* Choose the number of threads.  Threads normally work on separate
+       blocks of the output vector; if there are not enough such blocks,
+       threads work on separate parts of the input vector and their partial
+       results are summed (in a deterministic order) from a workspace which
+       must be pushed before the result. */
+    nthreads = yor_nthreads(nx*ny);
+    nblocks = (ny + MVMULT_BLOCK - 1)/MVMULT_BLOCK;
+    if (nthreads > 1 && nblocks < nthreads) {
+      if (nthreads > nx) nthreads = (nx > 1 ? nx : 1);
+      ws = yor_push_workspace(nthreads*ny*(type_x == YOR_FLOAT ?
+                                           sizeof(float) : sizeof(double)));
+    } else {
+      ws = NULL;
+    }
+
     /* Allocate output array and perform matrix multiplication. */
-    y = ((Array*)PushDataBlock(NewArray(&doubleStruct, tmpDims)))->value.d;
-    if (flags) {
-      for (i = 0 ; i < ny ; ++i, a += nx) {
-        s = zero;
-        for (j = 0 ; j < nx ; ++j) {
-          s += a[j]*x[j];
-        }
-        y[i] = s;
-      }
+    if (type_x == YOR_FLOAT) {
+      y = ((Array*)PushDataBlock(NewArray(&floatStruct, tmpDims)))->value.f;
+      mvmult_f(flags, y, a, x, ny, nx, nthreads, ws);
     } else {
-      memset(y, 0, ny*sizeof(*y));
-      for (j = 0 ; j < nx ; ++j, a += ny) {
-        if ((s = x[j]) != zero) {
-          for (i = 0 ; i < ny ; ++i) {
-            y[i] += a[i]*s;
-          }
-        }
-      }
+      y = ((Array*)PushDataBlock(NewArray(&doubleStruct, tmpDims)))->value.d;
+      mvmult_d(flags, y, a, x, ny, nx, nthreads, ws);
     }
   }
 }
@@ -671,3 +915,156 @@ static size_t pack_dimlist(const Dimension* dims, size_t dimlist[],
   }
   return n;
 }
+
+#else /* _YETI_SPARSE_C is defined */
+
+/*---------------------------------------------------------------------------*/
+/* DENSE MATRIX-VECTOR KERNELS */
+
+/*
+ * The following code is compiled for each floating-point type REAL (float or
+ * double) with SUFFIX the corresponding suffix of the function names.
+ *
+ * For the direct product (job = 0), A is a NY-by-NX matrix stored in
+ * column-major order (as a Yorick array) and y = A.x is computed by
+ * accumulating 4 columns at a time into a block of y small enough to remain
+ * in the cache.  For the transposed product (job = 1), A is stored as NY
+ * contiguous rows of length NX and y = A'.x is computed as dot products of 4
+ * rows at a time with x so that x is loaded only once for these rows.  The
+ * innermost loops have no dependencies other than reductions and are written
+ * for the compiler to vectorize them.
+ */
+
+#define MVMULT_JOIN(a, b) YOR_XJOIN(a, b)
+#define MVMULT_DIRECT     MVMULT_JOIN(mvmult_direct_,    SUFFIX)
+#define MVMULT_TRANSPOSE  MVMULT_JOIN(mvmult_transpose_, SUFFIX)
+#define MVMULT            MVMULT_JOIN(mvmult_,           SUFFIX)
+
+/* Add A(i0:i1-1,j0:j1-1).x(j0:j1-1) to y(i0:i1-1) (0-based ranges). */
+static void MVMULT_DIRECT(REAL y[], const REAL a[], const REAL x[],
+                          size_t ny, size_t i0, size_t i1,
+                          size_t j0, size_t j1)
+{
+  const REAL zero = 0;
+  size_t i, j, ib, ie;
+
+  for (ib = i0; ib < i1; ib = ie) {
+    ie = MVMULT_MIN(ib + MVMULT_BLOCK, i1);
+    for (j = j0; j + 4 <= j1; j += 4) {
+      REAL x0 = x[j], x1 = x[j+1], x2 = x[j+2], x3 = x[j+3];
+      if (x0 != zero || x1 != zero || x2 != zero || x3 != zero) {
+        const REAL* a0 = a + j*ny;
+        const REAL* a1 = a0 + ny;
+        const REAL* a2 = a1 + ny;
+        const REAL* a3 = a2 + ny;
+        YOR_OMP(simd)
+        for (i = ib; i < ie; ++i) {
+          y[i] += (a0[i]*x0 + a1[i]*x1) + (a2[i]*x2 + a3[i]*x3);
+        }
+      }
+    }
+    for (; j < j1; ++j) {
+      REAL x0 = x[j];
+      if (x0 != zero) {
+        const REAL* a0 = a + j*ny;
+        YOR_OMP(simd)
+        for (i = ib; i < ie; ++i) {
+          y[i] += a0[i]*x0;
+        }
+      }
+    }
+  }
+}
+
+/* Store A(j0:j1-1,i0:i1-1)'.x(j0:j1-1) into y(i0:i1-1) (0-based ranges). */
+static void MVMULT_TRANSPOSE(REAL y[], const REAL a[], const REAL x[],
+                             size_t nx, size_t i0, size_t i1,
+                             size_t j0, size_t j1)
+{
+  size_t i, j;
+
+  for (i = i0; i + 4 <= i1; i += 4) {
+    const REAL* a0 = a + i*nx;
+    const REAL* a1 = a0 + nx;
+    const REAL* a2 = a1 + nx;
+    const REAL* a3 = a2 + nx;
+    REAL s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    YOR_OMP(simd reduction(+:s0,s1,s2,s3))
+    for (j = j0; j < j1; ++j) {
+      REAL t = x[j];
+      s0 += a0[j]*t;
+      s1 += a1[j]*t;
+      s2 += a2[j]*t;
+      s3 += a3[j]*t;
+    }
+    y[i] = s0;
+    y[i+1] = s1;
+    y[i+2] = s2;
+    y[i+3] = s3;
+  }
+  for (; i < i1; ++i) {
+    const REAL* a0 = a + i*nx;
+    REAL s0 = 0;
+    YOR_OMP(simd reduction(+:s0))
+    for (j = j0; j < j1; ++j) {
+      s0 += a0[j]*x[j];
+    }
+    y[i] = s0;
+  }
+}
+
+/* Compute y = A.x (JOB = 0) or y = A'.x (JOB = 1) with NTHREADS threads.  If
+   WS is NULL, each thread computes whole blocks of y; otherwise, WS has
+   NTHREADS*NY elements and each thread computes the contribution of a part of
+   x into its own NY elements of WS. */
+static void MVMULT(int job, REAL y[], const REAL a[], const REAL x[],
+                   size_t ny, size_t nx, int nthreads, REAL ws[])
+{
+  long k, n;
+
+  if (ws == NULL) {
+    n = (ny + MVMULT_BLOCK - 1)/MVMULT_BLOCK;
+    YOR_OMP(parallel for num_threads(nthreads) schedule(static) if(nthreads > 1))
+    for (k = 0; k < n; ++k) {
+      size_t i0 = k*MVMULT_BLOCK;
+      size_t i1 = MVMULT_MIN(i0 + MVMULT_BLOCK, ny);
+      if (job) {
+        MVMULT_TRANSPOSE(y, a, x, nx, i0, i1, 0, nx);
+      } else {
+        memset(y + i0, 0, (i1 - i0)*sizeof(REAL));
+        MVMULT_DIRECT(y, a, x, ny, i0, i1, 0, nx);
+      }
+    }
+  } else {
+    n = nthreads;
+    YOR_OMP(parallel for num_threads(nthreads) schedule(static))
+    for (k = 0; k < n; ++k) {
+      size_t j0 = (nx*k)/n;
+      size_t j1 = (nx*(k + 1))/n;
+      REAL* w = ws + k*ny;
+      if (job) {
+        MVMULT_TRANSPOSE(w, a, x, nx, 0, ny, j0, j1);
+      } else {
+        memset(w, 0, ny*sizeof(REAL));
+        MVMULT_DIRECT(w, a, x, ny, 0, ny, j0, j1);
+      }
+    }
+    memcpy(y, ws, ny*sizeof(REAL));
+    for (k = 1; k < n; ++k) {
+      const REAL* w = ws + k*ny;
+      size_t i;
+      for (i = 0; i < ny; ++i) {
+        y[i] += w[i];
+      }
+    }
+  }
+}
+
+#undef MVMULT
+#undef MVMULT_TRANSPOSE
+#undef MVMULT_DIRECT
+#undef MVMULT_JOIN
+#undef SUFFIX
+#undef REAL
+
+#endif /* _YETI_SPARSE_C */
@@ -20,6 +20,10 @@
 #include "yeti.h"
 #include "yio.h"
 
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+
 /*---------------------------------------------------------------------------*/
 
 char* yor_strcpy(const char* s)
@@ -625,6 +629,38 @@ static void bad_opaque_type(const yor_opaque_type_t* type)
   yor_error(msg);
 }
 
+/*---------------------------------------------------------------------------*/
+/* MULTI-THREADING */
+
+/* Maximum number of threads, 0 to use the default of the OpenMP runtime. */
+static int max_threads = 0;
+
+int yor_get_max_threads(void)
+{
+#ifdef _OPENMP
+  return (max_threads > 0 ? max_threads : omp_get_max_threads());
+#else
+  return 1;
+#endif
+}
+
+void yor_set_max_threads(int nthreads)
+{
+  max_threads = (nthreads > 0 ? nthreads : 0);
+}
+
+int yor_nthreads(size_t work)
+{
+  size_t nthreads = yor_get_max_threads();
+  if (nthreads > 1) {
+    size_t n = work/YOR_MIN_WORK_PER_THREAD;
+    if (n < nthreads) {
+      nthreads = (n > 1 ? n : 1);
+    }
+  }
+  return (int)nthreads;
+}
+
 /*---------------------------------------------------------------------------*/
 /* WORKSPACE */
 
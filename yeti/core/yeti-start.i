@@ -1,4 +1,7 @@
 autoload, "yeti.i",
+    abcd_apply,
+    abcd_bispectrum,
+    abcd_spectrum,
     anonymous,
     arc,
     cost_l2,
@@ -6,6 +9,15 @@ autoload, "yeti.i",
     cost_l2l1,
     debug_refs,
     empty_tuple,
+    fidelity_add,
+    fidelity_new,
+    fits_mmap,
+    fits_mmap_advise,
+    fits_mmap_column,
+    fits_mmap_get,
+    fits_mmap_header,
+    fits_mmap_image,
+    fork,
     fpe_handling,
     fullsizeof,
     get_encoding,
@@ -38,8 +50,11 @@ autoload, "yeti.i",
     heapsort,
     install_encoding,
     insure_temporary,
+    is_fidelity,
+    is_fits_mmap,
     is_hash,
     is_mvect,
+    is_nudft,
     is_sparse_matrix,
     is_symlink,
     is_tuple,
@@ -68,12 +83,17 @@ autoload, "yeti.i",
     name_of_symlink,
     native_byte_order,
     nrefsof,
+    nudft_separable,
     parse_range,
     product,
     quick_interquartile_range,
     quick_median,
     quick_quartile,
     quick_select,
+    rgl_entropy_diag,
+    rgl_entropy_fg,
+    rgl_hyperbolic_fg,
+    rgl_hyperbolic_hv,
     rgl_roughness_cauchy,
     rgl_roughness_cauchy_periodic,
     rgl_roughness_l1,
@@ -84,6 +104,10 @@ autoload, "yeti.i",
     rgl_roughness_l2l0_periodic,
     rgl_roughness_l2l1,
     rgl_roughness_l2l1_periodic,
+    rgl_totvar_fg,
+    rgl_totvar_hv,
+    rgl_xsmooth_fg,
+    rgl_xsmooth_hv,
     same_encoding,
     setup_package,
     sinc,
@@ -100,7 +124,10 @@ autoload, "yeti.i",
     tuple,
     typemax,
     typemin,
+    unpack_bintable,
     value_of_symlink,
+    waitpid,
     yeti_convolve,
     yeti_init,
+    yeti_nthreads,
     yeti_wavelet;
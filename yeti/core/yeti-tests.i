@@ -270,10 +270,349 @@ func test_mixed_vectors(nil)
     test_eval, "dbg.nrefs == 1";
 }
 
+func test_nudft(nil)
+{
+    m = 50; nx = 17; ny = 12;
+    u = random_n(m); v = random_n(m);
+    x = span(-1, 1, nx); y = span(-1, 1, ny);
+    op = nudft_separable(u, x, v, y);
+    test_eval, "is_nudft(op)";
+    test_eval, "op.nx == nx && op.ny == ny && op.nfreqs == m";
+    q = -2*pi*(u*x(-,) + v*y(-,-,)); // M-by-NX-by-NY phases
+    a = random(nx, ny);
+    z = op(a);
+    re = cos(q)(,*)(,+)*a(*)(+);
+    im = sin(q)(,*)(,+)*a(*)(+);
+    test_eval, "max(abs(z - transpose([re, im]))) < 1e-12*max(abs(z))";
+    w = random_n(2, m);
+    b = op(w, 1);
+    test_eval, "abs(sum(z*w) - sum(a*b)) < 1e-12*sum(abs(z*w))";
+}
+
+func test_fork(nil)
+{
+    pid = fork();
+    if (pid == 0) {
+        batch, 1;
+        quit;
+    }
+    test_eval, "pid > 0";
+    test_eval, "waitpid(pid) == 0";
+}
+
+func test_fidelity(nil)
+{
+    nfreqs = 20; n = 15;
+    vis = random_n(2, nfreqs);
+    idx = 1 + long(nfreqs*random(n)*0.999);
+    dat = random(n); wgt = random(n);
+    obj = fidelity_new(nfreqs);
+    test_eval, "is_fidelity(obj)";
+    fidelity_add, obj, "vis2", 0, idx, [], dat, wgt;
+    test_eval, "obj.nterms == 1 && obj.ndata == n";
+    err = (vis(1,idx)^2 + vis(2,idx)^2) - dat;
+    test_eval, "abs(obj(vis) - sum(wgt*err^2)) < 1e-12*obj(vis)";
+    idx3 = 1 + long(nfreqs*random(3, n)*0.999);
+    sgn = double(2*(random(3, n) > 0.5) - 1);
+    fidelity_add, obj, "t3phi", 3, idx3, sgn, random_n(n), wgt;
+    fidelity_add, obj, "t3", 0, idx3, sgn, random_n(n), random_n(n),
+        wgt, 0.1*wgt, wgt;
+    test_eval, "obj.nterms == 3 && obj.ndata == 4*n";
+    local grd;
+    cost = obj(vis, grd);
+    test_eval, "cost == obj(vis)";
+    /* Check the gradient by finite differences. */
+    eps = 1e-6;
+    fd = array(double, dimsof(vis));
+    for (k = 1; k <= numberof(vis); ++k) {
+        v = vis; v(k) += eps; c1 = obj(v);
+        v = vis; v(k) -= eps; c2 = obj(v);
+        fd(k) = (c1 - c2)/(2*eps);
+    }
+    test_eval, "max(abs(grd - fd)) < 1e-5*max(abs(grd))";
+}
+
+func test_abcd(nil)
+{
+    nlbd = 3; nstep = 16; nscan = 5; nbase = 4; nin = 6; nout = 7;
+    m = random_n(nlbd, nout, nin);
+    x = random_n(nlbd, nstep, nscan, nin);
+    y = abcd_apply(m, x);
+    z = array(double, nlbd, nstep, nscan, nout);
+    for (l = 1; l <= nlbd; ++l) z(l,..) = x(l,..,+)*m(l,,+);
+    test_eval, "max(abs(y - z)) < 1e-12*max(abs(z))";
+
+    ft = random_n(nlbd, nstep, nscan, nbase) + 1i*random_n(nlbd, nstep, nscan, nbase);
+    mask = double(random(nlbd, nstep, nbase) > 0.5);
+    s = abcd_spectrum(ft, mask);
+    test_eval, "dimsof(s)(1) == 4 && allof(dimsof(s)(2:) == [4, nlbd, nscan, nbase])";
+    psd = abs(ft)^2;
+    bias = psd;
+    bias(,2:,,) = bias(,:2:-1,,);
+    fin = ft*mask(,,-,);
+    cross = (fin(,1:-1,,)*conj(fin(,2:0,,)))(,sum,,);
+    test_eval, "max(abs(s(1,..) - (psd*mask(,,-,))(,sum,,))) < 1e-12*max(psd)*nstep";
+    test_eval, "max(abs(s(2,..) - (bias*mask(,,-,))(,sum,,))) < 1e-12*max(psd)*nstep";
+    test_eval, "max(abs(s(3,..) - cross.re) + abs(s(4,..) - cross.im)) < 1e-12*max(psd)*nstep";
+
+    idx = [[1,2,3], [1,3,4], [2,4,1]];
+    b = abcd_bispectrum(ft, idx);
+    ref = (ft(..,idx(1,))*ft(..,idx(2,))*conj(ft(..,idx(3,))))(,avg,,);
+    test_eval, "structof(b) == complex && max(abs(b - ref)) < 1e-12*max(abs(ref))";
+    n2 = random(nlbd, nstep, nscan, nbase);
+    b = abcd_bispectrum(n2, idx);
+    ref = sqrt(abs(n2(..,idx(1,))*n2(..,idx(2,))*n2(..,idx(3,))))(,avg,,);
+    test_eval, "structof(b) == double && max(abs(b - ref)) < 1e-12*max(ref)";
+}
+
+func test_rgl_kernels(nil)
+{
+    x = random(12, 9) + 0.1;
+    s = random_n(12, 9);
+    p = random(12, 9) + 0.1;
+    msk = double(random(12, 9) > 0.2);
+    h = 1e-6;
+    local g, gp, gm;
+    // Each kernel is checked against finite differences of the penalty
+    // (gradient) and of the gradient (Hessian-vector product).
+    for (iso = 0; iso <= 1; ++iso) {
+        f = rgl_totvar_fg([2.0, 0.1], iso, x, msk, g);
+        fp = rgl_totvar_fg([2.0, 0.1], iso, x + h*s, msk, gp);
+        fm = rgl_totvar_fg([2.0, 0.1], iso, x - h*s, msk, gm);
+        hs = rgl_totvar_hv([2.0, 0.1], iso, x, msk, s);
+        test_eval, "abs((fp - fm)/(2*h) - sum(g*s)) < 1e-6*sum(abs(g*s))";
+        test_eval, "max(abs((gp - gm)/(2*h) - hs)) < 1e-6*max(abs(hs))";
+        test_eval, "rgl_totvar_fg([2.0, 0.1], iso, x, [])*0 == 0";
+    }
+    f = rgl_hyperbolic_fg([2.0, 0.1], [1.0, 0.5], x, msk, g);
+    fp = rgl_hyperbolic_fg([2.0, 0.1], [1.0, 0.5], x + h*s, msk, gp);
+    fm = rgl_hyperbolic_fg([2.0, 0.1], [1.0, 0.5], x - h*s, msk, gm);
+    hs = rgl_hyperbolic_hv([2.0, 0.1], [1.0, 0.5], x, msk, s);
+    test_eval, "abs((fp - fm)/(2*h) - sum(g*s)) < 1e-6*sum(abs(g*s))";
+    test_eval, "max(abs((gp - gm)/(2*h) - hs)) < 1e-6*max(abs(hs))";
+    for (k = 1; k <= 3; ++k) {
+        cost = ["l2", "l2l1", "l2l0"](k);
+        f = rgl_xsmooth_fg([2.0, 0.1], cost, 1n, x, g);
+        fp = rgl_xsmooth_fg([2.0, 0.1], cost, 1n, x + h*s, gp);
+        fm = rgl_xsmooth_fg([2.0, 0.1], cost, 1n, x - h*s, gm);
+        hs = rgl_xsmooth_hv([2.0, 0.1], cost, 1n, x, s);
+        test_eval, "abs((fp - fm)/(2*h) - sum(g*s)) < 1e-6*sum(abs(g*s))";
+        test_eval, "max(abs((gp - gm)/(2*h) - hs)) < 1e-6*max(abs(hs))";
+    }
+    test_eval, "abs(rgl_xsmooth_fg([2.0, 0.0], \"l2l1\", 0n, x) - 2*sum(x(dif,)^2) - 2*sum(x(,dif)^2)) < 1e-12";
+    for (id = 1; id <= 5; ++id) {
+        f = rgl_entropy_fg([2.0, 1e-9], id, x, p, g);
+        fp = rgl_entropy_fg([2.0, 1e-9], id, x + h*s, p, gp);
+        fm = rgl_entropy_fg([2.0, 1e-9], id, x - h*s, p, gm);
+        hs = rgl_entropy_diag([2.0, 1e-9], id, x)*s;
+        test_eval, "abs((fp - fm)/(2*h) - sum(g*s)) < 1e-6*sum(abs(g*s))";
+        test_eval, "max(abs((gp - gm)/(2*h) - hs)) < 1e-6*max(abs(hs))";
+    }
+    f = rgl_totvar_fg([2.0, 0.1], 1n, float(x), msk, g);
+    test_eval, "structof(g) == float";
+    test_eval, "abs(f - rgl_totvar_fg([2.0, 0.1], 1n, x, msk)) < 1e-5*abs(f)";
+}
+
+func test_rgl_roughness(nil)
+{
+    // The array is large enough to be split in several tiles.
+    x = random(40, 30, 50);
+    local g1, g4;
+    r = x(,,3:50) - x(,,1:48);
+    g = array(double, dimsof(x));
+    g(,,1:48) -= 3*r;
+    g(,,3:50) += 3*r;
+    test_eval, "abs(rgl_roughness_l2(1.5, [0,0,2], x, g1) - 1.5*sum(r*r)) < 1e-12*sum(r*r)";
+    test_eval, "max(abs(g1 - g)) < 1e-12";
+    r = roll(x, [0,0,1]) - x;
+    test_eval, "abs(rgl_roughness_l2_periodic(1.5, [0,0,-1], x) - 1.5*sum(r*r)) < 1e-12*sum(r*r)";
+    // The result must not depend on the number of threads.
+    for (p = 0; p <= 1; ++p) {
+        rgl = (p ? rgl_roughness_l2l1_periodic : rgl_roughness_l2l1);
+        old = yeti_nthreads(1);
+        g1 = []; f1 = rgl([1.3, 0.2], [1,-3,5], x, g1);
+        yeti_nthreads, 4;
+        g4 = []; f4 = rgl([1.3, 0.2], [1,-3,5], x, g4);
+        yeti_nthreads, old;
+        test_eval, "f1 == f4 && allof(g1 == g4)";
+    }
+}
+
+func _test_morph_ref(a, dx, dy, mop)
+{
+    // Brute force dilation (MOP true) or erosion of 2-D array A by a
+    // structuring element containing the origin.
+    w = dimsof(a)(2); h = dimsof(a)(3);
+    r = a;
+    for (i = 1; i <= numberof(dx); ++i) {
+        x0 = max(1, 1 - dx(i)); x1 = min(w, w - dx(i));
+        y0 = max(1, 1 - dy(i)); y1 = min(h, h - dy(i));
+        if (x0 > x1 || y0 > y1) continue;
+        s = a(x0+dx(i):x1+dx(i), y0+dy(i):y1+dy(i));
+        t = r(x0:x1, y0:y1);
+        r(x0:x1, y0:y1) = (mop ? max(t, s) : min(t, s));
+    }
+    return r;
+}
+
+func test_morph(nil)
+{
+    a = random_n(37, 23);
+    for (r = 0; r <= 6; ++r) {
+        x = indgen(-r:r); y = x(-,);
+        k = where(x*x + y*y <= r*(r + 1));
+        dx = (x + 0*y)(k); dy = (0*x + y)(k);
+        test_eval, "allof(morph_dilation(a, r) == _test_morph_ref(a, dx, dy, 1))";
+        test_eval, "allof(morph_erosion(a, r) == _test_morph_ref(a, dx, dy, 0))";
+    }
+    // Box and irregular structuring elements.
+    x = indgen(-3:2); y = indgen(-1:4)(-,);
+    dx = (x + 0*y)(*); dy = (0*x + y)(*);
+    test_eval, "allof(morph_dilation(a, [dx, dy]) == _test_morph_ref(a, dx, dy, 1))";
+    dx = [0, 3, 4, 5, -2, 0, -1, -7, -6, -5, 2, 1];
+    dy = [0, 1, 1, 1, -2, 0, -2,  3,  3,  3, 0, 0];
+    test_eval, "allof(morph_erosion(a, [dx, dy]) == _test_morph_ref(a, dx, dy, 0))";
+    b = short(100*a);
+    test_eval, "allof(morph_dilation(b, [dx, dy]) == _test_morph_ref(b, dx, dy, 1))";
+}
+
+func _test_same_array(a, b)
+{
+    return (structof(a) == structof(b) && numberof(dimsof(a)) ==
+            numberof(dimsof(b)) && allof(dimsof(a) == dimsof(b)) &&
+            allof(a == b));
+}
+
+func test_bintable(nil)
+{
+    require, "fits.i";
+    nrows = 7;
+    cols = [&short(indgen(nrows) - 4), &int(1000*random_n(nrows, 3)),
+            &float(random(nrows)), &random_n(nrows, 2, 3),
+            &(random_n(nrows, 2) + 1i*random_n(nrows, 2)),
+            &char(indgen(nrows)), &char(['T','F',' '](1 + indgen(nrows)%3)),
+            &swrite(format="str%d  ", indgen(nrows))];
+    file = "/tmp/yeti-test-bintable.fits";
+    fh = fits_open(file, 'w', overwrite=1);
+    fits_set, fh, "SIMPLE", 'T';
+    fits_set, fh, "BITPIX", 8;
+    fits_set, fh, "NAXIS", 0;
+    fits_set, fh, "EXTEND", 'T';
+    fits_write_header, fh;
+    fits_new_bintable, fh;
+    fits_write_bintable, fh, cols;
+    fits_close, fh;
+    fh = fits_open(file);
+    fits_next_hdu, fh;
+    ref = fits_read_bintable(fh);
+    pitch = fits_get(fh, "NAXIS1");
+    tform = tdim = array(string, numberof(cols));
+    for (i = 1; i <= numberof(cols); ++i) {
+        tform(i) = fits_get(fh, swrite(format="TFORM%d", i));
+        if (i == 4) tdim(i) = fits_get(fh, "TDIM4");
+    }
+    raw = array(char, pitch, nrows);
+    _read, _car(fh, 4), _car(fh, 3)(3), raw;
+    fits_close, fh;
+    remove, file;
+    // fits_read_bintable reads 'J' columns as 64-bit integers on LP64
+    // machines and fits_write_bintable cannot write logical columns.
+    ref(2) = &long(*cols(2));
+    ref(7) = &_fits_bintable_fix_logical(*ref(7), -1);
+    tform(7) = "L";
+    ptr = unpack_bintable(raw, tform, tdim);
+    for (i = 1; i <= numberof(cols); ++i) {
+        test_eval, swrite(format="_test_same_array(*ptr(%d), *ref(%d))", i, i);
+    }
+    ptr = unpack_bintable(raw, tform, tdim, last=1);
+    test_eval, "_test_same_array(*ptr(4), transpose(*ref(4), 0))";
+    test_eval, "_test_same_array(*ptr(2), transpose(*ref(2)))";
+    ptr = unpack_bintable(raw, tform, trim=1);
+    test_eval, "dimsof(*ptr(4))(1) == 2 && allof(*ptr(4) == (*ref(4))(,*))";
+    test_eval, "allof(*ptr(8) == strtrim(*ref(8), 2))";
+}
+
+func test_fits_mmap(nil)
+{
+    require, "fits.i";
+    nrows = 9;
+    img = float(random_n(4, 3, 5));
+    cols = [&short(indgen(nrows) - 4), &random_n(nrows, 2, 3),
+            &swrite(format="str%d  ", indgen(nrows))];
+    file = "/tmp/yeti-test-mmap.fits";
+    fh = fits_open(file, 'w', overwrite=1);
+    fits_set, fh, "SIMPLE", 'T';
+    fits_set, fh, "BITPIX", -32;
+    fits_set, fh, "NAXIS", 3;
+    fits_set, fh, "NAXIS1", 4;
+    fits_set, fh, "NAXIS2", 3;
+    fits_set, fh, "NAXIS3", 5;
+    fits_set, fh, "EXTEND", 'T';
+    fits_write_header, fh;
+    fits_write_array, fh, img;
+    fits_new_bintable, fh;
+    fits_set, fh, "EXTNAME", "IMAGING_DATA";
+    fits_set, fh, "TTYPE1", "INDEX";
+    fits_set, fh, "TTYPE2", "DATA";
+    fits_set, fh, "TTYPE3", "NAME";
+    fits_write_bintable, fh, cols;
+    fits_close, fh;
+
+    fm = fits_mmap(file);
+    test_eval, "is_fits_mmap(fm) && !is_fits_mmap(file)";
+    test_eval, "fm.nhdus == 2 && fm.path == file";
+    test_eval, "is_void(fits_mmap(file + \"-missing\", quiet=1))";
+    test_eval, "fits_mmap_get(fm, 1, \"naxis3\") == 5";
+    test_eval, "is_void(fits_mmap_get(fm, 1, \"BSCALE\"))";
+    test_eval, "fits_mmap_get(fm, \"IMAGING_DATA\", \"TTYPE3\") == \"NAME\"";
+    test_eval, "numberof(fits_mmap_header(fm, 2)) > 10";
+    test_eval, "_test_same_array(fits_mmap_image(fm, 1), img)";
+    test_eval, "_test_same_array(fits_mmap_image(fm, 1, 2), img(,,2))";
+    test_eval, "_test_same_array(fits_mmap_image(fm, 1, 2:0:2), img(,,2:0:2))";
+    test_eval, "_test_same_array(fits_mmap_image(fm, 1, [5,1]), img(,,[5,1]))";
+    test_eval, "_test_same_array(fits_mmap_column(fm, 2, 1), *cols(1))";
+    test_eval, "_test_same_array(fits_mmap_column(fm, 2, \"data\"), *cols(2))";
+    test_eval, "_test_same_array(fits_mmap_column(fm, 2, 2, 3:6), (*cols(2))(3:6,,))";
+    test_eval, "_test_same_array(fits_mmap_column(fm, 2, 2, 4, last=1), (*cols(2))(4,,))";
+    test_eval, "_test_same_array(fits_mmap_column(fm, 2, 2, ::-3, last=1), transpose((*cols(2))(::-3,,), 0))";
+    test_eval, "_test_same_array(fits_mmap_column(fm, 2, 3, [2,2,-1]), (*cols(3))([2,2,8]))";
+    test_eval, "allof(fits_mmap_column(fm, 2, 3, trim=1) == strtrim(*cols(3), 2))";
+    fits_mmap_advise, fm, "sequential";
+    fits_mmap_advise, fm, "willneed", 2, 3:5;
+    fm = [];
+
+    // fits.i cannot write HIERARCH cards.
+    cards = swrite(format="%-80s", ["SIMPLE  =                    T",
+                                    "BITPIX  =                    8",
+                                    "NAXIS   =                    0",
+                                    "HIERARCH ESO DET DIT = 2.5D-1 / [s]",
+                                    "OBJECT  = 'O''Hara  '", "END"]);
+    raw = array(char(' '), 2880);
+    raw(1:80*numberof(cards)) = strchar(sum(cards))(1:-1);
+    f = open(file, "wb");
+    _write, f, 0, raw;
+    close, f;
+    fm = fits_mmap(file);
+    test_eval, "fits_mmap_get(fm, 1, \"eso det dit\") == 0.25";
+    test_eval, "fits_mmap_get(fm, 1, \"OBJECT\") == \"O'Hara\"";
+    test_eval, "fits_mmap_get(fm, 1, \"SIMPLE\") == 1";
+    fm = [];
+    remove, file;
+}
+
 if (batch()) {
     test_tuples;
     test_types;
     test_mixed_vectors;
+    test_nudft;
+    test_rgl_kernels;
+    test_rgl_roughness;
+    test_morph;
+    test_bintable;
+    test_fits_mmap;
+    test_fidelity;
+    test_abcd;
+    test_fork;
     test_quick_quartile;
     test_summary;
 }
@@ -476,6 +476,36 @@ extern void* yor_push_workspace(size_t nbytes);
         the caller has to make sure that the stack is large enough (see
         CheckStack). */
 
+/*---------------------------------------------------------------------------*/
+/* MULTI-THREADING */
+
+/* Multi-threaded kernels are written with OpenMP directives which are
+   simply ignored if Yeti is not compiled with OpenMP support. */
+#ifdef _OPENMP
+# define YOR_OMP(args) _Pragma(YOR_STRINGIFY(omp args))
+#else
+# define YOR_OMP(args)
+#endif
+/*----- Insert OpenMP directive "#pragma omp ARGS" if OpenMP is enabled. */
+
+#define YOR_MIN_WORK_PER_THREAD 32768
+/*----- Minimum number of elementary operations for a thread to be worth
+        starting. */
+
+extern int yor_get_max_threads(void);
+/*----- Return the maximum number of threads that multi-threaded kernels
+        may use (always 1 if OpenMP is not enabled). */
+
+extern void yor_set_max_threads(int nthreads);
+/*----- Set the maximum number of threads that multi-threaded kernels may
+        use.  If NTHREADS < 1, the default of the OpenMP runtime (e.g. as
+        set by environment variable OMP_NUM_THREADS) is restored. */
+
+extern int yor_nthreads(size_t work);
+/*----- Return the number of threads to use for a computation involving
+        WORK elementary operations.  The result is at least 1 and at most
+        the value returned by yor_get_max_threads. */
+
 /*---------------------------------------------------------------------------*/
 /* OPAQUE OBJECTS */
 
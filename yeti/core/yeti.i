@@ -1376,6 +1376,14 @@ extern morph_erosion;
            dy = indgen(-2:2);
            result =  morph_dilation(img, [dx, dy(-,)])
 
+     If the structuring element contains the origin (which is always the
+     case when R is a radius), it is decomposed into runs of consecutive
+     offsets along the 1st dimension and the van Herk/Gil-Werman algorithm is
+     used: the cost per voxel does not depend on the length of the runs, and
+     the operation is separable (hence the cost is independent of the size)
+     for a box.  The result is exactly the same as with the direct algorithm.
+     Large arrays are processed in parallel (see yeti_nthreads).
+
 
    SEE ALSO: morph_closing, morph_opening, morph_white_top_hat,
              morph_black_top_hat, morph_enhance.
@@ -1656,6 +1664,10 @@ extern rgl_roughness_cauchy_periodic;
      the contents of GRD is augmented by the gradient (and GRD is converted to
      "double" if it is not yet the case).
 
+     Large arrays are processed by tiles in parallel (see yeti_nthreads).
+     The tiles do not depend on the number of threads, so the result is the
+     same whatever the number of threads.
+
 
    EXAMPLES
 
@@ -1685,6 +1697,53 @@ extern rgl_roughness_cauchy_periodic;
      cost_l2.
  */
 
+extern rgl_totvar_fg;
+extern rgl_totvar_hv;
+extern rgl_hyperbolic_fg;
+extern rgl_hyperbolic_hv;
+extern rgl_xsmooth_fg;
+extern rgl_xsmooth_hv;
+extern rgl_entropy_fg;
+extern rgl_entropy_diag;
+/* DOCUMENT err = rgl_totvar_fg(hyper, isotropic, x, mask [, grd]);
+         or hs = rgl_totvar_hv(hyper, isotropic, x, mask, s);
+         or err = rgl_hyperbolic_fg(hyper, eta, x, mask [, grd]);
+         or hs = rgl_hyperbolic_hv(hyper, eta, x, mask, s);
+         or err = rgl_xsmooth_fg(hyper, cost, isotropic, x [, grd]);
+         or hs = rgl_xsmooth_hv(hyper, cost, isotropic, x, s);
+         or err = rgl_entropy_fg(hyper, id, x, prior [, grd]);
+         or hd = rgl_entropy_diag(hyper, id, x);
+
+     Compiled kernels for the "totvar", "hyperbolic", "xsmooth" and "entropy"
+     regularizers of IPY's "rgl.i" (which see for the definitions of the
+     penalties).  The functions with suffix "_fg" return the penalty ERR at X
+     and, if optional argument GRD is specified, store the gradient in the
+     caller's variable GRD.  Penalty and gradient are computed in a single
+     pass without temporary arrays.  The functions with suffix "_hv" return
+     the product of the Hessian of the penalty at X by S, rgl_entropy_diag
+     returns the diagonal of the Hessian of the (separable) entropy.
+
+     X may be of any real type, computations are done in single precision if
+     X is of type float and in double precision otherwise.  Optional MASK
+     (which may be nil) and S must have the same dimensions as X.
+
+     For total variation, X is a 2-D array, HYPER = [MU, EPSILON] and
+     ISOTROPIC is a boolean.
+
+     For hyperbolic smoothness, X is a 1-D or 2-D array, HYPER = [MU, TAU]
+     and ETA is a scalar or a vector of scales along the dimensions of X.
+
+     For general smoothness, the finite differences are taken along the 2
+     first dimensions of X, HYPER = [MU, THRESHOLD] and COST is the name of
+     the cost function ("l2", "l2l1" or "l2l0", with or without a "cost_"
+     prefix, see cost_l2).
+
+     For entropy, HYPER = [MU, EPSILON], ID is the identifier (1 to 5) of the
+     entropy and PRIOR is the prior (required for ID = 4 or 5).
+
+   SEE ALSO: rgl_roughness_l2, cost_l2.
+ */
+
 /*---------------------------------------------------------------------------*/
 /* 1D CONVOLUTION AND "A TROUS" WAVELET TRANSFORM */
 
@@ -1954,6 +2013,8 @@ extern arc;
 extern sparse_matrix;
 /* DOCUMENT s = sparse_matrix(coefs, row_dimlist, row_indices,
                                      col_dimlist, col_indices);
+         or s = sparse_matrix(coefs, row_dimlist, row_indices,
+                                     col_dimlist, col_indices, compressed=1);
 
      Returns a sparse matrix object.  COEFS is an array with the non-zero
      coefficients of the full matrix.  ROW_DIMLIST and COL_DIMLIST are the
@@ -1978,8 +2039,17 @@ extern sparse_matrix;
 
       The contents of the sparse matrix object S can be queried as with a
       regular Yorick structure: S.coefs, S.row_dimlist, S.row_indices,
-      S.col_dimlist or S.col_indices are valid expressions if S is a sparse
-      matrix.
+      S.col_dimlist, S.col_indices or S.compressed are valid expressions if S
+      is a sparse matrix.
+
+      If keyword COMPRESSED is true, the coefficients are stored once sorted
+      by rows (CSR format) and once sorted by columns (CSC format), with
+      32-bit indices when the dimensions allow it.  A compressed sparse
+      matrix takes about the same memory as a non-compressed one, but its
+      direct and transposed products are faster and multi-threaded (see
+      yeti_nthreads).  For a compressed sparse matrix, S.coefs, S.row_indices
+      and S.col_indices yield the coefficients and their indices sorted by
+      rows.
 
 
     SEE ALSO: is_sparse_matrix, mvmult,
@@ -2006,17 +2076,19 @@ func sparse_grow(s, coefs, row_indices, col_indices)
 {
   return sparse_matrix(grow(s.coefs, coefs),
                        s.row_dimlist, grow(s.row_indices, row_indices),
-                       s.col_dimlist, grow(s.col_indices, col_indices));
+                       s.col_dimlist, grow(s.col_indices, col_indices),
+                       compressed=s.compressed);
 }
 
-func sparse_squeeze(a, n)
+func sparse_squeeze(a, n, compressed=)
 /* DOCUMENT s = sparse_squeeze(a);
          or s = sparse_squeeze(a, n);
      Convert array A into its sparse matrix representation.  Optional argument
      N (default, N=1) is the number of dimensions of the input space.  The
      dimension list of the input space are the N trailing dimensions of A and,
      assuming that A has NDIMS dimensions, the dimension list of the output
-     space are the NDIMS - N leading dimensions of A.
+     space are the NDIMS - N leading dimensions of A.  Keyword COMPRESSED is
+     passed to sparse_matrix.
 
    SEE ALSO: sparse_matrix, sparse_expand.
  */
@@ -2038,7 +2110,7 @@ func sparse_squeeze(a, n)
   j = i - 1;
   return sparse_matrix(a(i),
                        row_dimlist, 1 + j%stride,
-                       col_dimlist, 1 + j/stride);
+                       col_dimlist, 1 + j/stride, compressed=compressed);
 }
 
 func sparse_expand(s)
@@ -2119,10 +2191,299 @@ extern mvmult;
      same as those of X and the dimensions of the result are the remaining
      trailing dimensions of A.
 
-   SEE ALSO: sparse_matrix, sparse_squeeze.
+     If A is a regular array, the computations are done in single precision
+     if A is of type float and X is not of type double and in double
+     precision otherwise.  The products by large regular arrays are
+     multi-threaded (see yeti_nthreads), so are the products by compressed
+     sparse matrices.
+
+   SEE ALSO: sparse_matrix, sparse_squeeze, yeti_nthreads.
+ */
+
+extern yeti_nthreads;
+/* DOCUMENT yeti_nthreads, n;
+         or old = yeti_nthreads(n);
+         or yeti_nthreads();
+
+     Set or query the maximum number of threads used by the multi-threaded
+     functions of Yeti (e.g., mvmult).  When called as a function, the
+     previous setting is returned.  If N < 1, the default of the OpenMP
+     runtime is restored, usually the number of processors or the value of
+     the environment variable OMP_NUM_THREADS.  Small problems are always
+     processed with fewer threads.  The number of threads is always 1 if
+     Yeti has been compiled without OpenMP support.
+
+   SEE ALSO: mvmult.
+ */
+
+/*---------------------------------------------------------------------------*/
+/* NONUNIFORM DISCRETE FOURIER TRANSFORM */
+
+extern nudft_separable;
+extern is_nudft;
+/* DOCUMENT op = nudft_separable(u, x, v, y);
+         or is_nudft(obj);
+
+     The function nudft_separable() yields an operator implementing the
+     separable 2-D nonuniform discrete Fourier transform of an image sampled
+     at positions X (along the 1st dimension) and Y (along the 2nd dimension)
+     for the spatial frequencies (U,V) which are vectors of same length, say
+     M.  The operator is used as:
+
+         z = op(a);     // direct transform
+         b = op(z, 1);  // real part of the adjoint transform
+
+     where A is an NX-by-NY real array with NX = numberof(X) and
+     NY = numberof(Y) and Z is a 2-by-M real array such that Z(1,k) and
+     Z(2,k) are the real and imaginary parts of:
+
+         sum_{i,j} A(i,j)*exp(-2i*pi*(U(k)*X(i) + V(k)*Y(j)))
+
+     The coefficients exp(-2i*pi*U(k)*X(i)) and exp(-2i*pi*V(k)*Y(j)) are
+     precomputed and the transforms are computed in a single pass without
+     temporary arrays and are multi-threaded (see yeti_nthreads).  Members
+     op.nx, op.ny and op.nfreqs yield NX, NY and M, op.A1 and op.A2 yield the
+     coefficients as 2-by-NX-by-M and 2-by-NY-by-M arrays.
+
+     is_nudft(obj) yields whether OBJ is a nonuniform discrete Fourier
+     transform operator.
+
+   SEE ALSO: mvmult, yeti_nthreads.
  */
 
 
+/*---------------------------------------------------------------------------*/
+/* DATA FIDELITY FOR INTERFEROMETRIC DATA */
+
+extern fidelity_new;
+extern fidelity_add;
+extern is_fidelity;
+/* DOCUMENT obj = fidelity_new(nfreqs);
+         or fidelity_add, obj, kind, approx, idx, sgn, dat, wgt;
+         or fidelity_add, obj, kind, approx, idx, sgn, re, im, wrr, wri, wii;
+         or cost = obj(vis);
+         or cost = obj(vis, grd);
+         or is_fidelity(obj);
+
+     Compiled data fidelity for interferometric data.  fidelity_new() creates
+     an empty data fidelity object for a model of NFREQS complex
+     visibilities.  fidelity_add() appends a term to the data fidelity, KIND
+     is one of:
+
+       "vis2"   - powerspectrum data DAT with weights WGT;
+       "visamp" - visibility amplitude data DAT with weights WGT;
+       "visphi" - visibility phase data DAT (in radians) with weights WGT;
+       "vis"    - complex visibility data RE + i*IM with weights WRR, WRI
+                  and WII (see mira_polar_to_cartesian);
+       "t3amp"  - bispectrum amplitude data DAT with weights WGT;
+       "t3phi"  - closure phase data DAT (in radians) with weights WGT;
+       "t3"     - complex bispectrum data RE + i*IM with weights WRR, WRI
+                  and WII.
+
+     IDX gives the (1-based) indices of the model complex visibilities
+     involved in each measurement, it is a 3-by-N array for the bispectrum
+     terms and has N elements otherwise, N being the number of measurements.
+     SGN (can be nil except for "t3" and "t3phi") has the same dimensions as
+     IDX and gives the signs (+1 or -1) of the phases of the complex
+     visibilities in the bispectrum.  APPROX is the approximation of the
+     phase penalty (only used for "visphi" and "t3phi"): 1 for a quadratic
+     penalty of the wrapped phase residuals, 2 for the convex limit
+     (sin(err)^2) and 3 for the von Mises penalty (4*sin(err/2)^2).  The
+     terms are the same as in MiRA's data fidelity.
+
+     Applying the object to a 2-by-NFREQS array VIS of model complex
+     visibilities (real parts in VIS(1,) and imaginary parts in VIS(2,))
+     yields the total cost integrated in a single pass over all the terms.
+     If GRD is specified, it must be a simple variable reference to store the
+     gradient of the cost with respect to VIS.
+
+     Members OBJ.nfreqs, OBJ.nterms and OBJ.ndata yield the number of model
+     complex visibilities, the number of terms and the number of real-valued
+     measurements.
+
+   SEE ALSO: nudft_separable.
+ */
+
+/*---------------------------------------------------------------------------*/
+/* ABCD FRINGE ESTIMATORS */
+
+extern abcd_apply;
+extern abcd_spectrum;
+extern abcd_bispectrum;
+/* DOCUMENT y = abcd_apply(m, x);
+         or s = abcd_spectrum(ft, mask);
+         or b = abcd_bispectrum(x, idx);
+
+     Compiled kernels of the estimators of scanning ABCD fringe data (as
+     used by PNDRS).  The data are stored with the spectral channel varying
+     fastest, then the OPD step, the scan and the output or the baseline.
+     The kernels make a single pass over the data without temporary arrays
+     and are multi-threaded over the scans (see yeti_nthreads).
+
+     abcd_apply() applies a linear model independently for each spectral
+     channel: M is NLBD-by-NOUT-by-NIN, X is NLBD-by-...-by-NIN and the
+     result is NLBD-by-...-by-NOUT:
+
+         y(l,..,j) = sum_k m(l,j,k)*x(l,..,k)
+
+     This yields the coherent fluxes from the pixels with M the
+     pseudo-inverse of the V2PM (see QRsolve) and the continuum from the
+     fluxes with M the V2PM.
+
+     abcd_spectrum() integrates the power spectrum of the complex Fourier
+     transform FT (NLBD-by-NSTEP-by-NSCAN-by-NBASE) over the frequencies
+     selected by the real array MASK (NLBD-by-NSTEP-by-NBASE).  The result
+     is 4-by-NLBD-by-NSCAN-by-NBASE with, for each channel, scan and
+     baseline:
+
+         s(1,..) = sum_f mask(f)*abs(ft(f))^2          // power
+         s(2,..) = sum_f mask(f)*abs(ft(-f))^2         // bias
+         s(3,..) + 1i*s(4,..) =                        // cross spectrum
+             sum_f mask(f)*mask(f+1)*ft(f)*conj(ft(f+1))
+
+     where the opposite frequency -f of step F > 1 is step NSTEP + 2 - F
+     (the bias is the power at the negative frequencies, where there are no
+     fringes).
+
+     abcd_bispectrum() averages over the OPD steps the bispectrum of the
+     complex coherent fluxes X (NLBD-by-NSTEP-by-NSCAN-by-NBASE) for the
+     triplets of baselines IDX (3-by-NCLO array of 1-based indices):
+
+         b(l,scan,c) = avg_step x(..,i)*x(..,j)*conj(x(..,k))
+
+     with [i,j,k] = IDX(,c).  The result is NLBD-by-NSCAN-by-NCLO.  If X is
+     real, the average of sqrt(abs(x(..,i)*x(..,j)*x(..,k))) is computed
+     instead (normalisation of the bispectrum amplitude).
+
+   SEE ALSO: QRsolve, yeti_nthreads.
+ */
+
+/*---------------------------------------------------------------------------*/
+/* CHILD PROCESSES */
+
+extern fork;
+extern waitpid;
+/* DOCUMENT pid = fork();
+         or status = waitpid(pid);
+
+     The function fork() creates a new process by duplicating the calling
+     Yorick process.  It returns 0 in the child process and the identifier of
+     the child in the parent process.  Pending output is flushed before
+     forking.  The child has a copy-on-write image of all the variables of
+     the parent, so large read-only data are shared at no cost.  The child
+     should end by calling `quit` (it may be worth turning batch mode on in
+     the child so that any error also terminates it).
+
+     The thread pools of the parent do not survive in the child, and a
+     multi-threaded kernel would wait forever for them.  The child is
+     therefore single-threaded: `yeti_nthreads` is set to 1 and so is the
+     number of threads of the OpenMP runtime.  Do not raise them in the
+     child.  Objects created by the parent with their own threads (e.g. NFFT
+     operators or FFTW plans made with several threads) must be rebuilt in
+     the child with a single thread.
+
+     The function waitpid() waits for the child process PID to terminate and
+     returns its exit status, or minus the number of the signal that killed
+     it.
+
+   SEE ALSO: quit, batch, spawn, yeti_nthreads.
+ */
+
+/*---------------------------------------------------------------------------*/
+/* FITS FILES */
+
+extern unpack_bintable;
+/* DOCUMENT ptr = unpack_bintable(raw, tform);
+         or ptr = unpack_bintable(raw, tform, tdim, trim=, last=);
+
+     Decode the raw contents of a FITS binary table.  RAW is a PITCH-by-NROWS
+     array of char's with the rows of the table as stored in the file (PITCH
+     is the value of NAXIS1 and NROWS that of NAXIS2), TFORM is an array of
+     strings with the values of the TFORMn keywords and optional TDIM is an
+     array of strings, of same length as TFORM, with the values of the TDIMn
+     keywords ("" or string(0) for a missing keyword).
+
+     The result is a pointer array, the n-th element of which is the n-th
+     field of the table with the same conventions as fits_read_bintable:
+     dimensions are NROWS-by-TDIMn (or NROWS-by-REPEAT if TDIMn is not set,
+     or just NROWS if the repeat count is 1), 'A' fields yield a vector of
+     NROWS strings, 'L' fields yield int's (1 for 'T', 0 for 'F' and -1
+     otherwise), 'B' fields yield char's, 'I' fields yield short's, 'J' and
+     'K' fields yield long's, 'E' fields yield float's, 'D' fields yield
+     double's and 'C' and 'M' fields yield complex's.  Empty fields,
+     variable length arrays ('P' and 'Q' formats) and bit arrays ('X'
+     format) yield a null pointer.
+
+     If keyword TRIM is true, trailing spaces are removed from strings.  If
+     keyword LAST is true, the row index is the last dimension of the fields
+     instead of the first one (this is the layout of cfitsio_read_column).
+
+     Values are converted from big-endian representation and stored at their
+     final place in a single pass, so reading the table with a single call
+     to _read and decoding it with unpack_bintable is much faster than
+     reading it row by row.
+
+   SEE ALSO: fits_read_bintable, _read.
+ */
+
+extern fits_mmap;
+extern fits_mmap_get;
+extern fits_mmap_header;
+extern fits_mmap_image;
+extern fits_mmap_column;
+extern fits_mmap_advise;
+extern is_fits_mmap;
+/* DOCUMENT fm = fits_mmap(path);
+         or fm = fits_mmap(path, quiet=1);
+         or val = fits_mmap_get(fm, hdu, key);
+         or cards = fits_mmap_header(fm, hdu);
+         or arr = fits_mmap_image(fm, hdu);
+         or arr = fits_mmap_image(fm, hdu, frames);
+         or arr = fits_mmap_column(fm, hdu, col);
+         or arr = fits_mmap_column(fm, hdu, col, rows, trim=, last=);
+         or fits_mmap_advise, fm, advice;
+         or fits_mmap_advise, fm, advice, hdu, rows;
+         or is_fits_mmap(obj)
+
+     Memory-mapped access to an uncompressed FITS file.  fits_mmap maps the
+     file PATH in memory and parses the structure of its header-data units
+     (HDUs).  No data are read until requested: fits_mmap_image and
+     fits_mmap_column only convert the bytes of the selected frames or rows,
+     the other parts of the file are never touched.  The mapping lasts until
+     the object FM is destroyed.  If keyword QUIET is true, fits_mmap returns
+     nil instead of raising an error if the file cannot be mapped or is not a
+     FITS file.
+
+     HDU is the 1-based number of a header-data unit (1 for the primary one)
+     or the value of its EXTNAME keyword.  FM.path, FM.size and FM.nhdus
+     yield the name of the file, its size in bytes and its number of HDUs.
+
+     fits_mmap_get yields the value of keyword KEY in the header of HDU: a
+     string, an int for a logical value, a long or a double; or nil if the
+     keyword is missing.  Long keywords are looked for in HIERARCH cards.
+     fits_mmap_header yields the cards of the header (without END).
+
+     fits_mmap_image yields the data of an image HDU.  The frames are
+     indexed by the last dimension: FRAMES is nil (all frames), a scalar (a
+     single frame, the last dimension is dropped), an index range or a list
+     of indices.  The result type depends on BITPIX (char, short, int, long,
+     float or double); BSCALE and BZERO are not applied.
+
+     fits_mmap_column yields a column of a binary table HDU with the same
+     conventions as unpack_bintable.  COL is the column number or the value
+     of its TTYPE keyword (case insensitive).  ROWS selects the rows like
+     FRAMES for fits_mmap_image.  The result is nil for columns which cannot
+     be decoded (see unpack_bintable).
+
+     fits_mmap_advise gives a hint about the future accesses to the file, or
+     to the data of a given HDU, or to the given ROWS (frames) of an HDU.
+     ADVICE is one of "normal", "sequential" (read-ahead aggressively and
+     release pages soon after they are used), "random", "willneed"
+     (prefetch now) or "dontneed" (release the pages).
+
+   SEE ALSO: unpack_bintable, fits_read_bintable.
+ */
+
 /*---------------------------------------------------------------------------*/
 /* ACCESSING YORICK'S INTERNALS */
 
@@ -4,4 +4,8 @@ autoload, "fftw.i",
   fftw_indgen,
   fftw_dist,
   fftw_smooth,
-  fftw_convolve;
+  fftw_convolve,
+  fftw_fft, fftw_fft_inplace,
+  fftw_fft_engine, fftw_fft_forget, fftw_fft_measure,
+  fftw_override_fft,
+  fftw_wisdom, fftw_wisdom_load, fftw_wisdom_save;
@@ -76,6 +76,43 @@ func __dft2(x, i, n1, n2)
 }
 
 
+/* Compare fftw_fft with the builtin fft for various directions. */
+func fftw_fft_test(nil)
+{
+  dims = [4, 6, 16, 5, 3];
+  x = (random(dims) - 0.5) + 1i*(random(dims) - 0.5);
+  dirs = _lst([1], [-1], [0,1,0,0], [0,-1,0,0], [1,0,0,1], [1,-1,0,0],
+              [0,1,-1,1], [1,1,1,1]);
+  tolerance = 1e-13*numberof(x);
+  nfailures = 0;
+  write, format="%s\n", "  LJDIR        RJDIR    max(abs(A-B))";
+  for (pass = 1; pass <= 2; ++pass) {
+    for (l = dirs; l; l = _cdr(l)) {
+      dir = _car(l);
+      if (pass == 1) {
+        a = fft(x, dir);
+        b = fftw_fft(x, dir);
+        lj = sum(print(dir)); rj = "[]";
+      } else {
+        if (numberof(dir) == 1) continue;
+        a = fft(x, [], dir(1:2));
+        b = fftw_fft(x, [], dir(1:2));
+        lj = "[]"; rj = sum(print(dir(1:2)));
+      }
+      err = max(abs(a - b));
+      write, format="  %-11s  %-7s  %9.1e%s\n", lj, rj, err,
+        (err <= tolerance ? "" : "  FAILURE");
+      if (err > tolerance) ++nfailures;
+    }
+  }
+  y = x;
+  fftw_fft_inplace, y, [0,1,0,0];
+  if (max(abs(y - fft(x, [0,1,0,0]))) > tolerance) ++nfailures;
+  write, format="%d failure(s)\n", nfailures;
+  return nfailures;
+}
+
+
 func __fftw_time(s,t,n)
 {
   t *= 1e6/n; // convert to microseconds
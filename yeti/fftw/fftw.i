@@ -15,7 +15,8 @@
  *-----------------------------------------------------------------------------
  */
 
-/* load dynamic code */
+/* load dynamic code (the FFTW3 engine uses the thread settings of Yeti) */
+if (is_func(plug_in) && is_func(yeti_init) != 2) plug_in, "yeti";
 if (is_func(plug_in)) plug_in, "yor_fftw";
 
 extern fftw_plan;
@@ -106,6 +107,120 @@ func cfftw(x, dir) { return fftw(x, fftw_plan(dimsof(x), dir)); }
 
    SEE ALSO fftw_plan. */
 
+extern fftw_fft_engine;
+extern fftw_fft_forget;
+extern fftw_fft_measure;
+extern _fftw_fft;
+/* DOCUMENT fftw_fft(x, ljdir, rjdir)
+       -or- fftw_fft_inplace, x, ljdir, rjdir;
+       -or- fftw_fft_engine()
+       -or- fftw_fft_forget;
+       -or- fftw_fft_measure(flag)
+       -or- fftw_override_fft, flag;
+
+     The functions fftw_fft and fftw_fft_inplace are drop-in replacements
+     for the builtin fft and fft_inplace (which see) computed by FFTW
+     version 3.  Arguments LJDIR and RJDIR have the same meaning as for fft,
+     so any subset of the dimensions of X may be transformed with any
+     direction, e.g.:
+
+         fftw_fft(x, [0,1,0,0])
+
+     transforms a 4-D array X along its second dimension only.  Keyword SETUP
+     is accepted for compatibility but ignored.
+
+     The transform is computed in-place by FFTW plans (of the "guru"
+     interface) whose strides skip the non-transformed dimensions, no data is
+     copied or transposed.  Plans are kept in a cache so that transforming
+     repeatedly arrays of the same dimensions and directions only costs the
+     execution of the plans.  If the plugin has been compiled with OpenMP,
+     large transforms are split among several threads along the longest
+     non-transformed dimension (the number of threads may be set with
+     yeti_nthreads).
+
+     fftw_fft_engine() returns the FFTW3 version string, or nil if the plugin
+     was compiled without FFTW3 support.  fftw_fft_forget destroys all cached
+     plans.  fftw_fft_measure(FLAG) sets whether new plans are tuned by
+     FFTW_MEASURE (this runs a few transforms of a scratch array the first
+     time given dimensions and directions are met) rather than chosen by
+     FFTW_ESTIMATE (the default), and returns the previous setting.
+
+     fftw_override_fft, 1; replaces the global functions fft and fft_inplace
+     by fftw_fft and fftw_fft_inplace (this is a no-op if FFTW3 is not
+     available), fftw_override_fft, 0; restores the original functions.
+     Functions which call fft, like those of PNDRS, then transparently use
+     FFTW.
+
+   SEE ALSO fft, fft_inplace, fft_dirs, fftw. */
+
+func fftw_fft(x, ljdir, rjdir, setup=)
+{
+  result = complex(x);
+  fftw_fft_inplace, result, ljdir, rjdir;
+  return result;
+}
+
+func fftw_fft_inplace(x, ljdir, rjdir, setup=)
+{
+  if (structof(x) != complex) error, "expecting a complex argument";
+  ndims = dimsof(x)(1);
+  if (ndims < 1) return;
+  _fftw_fft, x, fft_dirs(ndims, ljdir, rjdir);
+}
+
+local _fftw_orig_fft, _fftw_orig_fft_inplace;
+func fftw_override_fft(flag)
+{
+  extern fft, fft_inplace, _fftw_orig_fft, _fftw_orig_fft_inplace;
+  if (flag) {
+    if (is_void(fftw_fft_engine())) return;
+    if (is_void(_fftw_orig_fft)) {
+      _fftw_orig_fft = fft;
+      _fftw_orig_fft_inplace = fft_inplace;
+    }
+    fft = fftw_fft;
+    fft_inplace = fftw_fft_inplace;
+  } else if (! is_void(_fftw_orig_fft)) {
+    fft = _fftw_orig_fft;
+    fft_inplace = _fftw_orig_fft_inplace;
+    _fftw_orig_fft = _fftw_orig_fft_inplace = [];
+  }
+}
+
+extern fftw_wisdom;
+extern fftw_wisdom_load;
+extern fftw_wisdom_save;
+/* DOCUMENT fftw_wisdom()
+       -or- fftw_wisdom, name;
+       -or- fftw_wisdom_load()
+       -or- fftw_wisdom_load(name)
+       -or- fftw_wisdom_save;
+       -or- fftw_wisdom_save, name;
+
+     The wisdom of FFTW (the knowledge gathered by the planner) is
+     persistent: it is imported from a wisdom file before the first plan is
+     created and, if some plans have been measured (keyword MEASURE of
+     fftw_plan or fftw_fft_measure), merged back into this file when Yorick
+     exits.  Measuring is thus only slow the first time given dimensions are
+     met on a machine.
+
+     fftw_wisdom() returns the name of the wisdom file, fftw_wisdom, NAME
+     sets it.  The default is given by the environment variable
+     YORICK_FFTW_WISDOM or is "~/.yorick/fftw3-wisdom-HOSTNAME" (or
+     "fftw2-wisdom-HOSTNAME" for FFTW2).  The FFTW3 wisdom file is shared with
+     the YNFFT plugin.  Concurrent processes (e.g. batch jobs) safely update
+     the same file: accesses are serialized by a lock on the file NAME.lock
+     and the wisdom of all processes is merged.
+
+     fftw_wisdom_load imports the wisdom file (or NAME) now and returns
+     whether it exists.  fftw_wisdom_save saves the wisdom now.
+
+     Plans created by fftw_plan are also kept in a registry so that calling
+     fftw_plan again with the same dimensions, direction and options returns
+     the same plan without planning.
+
+   SEE ALSO fftw_plan, fftw_fft. */
+
 func fftw_indgen(dim) { return (u= indgen(0:dim-1)) - dim*(u > dim/2); }
 /* DOCUMENT fftw_indgen(len)
      Return FFT frequencies along a dimension of length LEN.
@@ -54,6 +54,13 @@ static int get_boolean(Symbol* s);
 static void FreePlan(void* addr);
 static void PrintPlan(Operand* op);
 
+/* Persistent wisdom (see ywisdom.c). */
+extern void yfftw_wisdom_init(void);
+extern void yfftw_wisdom_update(void);
+
+/* Number of plans kept in the registry. */
+#define REGISTRY_SIZE 32
+
 /*---------------------------------------------------------------------------*/
 /* FFTW plan opaque object */
 
@@ -112,6 +119,61 @@ static void FreePlan(void* addr)
   }
 }
 
+/*---------------------------------------------------------------------------*/
+/* Registry of plans.  Plans are immutable once created, the same plan
+   object can therefore be returned by fftw_plan for identical settings.  The
+   registry holds a reference on its plans, the least recently used one is
+   dropped when the registry is full. */
+
+static y_fftw_plan_t* registry[REGISTRY_SIZE];
+static unsigned long registry_stamp[REGISTRY_SIZE];
+static unsigned long last_stamp = 0;
+
+static y_fftw_plan_t* find_plan(int rank, const int* dims, int dir,
+                                int real, int flags)
+{
+  int i, k;
+  for (i = 0; i < REGISTRY_SIZE; ++i) {
+    y_fftw_plan_t* p = registry[i];
+    if (p != NULL && p->rank == rank && p->dir == dir && p->real == real &&
+        p->flags == flags) {
+      for (k = 0; k < (rank > 1 ? rank : 1); ++k) {
+        if (p->dims[k] != dims[k]) break;
+      }
+      if (k == (rank > 1 ? rank : 1)) {
+        registry_stamp[i] = ++last_stamp;
+        return p;
+      }
+    }
+  }
+  return NULL;
+}
+
+static void register_plan(y_fftw_plan_t* p)
+{
+  int i, j = 0;
+  for (i = 0; i < REGISTRY_SIZE; ++i) {
+    if (registry[i] == NULL) {
+      j = i;
+      break;
+    }
+    if (registry_stamp[i] < registry_stamp[j]) j = i;
+  }
+  if (registry[j] != NULL) Unref(registry[j]);
+  registry[j] = Ref(p);
+  registry_stamp[j] = ++last_stamp;
+}
+
+int yfftw_import_wisdom(FILE* file)
+{
+  return (fftw_import_wisdom_from_file(file) == FFTW_SUCCESS);
+}
+
+void yfftw_export_wisdom(FILE* file)
+{
+  fftw_export_wisdom_to_file(file);
+}
+
 static void PrintPlan(Operand* op)
 {
   y_fftw_plan_t* p = (y_fftw_plan_t*)op->value;
@@ -249,9 +311,25 @@ void Y_fftw_plan(int argc)
     YError("too few arguments in fftw_plan");
   }
 
+  /* Return the registered plan if any (dimensions in row-major order). */
+  int flags = (FFTW_USE_WISDOM | (measure ? FFTW_MEASURE : FFTW_ESTIMATE) |
+               ((real && dir == FFTW_COMPLEX_TO_REAL) ?
+                FFTW_OUT_OF_PLACE : FFTW_IN_PLACE));
+  int rdims[rank > 1 ? rank : 1];
+  rdims[0] = 0;
+  if (len == 0) {
+    rdims[0] = number;
+  } else {
+    for (long i = 1; i < len; ++i) rdims[len - 1 - i] = dimlist[i];
+  }
+  y_fftw_plan_t* p = find_plan(rank, rdims, dir, real, flags);
+  if (p != NULL) {
+    PushDataBlock(Ref(p));
+    return;
+  }
+
   /* Allocate new plan (with at least one slot for dims member) and push
      it on top of the stack. */
-  y_fftw_plan_t* p;
   size_t size = (OFFSET_OF(y_fftw_plan_t, dims)
                  + (rank > 1 ? rank : 1)*sizeof(*p->dims));
   p = p_malloc(size);
@@ -259,23 +337,16 @@ void Y_fftw_plan(int argc)
   p->ops = &fftwPlanOps;
   PushDataBlock(p); /* _AFTER_ having set OPS */
   p->dir = dir;
-  p->flags = ((measure ? FFTW_MEASURE : FFTW_ESTIMATE) |
-              ((real && dir == FFTW_COMPLEX_TO_REAL) ?
-               FFTW_OUT_OF_PLACE : FFTW_IN_PLACE));
+  p->flags = flags;
   p->real = real;
   p->rank = rank;
-
-  /* Store list of dimensions for this plan in row-major order. */
-  if (len == 0) {
-    p->dims[0] = number;
-  } else {
-    long i = 0;
-    while (--len >= 1) p->dims[i++] = dimlist[len];
-  }
+  memcpy(p->dims, rdims, (rank > 1 ? rank : 1)*sizeof(*p->dims));
 
   /* Create plan (noting to do for rank=0, because FFT of a scalar is a
      no-op). */
   if (rank >= 1) {
+    yfftw_wisdom_init();
+    if (measure) yfftw_wisdom_update();
     if (real) {
       /* Always use n-D plan for real FFT (because storage of complex
          values in 1-D RFFTW is not very useful in a language like
@@ -291,6 +362,7 @@ void Y_fftw_plan(int argc)
     }
     if (! p->plan) YError("failed to create FFTW plan");
   }
+  register_plan(p);
 #ifdef DEBUG
   for (int i = 0; i < p->rank; ++i) {
     printf("dims[%d]=%d\n", i, p->dims[i]);
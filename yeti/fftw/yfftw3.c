@@ -0,0 +1,357 @@
+/*
+ * yfftw3.c -
+ *
+ * FFTW (version 3) engine for Yorick's fft and fft_inplace.  Complex
+ * transforms along any subset of dimensions are computed in-place with plans
+ * of the FFTW guru interface which are cached and may be executed by several
+ * threads.
+ *
+ *-----------------------------------------------------------------------------
+ *
+ * This file is part of Yeti (https://github.com/emmt/Yeti) released under the
+ * MIT "Expat" license.
+ *
+ * Copyright (C) 1996-2020: Éric Thiébaut.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include "pstdlib.h"
+#include "yapi.h"
+
+/* BUILT-IN ROUTINES */
+extern void Y__fftw_fft(int argc);
+extern void Y_fftw_fft_engine(int argc);
+extern void Y_fftw_fft_forget(int argc);
+extern void Y_fftw_fft_measure(int argc);
+
+/* Persistent wisdom (see ywisdom.c). */
+extern void yfftw_wisdom_init(void);
+extern void yfftw_wisdom_update(void);
+
+/* Number of threads for a given amount of work (provided by Yeti, see
+   yeti.h and yeti_nthreads). */
+extern int yor_nthreads(size_t work);
+
+#ifndef HAVE_FFTW3
+# define HAVE_FFTW3 0
+#endif
+
+#if HAVE_FFTW3
+/*---------------------------------------------------------------------------*/
+
+#include <fftw3.h>
+
+/* Number of plans kept in the cache. */
+#define CACHE_SIZE 32
+
+/* Alignment (in bytes) which suits the SIMD code of FFTW whatever the
+   instruction set (up to AVX-512).  A plan can only be executed on arrays
+   whose alignment class (see fftw_alignment_of) is the same as the one of
+   the array used for planning, arrays which are not aligned on this
+   boundary are therefore planned with FFTW_UNALIGNED. */
+#define ALIGNMENT 64
+
+/* IMPLEMENTATION NOTES:
+ *
+ *  . Yorick arrays are stored in column-major order, dimension K has stride
+ *    (in complex elements) equal to the product of the lengths of the
+ *    dimensions before K.  The transformed dimensions of a given sign are the
+ *    rank of a guru plan, all other dimensions (of length > 1) make its
+ *    "howmany" loops.  Adjacent loop dimensions which are contiguous in memory
+ *    are merged.
+ *
+ *  . When both signs appear in the list of directions, the transform is
+ *    applied in two passes (one per sign) since separable DFT's along
+ *    different dimensions commute.
+ *
+ *  . The longest non-transformed dimension may be excluded from the guru
+ *    loops and iterated explicitly in parallel with fftw_execute_dft which is
+ *    the only thread-safe routine of FFTW.  Planning is always done by the
+ *    main thread.
+ *
+ *  . Plans are created with FFTW_ESTIMATE (the array is not overwritten), or
+ *    with FFTW_MEASURE on a scratch array of the same size if requested by
+ *    fftw_fft_measure, and cached with a key made of the dimensions, the
+ *    directions, the planner flags, the split dimension and whether the array
+ *    (and, when split, each of its parts) is aligned.  The least recently used plan is destroyed when the cache is
+ *    full.  Measured plans are cheap to recreate in other processes thanks to
+ *    the persistent wisdom (see ywisdom.c).
+ */
+
+typedef struct plan_key plan_key_t;
+struct plan_key {
+  int      rank; /* number of dimensions */
+  int     split; /* index of dimension iterated by threads, -1 if none */
+  int   aligned; /* array (and split parts) aligned on ALIGNMENT bytes? */
+  int   measure; /* plan tuned by FFTW_MEASURE? */
+  long dims[Y_DIMSIZE]; /* dimensions */
+  int  dirs[Y_DIMSIZE]; /* directions (-1, 0 or +1) */
+};
+
+typedef struct plan_entry plan_entry_t;
+struct plan_entry {
+  plan_key_t     key;
+  unsigned long stamp; /* time of last use, 0 if entry is free */
+  fftw_plan  plan[2]; /* plans for dir=+1 and dir=-1 (NULL if none) */
+};
+
+static plan_entry_t cache[CACHE_SIZE];
+static unsigned long last_stamp = 0;
+static int measure = 0;
+
+static void forget_plans(void)
+{
+  int i, j;
+  for (i = 0; i < CACHE_SIZE; ++i) {
+    for (j = 0; j < 2; ++j) {
+      if (cache[i].plan[j] != NULL) {
+        fftw_destroy_plan(cache[i].plan[j]);
+        cache[i].plan[j] = NULL;
+      }
+    }
+    cache[i].stamp = 0;
+  }
+}
+
+static int same_key(const plan_key_t* a, const plan_key_t* b)
+{
+  int k;
+  if (a->rank != b->rank || a->split != b->split ||
+      a->aligned != b->aligned || a->measure != b->measure) {
+    return 0;
+  }
+  for (k = 0; k < a->rank; ++k) {
+    if (a->dims[k] != b->dims[k] || a->dirs[k] != b->dirs[k]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static int to_int(long value)
+{
+  if (value > INT_MAX) y_error("array too large for FFTW");
+  return (int)value;
+}
+
+/* Create guru plan for transforming with SIGN (+1 or -1) the dimensions
+   whose direction is SIGN. */
+static fftw_plan make_plan(const plan_key_t* key, int sign, fftw_complex* x)
+{
+  fftw_iodim dims[Y_DIMSIZE], loops[Y_DIMSIZE];
+  long stride[Y_DIMSIZE];
+  int k, rank, nloops, prev;
+  unsigned flags;
+
+  stride[0] = 1;
+  for (k = 1; k < key->rank; ++k) {
+    stride[k] = stride[k-1]*key->dims[k-1];
+  }
+
+  /* Transformed dimensions, from slowest to fastest varying. */
+  rank = 0;
+  for (k = key->rank - 1; k >= 0; --k) {
+    if (key->dirs[k] == sign && key->dims[k] > 1) {
+      dims[rank].n = to_int(key->dims[k]);
+      dims[rank].is = dims[rank].os = to_int(stride[k]);
+      ++rank;
+    }
+  }
+  if (rank == 0) {
+    return NULL;
+  }
+
+  /* Loop dimensions, merging contiguous ones. */
+  nloops = 0;
+  prev = -2;
+  for (k = 0; k < key->rank; ++k) {
+    if (key->dirs[k] != sign && key->dims[k] > 1 && k != key->split) {
+      if (prev == k - 1) {
+        loops[nloops-1].n = to_int(loops[nloops-1].n*key->dims[k]);
+      } else {
+        loops[nloops].n = to_int(key->dims[k]);
+        loops[nloops].is = loops[nloops].os = to_int(stride[k]);
+        ++nloops;
+      }
+      prev = k;
+    }
+  }
+
+  flags = (key->measure ? FFTW_MEASURE : FFTW_ESTIMATE);
+  if (! key->aligned) flags |= FFTW_UNALIGNED;
+  return fftw_plan_guru_dft(rank, dims, nloops, loops, x, x,
+                            (sign > 0 ? FFTW_FORWARD : FFTW_BACKWARD),
+                            flags);
+}
+
+static plan_entry_t* get_plans(const plan_key_t* key, fftw_complex* x,
+                               long ntot)
+{
+  plan_entry_t* entry;
+  fftw_complex* tmp;
+  int i, j, failed;
+
+  ++last_stamp;
+  entry = NULL;
+  for (i = 0; i < CACHE_SIZE; ++i) {
+    if (cache[i].stamp != 0 && same_key(&cache[i].key, key)) {
+      cache[i].stamp = last_stamp;
+      return &cache[i];
+    }
+    if (entry == NULL || cache[i].stamp < entry->stamp) {
+      entry = &cache[i];
+    }
+  }
+
+  /* Recycle least recently used entry. */
+  for (j = 0; j < 2; ++j) {
+    if (entry->plan[j] != NULL) {
+      fftw_destroy_plan(entry->plan[j]);
+      entry->plan[j] = NULL;
+    }
+  }
+  entry->stamp = 0;
+  entry->key = *key;
+  yfftw_wisdom_init();
+  if (key->measure) {
+    yfftw_wisdom_update();
+    /* Measuring overwrites the array, use a scratch one. */
+    tmp = (fftw_complex*)fftw_malloc(ntot*sizeof(fftw_complex));
+    if (tmp == NULL) y_error("insufficient memory for FFTW planning");
+  } else {
+    tmp = x;
+  }
+  failed = 0;
+  for (j = 0; j < 2; ++j) {
+    int sign = (j == 0 ? +1 : -1);
+    for (i = 0; i < key->rank; ++i) {
+      if (key->dirs[i] == sign && key->dims[i] > 1) {
+        entry->plan[j] = make_plan(key, sign, tmp);
+        if (entry->plan[j] == NULL) failed = 1;
+        break;
+      }
+    }
+  }
+  if (tmp != x) fftw_free(tmp);
+  if (failed) y_error("failed to create FFTW plan");
+  entry->stamp = last_stamp;
+  return entry;
+}
+
+void Y__fftw_fft(int argc)
+{
+  plan_key_t key;
+  plan_entry_t* entry;
+  fftw_complex* x;
+  long dims[Y_DIMSIZE], ntot, ndirs, *dirs, count, stride;
+  int j, k, nthreads;
+
+  if (argc != 2) y_error("_fftw_fft takes exactly 2 arguments");
+  if (yarg_typeid(1) != Y_COMPLEX) y_error("expecting a complex array");
+  x = (fftw_complex*)ygeta_z(1, &ntot, dims);
+  dirs = ygeta_l(0, &ndirs, NULL);
+  if (ndirs != dims[0]) y_error("bad number of directions");
+
+  /* Build the key. */
+  memset(&key, 0, sizeof(key));
+  key.rank = (int)dims[0];
+  key.split = -1;
+  key.measure = measure;
+  for (k = 0; k < key.rank; ++k) {
+    key.dims[k] = dims[k+1];
+    if (dirs[k] > 0) key.dirs[k] = +1;
+    else if (dirs[k] < 0) key.dirs[k] = -1;
+  }
+
+  /* Choose the dimension to split among threads. */
+  nthreads = yor_nthreads(ntot);
+  if (nthreads > 1) {
+    for (k = 0; k < key.rank; ++k) {
+      if (key.dirs[k] == 0 && key.dims[k] > 1 &&
+          (key.split < 0 || key.dims[k] >= key.dims[key.split])) {
+        key.split = k;
+      }
+    }
+    if (key.split >= 0 && nthreads > key.dims[key.split]) {
+      nthreads = (int)key.dims[key.split];
+    }
+  }
+  if (key.split < 0) nthreads = 1;
+
+  /* The parts of a split array are executed by the plan made for the first
+     one, they must all have the same alignment. */
+  stride = 1;
+  for (k = 0; k < key.split; ++k) stride *= key.dims[k];
+  key.aligned = ((((size_t)x) % ALIGNMENT) == 0 &&
+                 (key.split < 0 ||
+                  ((stride*sizeof(fftw_complex)) % ALIGNMENT) == 0));
+
+  entry = get_plans(&key, x, ntot);
+  if (key.split < 0) {
+    for (j = 0; j < 2; ++j) {
+      if (entry->plan[j] != NULL) fftw_execute_dft(entry->plan[j], x, x);
+    }
+  } else {
+    count = key.dims[key.split];
+    for (j = 0; j < 2; ++j) {
+      fftw_plan plan = entry->plan[j];
+      long i;
+      if (plan == NULL) continue;
+#ifdef _OPENMP
+#     pragma omp parallel for num_threads(nthreads) schedule(static)
+#endif
+      for (i = 0; i < count; ++i) {
+        fftw_execute_dft(plan, x + i*stride, x + i*stride);
+      }
+    }
+  }
+  ypush_nil();
+}
+
+void Y_fftw_fft_engine(int argc)
+{
+  ystring_t* str = ypush_q(0);
+  str[0] = p_strcpy(fftw_version);
+}
+
+void Y_fftw_fft_forget(int argc)
+{
+  forget_plans();
+  ypush_nil();
+}
+
+void Y_fftw_fft_measure(int argc)
+{
+  int old = measure;
+  if (argc > 1) y_error("fftw_fft_measure takes at most one argument");
+  if (argc == 1 && ! yarg_nil(0)) {
+    measure = (yarg_true(0) ? 1 : 0);
+  }
+  ypush_int(old);
+}
+
+int yfftw_import_wisdom(FILE* file)
+{
+  return fftw_import_wisdom_from_file(file);
+}
+
+void yfftw_export_wisdom(FILE* file)
+{
+  fftw_export_wisdom_to_file(file);
+}
+
+/*---------------------------------------------------------------------------*/
+#else /* not HAVE_FFTW3 */
+
+static char* no_fftw3_support = "no FFTW3 support in this version of Yorick";
+
+void Y__fftw_fft(int argc) { y_error(no_fftw3_support); }
+void Y_fftw_fft_engine(int argc) { ypush_nil(); }
+void Y_fftw_fft_forget(int argc) { ypush_nil(); }
+void Y_fftw_fft_measure(int argc) { ypush_int(0); }
+
+#endif /* not HAVE_FFTW3 */
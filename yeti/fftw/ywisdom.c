@@ -0,0 +1,105 @@
+/*
+ * ywisdom.c -
+ *
+ * Persistent FFTW wisdom for the FFTW plugin (the implementation, shared
+ * with YNFFT, is in ywisdom.h).
+ *
+ *-----------------------------------------------------------------------------
+ *
+ * This file is part of Yeti (https://github.com/emmt/Yeti) released under the
+ * MIT "Expat" license.
+ *
+ * Copyright (C) 1996-2020: Éric Thiébaut.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include "pstdlib.h"
+#include "yapi.h"
+
+/* BUILT-IN ROUTINES */
+extern void Y_fftw_wisdom(int argc);
+extern void Y_fftw_wisdom_load(int argc);
+extern void Y_fftw_wisdom_save(int argc);
+
+/* Routines for the FFTW engines (yfftw.c and yfftw3.c). */
+extern void yfftw_wisdom_init(void);
+extern void yfftw_wisdom_update(void);
+
+#ifndef HAVE_FFTW
+# define HAVE_FFTW 0
+#endif
+#ifndef HAVE_FFTW3
+# define HAVE_FFTW3 0
+#endif
+
+#if HAVE_FFTW || HAVE_FFTW3
+/*---------------------------------------------------------------------------*/
+
+/* Import/export wisdom of the FFTW library linked with the plugin (defined
+   in yfftw.c for FFTW2 and in yfftw3.c for FFTW3). */
+extern int  yfftw_import_wisdom(FILE* file);
+extern void yfftw_export_wisdom(FILE* file);
+
+#if HAVE_FFTW3
+# define WISDOM_NAME "fftw3-wisdom"
+#else
+# define WISDOM_NAME "fftw2-wisdom"
+#endif
+#define WISDOM_IMPORT(file) yfftw_import_wisdom(file)
+#define WISDOM_EXPORT(file) yfftw_export_wisdom(file)
+#include "ywisdom.h"
+
+void yfftw_wisdom_init(void)
+{
+  init_wisdom();
+}
+
+void yfftw_wisdom_update(void)
+{
+  update_wisdom();
+}
+
+void Y_fftw_wisdom(int argc)
+{
+  if (argc > 1) y_error("fftw_wisdom takes at most one argument");
+  if (argc == 1 && ! yarg_nil(0)) {
+    set_wisdom_file(ygets_q(0));
+  }
+  *ypush_q(0) = p_strcpy(get_wisdom_file());
+}
+
+void Y_fftw_wisdom_load(int argc)
+{
+  int status;
+  if (argc > 1) y_error("fftw_wisdom_load takes at most one argument");
+  status = load_wisdom((argc == 1 && ! yarg_nil(0)) ? ygets_q(0)
+                       : get_wisdom_file());
+  if (status < 0) y_error("failed to import FFTW wisdom");
+  wisdom_loaded = 1;
+  ypush_int(status == 0);
+}
+
+void Y_fftw_wisdom_save(int argc)
+{
+  if (argc > 1) y_error("fftw_wisdom_save takes at most one argument");
+  if (save_wisdom((argc == 1 && ! yarg_nil(0)) ? ygets_q(0)
+                  : get_wisdom_file()) != 0) {
+    y_error("failed to export FFTW wisdom");
+  }
+  ypush_nil();
+}
+
+/*---------------------------------------------------------------------------*/
+#else /* not HAVE_FFTW and not HAVE_FFTW3 */
+
+static char* no_fftw_support = "no FFTW support in this version of Yorick";
+
+void yfftw_wisdom_init(void) {}
+void yfftw_wisdom_update(void) {}
+void Y_fftw_wisdom(int argc) { ypush_nil(); }
+void Y_fftw_wisdom_load(int argc) { y_error(no_fftw_support); }
+void Y_fftw_wisdom_save(int argc) { y_error(no_fftw_support); }
+
+#endif /* not HAVE_FFTW and not HAVE_FFTW3 */
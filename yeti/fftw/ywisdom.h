@@ -0,0 +1,218 @@
+/*
+ * ywisdom.h -
+ *
+ * Persistent FFTW wisdom.  The wisdom accumulated by the FFTW planner is
+ * imported from a file before the first plan is created and merged back into
+ * this file when Yorick exits, so that expensive planning (FFTW_MEASURE or
+ * better) is only paid once per machine.
+ *
+ * This file is included by the FFTW plugin of Yeti (ywisdom.c) and by YNFFT
+ * (yor_nfft.c) which thus share the same wisdom file.  All the code is
+ * private to the including file which must first include "pstdlib.h" (which
+ * has no include guard) and define:
+ *
+ *   WISDOM_NAME          - default base name of the wisdom file (a string);
+ *   WISDOM_IMPORT(file)  - import the wisdom from FILE, non-zero on success;
+ *   WISDOM_EXPORT(file)  - export the wisdom to FILE.
+ *
+ *-----------------------------------------------------------------------------
+ *
+ * This file is part of Yeti (https://github.com/emmt/Yeti) released under the
+ * MIT "Expat" license.
+ *
+ * Copyright (C) 1996-2020: Éric Thiébaut.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#ifndef _YWISDOM_H
+#define _YWISDOM_H 1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#if !defined(WISDOM_NAME) || !defined(WISDOM_IMPORT) || !defined(WISDOM_EXPORT)
+# error WISDOM_NAME, WISDOM_IMPORT and WISDOM_EXPORT must be defined
+#endif
+
+/* Environment variable with the name of the wisdom file.  The default is
+   "$HOME/.yorick/" WISDOM_NAME "-$HOSTNAME" so that machines sharing the
+   same home directory do not share their wisdom. */
+#define WISDOM_ENV "YORICK_FFTW_WISDOM"
+
+/* IMPLEMENTATION NOTES:
+ *
+ *  . Concurrent processes (e.g. batch jobs) serialize their accesses to the
+ *    wisdom file with a POSIX record lock on a companion file whose name is
+ *    that of the wisdom file with ".lock" appended.  Readers take a shared
+ *    lock, writers an exclusive one.
+ *
+ *  . Saving first imports the wisdom file (while holding the exclusive lock)
+ *    so that the wisdom of other processes is merged, then writes a
+ *    temporary file which is atomically renamed as the wisdom file.  The
+ *    wisdom file is thus always complete.
+ *
+ *  . The wisdom is only saved at exit if some planning may have produced
+ *    new wisdom (see update_wisdom).
+ */
+
+static char* wisdom_file = NULL; /* name of wisdom file */
+static int wisdom_loaded = 0; /* wisdom has been imported? */
+static int wisdom_modified = 0; /* wisdom may have been modified since saved? */
+static int wisdom_registered = 0; /* exit handler registered? */
+
+static const char* get_wisdom_file(void)
+{
+  if (wisdom_file == NULL) {
+    const char* env = getenv(WISDOM_ENV);
+    if (env != NULL && env[0] != '\0') {
+      wisdom_file = p_strcpy(env);
+    } else {
+      const char* home = getenv("HOME");
+      char host[256];
+      if (home == NULL || home[0] == '\0') home = ".";
+      if (gethostname(host, sizeof(host)) != 0) host[0] = '\0';
+      host[sizeof(host) - 1] = '\0';
+      wisdom_file = p_strncat(home, "/.yorick/" WISDOM_NAME, 0);
+      if (host[0] != '\0') {
+        char* str = p_strncat(wisdom_file, "-", 0);
+        p_free(wisdom_file);
+        wisdom_file = p_strncat(str, host, 0);
+        p_free(str);
+      }
+    }
+  }
+  return wisdom_file;
+}
+
+/* Change the name of the wisdom file, the new file will be imported before
+   the next plan is created. */
+static void set_wisdom_file(const char* name)
+{
+  char* str = p_strcpy(name);
+  if (wisdom_file != NULL) p_free(wisdom_file);
+  wisdom_file = str;
+  wisdom_loaded = 0;
+}
+
+/* Open the lock file associated with wisdom file NAME and lock it.  Returns
+   the file descriptor or -1 on error. */
+static int lock_wisdom(const char* name, int exclusive)
+{
+  struct flock lock;
+  char* lockname = p_strncat(name, ".lock", 0);
+  int fd = open(lockname, O_RDWR|O_CREAT, 0666);
+  p_free(lockname);
+  if (fd < 0) return -1;
+  memset(&lock, 0, sizeof(lock));
+  lock.l_type = (exclusive ? F_WRLCK : F_RDLCK);
+  lock.l_whence = SEEK_SET;
+  lock.l_start = 0;
+  lock.l_len = 0;
+  while (fcntl(fd, F_SETLKW, &lock) == -1) {
+    if (errno != EINTR) {
+      close(fd);
+      return -1;
+    }
+  }
+  return fd;
+}
+
+static void unlock_wisdom(int fd)
+{
+  if (fd >= 0) close(fd); /* closing releases the lock */
+}
+
+/* Create the directory part of NAME if needed (only one level). */
+static void make_parent_dir(const char* name)
+{
+  const char* slash = strrchr(name, '/');
+  if (slash != NULL && slash != name) {
+    char* dir = p_strncat(NULL, name, slash - name);
+    mkdir(dir, 0777);
+    p_free(dir);
+  }
+}
+
+/* Import wisdom from file NAME, returns 0 on success, 1 if the file does not
+   exist, -1 on error. */
+static int load_wisdom(const char* name)
+{
+  FILE* file;
+  int fd, status;
+  fd = lock_wisdom(name, 0);
+  file = fopen(name, "r");
+  if (file == NULL) {
+    status = (errno == ENOENT ? 1 : -1);
+  } else {
+    status = (WISDOM_IMPORT(file) ? 0 : -1);
+    fclose(file);
+  }
+  unlock_wisdom(fd);
+  return status;
+}
+
+/* Merge wisdom into file NAME, returns 0 on success, -1 on error. */
+static int save_wisdom(const char* name)
+{
+  FILE* file;
+  char suffix[32];
+  char* tmpname;
+  int fd, status;
+
+  make_parent_dir(name);
+  fd = lock_wisdom(name, 1);
+  if (fd < 0) return -1;
+  file = fopen(name, "r");
+  if (file != NULL) {
+    (void)WISDOM_IMPORT(file);
+    fclose(file);
+  }
+  sprintf(suffix, ".%ld.tmp", (long)getpid());
+  tmpname = p_strncat(name, suffix, 0);
+  status = -1;
+  file = fopen(tmpname, "w");
+  if (file != NULL) {
+    WISDOM_EXPORT(file);
+    if (fclose(file) == 0 && rename(tmpname, name) == 0) {
+      status = 0;
+    }
+  }
+  if (status != 0) remove(tmpname);
+  p_free(tmpname);
+  unlock_wisdom(fd);
+  if (status == 0) wisdom_modified = 0;
+  return status;
+}
+
+static void save_wisdom_at_exit(void)
+{
+  if (wisdom_modified) (void)save_wisdom(get_wisdom_file());
+}
+
+/* To be called before creating a plan. */
+static void init_wisdom(void)
+{
+  if (! wisdom_loaded) {
+    wisdom_loaded = 1;
+    (void)load_wisdom(get_wisdom_file());
+  }
+}
+
+/* To be called before creating a plan which may produce new wisdom (i.e.
+   with FFTW_MEASURE or better). */
+static void update_wisdom(void)
+{
+  wisdom_modified = 1;
+  if (! wisdom_registered) {
+    wisdom_registered = 1;
+    atexit(save_wisdom_at_exit);
+  }
+}
+
+#endif /* _YWISDOM_H */
@@ -1 +1,2 @@
-autoload, "nfft.i", nfft_version, nfft_new, nfft_indgen, nfft_mira3d_new;
+autoload, "nfft.i", nfft_version, nfft_new, nfft_indgen, nfft_mira3d_new,
+  nfft_wisdom, nfft_wisdom_save;
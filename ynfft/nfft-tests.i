@@ -134,6 +134,44 @@ func nfft_test
   a22 = nfft_full_matrix(f2, 2);
   if (anyof(a22 != a2)) error, "matrix coefficients have changed";
 
+  // Real input and real-valued adjoint.
+  x = random(n1);
+  if (anyof(f(x) != f(complex(x)))) error, "real input not properly converted";
+  if (anyof(f(float(x)) != f(complex(float(x))))) {
+    error, "float input not properly converted";
+  }
+  c = char(indgen(0:n1-1)*(255/(n1 - 1)));
+  if (max(c) <= 127) error, "char test needs values above 127";
+  if (anyof(f(c) != f(complex(c)))) error, "char input not properly converted";
+  y = f(x);
+  if (anyof(f(y, 2) != double(f(y, 1)))) error, "bad real-valued adjoint";
+  if (structof(f(y, 2)) != double) error, "adjoint should be real";
+
+  // Stack of arguments.
+  xs = random(n1, 3);
+  ys = f(xs);
+  if (anyof(dimsof(ys) != [2, num_nodes, 3])) error, "bad stacked dimensions";
+  for (k = 1; k <= 3; ++k) {
+    if (anyof(ys(,k) != f(xs(,k)))) error, "bad stacked transform";
+    if (anyof(f(ys, 1)(,k) != f(ys(,k), 1))) error, "bad stacked adjoint";
+    if (anyof(f(ys, 2)(,k) != f(ys(,k), 2))) error, "bad stacked adjoint";
+  }
+  // The workspaces of G have their own FFTW plans, the results may differ
+  // from those of F by rounding errors.
+  g = nfft_new(n1, u1*PIXSCALE, nthreads=2);
+  if (g.nthreads != 2 || dimsof(xs)(0) < 2) error, "stack not threaded";
+  z = f(ys, 1);
+  r = f(ys, 2);
+  if (max(abs(g(xs) - ys)) > 1e-12*max(abs(ys)) ||
+      max(abs(g(ys, 1) - z)) > 1e-12*max(abs(z)) ||
+      max(abs(g(ys, 2) - r)) > 1e-12*max(abs(r))) {
+    error, "bad multi-threaded stack";
+  }
+  if (g.nworkspaces != 2) {
+    write, format="WARNING - %s\n",
+      "stacks not transformed in parallel (plugin compiled without OpenMP)";
+  }
+
   // 2-D test
   f = nfft_new(n1, u1*PIXSCALE, n2, u2*PIXSCALE);
   a0 = nfft_full_matrix(f, 0);
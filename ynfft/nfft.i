@@ -44,6 +44,29 @@ extern nfft_version;
      Returns the version of NFFT plug-in as a string.
    SEE ALSO: nfft_new.
  */
+extern nfft_wisdom;
+extern nfft_wisdom_save;
+/* DOCUMENT nfft_wisdom();
+         or nfft_wisdom, name;
+         or nfft_wisdom_save;
+         or nfft_wisdom_save, name;
+
+     The wisdom of FFTW is persistent: it is imported from a file before the
+     first NFFT operator is created and, if some FFTW plans have been
+     measured (see NFFT_MEASURE), merged back into this file when Yorick
+     exits.  Creating operators with NFFT_MEASURE is thus only slow the first
+     time given dimensions are met on a machine.
+
+     nfft_wisdom() returns the name of the wisdom file, nfft_wisdom, NAME
+     sets it.  The default is given by the environment variable
+     YORICK_FFTW_WISDOM or is "~/.yorick/fftw3-wisdom-HOSTNAME".  This file is
+     shared with the FFTW3 engine of Yeti (see fftw_wisdom) and concurrent
+     processes can safely update it.  nfft_wisdom_save saves the wisdom now
+     (in the wisdom file or in NAME).
+
+   SEE ALSO: nfft_new.
+ */
+
 local NFFT_PRE_PHI_HUT, NFFT_FG_PSI, NFFT_PRE_LIN_PSI, NFFT_PRE_FG_PSI;
 local NFFT_PRE_PSI, NFFT_PRE_FULL_PSI, NFFT_SORT_NODES;
 local NFFT_ESTIMATE, NFFT_MEASURE, NFFT_PATIENT, NFFT_EXHAUSTIVE;
@@ -100,6 +123,32 @@ extern nfft_new;
 
        a = op(b, 1)
 
+     The input of the operator may be any numerical array (e.g. a real image
+     for the direct transform), it is directly converted into the workspace
+     of the operator without temporary copies.  When the input of the direct
+     transform is known to be real, the adjoint of the real part of the
+     direct transform is obtained by:
+
+       a = op(b, 2)
+
+     which is the same as double(op(b, 1)) but without building the complex
+     result.
+
+     A stack of arguments can be transformed in a single call by adding a
+     trailing dimension to the argument: if A is a stack of K arrays of
+     dimensions DIMS (i.e. A has dimensions [D+1, N1, ..., ND, K]), then
+     op(A) yields an M-by-K complex array whose columns are the transforms
+     of the arrays in A.  Conversely, if B is an M-by-K array, op(B, 1) and
+     op(B, 2) yield stacks of K arrays of dimensions DIMS.  All the
+     transforms share the precomputed tables of the operator.  If the
+     operator has been created with NTHREADS > 1 and the plugin has been
+     compiled with OpenMP, the stack is split between min(K, NTHREADS)
+     threads, each with its own workspace (arrays and oversampled buffers
+     with single-threaded FFTW plans); these workspaces are created at the
+     first such call and kept with the operator.  Otherwise the transforms
+     of the stack are done one after the other, each using NTHREADS
+     threads within FFTW (see keyword NTHREADS below).
+
      The 1-D transform is:
 
        b(j) = sum_{k1=1}^{n1} a(k1)*exp(-2i*pi*(k1 - 1 - n1/2)*x(j));
@@ -118,6 +167,9 @@ extern nfft_new;
        op.fftw_flags   = flags for FFTW (for debug only);
        op.cutoff       = size of window;
        op.nevals       = number of evaluations;
+       op.nthreads     = number of threads (see keyword NTHREADS);
+       op.nworkspaces  = number of workspaces for the stacks transformed in
+                         parallel (0 if none has been so far);
 
      The operator is approximated by:
 
@@ -212,6 +264,11 @@ extern nfft_new;
 
        (NFFT_PRE_PHI_HUT | NFFT_PRE_PSI | NFFT_ESTIMATE | (RANK > 1 ? NFFT_SORT_NODES : 0))
 
+     Keyword NTHREADS specifies the number of threads used by FFTW (and by
+     NFFT if it has been built with threads support) for a single transform,
+     and the maximum number of threads sharing a stack of arguments.  The
+     default is 1.
+
 
    SEE ALSO: xfft, mvmult.
  */
@@ -191,6 +191,7 @@ static long fftw_flags_index = -1L;
 static long nfft_flags_index = -1L;
 static long complex_meas_index = -1L;
 static long nthreads_index = -1L;
+static long nworkspaces_index = -1L;
 
 /* Default value for cutoff number (negative means not yet determined). */
 static long default_cutoff = -1;
@@ -236,6 +237,7 @@ static void initialize(void)
     SET_INDEX(nfft_flags);
     SET_INDEX(complex_meas);
     SET_INDEX(nthreads);
+    SET_INDEX(nworkspaces);
     SET_INDEX(fftw_flags);
 #undef SET_INDEX
     {
@@ -252,6 +254,30 @@ static void initialize(void)
   }
 }
 
+/*---------------------------------------------------------------------------*/
+/* PERSISTENT FFTW WISDOM */
+
+/* The wisdom of FFTW is imported from a file before the first plan is
+ * created and, if some plans have been measured, merged back into this file
+ * when Yorick exits.  The code, in ywisdom.h, is that of the FFTW3 engine of
+ * Yeti so that the file is shared: its name is given by environment variable
+ * YORICK_FFTW_WISDOM, or is "$HOME/.yorick/fftw3-wisdom-$HOSTNAME" by
+ * default. */
+
+#define WISDOM_NAME "fftw3-wisdom"
+#define WISDOM_IMPORT(file) fftw_import_wisdom_from_file(file)
+#define WISDOM_EXPORT(file) fftw_export_wisdom_to_file(file)
+#include "ywisdom.h"
+
+/* To be called before creating a plan with FFTW_FLAGS. */
+static void prepare_wisdom(unsigned int fftw_flags)
+{
+  init_wisdom();
+  if ((fftw_flags & FFTW_ESTIMATE) == 0) {
+    update_wisdom();
+  }
+}
+
 /*---------------------------------------------------------------------------*/
 /* MANAGE YORICK ARGUMENTS */
 
@@ -336,6 +362,9 @@ static const char *ordinal_suffix(long n)
 typedef struct _op op_t;
 struct _op {
   nfft_plan plan;
+  nfft_plan *work; /* per-thread workspaces for stacks (see op_make_work) */
+  int nwork;       /* number of workspaces in WORK */
+  int nthreads;    /* value of keyword NTHREADS */
   long nevals;
   int initialized;
 };
@@ -356,6 +385,8 @@ static void op_free(void *);
 static void op_print(void *);
 static void op_eval(void *, int);
 static void op_extract(void *, char *);
+static void op_make_work(op_t *op, int nwork);
+static void free_work(nfft_plan *w);
 
 /* Class definition. */
 static y_userobj_t op_class = {
@@ -373,25 +404,143 @@ static y_userobj_t op_class = {
 static void op_free(void *ptr)
 {
   op_t *op = (op_t *)ptr;
+  if (op->work != NULL) {
+    while (op->nwork > 0) {
+      free_work(&op->work[--op->nwork]);
+    }
+    p_free(op->work);
+    op->work = NULL;
+  }
   if (op->initialized) {
     nfft_finalize(&op->plan);
   }
 }
 
+/* A workspace is a shallow copy of the plan of the operator: it shares the
+   coordinates of the nodes and the precomputed tables (which are only read
+   by the transforms) but has its own input and output arrays, its own
+   oversampled buffers and its own FFTW plans, so that several elements of
+   a stack can be transformed at the same time by different threads.  The
+   transforms of NFFT 3 only write into f, f_hat and the oversampled buffers
+   g1 and g2 (also seen as g_hat and g), so all these pointers are set for
+   the workspace. */
+static void free_work(nfft_plan *w)
+{
+  if (w->my_fftw_plan2 != NULL) fftw_destroy_plan(w->my_fftw_plan2);
+  if (w->my_fftw_plan1 != NULL) fftw_destroy_plan(w->my_fftw_plan1);
+  if (w->g2 != NULL && w->g2 != w->g1) fftw_free(w->g2);
+  if (w->g1 != NULL) fftw_free(w->g1);
+  if (w->f_hat != NULL) fftw_free(w->f_hat);
+  if (w->f != NULL) fftw_free(w->f);
+}
+
+/* Make sure that operator OP has at least NWORK workspaces.  FFTW planning
+   is not thread-safe, so this must be called before any parallel region. */
+static void op_make_work(op_t *op, int nwork)
+{
+  const nfft_plan *plan = &op->plan;
+  nfft_plan *w;
+  int n[MAX_RANK];
+  long t;
+
+  if (op->nwork >= nwork) return;
+  if (op->work == NULL) {
+    /* Never more workspaces than threads. */
+    op->work = (nfft_plan *)p_malloc(op->nthreads*sizeof(nfft_plan));
+  }
+  for (t = 0; t < plan->d; ++t) {
+    n[t] = (int)plan->n[t];
+  }
+  prepare_wisdom(plan->fftw_flags);
+#ifdef USE_THREADS
+  /* Each thread runs its own single-threaded FFTs. */
+  fftw_plan_with_nthreads(1);
+#endif
+  while (op->nwork < nwork) {
+    w = &op->work[op->nwork];
+    *w = *plan;
+    w->my_fftw_plan1 = NULL;
+    w->my_fftw_plan2 = NULL;
+    w->f = (fftw_complex *)fftw_malloc(plan->M_total*sizeof(fftw_complex));
+    w->f_hat = (fftw_complex *)fftw_malloc(plan->N_total*sizeof(fftw_complex));
+    w->g1 = (fftw_complex *)fftw_malloc(plan->n_total*sizeof(fftw_complex));
+    if (plan->g2 == plan->g1) {
+      w->g2 = w->g1;
+    } else {
+      w->g2 = (fftw_complex *)fftw_malloc(plan->n_total*sizeof(fftw_complex));
+    }
+    w->g_hat = w->g1;
+    w->g = w->g2;
+    if (w->f != NULL && w->f_hat != NULL && w->g1 != NULL && w->g2 != NULL) {
+      w->my_fftw_plan1 = fftw_plan_dft(plan->d, n, w->g1, w->g2,
+                                       FFTW_FORWARD, plan->fftw_flags);
+      w->my_fftw_plan2 = fftw_plan_dft(plan->d, n, w->g2, w->g1,
+                                       FFTW_BACKWARD, plan->fftw_flags);
+    }
+    if (w->my_fftw_plan1 == NULL || w->my_fftw_plan2 == NULL) {
+      free_work(w);
+#ifdef USE_THREADS
+      fftw_plan_with_nthreads(op->nthreads);
+#endif
+      y_error("insufficient memory for NFFT workspaces");
+    }
+    ++op->nwork;
+  }
+#ifdef USE_THREADS
+  fftw_plan_with_nthreads(op->nthreads);
+#endif
+}
+
 static void op_print(void *ptr)
 {
   y_print("NFFT operator", 1);
 }
 
+/* Copy/convert N values of type TYPE from SRC (starting at offset OFF) into
+   the interleaved complex array DST (imaginary parts set to zero for
+   non-complex types). */
+#define COPY_TO_COMPLEX(TYPE)                   \
+  do {                                          \
+    const TYPE *inp = (const TYPE *)src + off;  \
+    for (j = 0; j < n; ++j) {                   \
+      dst[2*j] = (double)inp[j];                \
+      dst[2*j + 1] = 0.0;                       \
+    }                                           \
+  } while (0)
+
+static void copy_to_complex(double *dst, const void *src, long off, long n,
+                            int type)
+{
+  long j;
+  switch (type) {
+  /* Yorick char is unsigned, unlike C char on most machines. */
+  case Y_CHAR:    COPY_TO_COMPLEX(unsigned char); break;
+  case Y_SHORT:   COPY_TO_COMPLEX(short);  break;
+  case Y_INT:     COPY_TO_COMPLEX(int);    break;
+  case Y_LONG:    COPY_TO_COMPLEX(long);   break;
+  case Y_FLOAT:   COPY_TO_COMPLEX(float);  break;
+  case Y_DOUBLE:  COPY_TO_COMPLEX(double); break;
+  case Y_COMPLEX:
+    memcpy(dst, (const double *)src + 2*off, n*(2*sizeof(double)));
+    break;
+  default: y_error("expecting a numerical array");
+  }
+}
+
+#undef COPY_TO_COMPLEX
+
 static void op_eval(void *ptr, int argc)
 {
   op_t *op = (op_t *)ptr;
-  const double *src;
+  const void *src;
   double *dst;
   const NFFT_INT *inp_dims;
   long dims[Y_DIMSIZE];
-  long t, rank, num_nodes, dim, nsrc, ndst;
-  int arg_type, job = 0;
+  long b, t, rank, num_nodes, nsrc, ndst, nimg, nbatch;
+  int arg_type, src_type, job = 0;
+#ifdef _OPENMP
+  int nwork;
+#endif
 
   /* Get the direction of the transform and check number of arguments. */
   if (argc == 2) {
@@ -405,33 +554,47 @@ static void op_eval(void *ptr, int argc)
   } else if (argc != 1) {
     y_error("syntax: op(a) or op(a, job) with op the NFFT operator");
   }
+  if (job < 0 || job > 2) {
+    y_error("bad job");
+  }
 
-  /*FIXME: for efficiency make the conversion and padding myself */
-  /*FIXME: add a flag to pretend result is a double */
-  src = ygeta_z(0, &nsrc, dims);
+  /* The source values are directly converted into the workspace of the plan
+     (no temporary arrays).  An extra trailing dimension means a stack of
+     independent arguments which are all transformed with the same
+     precomputed tables; with several threads, the stack is split between
+     them, each thread having its own workspace. */
+  src = ygeta_any(0, &nsrc, dims, &src_type);
+  if (! IS_NUMERICAL(src_type)) {
+    y_error("expecting a numerical array");
+  }
   rank = GET_RANK(op);
   num_nodes = GET_NUM_NODES(op);
   inp_dims = GET_INP_DIMS(op);
+  nimg = 1;
+  for (t = 0; t < rank; ++t) {
+    nimg *= inp_dims[t];
+  }
   if (job) {
     /* Apply adjoint. */
-    if (dims[0] > 1 || nsrc != num_nodes) {
+    if (dims[0] > 2 || (dims[0] >= 1 ? dims[1] : 1) != num_nodes) {
       goto bad_dims;
     }
-    memcpy(op->plan.f, src, nsrc*(2*sizeof(double)));
-    yarg_drop(1); /* source no longer needed */
-    nfft_adjoint(&op->plan);
+    nbatch = (dims[0] == 2 ? dims[2] : 0);
     dims[0] = rank;
-    ndst = 1;
     for (t = 0; t < rank; ++t) {
-      dim = inp_dims[rank - 1 - t];
-      ndst *= dim;
-      dims[1 + t] = dim;
+      dims[1 + t] = inp_dims[rank - 1 - t];
     }
-    dst = ypush_z(dims);
-    memcpy(dst, op->plan.f_hat, ndst*(2*sizeof(double)));
+    if (nbatch > 0) {
+      dims[0] = rank + 1;
+      dims[rank + 1] = nbatch;
+    } else {
+      nbatch = 1;
+    }
+    ndst = nimg;
+    dst = (job == 2 ? ypush_d(dims) : (double *)ypush_z(dims));
   } else {
     /* Apply transform. */
-    if (dims[0] != rank) {
+    if (dims[0] != rank && dims[0] != rank + 1) {
       goto bad_dims;
     }
     for (t = 0; t < rank; ++t) {
@@ -439,16 +602,57 @@ static void op_eval(void *ptr, int argc)
         goto bad_dims;
       }
     }
-    memcpy(op->plan.f_hat, src, nsrc*(2*sizeof(double)));
-    yarg_drop(1); /* source no longer needed */
-    nfft_trafo(&op->plan);
+    nbatch = (dims[0] > rank ? dims[rank + 1] : 0);
     ndst = num_nodes;
-    dims[0] = (ndst > 1 ? 1 : 0);
-    dims[1] = ndst;
-    dst = ypush_z(dims);
-    memcpy(dst, op->plan.f, ndst*(2*sizeof(double)));
+    if (nbatch > 0) {
+      dims[0] = 2;
+      dims[1] = ndst;
+      dims[2] = nbatch;
+    } else {
+      nbatch = 1;
+      dims[0] = (ndst > 1 ? 1 : 0);
+      dims[1] = ndst;
+    }
+    dst = (double *)ypush_z(dims);
   }
-  ++op->nevals;
+
+#ifdef _OPENMP
+  nwork = 1;
+  if (nbatch > 1 && op->nthreads > 1) {
+    nwork = (nbatch < op->nthreads ? (int)nbatch : op->nthreads);
+    op_make_work(op, nwork);
+  }
+#pragma omp parallel for num_threads(nwork) schedule(static) if (nwork > 1)
+#endif
+  for (b = 0; b < nbatch; ++b) {
+#ifdef _OPENMP
+    nfft_plan *plan = (nwork > 1 ? &op->work[omp_get_thread_num()]
+                       : &op->plan);
+#else
+    nfft_plan *plan = &op->plan;
+#endif
+    if (job) {
+      const double *res = (const double *)plan->f_hat;
+      copy_to_complex((double *)plan->f, src, b*num_nodes, num_nodes,
+                      src_type);
+      nfft_adjoint(plan);
+      if (job == 2) {
+        /* Only keep the real part of the result. */
+        double *out = dst + b*ndst;
+        long j;
+        for (j = 0; j < ndst; ++j) {
+          out[j] = res[2*j];
+        }
+      } else {
+        memcpy(dst + 2*b*ndst, res, ndst*(2*sizeof(double)));
+      }
+    } else {
+      copy_to_complex((double *)plan->f_hat, src, b*nimg, nimg, src_type);
+      nfft_trafo(plan);
+      memcpy(dst + 2*b*ndst, plan->f, ndst*(2*sizeof(double)));
+    }
+  }
+  op->nevals += nbatch;
   return;
 
  bad_dims:
@@ -539,6 +743,10 @@ static void op_extract(void *ptr, char *member)
   } else if (index == fftw_flags_index) {
     int value = GET_FFTW_FLAGS(op);
     ypush_int(value);
+  } else if (index == nthreads_index) {
+    ypush_int(op->nthreads);
+  } else if (index == nworkspaces_index) {
+    ypush_int(op->nwork);
   } else {
     y_error("invalid NFFT member");
     /*ypush_nil();*/
@@ -616,6 +824,25 @@ BUILTIN(version)(int argc)
   ypush_q(NULL)[0] = p_strcpy(VERSION);
 }
 
+BUILTIN(wisdom)(int argc)
+{
+  if (argc > 1) y_error("nfft_wisdom takes at most one argument");
+  if (argc == 1 && ! yarg_nil(0)) {
+    set_wisdom_file(ygets_q(0));
+  }
+  ypush_q(NULL)[0] = p_strcpy(get_wisdom_file());
+}
+
+BUILTIN(wisdom_save)(int argc)
+{
+  if (argc > 1) y_error("nfft_wisdom_save takes at most one argument");
+  if (save_wisdom((argc == 1 && ! yarg_nil(0)) ? ygets_q(0)
+                  : get_wisdom_file()) != SUCCESS) {
+    y_error("failed to export FFTW wisdom");
+  }
+  ypush_nil();
+}
+
 BUILTIN(indgen)(int argc)
 {
   double stp;
@@ -973,13 +1200,14 @@ BUILTIN(new)(int argc)
   op = (op_t *)ypush_obj(&op_class, sizeof(op_t));
 
   /* Set number of threads for FFTW. */
-  if (nthreads > 1) {
+  op->nthreads = nthreads;
 #ifdef USE_THREADS
-    fftw_plan_with_nthreads(nthreads);
+  fftw_plan_with_nthreads(nthreads);
 #else
+  if (nthreads > 1) {
     y_warn("NFFT not compiled with support for multi-threaded FFTW");
-#endif
   }
+#endif
 
   /* Create NFFT plan. */
   make_nfft_plan(&op->plan, rank, inp_dims, ovr_dims,
@@ -1044,6 +1272,7 @@ static void make_nfft_plan(nfft_plan *plan, long rank,
       goto integer_overflow;
     }
   }
+  prepare_wisdom(fftw_flags);
   nfft_init_guru(plan, rank, _inp_dims, _num_nodes,
                  _ovr_dims, cutoff, nfft_flags, fftw_flags);
 
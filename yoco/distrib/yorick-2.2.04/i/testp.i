@@ -284,330 +284,331 @@ func parser_test(pos1,pos2,pos3,..,key1=,key2=,key3=)
  167 sp+>2    PushLong(3)
  169 sp+>3    PushNil
  170 sp->2    FormRange(2)
- 172 sp+>3    PushLong(6)
- 174 sp+>4    PushVariable(loc1)
- 176 sp->3    Multiply
- 177 sp+>4    PushVariable(loc2)
- 179 sp->3    Add
- 180 sp+>4    PushNil
- 181 sp+>5    PushNil
- 182 sp+>6    PushVariable(loc2)
- 184 sp+>7    PushVariable(loc3)
- 186 sp->6    Add
- 187 sp->4    FormRange(3)
- 189 sp->1    Eval(3)
- 191 sp+>2    PushLong(5)
- 193 sp->1    Assign
- 194 sp->0    DropTop
- 195 sp+>1    PushVariable(loc7)
- 197 sp+>2    PushLong(7)
- 199 sp+>3    PushVariable(loc6)
- 201 sp+>4    PushLong(3)
- 203 sp+>5    PushNil
- 204 sp->3    Eval(2)
- 206 sp->2    Multiply
- 207 sp->1    Add
- 208 sp0>1    Define(loc8)
- 210 sp->0    DropTop
- 211 sp+>1    PushVariable(loc1)
- 213 sp->0    BranchFalse to pc= 221
- 215 sp+>1    PushVariable(ext5)
- 217 sp0>1    Print
- 218 sp->0    DropTop
- 219 sp0>0    Branch to pc= 228
- 221 sp+>1    PushVariable(ext5)
- 223 sp+>2    PushLong(1)
- 225 sp->1    Eval(1)
- 227 sp->0    DropTop
- 228 sp+>1    PushVariable(loc1)
- 230 sp->0    BranchFalse to pc= 236
- 232 sp+>1    PushVariable(ext5)
- 234 sp0>1    Print
- 235 sp->0    DropTop
- 236 sp+>1    PushVariable(ext5)
- 238 sp+>2    PushLong(1)
- 240 sp->1    Eval(1)
- 242 sp->0    DropTop
- 243 sp+>1    PushVariable(loc1)
- 245 sp->0    BranchFalse to pc= 253
- 247 sp+>1    PushVariable(ext3)
- 249 sp0>1    Print
- 250 sp->0    DropTop
- 251 sp0>0    Branch to pc= 293
- 253 sp+>1    PushVariable(loc2)
- 255 sp->0    BranchTrue to pc= 266
- 257 sp+>1    PushVariable(ext3)
- 259 sp+>2    PushLong(1)
- 261 sp->1    Eval(1)
- 263 sp->0    DropTop
- 264 sp0>0    Branch to pc= 293
- 266 sp+>1    PushVariable(loc3)
- 268 sp->0    BranchFalse to pc= 286
- 270 sp+>1    PushVariable(ext3)
- 272 sp+>2    PushLong(1)
- 274 sp->1    Eval(1)
- 276 sp->0    DropTop
- 277 sp+>1    PushVariable(ext3)
- 279 sp+>2    PushLong(2)
- 281 sp->1    Eval(1)
- 283 sp->0    DropTop
- 284 sp0>0    Branch to pc= 293
- 286 sp+>1    PushVariable(ext3)
- 288 sp+>2    PushLong(3)
- 290 sp->1    Eval(1)
- 292 sp->0    DropTop
- 293 sp+>1    PushVariable(loc1)
- 295 sp->0    BranchFalse to pc= 303
- 297 sp+>1    PushVariable(ext4)
- 299 sp0>1    Print
- 300 sp->0    DropTop
- 301 sp0>0    Branch to pc= 343
- 303 sp+>1    PushVariable(loc2)
- 305 sp->0    BranchFalse to pc= 316
- 307 sp+>1    PushVariable(ext4)
- 309 sp+>2    PushLong(1)
- 311 sp->1    Eval(1)
- 313 sp->0    DropTop
- 314 sp0>0    Branch to pc= 343
- 316 sp+>1    PushVariable(loc3)
- 318 sp->0    BranchTrue to pc= 336
- 320 sp+>1    PushVariable(ext4)
- 322 sp+>2    PushLong(1)
- 324 sp->1    Eval(1)
- 326 sp->0    DropTop
- 327 sp+>1    PushVariable(ext4)
- 329 sp+>2    PushLong(2)
- 331 sp->1    Eval(1)
- 333 sp->0    DropTop
- 334 sp0>0    Branch to pc= 343
- 336 sp+>1    PushVariable(ext4)
- 338 sp+>2    PushLong(3)
- 340 sp->1    Eval(1)
- 342 sp->0    DropTop
- 343 sp+>1    PushVariable(loc1)
- 345 sp->0    BranchTrue to pc= 353
- 347 sp+>1    PushVariable(ext5)
- 349 sp0>1    Print
- 350 sp->0    DropTop
- 351 sp0>0    Branch to pc= 393
- 353 sp+>1    PushVariable(loc2)
- 355 sp->0    BranchFalse to pc= 366
- 357 sp+>1    PushVariable(ext5)
- 359 sp+>2    PushLong(1)
- 361 sp->1    Eval(1)
- 363 sp->0    DropTop
- 364 sp0>0    Branch to pc= 393
- 366 sp+>1    PushVariable(loc3)
- 368 sp->0    BranchFalse to pc= 386
- 370 sp+>1    PushVariable(ext5)
- 372 sp+>2    PushLong(1)
- 374 sp->1    Eval(1)
- 376 sp->0    DropTop
- 377 sp+>1    PushVariable(ext5)
- 379 sp+>2    PushLong(2)
- 381 sp->1    Eval(1)
- 383 sp->0    DropTop
- 384 sp0>0    Branch to pc= 393
- 386 sp+>1    PushVariable(ext5)
- 388 sp+>2    PushLong(3)
- 390 sp->1    Eval(1)
- 392 sp->0    DropTop
- 393 sp+>1    PushVariable(loc1)
- 395 sp+>2    Push1
- 396 sp+>3    DupUnder
- 397 sp->2    Subtract
- 398 sp0>2    Define(loc1)
- 400 sp->1    DropTop
- 401 sp->0    BranchFalse to pc= 416
- 403 sp+>1    PushVariable(ext6)
- 405 sp0>1    Print
- 406 sp->0    DropTop
- 407 sp+>1    PushVariable(ext6)
- 409 sp+>2    PushLong(2)
- 411 sp->1    Eval(1)
- 413 sp->0    DropTop
- 414 sp0>0    Branch to pc= 393
- 416 sp+>1    PushVariable(ext6)
- 418 sp0>1    Print
- 419 sp->0    DropTop
- 420 sp+>1    PushVariable(ext1)
- 422 sp->0    BranchFalse to pc= 426
- 424 sp0>0    Branch to pc= 447
- 426 sp+>1    PushVariable(ext2)
- 428 sp->0    BranchFalse to pc= 432
- 430 sp0>0    Branch to pc= 439
- 432 sp+>1    PushVariable(ext6)
- 434 sp+>2    PushLong(2)
- 436 sp->1    Eval(1)
- 438 sp->0    DropTop
- 439 sp+>1    PushVariable(loc1)
- 441 sp+>2    Push1
- 442 sp->1    Subtract
- 443 sp0>1    Define(loc1)
- 445 sp->0    BranchTrue to pc= 416
- 447 sp+>1    PushVariable(ext6)
- 449 sp->0    BranchFalse to pc= 453
- 451 sp0>0    Branch to pc= 493
- 453 sp+>1    PushVariable(ext3)
- 455 sp->0    BranchFalse to pc= 459
- 457 sp0>0    Branch to pc= 416
- 459 sp+>1    PushLong(0)
- 461 sp0>1    Define(loc1)
- 463 sp->0    DropTop
- 464 sp+>1    PushVariable(loc1)
- 466 sp+>2    PushLong(8)
- 468 sp->1    Less
- 469 sp->0    BranchFalse to pc= 493
- 471 sp+>1    PushVariable(ext5)
- 473 sp0>1    Print
- 474 sp->0    DropTop
- 475 sp+>1    PushVariable(ext5)
- 477 sp+>2    PushLong(2)
- 479 sp->1    Eval(1)
- 481 sp->0    DropTop
- 482 sp+>1    PushVariable(loc1)
- 484 sp+>2    Push1
- 485 sp+>3    DupUnder
- 486 sp->2    Add
- 487 sp0>2    Define(loc1)
- 489 sp->1    DropTop
- 490 sp->0    DropTop
- 491 sp0>0    Branch to pc= 464
- 493 sp+>1    PushLong(0)
- 495 sp0>1    Define(loc1)
- 497 sp->0    DropTop
- 498 sp+>1    PushLong(0)
- 500 sp0>1    Define(loc3)
- 502 sp0>1    Define(loc2)
- 504 sp->0    DropTop
- 505 sp+>1    PushVariable(loc1)
- 507 sp+>2    PushLong(8)
- 509 sp->1    Less
- 510 sp->0    BranchFalse to pc= 660
- 512 sp+>1    PushVariable(ext4)
- 514 sp+>2    PushLong(9)
- 516 sp->1    GreaterEQ
- 517 sp->0    BranchFalse to pc= 521
- 519 sp0>0    Branch to pc= 633
- 521 sp+>1    PushVariable(ext5)
- 523 sp0>1    Print
- 524 sp->0    DropTop
- 525 sp+>1    PushVariable(ext6)
- 527 sp0>1    Print
- 528 sp->0    DropTop
- 529 sp+>1    PushVariable(ext1)
- 531 sp+>2    PushLong(3)
- 533 sp->1    NotEqual
- 534 sp->0    BranchFalse to pc= 538
- 536 sp0>0    Branch to pc= 617
- 538 sp+>1    PushLong(0)
- 540 sp0>1    Define(loc1)
- 542 sp->0    DropTop
- 543 sp+>1    PushVariable(loc1)
- 545 sp+>2    PushLong(8)
- 547 sp->1    Less
- 548 sp->0    BranchFalse to pc= 596
- 550 sp+>1    PushVariable(ext5)
- 552 sp0>1    Print
- 553 sp->0    DropTop
- 554 sp+>1    PushVariable(ext3)
- 556 sp+>2    PushLong(2)
- 558 sp->1    LessEQ
- 559 sp->0    BranchFalse to pc= 563
- 561 sp0>0    Branch to pc= 596
- 563 sp+>1    PushVariable(ext4)
- 565 sp+>2    PushLong(7)
- 567 sp->1    Equal
- 568 sp->0    BranchFalse to pc= 572
- 570 sp0>0    Branch to pc= 585
- 572 sp+>1    PushVariable(ext1)
- 574 sp->0    BranchTrue to pc= 578
- 576 sp0>0    Branch to pc= 633
- 578 sp+>1    PushVariable(ext5)
- 580 sp+>2    PushLong(2)
- 582 sp->1    Eval(1)
- 584 sp->0    DropTop
- 585 sp+>1    PushVariable(loc1)
- 587 sp+>2    Push1
- 588 sp+>3    DupUnder
- 589 sp->2    Add
- 590 sp0>2    Define(loc1)
- 592 sp->1    DropTop
- 593 sp->0    DropTop
- 594 sp0>0    Branch to pc= 543
- 596 sp+>1    PushVariable(ext2)
- 598 sp->0    BranchFalse to pc= 602
- 600 sp0>0    Branch to pc= 609
- 602 sp+>1    PushVariable(ext6)
- 604 sp+>2    PushLong(2)
- 606 sp->1    Eval(1)
- 608 sp->0    DropTop
- 609 sp+>1    PushVariable(loc1)
- 611 sp+>2    Push1
- 612 sp->1    Subtract
- 613 sp0>1    Define(loc1)
- 615 sp->0    BranchTrue to pc= 525
- 617 sp+>1    PushVariable(ext3)
- 619 sp+>2    PushLong(3)
- 621 sp->1    Greater
- 622 sp->0    BranchFalse to pc= 626
- 624 sp0>0    Branch to pc= 660
- 626 sp+>1    PushVariable(ext5)
- 628 sp+>2    PushLong(2)
- 630 sp->1    Eval(1)
- 632 sp->0    DropTop
- 633 sp+>1    PushVariable(loc1)
- 635 sp+>2    Push1
- 636 sp+>3    DupUnder
- 637 sp->2    Add
- 638 sp0>2    Define(loc1)
- 640 sp->1    DropTop
- 641 sp->0    DropTop
- 642 sp+>1    PushVariable(loc2)
- 644 sp+>2    PushLong(2)
- 646 sp->1    Add
- 647 sp0>1    Define(loc2)
- 649 sp->0    DropTop
- 650 sp+>1    PushVariable(loc3)
- 652 sp+>2    PushLong(3)
- 654 sp->1    Add
- 655 sp0>1    Define(loc3)
- 657 sp->0    DropTop
- 658 sp0>0    Branch to pc= 505
- 660 sp+>1    PushVariable(loc1)
- 662 sp->0    BranchTrue to pc= 673
- 664 sp+>1    PushVariable(loc2)
- 666 sp->0    BranchFalse to pc= 671
- 668 sp+>1    PushVariable(loc3)
- 670 sp==0    AndOrLogical for &&
- 671 sp+>1    Push0
- 672 sp==0    AndOrLogical for ||
- 673 sp+>1    Push1
- 674 sp->0    BranchFalse to pc= 678
- 676 sp0>0    Branch to pc= 416
- 678 sp+>1    PushLong(3)
- 680 sp+>2    PushVariable(loc1)
- 682 sp+>3    PushLong(3)
- 684 sp+>4    PushLong(12)
- 686 sp+>5    PushLong(3)
- 688 sp->3    FormRange(3)
- 690 sp+>4    FormRangeFunc(ptp:)
- 692 sp+>5    PushLong(9)
- 694 sp+>6    PushLong(21)
- 696 sp->5    FormRange(2)
- 698 sp0>5    AddRangeFunc(avg:)
- 700 sp->2    Eval(3)
- 702 sp->1    Multiply
- 703 sp->0    BranchFalse to pc= 712
- 705 sp+>1    PushLong(3)
- 707 sp+>2    PushVariable(ext1)
- 709 sp->1    Add
- 710 sp0>1    Branch to pc= 717
- 712 sp+>1    PushLong(2)
- 714 sp+>2    PushVariable(ext2)
- 716 sp->1    Subtract
- 717 sp->0    Return
- 718 sp==0    Halt-Virtual-Machine
+ 172 sp0>2    Fused to pc= 182
+ 174 sp+>3    PushLong(6)
+ 176 sp+>4    PushVariable(loc1)
+ 178 sp->3    Multiply
+ 179 sp+>4    PushVariable(loc2)
+ 181 sp->3    Add
+ 182 sp+>4    PushNil
+ 183 sp+>5    PushNil
+ 184 sp+>6    PushVariable(loc2)
+ 186 sp+>7    PushVariable(loc3)
+ 188 sp->6    Add
+ 189 sp->4    FormRange(3)
+ 191 sp->1    Eval(3)
+ 193 sp+>2    PushLong(5)
+ 195 sp->1    Assign
+ 196 sp->0    DropTop
+ 197 sp+>1    PushVariable(loc7)
+ 199 sp+>2    PushLong(7)
+ 201 sp+>3    PushVariable(loc6)
+ 203 sp+>4    PushLong(3)
+ 205 sp+>5    PushNil
+ 206 sp->3    Eval(2)
+ 208 sp->2    Multiply
+ 209 sp->1    Add
+ 210 sp0>1    Define(loc8)
+ 212 sp->0    DropTop
+ 213 sp+>1    PushVariable(loc1)
+ 215 sp->0    BranchFalse to pc= 223
+ 217 sp+>1    PushVariable(ext5)
+ 219 sp0>1    Print
+ 220 sp->0    DropTop
+ 221 sp0>0    Branch to pc= 230
+ 223 sp+>1    PushVariable(ext5)
+ 225 sp+>2    PushLong(1)
+ 227 sp->1    Eval(1)
+ 229 sp->0    DropTop
+ 230 sp+>1    PushVariable(loc1)
+ 232 sp->0    BranchFalse to pc= 238
+ 234 sp+>1    PushVariable(ext5)
+ 236 sp0>1    Print
+ 237 sp->0    DropTop
+ 238 sp+>1    PushVariable(ext5)
+ 240 sp+>2    PushLong(1)
+ 242 sp->1    Eval(1)
+ 244 sp->0    DropTop
+ 245 sp+>1    PushVariable(loc1)
+ 247 sp->0    BranchFalse to pc= 255
+ 249 sp+>1    PushVariable(ext3)
+ 251 sp0>1    Print
+ 252 sp->0    DropTop
+ 253 sp0>0    Branch to pc= 295
+ 255 sp+>1    PushVariable(loc2)
+ 257 sp->0    BranchTrue to pc= 268
+ 259 sp+>1    PushVariable(ext3)
+ 261 sp+>2    PushLong(1)
+ 263 sp->1    Eval(1)
+ 265 sp->0    DropTop
+ 266 sp0>0    Branch to pc= 295
+ 268 sp+>1    PushVariable(loc3)
+ 270 sp->0    BranchFalse to pc= 288
+ 272 sp+>1    PushVariable(ext3)
+ 274 sp+>2    PushLong(1)
+ 276 sp->1    Eval(1)
+ 278 sp->0    DropTop
+ 279 sp+>1    PushVariable(ext3)
+ 281 sp+>2    PushLong(2)
+ 283 sp->1    Eval(1)
+ 285 sp->0    DropTop
+ 286 sp0>0    Branch to pc= 295
+ 288 sp+>1    PushVariable(ext3)
+ 290 sp+>2    PushLong(3)
+ 292 sp->1    Eval(1)
+ 294 sp->0    DropTop
+ 295 sp+>1    PushVariable(loc1)
+ 297 sp->0    BranchFalse to pc= 305
+ 299 sp+>1    PushVariable(ext4)
+ 301 sp0>1    Print
+ 302 sp->0    DropTop
+ 303 sp0>0    Branch to pc= 345
+ 305 sp+>1    PushVariable(loc2)
+ 307 sp->0    BranchFalse to pc= 318
+ 309 sp+>1    PushVariable(ext4)
+ 311 sp+>2    PushLong(1)
+ 313 sp->1    Eval(1)
+ 315 sp->0    DropTop
+ 316 sp0>0    Branch to pc= 345
+ 318 sp+>1    PushVariable(loc3)
+ 320 sp->0    BranchTrue to pc= 338
+ 322 sp+>1    PushVariable(ext4)
+ 324 sp+>2    PushLong(1)
+ 326 sp->1    Eval(1)
+ 328 sp->0    DropTop
+ 329 sp+>1    PushVariable(ext4)
+ 331 sp+>2    PushLong(2)
+ 333 sp->1    Eval(1)
+ 335 sp->0    DropTop
+ 336 sp0>0    Branch to pc= 345
+ 338 sp+>1    PushVariable(ext4)
+ 340 sp+>2    PushLong(3)
+ 342 sp->1    Eval(1)
+ 344 sp->0    DropTop
+ 345 sp+>1    PushVariable(loc1)
+ 347 sp->0    BranchTrue to pc= 355
+ 349 sp+>1    PushVariable(ext5)
+ 351 sp0>1    Print
+ 352 sp->0    DropTop
+ 353 sp0>0    Branch to pc= 395
+ 355 sp+>1    PushVariable(loc2)
+ 357 sp->0    BranchFalse to pc= 368
+ 359 sp+>1    PushVariable(ext5)
+ 361 sp+>2    PushLong(1)
+ 363 sp->1    Eval(1)
+ 365 sp->0    DropTop
+ 366 sp0>0    Branch to pc= 395
+ 368 sp+>1    PushVariable(loc3)
+ 370 sp->0    BranchFalse to pc= 388
+ 372 sp+>1    PushVariable(ext5)
+ 374 sp+>2    PushLong(1)
+ 376 sp->1    Eval(1)
+ 378 sp->0    DropTop
+ 379 sp+>1    PushVariable(ext5)
+ 381 sp+>2    PushLong(2)
+ 383 sp->1    Eval(1)
+ 385 sp->0    DropTop
+ 386 sp0>0    Branch to pc= 395
+ 388 sp+>1    PushVariable(ext5)
+ 390 sp+>2    PushLong(3)
+ 392 sp->1    Eval(1)
+ 394 sp->0    DropTop
+ 395 sp+>1    PushVariable(loc1)
+ 397 sp+>2    Push1
+ 398 sp+>3    DupUnder
+ 399 sp->2    Subtract
+ 400 sp0>2    Define(loc1)
+ 402 sp->1    DropTop
+ 403 sp->0    BranchFalse to pc= 418
+ 405 sp+>1    PushVariable(ext6)
+ 407 sp0>1    Print
+ 408 sp->0    DropTop
+ 409 sp+>1    PushVariable(ext6)
+ 411 sp+>2    PushLong(2)
+ 413 sp->1    Eval(1)
+ 415 sp->0    DropTop
+ 416 sp0>0    Branch to pc= 395
+ 418 sp+>1    PushVariable(ext6)
+ 420 sp0>1    Print
+ 421 sp->0    DropTop
+ 422 sp+>1    PushVariable(ext1)
+ 424 sp->0    BranchFalse to pc= 428
+ 426 sp0>0    Branch to pc= 449
+ 428 sp+>1    PushVariable(ext2)
+ 430 sp->0    BranchFalse to pc= 434
+ 432 sp0>0    Branch to pc= 441
+ 434 sp+>1    PushVariable(ext6)
+ 436 sp+>2    PushLong(2)
+ 438 sp->1    Eval(1)
+ 440 sp->0    DropTop
+ 441 sp+>1    PushVariable(loc1)
+ 443 sp+>2    Push1
+ 444 sp->1    SubtractInPlace
+ 445 sp0>1    Define(loc1)
+ 447 sp->0    BranchTrue to pc= 418
+ 449 sp+>1    PushVariable(ext6)
+ 451 sp->0    BranchFalse to pc= 455
+ 453 sp0>0    Branch to pc= 495
+ 455 sp+>1    PushVariable(ext3)
+ 457 sp->0    BranchFalse to pc= 461
+ 459 sp0>0    Branch to pc= 418
+ 461 sp+>1    PushLong(0)
+ 463 sp0>1    Define(loc1)
+ 465 sp->0    DropTop
+ 466 sp+>1    PushVariable(loc1)
+ 468 sp+>2    PushLong(8)
+ 470 sp->1    Less
+ 471 sp->0    BranchFalse to pc= 495
+ 473 sp+>1    PushVariable(ext5)
+ 475 sp0>1    Print
+ 476 sp->0    DropTop
+ 477 sp+>1    PushVariable(ext5)
+ 479 sp+>2    PushLong(2)
+ 481 sp->1    Eval(1)
+ 483 sp->0    DropTop
+ 484 sp+>1    PushVariable(loc1)
+ 486 sp+>2    Push1
+ 487 sp+>3    DupUnder
+ 488 sp->2    Add
+ 489 sp0>2    Define(loc1)
+ 491 sp->1    DropTop
+ 492 sp->0    DropTop
+ 493 sp0>0    Branch to pc= 466
+ 495 sp+>1    PushLong(0)
+ 497 sp0>1    Define(loc1)
+ 499 sp->0    DropTop
+ 500 sp+>1    PushLong(0)
+ 502 sp0>1    Define(loc3)
+ 504 sp0>1    Define(loc2)
+ 506 sp->0    DropTop
+ 507 sp+>1    PushVariable(loc1)
+ 509 sp+>2    PushLong(8)
+ 511 sp->1    Less
+ 512 sp->0    BranchFalse to pc= 662
+ 514 sp+>1    PushVariable(ext4)
+ 516 sp+>2    PushLong(9)
+ 518 sp->1    GreaterEQ
+ 519 sp->0    BranchFalse to pc= 523
+ 521 sp0>0    Branch to pc= 635
+ 523 sp+>1    PushVariable(ext5)
+ 525 sp0>1    Print
+ 526 sp->0    DropTop
+ 527 sp+>1    PushVariable(ext6)
+ 529 sp0>1    Print
+ 530 sp->0    DropTop
+ 531 sp+>1    PushVariable(ext1)
+ 533 sp+>2    PushLong(3)
+ 535 sp->1    NotEqual
+ 536 sp->0    BranchFalse to pc= 540
+ 538 sp0>0    Branch to pc= 619
+ 540 sp+>1    PushLong(0)
+ 542 sp0>1    Define(loc1)
+ 544 sp->0    DropTop
+ 545 sp+>1    PushVariable(loc1)
+ 547 sp+>2    PushLong(8)
+ 549 sp->1    Less
+ 550 sp->0    BranchFalse to pc= 598
+ 552 sp+>1    PushVariable(ext5)
+ 554 sp0>1    Print
+ 555 sp->0    DropTop
+ 556 sp+>1    PushVariable(ext3)
+ 558 sp+>2    PushLong(2)
+ 560 sp->1    LessEQ
+ 561 sp->0    BranchFalse to pc= 565
+ 563 sp0>0    Branch to pc= 598
+ 565 sp+>1    PushVariable(ext4)
+ 567 sp+>2    PushLong(7)
+ 569 sp->1    Equal
+ 570 sp->0    BranchFalse to pc= 574
+ 572 sp0>0    Branch to pc= 587
+ 574 sp+>1    PushVariable(ext1)
+ 576 sp->0    BranchTrue to pc= 580
+ 578 sp0>0    Branch to pc= 635
+ 580 sp+>1    PushVariable(ext5)
+ 582 sp+>2    PushLong(2)
+ 584 sp->1    Eval(1)
+ 586 sp->0    DropTop
+ 587 sp+>1    PushVariable(loc1)
+ 589 sp+>2    Push1
+ 590 sp+>3    DupUnder
+ 591 sp->2    Add
+ 592 sp0>2    Define(loc1)
+ 594 sp->1    DropTop
+ 595 sp->0    DropTop
+ 596 sp0>0    Branch to pc= 545
+ 598 sp+>1    PushVariable(ext2)
+ 600 sp->0    BranchFalse to pc= 604
+ 602 sp0>0    Branch to pc= 611
+ 604 sp+>1    PushVariable(ext6)
+ 606 sp+>2    PushLong(2)
+ 608 sp->1    Eval(1)
+ 610 sp->0    DropTop
+ 611 sp+>1    PushVariable(loc1)
+ 613 sp+>2    Push1
+ 614 sp->1    SubtractInPlace
+ 615 sp0>1    Define(loc1)
+ 617 sp->0    BranchTrue to pc= 527
+ 619 sp+>1    PushVariable(ext3)
+ 621 sp+>2    PushLong(3)
+ 623 sp->1    Greater
+ 624 sp->0    BranchFalse to pc= 628
+ 626 sp0>0    Branch to pc= 662
+ 628 sp+>1    PushVariable(ext5)
+ 630 sp+>2    PushLong(2)
+ 632 sp->1    Eval(1)
+ 634 sp->0    DropTop
+ 635 sp+>1    PushVariable(loc1)
+ 637 sp+>2    Push1
+ 638 sp+>3    DupUnder
+ 639 sp->2    Add
+ 640 sp0>2    Define(loc1)
+ 642 sp->1    DropTop
+ 643 sp->0    DropTop
+ 644 sp+>1    PushVariable(loc2)
+ 646 sp+>2    PushLong(2)
+ 648 sp->1    AddInPlace
+ 649 sp0>1    Define(loc2)
+ 651 sp->0    DropTop
+ 652 sp+>1    PushVariable(loc3)
+ 654 sp+>2    PushLong(3)
+ 656 sp->1    AddInPlace
+ 657 sp0>1    Define(loc3)
+ 659 sp->0    DropTop
+ 660 sp0>0    Branch to pc= 507
+ 662 sp+>1    PushVariable(loc1)
+ 664 sp->0    BranchTrue to pc= 675
+ 666 sp+>1    PushVariable(loc2)
+ 668 sp->0    BranchFalse to pc= 673
+ 670 sp+>1    PushVariable(loc3)
+ 672 sp==0    AndOrLogical for &&
+ 673 sp+>1    Push0
+ 674 sp==0    AndOrLogical for ||
+ 675 sp+>1    Push1
+ 676 sp->0    BranchFalse to pc= 680
+ 678 sp0>0    Branch to pc= 418
+ 680 sp+>1    PushLong(3)
+ 682 sp+>2    PushVariable(loc1)
+ 684 sp+>3    PushLong(3)
+ 686 sp+>4    PushLong(12)
+ 688 sp+>5    PushLong(3)
+ 690 sp->3    FormRange(3)
+ 692 sp+>4    FormRangeFunc(ptp:)
+ 694 sp+>5    PushLong(9)
+ 696 sp+>6    PushLong(21)
+ 698 sp->5    FormRange(2)
+ 700 sp0>5    AddRangeFunc(avg:)
+ 702 sp->2    Eval(3)
+ 704 sp->1    Multiply
+ 705 sp->0    BranchFalse to pc= 714
+ 707 sp+>1    PushLong(3)
+ 709 sp+>2    PushVariable(ext1)
+ 711 sp->1    Add
+ 712 sp0>1    Branch to pc= 719
+ 714 sp+>1    PushLong(2)
+ 716 sp+>2    PushVariable(ext2)
+ 718 sp->1    Subtract
+ 719 sp->0    Return
+ 720 sp==0    Halt-Virtual-Machine
 #endif
 
 /* Try reinstated line */
@@ -1899,6 +1900,183 @@ if (do_stats) "Q "+print(yorick_stats());
 
 /* ------------------------------------------------------------------------- */
 
+write, "Test fused arithmetic...";
+
+func junk(a, b, c, z)
+{
+  local t, i;
+  t= a*b(-,);
+  if (anyof(a*b(-,)+c != t+c)) {
+    goofs++;
+    "**FAILURE** of - fused broadcast multiply-add";
+  }
+  t= a*c;
+  t= exp(-t);
+  if (anyof(sqrt(abs(exp(-a*c)-a)) != sqrt(abs(t-a)))) {
+    goofs++;
+    "**FAILURE** of - fused math function chain";
+  }
+  t= float(a)^2;
+  if (structof(float(a)^2+1)!=float || anyof(float(a)^2+1 != t+1)) {
+    goofs++;
+    "**FAILURE** of - fused float integer power";
+  }
+  t= z/c;
+  if (anyof(z/c-z*z != t-z*z)) {
+    goofs++;
+    "**FAILURE** of - fused complex arithmetic";
+  }
+  i= long(b);
+  t= 3*i;
+  if (structof(3*i+1)!=long || anyof(3*i+1 != t+1)) {
+    goofs++;
+    "**FAILURE** of - fused integer fall through";
+  }
+  if (!is_scalar(a(1)*b(1)+c(1)) || a(1)*b(1)+c(1)!=a(1)*b(1)+c(1,1)) {
+    goofs++;
+    "**FAILURE** of - fused scalar result";
+  }
+}
+junk, [[1.5,-2.,3.],[.25,0.,-1.]], [2.,-3.], [[2.,1.,.5],[-1.,-2.,4.]],
+  [[1+2i,-1i,3.],[0.5i,2.,-1-1i]];
+junk, [[1.5,-2.,3.],[.25,0.,-1.]], [2,-3], [[2.,1.,.5],[-1.,-2.,4.]],
+  [[1+2i,-1i,3.],[0.5i,2.,-1-1i]];
+junk= [];
+
+if (do_stats) "R "+print(yorick_stats());
+
+/* ------------------------------------------------------------------------- */
+
+write, "Test superinstructions...";
+
+src= [
+"func junk(x, n)",
+"{",
+"  local i, j, k, s, c, r;",
+"  r= [];  k= 0;  s= 0.;  c= int(0);",
+"  for (i=1 ; i<=n ; i++) {",
+"    j= i;  j++;  j--;  ++c;",
+"    k= k + i*3;  k-= 1;",
+"    s= s + x(i)*2 - x(2)*i;",
+"    if (k > 7) k= k - 5;",
+"    if (s != 0.5 && x(i) <= 2.) s+= 1;",
+"    grow, r, structof(c+1)==int, structof(i<2)==int, structof(c*2.)==double,",
+"      x(i)+c, k*c, i==j, s;",
+"  }",
+"  x= [1,2];  c= 0;",
+"  while (c < 3) { c+= x(2);  grow, r, x(1)-c; }",
+"  return r;",
+"}"];
+i= superinst();
+superinst, 0;
+include, src, 1;
+r= junk([1.5,-2.,3.,0.25], 4);
+superinst, 1;
+include, src, 1;
+if (!anyof(strmatch(disassemble(junk), "PushVarBranch"))) {
+  goofs++;
+  "**FAILURE** of - superinst did not generate superinstructions";
+}
+if (numberof(r)!=30 || anyof(junk([1.5,-2.,3.,0.25], 4) != r)) {
+  goofs++;
+  "**FAILURE** of - superinstruction results differ from ordinary code";
+}
+superinst, i;
+junk= src= i= r= [];
+
+if (do_stats) "S "+print(yorick_stats());
+
+/* ------------------------------------------------------------------------- */
+
+write, "Test sampling profiler...";
+
+func junk1(n) { return sort(random(n))(1); }
+func junk2(secs)
+{
+  local t, s;
+  t= s= array(0., 3);
+  timer, t;
+  do { junk1, 1000; timer, t, s; } while (s(1) < secs);
+}
+func junk3(interval)
+{
+  if (catch(-1)) return 0;
+  profile_start, interval;
+  return 1;
+}
+if (junk3()) {
+  junk2, 0.2;
+  i= profile_stop();
+  r= profile_dump();
+  if (i<1 || !anyof(strmatch(r, " junk1 ")) ||
+      !anyof(strmatch(r, " junk2 ")) ||
+      !anyof(strmatch(r, " sort  -  (built-in)"))) {
+    goofs++;
+    "**FAILURE** of - profile_dump missing expected functions";
+  }
+} else {
+  "WARNING sampling profiler not available on this platform";
+}
+junk1= junk2= junk3= i= r= [];
+
+if (do_stats) "S "+print(yorick_stats());
+
+/* ------------------------------------------------------------------------- */
+
+write, "Test large block pool...";
+
+i= mempool();
+r= array(1.5, 100000);
+r= [];
+r= array(2.5, 100000);
+if (sum(r) != 250000. || mempool()(1) != i(1)+1) {
+  goofs++;
+  "**FAILURE** of - large block not recycled from pool";
+}
+r= [];
+i= mempool();
+mempool, 0;
+if (mempool()(3) || mempool()(4) || mempool()(5)) {
+  goofs++;
+  "**FAILURE** of - mempool, 0 did not release pooled blocks";
+}
+mempool, i(5);
+i= r= [];
+
+if (do_stats) "S "+print(yorick_stats());
+
+/* ------------------------------------------------------------------------- */
+
+write, "Test in-place x+= x-= x*= x/=...";
+
+func junk(x, y)
+{
+  x+= y;  x*= 2.;  x-= 1.;  x/= [5.,7.,3.,11.];
+  return x;
+}
+i= r= array(2., 4);
+eq_nocopy, junk1, r;
+r+= 1.;
+junk2= junk(i, [1.,2.,3.,4.]);
+src= [1,2];
+src+= 0.5;
+if (anyof(i!=2.) || anyof(junk1!=2.) || anyof(r!=3.) ||
+    anyof(junk2!=[1.,1.,3.,1.]) || structof(src)!=double ||
+    anyof(src!=[1.5,2.5])) {
+  goofs++;
+  "**FAILURE** of - in-place compound assignment";
+}
+r+= [[1.,2.],[3.,4.]](-,);
+if (anyof(dimsof(r)!=[3,4,2,2]) || r(4,2,2)!=7.) {
+  goofs++;
+  "**FAILURE** of - broadcasting in compound assignment";
+}
+junk= junk1= junk2= src= i= r= [];
+
+if (do_stats) "S "+print(yorick_stats());
+
+/* ------------------------------------------------------------------------- */
+
 iS= lS= dS= cA= sA= iA= lA= fA= dA= zA= [];
 write, format= "End of Yorick parser test, %d goofs\n", goofs;
 
@@ -0,0 +1,111 @@
+/*
+ * $Id: vmbench.i,v 1.1 2026-10-17 dhmunro Exp $
+ * Micro-benchmarks of the virtual machine on scalar, loop-heavy code.
+ */
+/* Copyright (c) 2005, The Regents of the University of California.
+ * All rights reserved.
+ * This file is part of yorick (http://yorick.sourceforge.net).
+ * Read the accompanying LICENSE file for details.
+ */
+
+func vmbench(n)
+/* DOCUMENT vmbench
+         or vmbench, n
+     Time a few loop-heavy interpreted functions, each compiled twice:
+     once with superinstructions off, once with them on (see superinst).
+     Prints the CPU time for each version and their ratio, and checks
+     that both versions return identical results.  N is the number of
+     loop passes, default 1000000.
+   SEE ALSO: superinst, timer
+ */
+{
+  local old, name, i, t0, t1, r0, r1, ratio;
+  if (is_void(n)) n= 1000000;
+  old= superinst();
+  superinst, 0;
+  include, _vmb_source, 1;
+  t0= _vmb_run(n, r0);
+  superinst, 1;
+  include, _vmb_source, 1;
+  t1= _vmb_run(n, r1);
+  superinst, old;
+  write, format="%-10s %9s %9s %7s\n", "benchmark", "off(s)", "on(s)", "ratio";
+  for (i=1 ; i<=numberof(_vmb_names) ; i++) {
+    ratio= (t1(i)>0.)? t0(i)/t1(i) : 0.;
+    write, format="%-10s %9.3f %9.3f %7.2f%s\n", _vmb_names(i), t0(i), t1(i),
+      ratio, ((r0(i)==r1(i))? "" : "  **RESULTS DIFFER**");
+  }
+}
+
+func _vmb_run(n, &result)
+{
+  local f, t, elapsed, split, i;
+  result= t= array(0.0, numberof(_vmb_names));
+  elapsed= array(0.0, 3);
+  for (i=1 ; i<=numberof(_vmb_names) ; i++) {
+    f= symbol_def("_vmb_"+_vmb_names(i));
+    split= array(0.0, 3);
+    timer, elapsed;
+    result(i)= f(n);
+    timer, elapsed, split;
+    t(i)= split(1);
+  }
+  return t;
+}
+
+_vmb_names= ["count", "sum", "collatz", "index", "mixed"];
+
+/* redefined by vmbench with superinstructions off, then on */
+_vmb_source= [
+"func _vmb_count(n)",
+"{",
+"  local i, k;",
+"  k= 0;",
+"  for (i=1 ; i<=n ; i++) k+= 2;",
+"  return k;",
+"}",
+"func _vmb_sum(n)",
+"{",
+"  local i, s;",
+"  s= 0.0;",
+"  for (i=1 ; i<=n ; ++i) s= s + i*0.5;",
+"  return s;",
+"}",
+"func _vmb_collatz(n)",
+"{",
+"  local i, k, steps;",
+"  steps= 0;",
+"  for (i=1 ; i<=n/20 ; i++) {",
+"    k= i;",
+"    while (k != 1) {",
+"      if (k%2 == 0) k/= 2;",
+"      else k= 3*k + 1;",
+"      steps++;",
+"      if (steps > n) break;",
+"    }",
+"  }",
+"  return steps;",
+"}",
+"func _vmb_index(n)",
+"{",
+"  local i, j, x, s;",
+"  x= span(0., 1., 100);",
+"  s= 0.0;",
+"  for (i=1 ; i<=n ; i++) {",
+"    j= i%100 + 1;",
+"    s= s + x(j)*x(j);",
+"  }",
+"  return s;",
+"}",
+"func _vmb_mixed(n)",
+"{",
+"  local i, a, b, c;",
+"  a= 1;  b= 0.;  c= 0;",
+"  for (i=0 ; i<n ; i++) {",
+"    if (a > 1000) a= a - 999;",
+"    else a= a*3;",
+"    b= b + a - 0.5;",
+"    if (b >= 1.e6) c++;",
+"  }",
+"  return b + c;",
+"}"];
@@ -5296,6 +5296,24 @@ extern yorick_stats;
      For debugging.  See ydata.c source code.
  */
 
+extern mempool;
+/* DOCUMENT stats= mempool()
+            mempool, max_bytes
+     returns statistics for the pool of recycled large memory blocks,
+     after setting the maximum number of bytes it may hold, if given.
+     Freed blocks of more than 4 kB (up to 1 GB), such as the data of
+     temporary arrays, are kept on free lists by size class, so that
+     the next allocation of a similar size reuses them.  Each list holds
+     at most 8 blocks, and all together at most MAX_BYTES (default
+     64 MB); MAX_BYTES=0 releases all held blocks and stops recycling.
+     The statistics are an array of 6 longs:
+       [hits, misses, blocks_held, bytes_held, max_bytes, huge_bytes]
+     where hits and misses count large allocations which did or did not
+     reuse a held block, and huge_bytes is the size of blocks currently
+     backed by huge pages (on platforms which support them).
+   SEE ALSO: yorick_stats
+ */
+
 extern cd;
 /* DOCUMENT cd, directory_name
          or cd(directory_name)
@@ -6165,6 +6183,59 @@ extern disassemble;
      line as a separate main program.
  */
 
+extern superinst;
+/* DOCUMENT superinst, 1
+            superinst, 0
+            superinst()
+     turns on, turns off, or tests for superinstructions, respectively.
+     When superinstructions are on, each function subsequently defined
+     has common sequences of virtual machine instructions -- such as
+     i<=n followed by a branch, k+=2, i++, or x(i) in an expression --
+     replaced by single superinstructions, which run faster when the
+     variables involved are int, long, or double scalars.  Functions
+     defined while superinstructions are off are unaffected.  The
+     results are the same either way.  The disassemble output shows
+     the superinstructions as PushVar... in place of PushVariable.
+
+   SEE ALSO: disassemble
+ */
+
+extern profile_start;
+extern profile_stop;
+extern profile_dump;
+/* DOCUMENT profile_start
+            profile_start, interval
+            nsamples= profile_stop()
+            profile_dump
+            profile_dump, folded_file
+            table= profile_dump(folded_file)
+     sample where the interpreter spends its time.  After profile_start,
+     every INTERVAL seconds (default 0.001) of cpu time, the stack of
+     interpreted functions being executed is recorded, along with the
+     built-in function it has called, if any.  Samples accumulate until
+     profile_stop, which returns their number.  Time spent parsing or
+     waiting for input is not attributed to any function.  Calling
+     profile_start again discards the previous samples.
+
+     profile_dump prints a table of function, source line number, and
+     source file, sorted by decreasing self samples -- those for which
+     that line (or built-in) was innermost -- followed by total samples,
+     those for which that line was on the stack at all.  The line of a
+     built-in function is -, and the lines calling it are listed
+     separately.  Called as a function, profile_dump returns the table
+     as an array of strings instead of printing it.  If FOLDED_FILE is
+     given, profile_dump also writes one line per distinct stack, with
+     the function names from outermost to innermost separated by
+     semicolons, followed by the sample count.  This is the "folded"
+     input format for flame graph generators such as flamegraph.pl.
+
+     Line numbers are found by reparsing the source of each function,
+     like the debugger does after an error; they are 0 if the source
+     file has changed since the function was defined.  Profiling is not
+     available on platforms without a cpu time interval timer (Windows).
+   SEE ALSO: timer, dbwhere, superinst
+ */
+
 /*= SECTION(list) list objects (deprecated, use oxy) =======================*/
 
 extern _lst;
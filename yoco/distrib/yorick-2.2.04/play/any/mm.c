@@ -31,6 +31,13 @@ long p_nfrees = 0;
 long p_nsmall = 0;
 long p_asmall = 0;
 
+long p_mpool = 64L<<20;
+long p_npool = 0;
+long p_apool = 0;
+long p_nphit = 0;
+long p_npmiss = 0;
+long p_ahuge = 0;
+
 p_twkspc p_wkspc;
 
 static void *
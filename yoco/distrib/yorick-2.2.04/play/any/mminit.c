@@ -15,6 +15,11 @@
 #include "config.h"
 #include "pstdlib.h"
 
+#include <string.h>
+#ifdef USE_MADV_HUGEPAGE
+#include <sys/mman.h>
+#endif
+
 typedef union mm_block mm_block;
 typedef struct mm_arena mm_arena;
 
@@ -72,9 +77,41 @@ static mm_arena *arena_list[32] = {
 
 static mm_block *expand_arena(mm_arena *arena);
 
+/* blocks larger than 2^MM_POOL_MIN bytes (including the mm_block header),
+ * up to 2^MM_POOL_MAX bytes, are rounded up to one of four size classes
+ * per power of two, and freed blocks are kept on a free list for their
+ * class, so that temporary arrays of the same size are recycled without
+ * calling malloc and free (or faulting in fresh pages from the system)
+ * -- a pool is an mm_arena whose next_free is the free list, n_blocks is
+ *    the length of the free list, and size is the number of mm_blocks per
+ *    unit, as for the small block arenas
+ * -- the free lists hold at most MM_POOL_DEPTH blocks of any class,
+ *    and at most p_mpool bytes in all (see p_mmpool)
+ * -- with USE_MADV_HUGEPAGE, blocks of MM_HUGE bytes or more are mapped
+ *    directly and marked for huge pages, reducing TLB misses and page
+ *    faults for multi-megabyte arrays
+ * -- like the small block arenas, the free lists and counters are not
+ *    locked, see the restriction to the main thread in pstdlib.h */
+#define MM_POOL_MIN 12
+#define MM_POOL_MAX 30
+#define MM_POOL_DEPTH 8
+#define MM_NPOOLS (4*(MM_POOL_MAX-MM_POOL_MIN))
+#define MM_HUGE ((size_t)1<<21)
+
+static mm_arena pools[MM_NPOOLS];
+
+static mm_arena *pool_of(size_t nbytes);
+static void pool_free(mm_arena *pool, mm_block *block);
+static mm_block *big_alloc(size_t nbytes);
+static void big_free(mm_block *block, size_t nbytes);
+
 void
 p_mminit(void)  /* actually p_mmdebug if P_DEBUG */
 {
+  int i;
+  for (i=0 ; i<MM_NPOOLS ; i++)
+    pools[i].size = ((long)(4+(i&3)+1) << (MM_POOL_MIN+(i>>2)-2))
+      / sizeof(mm_block);
   p_malloc =  &bmalloc;
   p_free =    &bfree;
   p_realloc = &brealloc;
@@ -96,9 +133,25 @@ bmalloc(size_t n)
     block->arena = arena;
     p_nsmall++;
   } else {
-    block = (void *)malloc(MM_EXTRA*sizeof(mm_block)+n);
-    if (!block) return p_mmfail(n);
-    block->arena = 0;
+    mm_arena *pool = pool_of(MM_EXTRA*sizeof(mm_block)+n);
+    if (pool) {
+      block = pool->next_free;
+      if (block) {
+        pool->next_free = block->next_free;
+        pool->n_blocks--;
+        p_npool--;
+        p_apool -= pool->size*sizeof(mm_block);
+        p_nphit++;
+      } else {
+        block = big_alloc(pool->size*sizeof(mm_block));
+        if (!block) return p_mmfail(n);
+        p_npmiss++;
+      }
+    } else {
+      block = (void *)malloc(MM_EXTRA*sizeof(mm_block)+n);
+      if (!block) return p_mmfail(n);
+    }
+    block->arena = pool;
   }
   MM_GUARD(block, n)
   p_nallocs++;
@@ -112,7 +165,9 @@ bfree(void *p)
     mm_block *block = ((mm_block *)p) - MM_OFFSET;
     mm_arena *arena = block->arena;
     MM_VCHECK(p)
-    if (arena) {
+    if (arena>=pools && arena<pools+MM_NPOOLS) {
+      pool_free(arena, block);
+    } else if (arena) {
       block->next_free = arena->next_free;
       arena->next_free = block;
       p_nsmall--;
@@ -146,7 +201,20 @@ brealloc(void *p, size_t n)
     mm_block *block = ((mm_block *)p) - MM_OFFSET;
     mm_arena *arena = block->arena;
     MM_CHECK(p, n<=0? 1 : n)
-    if (arena) {
+    if (arena>=pools && arena<pools+MM_NPOOLS) {
+      void *new_p;
+      size_t old_n = (arena->size-MM_EXTRA)*sizeof(mm_block);
+      if (n<=0) n = 1;
+      if (n <= old_n && n > old_n/2) {
+        MM_GUARD(block, n)
+        return p;
+      }
+      new_p = bmalloc(n);
+      if (!new_p) return p_mmfail(n);
+      memcpy(new_p, p, n<old_n? n : old_n);
+      bfree(p);
+      return new_p;
+    } else if (arena) {
       mm_block *new_block;
       long i, old_n = arena->size-MM_EXTRA;
       if (n <= sizeof(mm_block)*old_n) {
@@ -174,6 +242,94 @@ brealloc(void *p, size_t n)
   }
 }
 
+static mm_arena *
+pool_of(size_t nbytes)
+{
+  int o;
+  size_t q;
+  if (nbytes <= ((size_t)1<<MM_POOL_MIN) || nbytes > ((size_t)1<<MM_POOL_MAX))
+    return 0;
+  /* 2^o < nbytes <= 2^(o+1), classes are multiples of q = 2^(o-2) */
+  for (o=MM_POOL_MIN ; ((size_t)2<<o) < nbytes ; o++);
+  q = (size_t)1 << (o-2);
+  return pools + 4*(o-MM_POOL_MIN) + (int)((nbytes+q-1)/q) - 5;
+}
+
+static void
+pool_free(mm_arena *pool, mm_block *block)
+{
+  size_t nbytes = pool->size*sizeof(mm_block);
+  if (pool->n_blocks < MM_POOL_DEPTH && p_apool+(long)nbytes <= p_mpool) {
+    block->next_free = pool->next_free;
+    pool->next_free = block;
+    pool->n_blocks++;
+    p_npool++;
+    p_apool += nbytes;
+  } else {
+    big_free(block, nbytes);
+  }
+}
+
+long
+p_mmpool(long maxbytes)
+{
+  long old = p_mpool;
+  if (maxbytes >= 0) {
+    int i;
+    p_mpool = maxbytes;
+    /* release largest blocks first */
+    for (i=MM_NPOOLS-1 ; i>=0 && p_apool>p_mpool ; i--) {
+      mm_arena *pool = pools+i;
+      size_t nbytes = pool->size*sizeof(mm_block);
+      mm_block *block;
+      while (p_apool>p_mpool && (block = pool->next_free)) {
+        pool->next_free = block->next_free;
+        pool->n_blocks--;
+        p_npool--;
+        p_apool -= nbytes;
+        big_free(block, nbytes);
+      }
+    }
+  }
+  return old;
+}
+
+static mm_block *
+big_alloc(size_t nbytes)
+{
+#ifdef USE_MADV_HUGEPAGE
+  if (nbytes >= MM_HUGE) {
+    /* map an extra MM_HUGE bytes to align the block with huge pages,
+     * nbytes is a multiple of the page size */
+    char *p = mmap(0, nbytes+MM_HUGE, PROT_READ|PROT_WRITE,
+                   MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    size_t lead;
+    if (p == MAP_FAILED) return 0;
+    lead = (MM_HUGE - ((size_t)(p-(char *)0) & (MM_HUGE-1))) & (MM_HUGE-1);
+    if (lead) munmap(p, lead);
+    munmap(p+lead+nbytes, MM_HUGE-lead);
+    p += lead;
+    madvise(p, nbytes, MADV_HUGEPAGE);
+    p_ahuge += nbytes;
+    return (mm_block *)p;
+  }
+#endif
+  return (void *)malloc(nbytes);
+}
+
+static void
+big_free(mm_block *block, size_t nbytes)
+{
+#ifdef USE_MADV_HUGEPAGE
+  if (nbytes >= MM_HUGE) {
+    munmap((void *)block, nbytes);
+    p_ahuge -= nbytes;
+    return;
+  }
+#endif
+  free(block);
+}
+
 #ifdef P_DEBUG
 /* provide primitive checking for memory overrun and underrun
  * checked on every free or realloc operation, or p_mmcheck can
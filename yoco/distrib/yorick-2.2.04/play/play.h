@@ -66,6 +66,10 @@ typedef unsigned long p_col_t;
 PLUG_API void p_quitter(int (*on_quit)(void));
 PLUG_API void p_stdinit(void (*on_stdin)(char *input_line));
 PLUG_API void p_handler(void (*on_exception)(int signal, char *errmsg));
+/* p_sampler calls on_sample every secs of cpu time until called again
+ * with secs<=0 -- on_sample runs as a signal handler, so it should only
+ * set flags; returns non-zero if no sampling timer on this platform */
+PLUG_API int p_sampler(double secs, void (*on_sample)(void));
 PLUG_API void p_gui(void (*on_expose)(void *c, int *xy),
                     void (*on_destroy)(void *c),
                     void (*on_resize)(void *c,int w,int h),
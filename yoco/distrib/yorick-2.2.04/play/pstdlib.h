@@ -37,6 +37,25 @@ PLUG_API long p_nfrees;
 PLUG_API long p_nsmall;
 PLUG_API long p_asmall;
 
+/* p_mminit recycles large blocks through size class free lists
+ * -- p_mmpool sets p_mpool, the maximum number of bytes held in the
+ *    free lists, releasing blocks as needed, and returns the previous
+ *    value (maxbytes<0 just returns it, maxbytes==0 disables recycling)
+ * -- p_npool and p_apool are the number and bytes of free blocks held,
+ *    p_nphit and p_npmiss count large allocations satisfied from the
+ *    free lists or not, p_ahuge is bytes currently in huge page blocks
+ * -- neither the free lists nor the small block arenas are locked:
+ *    once p_mminit has been called, p_malloc, p_free and p_realloc
+ *    must only be called from the main thread, never from worker
+ *    threads (e.g. inside OpenMP parallel regions) */
+PLUG_API long p_mpool;
+PLUG_API long p_npool;
+PLUG_API long p_apool;
+PLUG_API long p_nphit;
+PLUG_API long p_npmiss;
+PLUG_API long p_ahuge;
+PLUG_API long p_mmpool(long maxbytes);
+
 /* define this to get control when mm functions fail
  * -- if it returns, must return 0 */
 PLUG_API void *(*p_mmfail)(unsigned long n);
@@ -145,6 +145,17 @@ MAIN_DECLARE {
   MAIN_RETURN(0); }
 #endif
 
+#ifdef TEST_HUGEPAGE
+#include <sys/mman.h>
+MAIN_DECLARE {
+  size_t n = 4<<20;
+  void *p = mmap(0, n, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) MAIN_RETURN(1);
+  madvise(p, n, MADV_HUGEPAGE);
+  munmap(p, n);
+  MAIN_RETURN(0); }
+#endif
+
 #ifdef TEST_FENV_H
 #include <fenv.h>
 #include <signal.h>
@@ -360,6 +360,16 @@ else
 fi
 echo "D_USE_SOFTFPE=$softfpe" >>../../Make.cfg
 
+# find out whether large blocks can be backed by huge pages
+args="-DTEST_HUGEPAGE $commonargs"
+if $CC $args >cfg.12 2>&1; then
+  echo "using madvise(MADV_HUGEPAGE) for large blocks"
+  echo "D_MMINIT=-DUSE_MADV_HUGEPAGE" >>../../Make.cfg
+  if test $debug = no; then rm -f cfg.12; fi
+else
+  echo "D_MMINIT=" >>../../Make.cfg
+fi
+
 #----------------------------------------------------------------------
 # try to figure out how dynamic linking for plugins works
 #----------------------------------------------------------------------
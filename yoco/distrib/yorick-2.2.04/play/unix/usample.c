@@ -0,0 +1,57 @@
+/*
+ * $Id: usample.c,v 1.1 2026-10-17 dhmunro Exp $
+ * p_sampler cpu time interval timer for UNIX machines
+ */
+/* Copyright (c) 2005, The Regents of the University of California.
+ * All rights reserved.
+ * This file is part of yorick (http://yorick.sourceforge.net).
+ * Read the accompanying LICENSE file for details.
+ */
+
+#include "config.h"
+#include "play.h"
+
+/* setitimer is BSD, not POSIX 1003.1-1990 */
+#undef _POSIX_SOURCE
+#include <signal.h>
+#include <sys/time.h>
+
+static void (*u_on_sample)(void) = 0;
+static void u_sigprof(int sig);
+
+int
+p_sampler(double secs, void (*on_sample)(void))
+{
+  struct itimerval interval;
+  struct sigaction action;
+  long usec = (secs > 0. && on_sample)? (long)(1.e6*secs + 0.5) : 0;
+  if (secs > 0. && usec < 1) usec = 1;
+
+  if (usec) {
+    u_on_sample = on_sample;
+    action.sa_handler = &u_sigprof;
+    sigemptyset(&action.sa_mask);
+#ifdef SA_RESTART
+    /* do not let a sample interrupt read() or write() */
+    action.sa_flags = SA_RESTART;
+#else
+    action.sa_flags = 0;
+#endif
+    if (sigaction(SIGPROF, &action, 0)) return 1;
+  }
+  interval.it_interval.tv_sec = usec / 1000000;
+  interval.it_interval.tv_usec = usec % 1000000;
+  interval.it_value = interval.it_interval;
+  if (setitimer(ITIMER_PROF, &interval, 0)) usec = -1;
+  if (usec <= 0) {
+    signal(SIGPROF, SIG_IGN);
+    u_on_sample = 0;
+  }
+  return (usec < 0);
+}
+
+static void
+u_sigprof(int sig)
+{
+  if (u_on_sample) u_on_sample();
+}
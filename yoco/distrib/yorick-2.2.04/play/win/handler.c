@@ -146,3 +146,11 @@ w_interrupt(void)
     ResumeThread(w_worker);
   }
 }
+
+int
+p_sampler(double secs, void (*on_sample)(void))
+{
+  /* no cpu time interval timer -- a timer thread cannot safely
+   * interrupt the worker the way SIGPROF does under UNIX */
+  return (secs > 0.);
+}
@@ -25,6 +25,7 @@ extern int YpReCompare(Function *func,
 extern BuiltIn Y_disassemble;
 extern int LookupAction(VMaction *Action);
 extern int StackChange(int meaning, int count);
+extern int ActionLength(VMaction *Action);
 
 /* Better idea:
    Disassemble should not produce text, but rather a "meaning list"
@@ -57,10 +58,16 @@ extern VMaction Address, Negate, Complement, Not, True;
 extern VMaction Power, Multiply, Divide, Modulo, Add, Subtract,
   ShiftL, ShiftR, Less, Greater, LessEQ, GreaterEQ, Equal, NotEqual,
   AndBits, XorBits, OrBits, AndOrLogical;
+extern VMaction AddInPlace, SubtractInPlace, MultiplyInPlace, DivideInPlace;
 extern VMaction Define, Assign, DupUnder, EvalUnder, DropTop;
 extern VMaction BranchFalse, BranchTrue, Branch, Return;
 extern VMaction OpenStruct, DeclareMember, CloseStruct;
 extern VMaction MatrixMult, Build, CallShell, Print, NextArg, MoreArgs;
+extern VMaction Fused;
+extern VMaction PushVarOp, PushVarBranch, PushVarDefine, PushVarIncr,
+  PushVarIndex;
+
+extern VMaction *SuperBase(VMaction *Action);
 
 /* vmMeaning describes a Virtual Machine instruction (type Instruction) */
 struct {
@@ -249,6 +256,28 @@ struct {
       CATEGORY(STACK_INC, PC_INDEX, IS_ALT_FORM) },
   { &MoreArgs, "MoreArgs", "%4ld sp+>%-4d %s",
       CATEGORY(STACK_INC, PC_INDEX, IS_ALT_FORM) },
+  { &Fused, "Fused", "%4ld sp0>%-4d %s to pc= %ld",
+      CATEGORY(STACK_FIXED, PC_DISPLACE, 0) },
+
+  { &AddInPlace, "AddInPlace", "%4ld sp->%-4d %s",
+      CATEGORY(STACK_DEC, PC_UNUSED, 0) },
+  { &SubtractInPlace, "SubtractInPlace", "%4ld sp->%-4d %s",
+      CATEGORY(STACK_DEC, PC_UNUSED, 0) },
+  { &MultiplyInPlace, "MultiplyInPlace", "%4ld sp->%-4d %s",
+      CATEGORY(STACK_DEC, PC_UNUSED, 0) },
+  { &DivideInPlace, "DivideInPlace", "%4ld sp->%-4d %s",
+      CATEGORY(STACK_DEC, PC_UNUSED, 0) },
+
+  { &PushVarOp, "PushVarOp", "%4ld sp+>%-4d %s(%s)",
+      CATEGORY(STACK_INC, PC_INDEX, 0) },
+  { &PushVarBranch, "PushVarBranch", "%4ld sp+>%-4d %s(%s)",
+      CATEGORY(STACK_INC, PC_INDEX, 0) },
+  { &PushVarDefine, "PushVarDefine", "%4ld sp+>%-4d %s(%s)",
+      CATEGORY(STACK_INC, PC_INDEX, 0) },
+  { &PushVarIncr, "PushVarIncr", "%4ld sp+>%-4d %s(%s)",
+      CATEGORY(STACK_INC, PC_INDEX, 0) },
+  { &PushVarIndex, "PushVarIndex", "%4ld sp+>%-4d %s(%s)",
+      CATEGORY(STACK_INC, PC_INDEX, 0) },
 
   { 0, "(illegal action)", "***** ILLEGAL ACTION *****", 0 }
 };
@@ -261,6 +290,15 @@ int LookupAction(VMaction *Action)
   return i;
 }
 
+/* ActionLength returns the number of Instructions occupied by Action and
+   its operand, or 0 if Action is not a virtual machine instruction.  */
+int ActionLength(VMaction *Action)
+{
+  int meaning= LookupAction(Action);
+  if (!vmMeaning[meaning].Action) return 0;
+  return (PC_CATEGORY(vmMeaning[meaning].flags)==PC_UNUSED)? 1 : 2;
+}
+
 static int stackDelta[]= { 0, 1, 2, -1, -3, 0, 1, -2 };
 
 int StackChange(int meaning, int count)
@@ -536,7 +574,9 @@ int YpReCompare(Function *func,
     /* YpFunc puts the frame variables (parameters and locals) at the end
        of the code.  Also, when reparsing, Instruction.constant values were
        filled in relative to func->constantTable.  */
-    for (i=0 ; i<codeSize ; i++) if (fcode[i].Action!=code[i].Action) break;
+    /* superinstructions are never generated when reparsing */
+    for (i=0 ; i<codeSize ; i++)
+      if (SuperBase(fcode[i].Action)!=code[i].Action) break;
     match= (match && i>=codeSize);
     if (match) {
       code+= codeSize;
@@ -74,6 +74,10 @@ extern Instruction *AbortReturn(void);
 extern void YCatchDrop(long isp);        /* in task.c */
 extern long ispCatch;                    /* in task.c */
 
+extern BIFunction *yProfBuiltin;         /* in profile.c */
+extern volatile long yProfTicks;         /* in profile.c */
+extern void YProfSample(BIFunction *bif, long weight);
+
 static void Swap(Symbol *sp, long index);
 static Symbol *ExtractKey(int index);
 
@@ -436,12 +440,22 @@ void EvalBI(Operand *op)
   long stackIndex= stack-spBottom;  /* see comment after function call */
   int n= op->references;         /* interpret misuse in FormEvalOp */
   BIFunction *bif= op->value;
+  BIFunction *caller= yProfBuiltin;
 
   /* Invoke built-in function */
   P_SOFTFPE_TEST;
+  yProfBuiltin= bif;
   bif->function(n);
+  yProfBuiltin= caller;
   P_SOFTFPE_TEST;
 
+  /* Record any profiler samples taken during the call (see profile.c).  */
+  if (yProfTicks && !caller) {
+    long ticks= yProfTicks;
+    yProfTicks= 0;
+    YProfSample(bif, ticks);
+  }
+
   /* Adjust remembered stack to allow for the stack being moved -- this
      can happen in Y_require and Y_include, and there is no other way
      to handle the problem.  The efficiency loss from this instruction
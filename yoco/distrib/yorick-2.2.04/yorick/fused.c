@@ -0,0 +1,746 @@
+/*
+ * $Id: fused.c,v 1.1 2026-10-17 dhmunro Exp $
+ *
+ * Implement the Fused virtual machine instruction, which evaluates a chain
+ * of elementwise arithmetic operations in a single pass over the result.
+ */
+/* Copyright (c) 2005, The Regents of the University of California.
+ * All rights reserved.
+ * This file is part of yorick (http://yorick.sourceforge.net).
+ * Read the accompanying LICENSE file for details.
+ */
+
+#include "ydata.h"
+#include "pstdlib.h"
+#include "play.h"
+#include <string.h>
+
+#include <errno.h>
+
+/* The parser inserts Fused in front of the code of an expression made of
+   the elementwise operations unary -, binary + - * / ^, and the functions
+   sin, cos, tan, exp, log, sqrt, and abs, on operands which are variables,
+   numeric constants, or variables indexed by - and nil (like b(-,)).
+   The instruction is followed by the displacement to the end of that code.
+
+   Fused decodes the code of the expression, finds the values of its
+   operands, and works out the data type and dimensions of each operation
+   by the same rules as the ordinary binary and unary operations.  Provided
+   the result of every operation is float, double, or complex and the
+   operands are conformable, the expression is evaluated in blocks of
+   FUSED_CHUNK elements, keeping the intermediate results in small scratch
+   buffers instead of full temporary arrays.  Operands which must be
+   broadcast are read with a stride of zero rather than copied by
+   Broadcast.  Then Fused branches past the ordinary code.
+
+   Otherwise -- integer arithmetic, non-numeric operands, a redefined sin,
+   a math library error, non-conformable operands -- Fused falls through
+   to the ordinary code, which produces the same value or error message
+   it always has.  */
+
+/* ------------------------------------------------------------------------ */
+
+extern VMaction Fused;
+
+extern VMaction PushChar, PushShort, PushInt, PushLong,
+  PushFloat, PushDouble, PushImaginary, PushVariable, PushNil, FormRangeFlag;
+extern VMaction Eval, Negate, Power, Multiply, Divide, Add, Subtract;
+
+extern VMaction *SuperBase(VMaction *Action);
+
+extern BuiltIn Y_sin, Y_cos, Y_tan, Y_exp, Y_log, Y_sqrt, Y_abs;
+
+/* ANSI standard math.h functions */
+extern double sin(double);
+extern double cos(double);
+extern double tan(double);
+extern double exp(double);
+extern double log(double);
+extern double sqrt(double);
+extern double pow(double, double);
+extern double hypot(double, double);
+
+/* complex and integer power equivalents are defined in nonc.c */
+extern double powDL(double, long);
+extern void powZL(double *, double *, long);
+extern void powZZ(double *, double *, double *);
+extern void sinZ(double z[2], double x[2]);
+extern void cosZ(double z[2], double x[2]);
+extern void tanZ(double z[2], double x[2]);
+extern void expZ(double z[2], double x[2]);
+extern void logZ(double z[2], double x[2]);
+extern void sqrtZ(double z[2], double x[2]);
+
+/* ------------------------------------------------------------------------ */
+
+#define FUSED_NODES 64   /* maximum number of operands and operations */
+#define FUSED_DEPTH 16   /* maximum number of pending intermediate results */
+#define FUSED_RANK 10    /* maximum number of dimensions */
+#define FUSED_CHUNK 256  /* number of elements evaluated at once */
+
+/* operations (F_LEAF is an operand) */
+#define F_LEAF 0
+#define F_ADD 1
+#define F_SUB 2
+#define F_MUL 3
+#define F_DIV 4
+#define F_POW 5    /* real or complex exponent */
+#define F_POWL 6   /* integer exponent */
+#define F_NEG 7
+#define F_SIN 8
+#define F_COS 9
+#define F_TAN 10
+#define F_EXP 11
+#define F_LOG 12
+#define F_SQRT 13
+#define F_ABS 14
+
+/* T_LONG is also used for integer exponents */
+static long typeSize[]= { sizeof(char), sizeof(short), sizeof(int),
+                          sizeof(long), sizeof(float), sizeof(double),
+                          2*sizeof(double) };
+
+typedef struct FusedNode FusedNode;
+struct FusedNode {
+  int op;         /* F_LEAF, F_ADD, ... */
+  int type;       /* data type of result (any numeric type for an operand) */
+  int need;       /* data type required by parent operation */
+  int indexed;    /* operand already indexed by - and nil */
+  int level;      /* index of its scratch buffer */
+  int rank;       /* number of dimensions */
+  long dims[FUSED_RANK];     /* dimension lengths, fastest first */
+  /* operands only: */
+  char *data;                /* address of first element */
+  long stride[FUSED_RANK];   /* element stride of each dimension */
+  union {
+    unsigned char c;
+    short s;
+    int i;
+    long l;
+    float f;
+    double d[2];
+  } value;                   /* constant operand */
+};
+
+static FusedNode nodes[FUSED_NODES];
+static int nNodes;
+
+static double scratch[FUSED_DEPTH][2*FUSED_CHUNK];
+static void *reg[FUSED_DEPTH];   /* current data for each level */
+
+static int FusedDecode(Instruction *code, Instruction *end);
+static int FusedAnalyze(void);
+static int FusedLeaf(FusedNode *node, Symbol *s);
+static int FusedChunk(long n, long *offset);
+static void FusedConvert(void *dst, int dtype, void *src, int stype,
+                         long n, int inc);
+static void FusedWiden(void *buf, int dtype, int stype, long n);
+
+/* ------------------------------------------------------------------------ */
+
+void Fused(void)
+{
+  Instruction *end= pc + pc->displace;
+  long dims[FUSED_RANK], strides[FUSED_NODES][FUSED_RANK];
+  long index[FUSED_RANK], offset[FUSED_NODES];
+  long i, j, k, n, number, rank, done;
+  FusedNode *root;
+  Array *result;
+  char *dst;
+  double scalar[2];
+
+  if (!FusedDecode(pc+1, end) || !FusedAnalyze()) {
+    pc++;
+    return;
+  }
+  root= &nodes[nNodes-1];
+
+  /* loop over result dimensions, merging adjacent dimensions wherever
+     every operand is either contiguous or broadcast across both */
+  rank= 0;
+  number= 1;
+  for (k=0 ; k<root->rank ; k++) {
+    long len= root->dims[k];
+    number*= len;
+    if (len==1) continue;
+    for (j=0 ; j<nNodes ; j++) {
+      FusedNode *node= &nodes[j];
+      if (node->op!=F_LEAF) continue;
+      strides[j][rank]=
+        (k<node->rank && node->dims[k]==len)? node->stride[k] : 0;
+    }
+    if (rank>0) {
+      for (j=0 ; j<nNodes ; j++) {
+        if (nodes[j].op!=F_LEAF) continue;
+        if (strides[j][rank]!=strides[j][rank-1]*dims[rank-1]) break;
+      }
+      if (j>=nNodes) {
+        dims[rank-1]*= len;
+        continue;
+      }
+    }
+    dims[rank++]= len;
+  }
+  if (rank==0) {
+    dims[rank]= 1;
+    for (j=0 ; j<nNodes ; j++) strides[j][rank]= 0;
+    rank= 1;
+  }
+
+  if (root->rank==0 && root->type==T_DOUBLE) {
+    result= 0;
+    dst= (char *)scalar;
+  } else {
+    StructDef *base= (root->type==T_FLOAT? &floatStruct :
+                      (root->type==T_DOUBLE? &doubleStruct : &complexStruct));
+    Dimension *tmp= tmpDims;
+    tmpDims= 0;
+    FreeDimension(tmp);
+    for (k=0 ; k<root->rank ; k++)
+      tmpDims= NewDimension(root->dims[k], 1L, tmpDims);
+    result= PushDataBlock(NewArray(base, tmpDims));
+    dst= result->value.c;
+  }
+
+  /* dimension 0 is evaluated in chunks, the others by odometer */
+  for (j=0 ; j<nNodes ; j++)
+    if (nodes[j].op==F_LEAF) nodes[j].stride[0]= strides[j][0];  /* 0 or 1 */
+  errno= 0;
+  for (k=0 ; k<rank ; k++) index[k]= 0;
+  for (done=0 ; done<number ; ) {
+    for (j=0 ; j<nNodes ; j++) {
+      if (nodes[j].op!=F_LEAF) continue;
+      offset[j]= 0;
+      for (k=1 ; k<rank ; k++) offset[j]+= index[k]*strides[j][k];
+    }
+    for (i=0 ; i<dims[0] ; i+=n) {
+      n= dims[0]-i;
+      if (n>FUSED_CHUNK) n= FUSED_CHUNK;
+      if (!FusedChunk(n, offset)) {
+        if (result) Drop(1);
+        pc++;
+        return;
+      }
+      memcpy(dst, reg[0], n*typeSize[root->type]);
+      dst+= n*typeSize[root->type];
+      done+= n;
+      for (j=0 ; j<nNodes ; j++)
+        if (nodes[j].op==F_LEAF) offset[j]+= n*strides[j][0];
+    }
+    for (k=1 ; k<rank ; k++) {
+      if (++index[k]<dims[k]) break;
+      index[k]= 0;
+    }
+  }
+
+  if (!result) PushDoubleValue(scalar[0]);
+  P_SOFTFPE_TEST;
+  pc= end;
+}
+
+/* ------------------------------------------------------------------------ */
+
+/* FusedDecode builds the list of operands and operations in postfix order
+   from the code, returning 0 if anything is not suitable.  */
+static int FusedDecode(Instruction *code, Instruction *end)
+{
+  /* stack items: node index, or -1 nil, -2 pseudo-index, or function */
+  int item[FUSED_NODES];
+  int depth= 0, nArrays= 0;
+  VMaction *Action;
+  FusedNode *node;
+  Symbol *cnst;
+  int i, n;
+
+  nNodes= 0;
+  while (code<end) {
+    Action= (code++)->Action;
+    if (Action==&Fused) {
+      code++;
+      continue;
+    }
+    if (nNodes>=FUSED_NODES || depth>=FUSED_NODES) return 0;
+    node= &nodes[nNodes];
+    node->op= F_LEAF;
+    node->rank= 0;
+    node->indexed= 0;
+    if (Action==&PushVariable || SuperBase(Action)==&PushVariable) {
+      Symbol *s= &globTab[(code++)->index];
+      if (s->ops==&dataBlockSym && s->value.db->ops==&builtinOps) {
+        BuiltIn *f= ((BIFunction *)s->value.db)->function;
+        if (f==&Y_sin) i= F_SIN;
+        else if (f==&Y_cos) i= F_COS;
+        else if (f==&Y_tan) i= F_TAN;
+        else if (f==&Y_exp) i= F_EXP;
+        else if (f==&Y_log) i= F_LOG;
+        else if (f==&Y_sqrt) i= F_SQRT;
+        else if (f==&Y_abs) i= F_ABS;
+        else return 0;
+        item[depth++]= FUSED_NODES+i;
+        continue;
+      }
+      if (!FusedLeaf(node, s)) return 0;
+      if (s->ops==&dataBlockSym) nArrays++;
+    } else if (Action==&PushNil) {
+      item[depth++]= -1;
+      continue;
+    } else if (Action==&FormRangeFlag) {
+      if ((code++)->count!=R_PSEUDO) return 0;
+      item[depth++]= -2;
+      continue;
+    } else if (Action==&PushDouble || Action==&PushImaginary ||
+               Action==&PushFloat) {
+      cnst= (code++)->constant;
+      node->data= (char *)&node->value;
+      if (Action==&PushFloat) {
+        node->type= T_FLOAT;
+        node->value.f= (float)cnst->value.d;
+      } else if (Action==&PushDouble) {
+        node->type= T_DOUBLE;
+        node->value.d[0]= cnst->value.d;
+      } else {
+        node->type= T_COMPLEX;
+        node->value.d[0]= 0.0;
+        node->value.d[1]= cnst->value.d;
+      }
+    } else if (Action==&PushLong || Action==&PushInt ||
+               Action==&PushShort || Action==&PushChar) {
+      cnst= (code++)->constant;
+      node->data= (char *)&node->value;
+      if (Action==&PushLong) {
+        node->type= T_LONG;
+        node->value.l= cnst->value.l;
+      } else if (Action==&PushInt) {
+        node->type= T_INT;
+        node->value.i= (int)cnst->value.l;
+      } else if (Action==&PushShort) {
+        node->type= T_SHORT;
+        node->value.s= (short)cnst->value.l;
+      } else {
+        node->type= T_CHAR;
+        node->value.c= (unsigned char)cnst->value.l;
+      }
+    } else if (Action==&Eval) {
+      n= (code++)->count;
+      if (n<1 || depth<n+1) return 0;
+      depth-= n;
+      i= item[depth-1];
+      if (i>=FUSED_NODES) {
+        /* math function of a single argument */
+        if (n!=1 || item[depth]<0 || item[depth]>=FUSED_NODES) return 0;
+        node->op= i-FUSED_NODES;
+      } else if (i==nNodes-1 && nodes[i].op==F_LEAF && !nodes[i].indexed &&
+                 nodes[i].data!=(char *)&nodes[i].value) {
+        /* variable indexed by - and nil only */
+        FusedNode *leaf= &nodes[i];
+        long dims[FUSED_RANK], stride[FUSED_RANK];
+        int k, r= 0;
+        if (n>FUSED_RANK) return 0;
+        for (k=0 ; k<n ; k++) {
+          if (item[depth+k]==-1) {
+            if (r>=leaf->rank) return 0;
+            dims[k]= leaf->dims[r];
+            stride[k]= leaf->stride[r++];
+          } else if (item[depth+k]==-2) {
+            dims[k]= 1;
+            stride[k]= 0;
+          } else {
+            return 0;
+          }
+        }
+        if (r!=leaf->rank) return 0;
+        leaf->rank= n;
+        for (k=0 ; k<n ; k++) {
+          leaf->dims[k]= dims[k];
+          leaf->stride[k]= stride[k];
+        }
+        leaf->indexed= 1;
+        continue;
+      } else {
+        return 0;
+      }
+      depth--;
+    } else if (Action==&Negate) {
+      if (depth<1 || item[depth-1]<0 || item[depth-1]>=FUSED_NODES) return 0;
+      node->op= F_NEG;
+      depth--;
+    } else {
+      if (Action==&Add) node->op= F_ADD;
+      else if (Action==&Subtract) node->op= F_SUB;
+      else if (Action==&Multiply) node->op= F_MUL;
+      else if (Action==&Divide) node->op= F_DIV;
+      else if (Action==&Power) node->op= F_POW;
+      else return 0;
+      if (depth<2) return 0;
+      for (i=1 ; i<=2 ; i++)
+        if (item[depth-i]<0 || item[depth-i]>=FUSED_NODES) return 0;
+      depth-= 2;
+    }
+    item[depth++]= nNodes++;
+  }
+  /* nothing to gain unless there is at least one array operand */
+  return (nArrays && depth==1 && nNodes>1 && item[0]==nNodes-1);
+}
+
+/* FusedLeaf fills in an operand node for the value of variable s.  */
+static int FusedLeaf(FusedNode *node, Symbol *s)
+{
+  Array *array;
+  Dimension *dims;
+  long stride;
+  int k;
+  if (s->ops==&doubleScalar) {
+    node->type= T_DOUBLE;
+    node->data= (char *)&s->value.d;
+  } else if (s->ops==&longScalar) {
+    node->type= T_LONG;
+    node->data= (char *)&s->value.l;
+  } else if (s->ops==&intScalar) {
+    node->type= T_INT;
+    node->data= (char *)&s->value.i;
+  } else if (s->ops==&dataBlockSym) {
+    array= (Array *)s->value.db;
+    if (array->ops==&charOps && array->type.base==&charStruct)
+      node->type= T_CHAR;
+    else if (array->ops==&shortOps && array->type.base==&shortStruct)
+      node->type= T_SHORT;
+    else if (array->ops==&intOps && array->type.base==&intStruct)
+      node->type= T_INT;
+    else if (array->ops==&longOps && array->type.base==&longStruct)
+      node->type= T_LONG;
+    else if (array->ops==&floatOps && array->type.base==&floatStruct)
+      node->type= T_FLOAT;
+    else if (array->ops==&doubleOps && array->type.base==&doubleStruct)
+      node->type= T_DOUBLE;
+    else if (array->ops==&complexOps && array->type.base==&complexStruct)
+      node->type= T_COMPLEX;
+    else
+      return 0;
+    node->data= array->value.c;
+    /* dimension list goes from slowest to fastest */
+    node->rank= CountDims(array->type.dims);
+    if (node->rank>FUSED_RANK) return 0;
+    k= node->rank;
+    for (dims=array->type.dims ; dims ; dims=dims->next) {
+      if (dims->origin!=1L) return 0;
+      node->dims[--k]= dims->number;
+    }
+    for (k=0,stride=1 ; k<node->rank ; k++) {
+      node->stride[k]= stride;
+      stride*= node->dims[k];
+    }
+  } else {
+    return 0;
+  }
+  return 1;
+}
+
+/* ------------------------------------------------------------------------ */
+
+/* FusedAnalyze works out the data type and dimensions of each operation,
+   returning 0 if integer arithmetic is involved or if the operands are not
+   conformable.  */
+static int FusedAnalyze(void)
+{
+  int stack[FUSED_NODES];
+  int depth= 0;
+  int j, k;
+  FusedNode *node, *l, *r;
+
+  for (j=0 ; j<nNodes ; j++) {
+    node= &nodes[j];
+    if (node->op==F_LEAF) {
+      if (depth>=FUSED_DEPTH) return 0;
+      node->level= depth;
+      stack[depth++]= j;
+      continue;
+    }
+
+    if (node->op>=F_NEG) {
+      /* unary operation */
+      l= &nodes[stack[depth-1]];
+      if (node->op==F_NEG || node->op==F_ABS) {
+        if (l->type<T_FLOAT) return 0;
+        l->need= l->type;
+        node->type= (node->op==F_ABS && l->type==T_COMPLEX)?
+          T_DOUBLE : l->type;
+      } else {
+        /* math functions convert integer and float arguments to double */
+        l->need= (l->type==T_COMPLEX)? T_COMPLEX : T_DOUBLE;
+        node->type= l->need;
+      }
+      node->rank= l->rank;
+      for (k=0 ; k<l->rank ; k++) node->dims[k]= l->dims[k];
+      node->level= depth-1;
+      stack[depth-1]= j;
+      continue;
+    }
+
+    /* binary operation */
+    l= &nodes[stack[depth-2]];
+    r= &nodes[stack[depth-1]];
+    if (node->op==F_POW && r->type<T_FLOAT) {
+      /* raising to integer power does not change type of left operand */
+      if (l->type<T_FLOAT) return 0;
+      node->op= F_POWL;
+      node->type= l->need= l->type;
+      r->need= T_LONG;
+    } else {
+      node->type= (l->type>r->type)? l->type : r->type;
+      if (node->type<T_FLOAT) return 0;
+      l->need= r->need= node->type;
+    }
+    node->rank= (l->rank>r->rank)? l->rank : r->rank;
+    for (k=0 ; k<node->rank ; k++) {
+      long ln= (k<l->rank)? l->dims[k] : 1;
+      long rn= (k<r->rank)? r->dims[k] : 1;
+      if (ln!=rn && ln!=1 && rn!=1) return 0;
+      node->dims[k]= (ln==1)? rn : ln;
+    }
+    node->level= depth-2;
+    stack[(--depth)-1]= j;
+  }
+  if (depth!=1) return 0;
+  nodes[nNodes-1].need= nodes[nNodes-1].type;
+  return 1;
+}
+
+/* ------------------------------------------------------------------------ */
+
+#define BINARY_OP(OP) \
+  if (type==T_FLOAT) { \
+    float *d= dst, *a= lv, *b= rv; \
+    for (i=0 ; i<n ; i++) d[i]= a[i] OP b[i]; \
+  } else if (type==T_DOUBLE) { \
+    double *d= dst, *a= lv, *b= rv; \
+    for (i=0 ; i<n ; i++) d[i]= a[i] OP b[i]; \
+  } else { \
+    double *d= dst, *a= lv, *b= rv; \
+    for (i=0 ; i<2*n ; i++) d[i]= a[i] OP b[i]; \
+  }
+
+#define MATH_OP(FUNC, FUNCZ, CHECK) \
+  if (type==T_DOUBLE) { \
+    double *d= dst, *a= lv; \
+    for (i=0 ; i<n ; i++) { d[i]= FUNC(a[i]); CHECK } \
+  } else { \
+    double *d= dst, *a= lv; \
+    for (i=0 ; i<2*n && !errno ; i+=2) FUNCZ(&d[i], &a[i]); \
+  }
+
+/* FusedChunk evaluates n elements of the expression, starting at the given
+   offsets of the operands, leaving the result in reg[0].  It returns 0 if
+   a math library function signals an error.  */
+static int FusedChunk(long n, long *offset)
+{
+  FusedNode *node;
+  void *dst, *lv, *rv;
+  int j, type;
+  long i;
+
+  for (j=0 ; j<nNodes ; j++) {
+    node= &nodes[j];
+    dst= scratch[node->level];
+    type= node->type;
+
+    if (node->op==F_LEAF) {
+      char *src= node->data + typeSize[type]*offset[j];
+      if (node->stride[0] && type==node->need) {
+        reg[node->level]= src;
+      } else {
+        FusedConvert(dst, node->need, src, type, n, node->stride[0]!=0);
+        reg[node->level]= dst;
+      }
+      continue;
+    }
+
+    lv= reg[node->level];
+    rv= (node->op<F_NEG)? reg[node->level+1] : 0;
+    switch (node->op) {
+    case F_ADD:
+      BINARY_OP(+)
+      break;
+    case F_SUB:
+      BINARY_OP(-)
+      break;
+    case F_MUL:
+      if (type!=T_COMPLEX) {
+        BINARY_OP(*)
+      } else {
+        double *d= dst, *a= lv, *b= rv;
+        double lr, li, rr, ri;  /* watch out for d==a */
+        for (i=0 ; i<n ; i++) {
+          lr= a[2*i];  li= a[2*i+1];
+          rr= b[2*i];  ri= b[2*i+1];
+          d[2*i]= lr*rr-li*ri;  d[2*i+1]= lr*ri+li*rr;
+        }
+      }
+      break;
+    case F_DIV:
+      if (type!=T_COMPLEX) {
+        BINARY_OP(/)
+      } else {
+        double *d= dst, *a= lv, *b= rv;
+        double lr, li, rr, ri;  /* watch out for d==a */
+        for (i=0 ; i<n ; i++) {
+          lr = a[2*i];  li = a[2*i+1];
+          rr = b[2*i];  ri = b[2*i+1];
+          if ((rr>0?rr:-rr)>(ri>0?ri:-ri)) { /* be careful about overflow... */
+            ri/=rr; rr=1.0/((1.0+ri*ri)*rr);
+            d[2*i] = (lr+li*ri)*rr;
+            d[2*i+1] = (li-lr*ri)*rr;
+          } else {
+            rr/=ri; ri=1.0/((1.0+rr*rr)*ri);
+            d[2*i] = (lr*rr+li)*ri;
+            d[2*i+1] = (li*rr-lr)*ri;
+          }
+        }
+      }
+      break;
+    case F_POWL:
+      if (type==T_FLOAT) {
+        float *d= dst, *a= lv;  long *b= rv;
+        for (i=0 ; i<n ; i++) d[i]= (float)powDL(a[i], b[i]);
+      } else if (type==T_DOUBLE) {
+        double *d= dst, *a= lv;  long *b= rv;
+        for (i=0 ; i<n ; i++) d[i]= powDL(a[i], b[i]);
+      } else {
+        double *d= dst, *a= lv;  long *b= rv;
+        for (i=0 ; i<n ; i++) powZL(&d[2*i], &a[2*i], b[i]);
+      }
+      break;
+    case F_POW:
+      if (type==T_FLOAT) {
+        float *d= dst, *a= lv, *b= rv;
+        for (i=0 ; i<n ; i++) { d[i]= (float)pow(a[i], b[i]);
+          if (errno) { if (errno==ERANGE && !d[i]) errno=0; else break; }}
+      } else if (type==T_DOUBLE) {
+        double *d= dst, *a= lv, *b= rv;
+        for (i=0 ; i<n ; i++) { d[i]= pow(a[i], b[i]);
+          if (errno) { if (errno==ERANGE && !d[i]) errno=0; else break; }}
+      } else {
+        double *d= dst, *a= lv, *b= rv;
+        for (i=0 ; i<2*n && !errno ; i+=2) powZZ(&d[i], &a[i], &b[i]);
+      }
+      break;
+    case F_NEG:
+      if (type==T_FLOAT) {
+        float *d= dst, *a= lv;
+        for (i=0 ; i<n ; i++) d[i]= -a[i];
+      } else {
+        double *d= dst, *a= lv;
+        long m= (type==T_COMPLEX)? 2*n : n;
+        for (i=0 ; i<m ; i++) d[i]= -a[i];
+      }
+      break;
+    case F_SIN:
+      MATH_OP(sin, sinZ, ;)
+      break;
+    case F_COS:
+      MATH_OP(cos, cosZ, ;)
+      break;
+    case F_TAN:
+      MATH_OP(tan, tanZ, ;)
+      break;
+    case F_EXP:
+      MATH_OP(exp, expZ,
+              if (errno) { if (errno==ERANGE && !d[i]) errno=0; else break; })
+      break;
+    case F_LOG:
+      MATH_OP(log, logZ, if (errno) break;)
+      break;
+    case F_SQRT:
+      MATH_OP(sqrt, sqrtZ, if (errno) break;)
+      break;
+    case F_ABS:
+      if (nodes[j-1].need==T_FLOAT) {
+        float *d= dst, *a= lv;
+        for (i=0 ; i<n ; i++) d[i]= a[i]<0? -a[i] : a[i];
+      } else if (nodes[j-1].need==T_DOUBLE) {
+        double *d= dst, *a= lv;
+        for (i=0 ; i<n ; i++) d[i]= a[i]<0? -a[i] : a[i];
+      } else {
+        double *d= dst, *a= lv;  /* d[i] precedes a[2*i] */
+        for (i=0 ; i<n ; i++) d[i]= hypot(a[2*i], a[2*i+1]);
+      }
+      break;
+    }
+    if (errno) return 0;
+
+    if (node->need!=type) FusedWiden(dst, node->need, type, n);
+    reg[node->level]= dst;
+  }
+  return 1;
+}
+
+/* ------------------------------------------------------------------------ */
+
+#define CONVERT(dtype, stype) \
+  { dtype *d= dst;  stype *s= src; \
+    if (inc) for (i=0 ; i<n ; i++) d[i]= (dtype)s[i]; \
+    else { dtype v= (dtype)s[0];  for (i=0 ; i<n ; i++) d[i]= v; } }
+
+#define CONVERT_Z(stype) \
+  { double *d= dst;  stype *s= src; \
+    if (inc) for (i=0 ; i<n ; i++) { d[2*i]= (double)s[i];  d[2*i+1]= 0.0; } \
+    else { double v= (double)s[0]; \
+      for (i=0 ; i<n ; i++) { d[2*i]= v;  d[2*i+1]= 0.0; } } }
+
+#define CONVERT_FROM(MACRO, dtype) \
+  switch (stype) { \
+  case T_CHAR: MACRO(dtype, unsigned char) break; \
+  case T_SHORT: MACRO(dtype, short) break; \
+  case T_INT: MACRO(dtype, int) break; \
+  case T_LONG: MACRO(dtype, long) break; \
+  case T_FLOAT: MACRO(dtype, float) break; \
+  case T_DOUBLE: MACRO(dtype, double) break; \
+  }
+
+#define CONVERT_ZFROM(dummy, stype) CONVERT_Z(stype)
+
+/* FusedConvert copies n elements of an operand into a scratch buffer,
+   converting them from stype to dtype, or broadcasts its first element
+   if inc is 0.  */
+static void FusedConvert(void *dst, int dtype, void *src, int stype,
+                         long n, int inc)
+{
+  long i;
+  if (dtype==T_LONG) {
+    CONVERT_FROM(CONVERT, long)
+  } else if (dtype==T_FLOAT) {
+    CONVERT_FROM(CONVERT, float)
+  } else if (dtype==T_DOUBLE) {
+    CONVERT_FROM(CONVERT, double)
+  } else if (stype!=T_COMPLEX) {
+    CONVERT_FROM(CONVERT_ZFROM, double)
+  } else {
+    double *d= dst, *s= src;
+    if (inc) {
+      memcpy(d, s, 2*n*sizeof(double));
+    } else {
+      for (i=0 ; i<n ; i++) { d[2*i]= s[0];  d[2*i+1]= s[1]; }
+    }
+  }
+}
+
+/* FusedWiden converts an intermediate result in place, from float to double
+   or complex, or from double to complex.  The loops run backwards since the
+   result elements are larger than the originals.  */
+static void FusedWiden(void *buf, int dtype, int stype, long n)
+{
+  long i;
+  if (stype==T_FLOAT) {
+    float *s= buf;
+    double *d= buf;
+    if (dtype==T_DOUBLE) {
+      for (i=n-1 ; i>=0 ; i--) d[i]= (double)s[i];
+    } else {
+      for (i=n-1 ; i>=0 ; i--) { d[2*i]= (double)s[i];  d[2*i+1]= 0.0; }
+    }
+  } else {
+    double *d= buf;
+    for (i=n-1 ; i>=0 ; i--) { d[2*i]= d[i];  d[2*i+1]= 0.0; }
+  }
+}
+
+/* ------------------------------------------------------------------------ */
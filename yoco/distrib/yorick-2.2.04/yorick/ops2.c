@@ -4,6 +4,7 @@
  *
  *  Add +   Subtract -   Multiply *   Divide /   Modulo %   Power ^
  *  Greater >   Less <   GreaterEQ >=   LessEQ <=   Equal ==   NotEqual !=
+ *  AddInPlace +=   SubtractInPlace -=   MultiplyInPlace *=   DivideInPlace /=
  */
 /* Copyright (c) 2005, The Regents of the University of California.
  * All rights reserved.
@@ -1314,3 +1315,52 @@ void NotEqualX(Operand *l, Operand *r)
 }
 
 /*--------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------*/
+/* AddInPlace, SubtractInPlace, MultiplyInPlace, DivideInPlace */
+
+/* The parser compiles "x+= expr" for a variable x as
+     PushVariable(x)  expr  AddInPlace  Define(x)
+   (see YpIncrement), and similarly for -=, *=, and /=.  When the only
+   references to the numeric array x are x itself and the copy on the
+   stack, the value of x is about to be discarded by the Define, so the
+   left operand can be treated as a temporary, and BuildResult2 writes
+   the result into it rather than into a new array.  If promotion or
+   broadcasting changes the type or shape of x, a new array is made as
+   before.  */
+
+extern VMaction AddInPlace, SubtractInPlace, MultiplyInPlace,
+  DivideInPlace, Define;
+
+static int InPlace(void);
+
+static int InPlace(void)
+{
+  Symbol *glob;
+  DataBlock *db;
+  /* pc is at the Define which follows the operation */
+  if ((sp-1)->ops!=&dataBlockSym || pc->Action!=&Define) return 0;
+  glob= &globTab[pc[1].index];
+  db= (sp-1)->value.db;
+  if (glob->ops!=&dataBlockSym || glob->value.db!=db ||
+      db->references!=1 || !db->ops->isArray ||
+      db->ops->typeID>T_COMPLEX) return 0;
+  FormOperandDB(sp-1, &lop);
+  lop.references= 0;
+  sp->ops->FormOperand(sp, &rop);
+  return 1;
+}
+
+void AddInPlace(void)
+{ if (InPlace()) Add_BB(&lop, &rop); else Add(); }
+
+void SubtractInPlace(void)
+{ if (InPlace()) Subtract_BB(&lop, &rop); else Subtract(); }
+
+void MultiplyInPlace(void)
+{ if (InPlace()) Multiply_BB(&lop, &rop); else Multiply(); }
+
+void DivideInPlace(void)
+{ if (InPlace()) Divide_BB(&lop, &rop); else Divide(); }
+
+/*--------------------------------------------------------------------------*/
@@ -38,10 +38,15 @@ extern VMaction Address, Negate, Complement, Not, True;
 extern VMaction Power, Multiply, Divide, Modulo, Add, Subtract,
   ShiftL, ShiftR, Less, Greater, LessEQ, GreaterEQ, Equal, NotEqual,
   AndBits, XorBits, OrBits, AndOrLogical;
+extern VMaction AddInPlace, SubtractInPlace, MultiplyInPlace, DivideInPlace;
 extern VMaction Define, Assign, DupUnder, EvalUnder, DropTop;
 extern VMaction BranchFalse, BranchTrue, Branch, Return;
 extern VMaction OpenStruct, DeclareMember, CloseStruct;
 extern VMaction MatrixMult, Build, CallShell, Print, NextArg, MoreArgs;
+extern VMaction Fused;
+
+extern int ySuperinst;
+extern void SuperCode(Instruction *code);
 
 /* ------------------------------------------------------------------------ */
 
@@ -124,6 +129,14 @@ static Instruction *incCode= 0;
 static long incCodeSize= 0;
 static long nextInc= 0;
 
+/* Elementwise arithmetic on variables and constants is fused into a single
+   pass over the result by the Fused instruction (see fused.c), inserted
+   in front of the ordinary code of the expression.  Inserting it moves the
+   code of the expression, whose variable and constant references are all
+   beyond the fuseVariable and fuseConstant marks -- references before the
+   marks may belong to a for-increment block moved aside by YpEndInc.  */
+static long fuseVariable, fuseConstant;
+
 static int loopDepth;   /* required to distinguish break/continue targets */
 
 typedef struct BreakStack BreakStack;
@@ -186,6 +199,9 @@ static void WillPopStack(long n);
 
 static void PushMarkStack(int pushing);
 
+static long CountFusedOps(long start);
+static void FuseCode(long start);
+
 static void ClearParser(void *func);
 
 /* ------------------------------------------------------------------------ */
@@ -226,6 +242,7 @@ static void ClearParser(void *func)
   wasUndecided= 0;
 
   nVariableRefs= nConstantRefs= nGotoTargets= 0;
+  fuseVariable= fuseConstant= 0;
   if (maxVariableRefs > 256L) maxVariableRefs= 0;  /* force realloc */
   if (maxConstantRefs > 256L) maxConstantRefs= 0;  /* force realloc */
   if (maxGotoTargets > 256L) maxGotoTargets= 0;  /* force realloc */
@@ -700,6 +717,7 @@ CodeBlock YpEval(CodeBlock obj, int nArgs)
     }
   }
   stackDepth-= delta;   /* in lieu of WillPopStack */
+  if (previousOp==&Eval) FuseCode(obj);
   return obj;
 }
 
@@ -810,6 +828,7 @@ CodeBlock YpUnop(int which, CodeBlock op)
     } else {
       if (CheckCodeSpace(1)) return op;
       vmCode[nextPC++].Action= previousOp= Unaries[which];
+      if (which==3) FuseCode(op);
     }
     return op;
 
@@ -840,6 +859,7 @@ CodeBlock YpBinop(CodeBlock lop, int which)
   if (CheckCodeSpace(1)) return lop;
   vmCode[nextPC++].Action= previousOp= Binaries[which];
   WillPopStack(1L);
+  if (which<6 && which!=3) FuseCode(lop);
   return lop;
 }
 
@@ -852,6 +872,7 @@ CodeBlock YpMultop(CodeBlock lop)
       matrixMarkers[nMatrixMarkers-1].stackDepth<stackDepth-1) {
     vmCode[nextPC++].Action= previousOp= &Multiply;
     WillPopStack(1L);
+    FuseCode(lop);
 
   } else {
     /* top two matrixMarkers must be at stackDepth and stackDepth-2
@@ -954,14 +975,21 @@ CodeBlock YpAssign(CBorLit lhs, CodeBlock rhs)
 /* Map from assop into Binaries array */
 static int assopMap[]= { 4, 5, 1, 2, 3, 6, 7, 14, 15, 16 };
 
+/* variants of the first four which may overwrite the variable (see ops2.c) */
+static VMaction *InPlaces[]= { &AddInPlace, &SubtractInPlace,
+                               &MultiplyInPlace, &DivideInPlace };
+
 CodeBlock YpIncrement(CodeBlock lhs, int assop, CodeBlock rhs)
 {
   /* assop is 0-9:
      += -= *= /= %= <<= >>= &= ~= |=   */
   if (lhs+2==rhs && vmCode[lhs].Action==&PushVariable) {
-    /* this is increment and redefine a variable */
+    /* this is increment and redefine a variable --
+       x++ leaves a second copy of x on the stack (DupUnder), so x can
+       never be overwritten in that case */
     if (CheckCodeSpace(3)) return lhs;
-    vmCode[nextPC++].Action= Binaries[assopMap[assop]];
+    vmCode[nextPC++].Action= (assop<4 && previousOp!=&DupUnder)?
+      InPlaces[assop] : Binaries[assopMap[assop]];
     vmCode[nextPC++].Action= previousOp= &Define;
     VariableReference(vmCode[lhs+1].index);
     WillPopStack(1L);
@@ -980,6 +1008,99 @@ CodeBlock YpIncrement(CodeBlock lhs, int assop, CodeBlock rhs)
 
 /* ------------------------------------------------------------------------ */
 
+static char *fusedNames[]= { "sin", "cos", "tan", "exp", "log", "sqrt", "abs",
+                             0 };
+
+#define MAX_FUSED_DEPTH 32
+
+/* CountFusedOps returns the number of operations in vmCode[start:nextPC]
+   if it is an expression Fused can evaluate, else 0.  The operands must be
+   variables, numeric constants, or variables indexed by - and nil only,
+   the operations unary -, binary + - * / ^, and calls to the functions in
+   fusedNames with a single argument.  */
+static long CountFusedOps(long start)
+{
+  /* stack items: 0 value, 1 variable, 2 function, 3 nil, 4 pseudo-index */
+  int kind[MAX_FUSED_DEPTH];
+  int i, n, depth= 0;
+  long pc= start, nOps= 0;
+  VMaction *Action;
+  char *name;
+  while (pc<nextPC) {
+    Action= vmCode[pc++].Action;
+    if (Action==&Fused) {
+      pc++;   /* already inserted for a subexpression */
+    } else if (Action==&PushVariable || Action==&PushNil ||
+               Action==&FormRangeFlag ||
+               (IsPushConst(Action) && Action!=&PushString)) {
+      if (depth>=MAX_FUSED_DEPTH) return 0;
+      if (Action==&PushVariable) {
+        name= literalTable.names[vmCode[pc++].index];
+        for (i=0 ; fusedNames[i] ; i++) if (!strcmp(name,fusedNames[i])) break;
+        kind[depth++]= fusedNames[i]? 2 : 1;
+      } else if (Action==&PushNil) {
+        kind[depth++]= 3;
+      } else if (Action==&FormRangeFlag) {
+        if (vmCode[pc++].count!=R_PSEUDO) return 0;
+        kind[depth++]= 4;
+      } else {
+        pc++;
+        kind[depth++]= 0;
+      }
+    } else if (Action==&Negate) {
+      if (depth<1 || kind[depth-1]>1) return 0;
+      kind[depth-1]= 0;
+      nOps++;
+    } else if (Action==&Power || Action==&Multiply || Action==&Divide ||
+               Action==&Add || Action==&Subtract) {
+      if (depth<2 || kind[depth-1]>1 || kind[depth-2]>1) return 0;
+      kind[(--depth)-1]= 0;
+      nOps++;
+    } else if (Action==&Eval) {
+      n= vmCode[pc++].count;
+      if (n<1 || depth<n+1) return 0;
+      depth-= n;
+      if (kind[depth-1]==2) {         /* function call */
+        if (n!=1 || kind[depth]>1) return 0;
+      } else if (kind[depth-1]==1) {  /* x(-,) and the like */
+        for (i=0 ; i<n ; i++) if (kind[depth+i]<3) return 0;
+      } else {
+        return 0;
+      }
+      kind[depth-1]= 0;
+      nOps++;
+    } else {
+      return 0;
+    }
+  }
+  return (depth==1 && kind[0]<=1)? nOps : 0;
+}
+
+/* FuseCode is called after the operation ending vmCode[start:nextPC] has
+   been emitted; it inserts the Fused instruction in front of the code, or
+   extends the one already there.  A single operation is not worth it.  */
+static void FuseCode(long start)
+{
+  long i;
+  if (CountFusedOps(start)<2) return;
+  if (vmCode[start].Action!=&Fused) {
+    if (CheckCodeSpace(2)) return;
+    for (i=nextPC-1 ; i>=start ; i--) vmCode[i+2]= vmCode[i];
+    nextPC+= 2;
+    for (i=nVariableRefs-1 ; i>=fuseVariable && variableRefs[i]>start ; i--)
+      variableRefs[i]+= 2;
+    for (i=nConstantRefs-1 ; i>=fuseConstant && constantRefs[i]>start ; i--)
+      constantRefs[i]+= 2;
+    if (reparsing) {
+      for (i=nYpReList-2 ; i>=0 && ypReList[i]>start ; i-=2) ypReList[i]+= 2;
+    }
+    vmCode[start].Action= &Fused;
+  }
+  SetBranchTarget(start+1, nextPC);
+}
+
+/* ------------------------------------------------------------------------ */
+
 static void SetBranchTarget(long pc, long targetPC)
 {
   vmCode[pc].displace= targetPC-pc;
@@ -1109,6 +1230,8 @@ void YpEndInc(CodeBlock inc)
   incCode[nextInc++].index= nConstantRefs;
   incCode[nextInc++].index= initialPC-nextPC; /* they've switched places */
   incCode[nextInc++].count= loopDepth;
+  fuseVariable= nVariableRefs;
+  fuseConstant= nConstantRefs;
 }
 
 CodeBlock YpFor(CodeBlock init, CodeBlock test, CodeBlock body)
@@ -1489,7 +1612,7 @@ void YpFunc(int isMain, int eol)
     pc= constantRefs[i];
     vmCode[pc].constant= cTable+vmCode[pc].index;
   }
-  nConstantRefs= 0;
+  nConstantRefs= fuseConstant= 0;
 
   /* locate or create all referenced variable names in globTab --
      reuse literalTypes array to hold globTab index */
@@ -1522,7 +1645,10 @@ void YpFunc(int isMain, int eol)
     pc= variableRefs[i];
     vmCode[pc].index= literalTypes[vmCode[pc].index];
   }
-  nVariableRefs= 0;
+  nVariableRefs= fuseVariable= 0;
+
+  /* replace common scalar sequences by superinstructions */
+  if (ySuperinst && !reparsing) SuperCode(vmCode);
 
   /* done with literal table */
   HashClear(&literalTable);  /* sets literalTable.maxItems==0 */
@@ -0,0 +1,440 @@
+/*
+ * $Id: profile.c,v 1.1 2026-10-17 dhmunro Exp $
+ *
+ * Implement a sampling profiler for interpreted functions and the
+ * built-in functions they call.
+ */
+/* Copyright (c) 2005, The Regents of the University of California.
+ * All rights reserved.
+ * This file is part of yorick (http://yorick.sourceforge.net).
+ * Read the accompanying LICENSE file for details.
+ */
+
+#include "ydata.h"
+#include "yio.h"
+#include "play.h"
+#include "phash.h"
+#include "pstdlib.h"
+#include "pstdio.h"
+#include <string.h>
+#include <stdlib.h>
+
+/* profile_start arranges (with p_sampler) for YProfTick in task.c to be
+   called at regular intervals of cpu time.  If a built-in function is
+   running, YProfTick merely counts the tick in yProfTicks, and EvalBI
+   records the sample when the built-in returns.  Otherwise, if the
+   virtual machine is running, YProfTick counts the tick in a volatile
+   counter which the YRun loop polls between two instructions, and YRun
+   records the sample (p_signalling is not used, so SIGINT and the event
+   queue are unaffected).
+   Either way, YProfSample walks the stack for the return addresses of
+   the interpreted functions being executed, so the samples are taken
+   only at points where the stack is intact.  Ticks which arrive while
+   the interpreter is idle or parsing are counted in yProfIdle.
+
+   Each distinct program counter (or built-in function) is a frame, which
+   holds a reference to its Function (or BIFunction), so that it remains
+   valid until the samples are discarded.  Source line numbers are found
+   only by profile_dump, by reparsing each sampled function, just as the
+   debugger does after an error.  */
+
+/* ------------------------------------------------------------------------ */
+
+extern Function *FuncContaining(Instruction *pc);
+extern char *YpReparse(void *function);
+extern long *ypReList, nYpReList;
+extern int ypReMatch;
+extern void YHalt(void);
+extern int PutsAsArray(char *s);
+
+extern void YProfTick(void);
+extern void YProfSample(BIFunction *bif, long weight);
+
+extern BuiltIn Y_profile_start, Y_profile_stop, Y_profile_dump;
+
+BIFunction *yProfBuiltin= 0;      /* built-in being called by EvalBI */
+volatile long yProfTicks= 0;      /* ticks while yProfBuiltin running */
+volatile long yProfIdle= 0;       /* ticks while VM not running */
+
+typedef struct ProfFrame ProfFrame;
+struct ProfFrame {
+  DataBlock *owner;  /* Function or BIFunction, owned by this frame */
+  long ipc;          /* code[ipc] is executing, -1 for built-in */
+  long id;           /* index into profFrames */
+  long loc;          /* index into locations, set by ProfLocate */
+};
+
+typedef struct ProfLoc ProfLoc;
+struct ProfLoc {
+  DataBlock *owner;  /* not owned, frame owns it */
+  long line;         /* source line number, 0 if unknown */
+  long self, total;  /* sample counts */
+  long stamp;        /* last sample counted in total */
+};
+
+static double profInterval= 0.0;   /* most recent sampling interval */
+static p_hashtab *profTable= 0;    /* pc or BIFunction -> ProfFrame */
+static ProfFrame **profFrames= 0;
+static long nProfFrames= 0, maxProfFrames= 0;
+/* samples are weight, depth, frame[depth] with innermost frame first */
+static long *profStack= 0;
+static long nProfStack= 0, maxProfStack= 0;
+static long nProfSamples= 0;
+
+static long ProfFrameOf(void *key, DataBlock *owner, long ipc);
+static void ProfPush(long value);
+static void ProfClear(void);
+static char *ProfName(DataBlock *owner);
+static int ProfSame(DataBlock *a, DataBlock *b);
+static long ProfLocate(ProfLoc **locs);
+static void ProfLines(Function *f, long *lines, long n);
+static int ProfCompare(const void *a, const void *b);
+static void ProfFolded(const char *filename);
+
+/* ------------------------------------------------------------------------ */
+
+void YProfSample(BIFunction *bif, long weight)
+{
+  Symbol *stack;
+  long id, depth, i0= nProfStack;
+
+  if (!profTable) return;
+  ProfPush(weight);
+  ProfPush(0L);
+  if (bif) {
+    id= ProfFrameOf(bif, (DataBlock *)bif, -1L);
+    if (id>=0) ProfPush(id);
+  }
+  if (pc) {
+    id= ProfFrameOf(pc, 0, 0L);
+    if (id>=0) ProfPush(id);
+  }
+  for (stack=sp ; stack>spBottom ; stack--) {
+    if (stack->ops!=&returnSym || stack->value.pc->Action==&YHalt) continue;
+    id= ProfFrameOf(stack->value.pc, 0, 0L);
+    if (id>=0) ProfPush(id);
+  }
+
+  depth= nProfStack-i0-2;
+  if (depth>0) {
+    profStack[i0+1]= depth;
+    nProfSamples+= weight;
+  } else {
+    /* not in any function, e.g.- main program still being parsed */
+    nProfStack= i0;
+    yProfIdle+= weight;
+  }
+}
+
+static long ProfFrameOf(void *key, DataBlock *owner, long ipc)
+{
+  p_hashkey hkey= P_PHASH(key);
+  ProfFrame *frame= p_hfind(profTable, hkey);
+  if (!frame) {
+    if (!owner) {
+      Function *f= FuncContaining(key);
+      if (!f) return -1;
+      owner= (DataBlock *)f;
+      ipc= (Instruction *)key - f->code;
+    }
+    if (nProfFrames>=maxProfFrames) {
+      maxProfFrames+= 256;
+      profFrames= p_realloc(profFrames, sizeof(ProfFrame *)*maxProfFrames);
+    }
+    frame= p_malloc(sizeof(ProfFrame));
+    frame->owner= Ref(owner);
+    frame->ipc= ipc;
+    frame->id= nProfFrames;
+    frame->loc= -1;
+    profFrames[nProfFrames++]= frame;
+    p_hinsert(profTable, hkey, frame);
+  }
+  return frame->id;
+}
+
+static void ProfPush(long value)
+{
+  if (nProfStack>=maxProfStack) {
+    maxProfStack+= 4096;
+    profStack= p_realloc(profStack, sizeof(long)*maxProfStack);
+  }
+  profStack[nProfStack++]= value;
+}
+
+static void ProfClear(void)
+{
+  long i;
+  if (profTable) {
+    p_hashtab *tab= profTable;
+    profTable= 0;
+    p_hfree(tab, 0);
+  }
+  for (i=0 ; i<nProfFrames ; i++) {
+    Unref(profFrames[i]->owner);
+    p_free(profFrames[i]);
+  }
+  p_free(profFrames);
+  profFrames= 0;
+  nProfFrames= maxProfFrames= 0;
+  p_free(profStack);
+  profStack= 0;
+  nProfStack= maxProfStack= nProfSamples= 0;
+  yProfTicks= yProfIdle= 0;
+}
+
+/* ------------------------------------------------------------------------ */
+
+void Y_profile_start(int nArgs)
+{
+  double interval= 0.001;
+  if (nArgs>1) YError("profile_start takes at most one argument");
+  if (nArgs==1 && YNotNil(sp)) interval= YGetReal(sp);
+  if (interval<=0.0) YError("profile_start interval must be positive");
+  p_sampler(0.0, 0);
+  ProfClear();
+  profTable= p_halloc(256);
+  if (p_sampler(interval, &YProfTick)) {
+    ProfClear();
+    YError("profile_start: no sampling timer on this platform");
+  }
+  profInterval= interval;
+}
+
+void Y_profile_stop(int nArgs)
+{
+  if (nArgs>1 || (nArgs==1 && YNotNil(sp)))
+    YError("profile_stop takes no arguments");
+  p_sampler(0.0, 0);
+  PushLongValue(nProfSamples);
+}
+
+void Y_profile_dump(int nArgs)
+{
+  char *filename= 0;
+  ProfLoc *locs;
+  long n, i, nTotal= nProfSamples;
+  char line[96];
+
+  if (nArgs>1) YError("profile_dump takes at most one argument");
+  if (nArgs==1 && YNotNil(sp)) filename= YGetString(sp);
+  if (!profTable) YError("profile_dump: profile_start has not been called");
+
+  n= ProfLocate(&locs);
+  if (filename) ProfFolded(filename);
+
+  qsort(locs, n, sizeof(ProfLoc), &ProfCompare);
+
+  if (CalledAsSubroutine()) {
+    PrintInit(YputsOut);
+    PushDataBlock(RefNC(&nilDB));
+  } else {
+    PrintInit(&PutsAsArray);
+    PushDataBlock(NewArray(&stringStruct, (Dimension *)0));
+  }
+  sprintf(line, "%ld samples every %g s, %ld outside interpreter",
+          nTotal, profInterval, (long)yProfIdle);
+  PrintFunc(line);
+  ForceNewline();
+  PrintFunc("    self   total  %self  function  line  file");
+  ForceNewline();
+  for (i=0 ; i<n ; i++) {
+    ProfLoc *loc= &locs[i];
+    Function *f= (Function *)loc->owner;
+    if (!loc->total) continue;
+    sprintf(line, "%8ld%8ld%7.2f  ", loc->self, loc->total,
+            nTotal? 100.0*loc->self/nTotal : 0.0);
+    PrintFunc(line);
+    PrintFunc(ProfName(loc->owner));
+    if (loc->owner->ops==&functionOps) {
+      sprintf(line, "  %ld  ", loc->line);
+      PrintFunc(line);
+      PrintFunc((f->isrc>=0)? sourceTab.names[f->isrc] : "?");
+    } else {
+      PrintFunc("  -  (built-in)");
+    }
+    ForceNewline();
+  }
+
+  p_free(locs);
+}
+
+/* ------------------------------------------------------------------------ */
+
+static char *ProfName(DataBlock *owner)
+{
+  if (owner->ops==&functionOps) {
+    long index= ((Function *)owner)->code[0].index;
+    return (index<0)? "*anon*" : globalTable.names[index];
+  } else {
+    return globalTable.names[((BIFunction *)owner)->index];
+  }
+}
+
+static int ProfSame(DataBlock *a, DataBlock *b)
+{
+  Function *fa= (Function *)a, *fb= (Function *)b;
+  if (a==b) return 1;
+  if (a->ops!=&functionOps || b->ops!=&functionOps) return 0;
+  return (fa->code[0].index==fb->code[0].index && fa->isrc==fb->isrc);
+}
+
+/* Set frame->loc to the index of its (function, line) location, and
+   accumulate the self and total sample counts for each location.  */
+static long ProfLocate(ProfLoc **locs)
+{
+  ProfLoc *loc= p_malloc(sizeof(ProfLoc)*(nProfFrames+1));
+  long *lines= p_malloc(sizeof(long)*(nProfFrames+1));
+  long i, j, n, k, weight, depth, sample;
+
+  /* gather the frames of each function, so that ProfLines need
+     reparse each function only once */
+  for (i=0 ; i<nProfFrames ; i++) lines[i]= -1;
+  for (i=0 ; i<nProfFrames ; i++) {
+    ProfFrame *frame= profFrames[i];
+    if (lines[i]>=0) continue;
+    if (frame->owner->ops==&functionOps) {
+      Function *f= (Function *)frame->owner;
+      long *ipcs= p_malloc(sizeof(long)*(nProfFrames-i));
+      for (j=i,k=0 ; j<nProfFrames ; j++)
+        if (profFrames[j]->owner==frame->owner) ipcs[k++]= profFrames[j]->ipc;
+      ProfLines(f, ipcs, k);
+      for (j=i,k=0 ; j<nProfFrames ; j++)
+        if (profFrames[j]->owner==frame->owner) lines[j]= ipcs[k++];
+      p_free(ipcs);
+    } else {
+      lines[i]= 0;
+    }
+  }
+
+  /* merge frames with the same function and line, including different
+     definitions of the same function, and all *main* programs */
+  for (i=n=0 ; i<nProfFrames ; i++) {
+    ProfFrame *frame= profFrames[i];
+    for (j=0 ; j<n ; j++)
+      if (loc[j].line==lines[i] && ProfSame(loc[j].owner, frame->owner)) break;
+    if (j>=n) {
+      loc[n].owner= frame->owner;
+      loc[n].line= lines[i];
+      loc[n].self= loc[n].total= 0;
+      loc[n++].stamp= -1;
+    }
+    frame->loc= j;
+  }
+  p_free(lines);
+
+  /* innermost frame gets self, every distinct location gets total */
+  for (i=sample=0 ; i<nProfStack ; i+=depth+2,sample++) {
+    weight= profStack[i];
+    depth= profStack[i+1];
+    loc[profFrames[profStack[i+2]]->loc].self+= weight;
+    for (j=0 ; j<depth ; j++) {
+      k= profFrames[profStack[i+2+j]]->loc;
+      if (loc[k].stamp==sample) continue;
+      loc[k].stamp= sample;
+      loc[k].total+= weight;
+    }
+  }
+
+  *locs= loc;
+  return n;
+}
+
+/* Replace the n code indices ipcs by their source line numbers.  */
+static void ProfLines(Function *f, long *ipcs, long n)
+{
+  long i, j, *pcLine= 0, nPCline= 0;
+  int nIncludes= nYpIncludes;
+
+  if (f->isrc>=0 && f->code[0].index>=0) {
+    char *msg= YpReparse(f);
+    if (msg[0]!='*' && ypReMatch) {
+      pcLine= ypReList;
+      nPCline= nYpReList;
+      ypReList= 0;
+    }
+    nYpReList= 0;
+    p_free(ypReList);
+    ypReList= 0;
+    /* YpReparse leaves its include file on the stack */
+    while (nYpIncludes>nIncludes && !ypIncludes[nYpIncludes-1].file) {
+      nYpIncludes--;
+      p_free(ypIncludes[nYpIncludes].filename);
+      ypIncludes[nYpIncludes].filename= 0;
+    }
+  }
+
+  for (i=0 ; i<n ; i++) {
+    /* pc has been incremented past the executing instruction, and the
+       line is that of the last statement beginning before it (see
+       FindErrLine in debug.c) -- the pc, line pairs are out of order
+       after for loop increments, so check them all */
+    long ipc= ipcs[i]-1, best= -1, first= -1, line= 0;
+    for (j=0 ; j+1<nPCline ; j+=2) {
+      if (pcLine[j]<=ipc && pcLine[j]>best) best= pcLine[j], line= pcLine[j+1];
+      if (first<0 || pcLine[j]<pcLine[first]) first= j;
+    }
+    /* just entered function, before first statement */
+    if (best<0 && first>=0) line= pcLine[first+1];
+    ipcs[i]= line;
+  }
+  p_free(pcLine);
+}
+
+static int ProfCompare(const void *a, const void *b)
+{
+  const ProfLoc *la= a;
+  const ProfLoc *lb= b;
+  if (la->self!=lb->self) return (la->self<lb->self)? 1 : -1;
+  if (la->total!=lb->total) return (la->total<lb->total)? 1 : -1;
+  return 0;
+}
+
+/* Write each distinct stack as a line of semicolon separated function
+   names, outermost first, followed by its sample count -- this is the
+   folded stack format read by flame graph generators.  */
+static void ProfFolded(const char *filename)
+{
+  HashTable stacks;
+  long *counts;
+  char *name= YExpandName(filename);
+  p_file *file= p_fopen(name, "w");
+  long i, j, depth, len, maxLen= 0;
+  char *line= 0;
+
+  p_free(name);
+  if (!file) YError("profile_dump: unable to create folded stack file");
+
+  HashInit(&stacks, 64);
+  counts= p_malloc(sizeof(long)*stacks.maxItems);
+  for (i=0 ; i<nProfStack ; i+=depth+2) {
+    depth= profStack[i+1];
+    for (len=0,j=0 ; j<depth ; j++)
+      len+= strlen(ProfName(profFrames[profStack[i+2+j]]->owner))+1;
+    if (len>maxLen) {
+      maxLen= len+64;
+      line= p_realloc(line, maxLen);
+    }
+    line[0]= '\0';
+    for (j=depth-1 ; j>=0 ; j--) {
+      strcat(line, ProfName(profFrames[profStack[i+2+j]]->owner));
+      if (j) strcat(line, ";");
+    }
+    if (!HashAdd(&stacks, line, 0L)) {
+      HASH_MANAGE(stacks, long, counts);
+      counts[hashIndex]= 0;
+    }
+    counts[hashIndex]+= profStack[i];
+  }
+
+  for (i=0 ; i<stacks.nItems ; i++) {
+    char count[32];
+    sprintf(count, " %ld\n", counts[i]);
+    p_fputs(file, stacks.names[i]);
+    p_fputs(file, count);
+  }
+  p_fclose(file);
+
+  HashClear(&stacks);
+  p_free(counts);
+  p_free(line);
+}
@@ -0,0 +1,392 @@
+/*
+ * $Id: super.c,v 1.1 2026-10-17 dhmunro Exp $
+ *
+ * Implement superinstructions, which execute a common sequence of virtual
+ * machine instructions on scalar operands with a single dispatch.
+ */
+/* Copyright (c) 2005, The Regents of the University of California.
+ * All rights reserved.
+ * This file is part of yorick (http://yorick.sourceforge.net).
+ * Read the accompanying LICENSE file for details.
+ */
+
+#include "ydata.h"
+#include "play.h"
+
+/* When ySuperinst is set (see the superinst function), YpFunc passes the
+   code of each function it defines to SuperCode, which replaces the
+   PushVariable at the start of each of the following sequences by a
+   superinstruction:
+
+     PushVarOp      a b op                 (op is + - * < > <= >= == !=)
+     PushVarBranch  a b cmp BranchFalse    (or BranchTrue)
+     PushVarDefine  a b op Define(c) DropTop       (op is + - *)
+     PushVarIncr    a Push1 DupUnder op Define(a) DropTop DropTop
+     PushVarIndex   x i Eval(1)            (x(i) immediately consumed)
+
+   where b is a variable, a long or double constant, or Push1, and op may
+   also be the AddInPlace, SubtractInPlace, or MultiplyInPlace form of
+   + - * which x+= x-= x*= compile to.  Only the Action of the PushVariable
+   changes; the rest of the sequence remains in place, so branches into
+   the middle of a sequence, the disassembler, and the debugger work as
+   before.  When the operands are int, long, or double
+   scalars, the superinstruction performs the entire sequence directly on
+   the Symbol values, without forming Operands, and leaves pc where the
+   ordinary sequence would have.  Otherwise, it simply performs the
+   PushVariable, and the ordinary instructions follow.  */
+
+/* ------------------------------------------------------------------------ */
+
+extern VMaction PushVariable, PushReference, PushLong, PushDouble, Push0,
+  Push1, DupUnder, Eval, Define, DropTop, BranchFalse, BranchTrue;
+extern VMaction Add, Subtract, Multiply, Divide, Power,
+  Less, Greater, LessEQ, GreaterEQ, Equal, NotEqual;
+extern VMaction AddInPlace, SubtractInPlace, MultiplyInPlace, DivideInPlace;
+
+extern VMaction PushVarOp, PushVarBranch, PushVarDefine, PushVarIncr,
+  PushVarIndex;
+
+extern int ActionLength(VMaction *Action);
+
+extern void SuperCode(Instruction *code);
+extern VMaction *SuperBase(VMaction *Action);
+
+extern BuiltIn Y_superinst;
+
+int ySuperinst= 0;
+
+/* scalar operand types, in order of promotion */
+#define S_INT 0
+#define S_LONG 1
+#define S_DOUBLE 2
+
+static VMaction *SuperOp(VMaction *Action);
+static int SuperBinary(VMaction *Action);
+static VMaction *SuperMatch(Instruction *ip);
+static int SuperLoad(Symbol *s, long *l, double *d);
+static Instruction *SuperOperand(Instruction *ip, int *t, long *l, double *d);
+static int SuperEval(VMaction *Op, int lt, long ll, double ld,
+                     int rt, long rl, double rd, long *l, double *d);
+static void SuperStore(Symbol *s, int t, long l, double d);
+
+/* ------------------------------------------------------------------------ */
+
+void Y_superinst(int nArgs)
+{
+  int flag= 2;
+  if (nArgs>1) YError("superinst takes exactly zero or one argument");
+  if (nArgs==1 && YNotNil(sp)) {
+    flag= (YGetInteger(sp)!=0);
+    Drop(1);
+  }
+  PushIntValue(ySuperinst);
+  if (flag!=2) ySuperinst= flag;
+}
+
+void SuperCode(Instruction *code)
+{
+  int n;
+  for ( ; code->Action ; code+=n) {
+    n= ActionLength(code->Action);
+    if (!n) break;
+    if (code->Action==&PushVariable) code->Action= SuperMatch(code);
+  }
+}
+
+VMaction *SuperBase(VMaction *Action)
+{
+  if (Action==&PushVarOp || Action==&PushVarBranch ||
+      Action==&PushVarDefine || Action==&PushVarIncr ||
+      Action==&PushVarIndex) return &PushVariable;
+  return Action;
+}
+
+/* the InPlace variants of + - * / compiled for x+= and the like are
+   identical to the ordinary operations when x is a scalar */
+static VMaction *SuperOp(VMaction *Action)
+{
+  if (Action==&AddInPlace) return &Add;
+  if (Action==&SubtractInPlace) return &Subtract;
+  if (Action==&MultiplyInPlace) return &Multiply;
+  if (Action==&DivideInPlace) return &Divide;
+  return Action;
+}
+
+static int SuperBinary(VMaction *Action)
+{
+  Action= SuperOp(Action);
+  return (Action==&Add || Action==&Subtract || Action==&Multiply ||
+          Action==&Divide || Action==&Power || Action==&Less ||
+          Action==&Greater || Action==&LessEQ || Action==&GreaterEQ ||
+          Action==&Equal || Action==&NotEqual);
+}
+
+static VMaction *SuperMatch(Instruction *ip)
+{
+  Instruction *op= ip+2;
+  VMaction *Action= op->Action;
+
+  if ((Action==&PushReference || Action==&PushLong) &&
+      op[2].Action==&Eval && op[3].count==1) {
+    /* the result of x(i) is an LValue, which would be fetched only when
+       it is used, or assigned to -- must be used immediately, or after
+       pushing a constant */
+    op+= 4;
+    if (op->Action==&PushLong || op->Action==&PushDouble) op+= 2;
+    else if (op->Action==&Push0 || op->Action==&Push1) op+= 1;
+    else if (op->Action==&Define) return &PushVarIndex;
+    return SuperBinary(op->Action)? &PushVarIndex : &PushVariable;
+  }
+
+  if (Action==&Push1 && op[1].Action==&DupUnder &&
+      (op[2].Action==&Add || op[2].Action==&Subtract) &&
+      op[3].Action==&Define && op[4].index==ip[1].index &&
+      op[5].Action==&DropTop && op[6].Action==&DropTop)
+    return &PushVarIncr;
+
+  if (Action==&PushVariable || Action==&PushLong || Action==&PushDouble)
+    op+= 2;
+  else if (Action==&Push1)
+    op+= 1;
+  else
+    return &PushVariable;
+
+  Action= SuperOp(op->Action);
+  if (Action==&Add || Action==&Subtract || Action==&Multiply) {
+    if (op[1].Action==&Define && op[3].Action==&DropTop)
+      return &PushVarDefine;
+    return &PushVarOp;
+  }
+  if (Action==&Less || Action==&Greater || Action==&LessEQ ||
+      Action==&GreaterEQ || Action==&Equal || Action==&NotEqual) {
+    if (op[1].Action==&BranchFalse || op[1].Action==&BranchTrue)
+      return &PushVarBranch;
+    return &PushVarOp;
+  }
+  return &PushVariable;
+}
+
+/* ------------------------------------------------------------------------ */
+
+/* SuperLoad sets only *l or *d, according to the returned type; the
+   callers initialize both so that neither is ever read uninitialized.  */
+static int SuperLoad(Symbol *s, long *l, double *d)
+{
+  if (s->ops==&longScalar) {
+    *l= s->value.l;
+    return S_LONG;
+  } else if (s->ops==&doubleScalar) {
+    *d= s->value.d;
+    return S_DOUBLE;
+  } else if (s->ops==&intScalar) {
+    *l= s->value.i;
+    return S_INT;
+  }
+  return -1;
+}
+
+/* SuperOperand gets the value pushed by the instruction at ip, returning
+   the address of the following instruction, or 0 if the value is not an
+   int, long, or double scalar.  */
+static Instruction *SuperOperand(Instruction *ip, int *t, long *l, double *d)
+{
+  VMaction *Action= ip->Action;
+  if (Action==&PushVariable) {
+    *t= SuperLoad(&globTab[ip[1].index], l, d);
+    return (*t<0)? 0 : ip+2;
+  } else if (Action==&PushLong) {
+    *t= S_LONG;
+    *l= ip[1].constant->value.l;
+    return ip+2;
+  } else if (Action==&PushDouble) {
+    *t= S_DOUBLE;
+    *d= ip[1].constant->value.d;
+    return ip+2;
+  }
+  *t= S_INT;   /* Push1 */
+  *l= 1;
+  return ip+1;
+}
+
+/* SuperEval performs the binary operation Op exactly as the corresponding
+   II, IL, ..., DD StackOp in ops2.c would, returning the result type.  */
+static int SuperEval(VMaction *Op, int lt, long ll, double ld,
+                     int rt, long rl, double rd, long *l, double *d)
+{
+  int t= (lt>rt)? lt : rt;
+  Op= SuperOp(Op);
+  if (t==S_DOUBLE) {
+    if (lt!=S_DOUBLE) ld= (double)ll;
+    if (rt!=S_DOUBLE) rd= (double)rl;
+    if (Op==&Add) *d= ld+rd;
+    else if (Op==&Subtract) *d= ld-rd;
+    else if (Op==&Multiply) *d= ld*rd;
+    else {
+      if (Op==&Less) *l= (ld<rd);
+      else if (Op==&Greater) *l= (ld>rd);
+      else if (Op==&LessEQ) *l= (ld<=rd);
+      else if (Op==&GreaterEQ) *l= (ld>=rd);
+      else if (Op==&Equal) *l= (ld==rd);
+      else *l= (ld!=rd);
+      return S_INT;
+    }
+  } else {
+    if (Op==&Add) *l= ll+rl;
+    else if (Op==&Subtract) *l= ll-rl;
+    else if (Op==&Multiply) *l= ll*rl;
+    else {
+      if (Op==&Less) *l= (ll<rl);
+      else if (Op==&Greater) *l= (ll>rl);
+      else if (Op==&LessEQ) *l= (ll<=rl);
+      else if (Op==&GreaterEQ) *l= (ll>=rl);
+      else if (Op==&Equal) *l= (ll==rl);
+      else *l= (ll!=rl);
+      return S_INT;
+    }
+  }
+  return t;
+}
+
+static void SuperStore(Symbol *s, int t, long l, double d)
+{
+  if (t==S_DOUBLE) {
+    s->value.d= d;
+    s->ops= &doubleScalar;
+  } else if (t==S_LONG) {
+    s->value.l= l;
+    s->ops= &longScalar;
+  } else {
+    s->value.i= (int)l;
+    s->ops= &intScalar;
+  }
+}
+
+/* ------------------------------------------------------------------------ */
+
+/* On entry, pc points to the index of the PushVariable variable.  */
+
+void PushVarOp(void)
+{
+  int lt, rt, t;
+  long ll= 0, rl= 0, l;
+  double ld= 0.0, rd= 0.0, d;
+  Instruction *op;
+  lt= SuperLoad(&globTab[pc->index], &ll, &ld);
+  op= (lt<0)? 0 : SuperOperand(pc+1, &rt, &rl, &rd);
+  if (!op) {
+    PushVariable();
+    return;
+  }
+  pc= op+1;
+  t= SuperEval(op->Action, lt, ll, ld, rt, rl, rd, &l, &d);
+  SuperStore(sp+1, t, l, d);
+  sp++;
+}
+
+void PushVarBranch(void)
+{
+  int lt, rt;
+  long ll= 0, rl= 0, l;
+  double ld= 0.0, rd= 0.0, d;
+  Instruction *op;
+  lt= SuperLoad(&globTab[pc->index], &ll, &ld);
+  op= (lt<0)? 0 : SuperOperand(pc+1, &rt, &rl, &rd);
+  if (!op) {
+    PushVariable();
+    return;
+  }
+  SuperEval(op->Action, lt, ll, ld, rt, rl, rd, &l, &d);
+  P_SOFTFPE_TEST;
+  pc= op+2;   /* at branch displacement, as in BranchFalse */
+  if ((op[1].Action==&BranchTrue)? l : !l) pc+= pc->displace;
+  else pc++;
+}
+
+void PushVarDefine(void)
+{
+  int lt, rt, t;
+  long ll= 0, rl= 0, l;
+  double ld= 0.0, rd= 0.0, d;
+  Instruction *op;
+  Symbol *glob;
+  lt= SuperLoad(&globTab[pc->index], &ll, &ld);
+  op= (lt<0)? 0 : SuperOperand(pc+1, &rt, &rl, &rd);
+  if (op) {
+    glob= &globTab[op[2].index];
+    if (glob->ops==&dataBlockSym && glob->value.db->ops==&lvalueOps) op= 0;
+  }
+  if (!op) {
+    PushVariable();
+    return;
+  }
+  pc= op+4;
+  t= SuperEval(op->Action, lt, ll, ld, rt, rl, rd, &l, &d);
+  P_SOFTFPE_TEST;
+  if (glob->ops==&dataBlockSym) {
+    DataBlock *db= glob->value.db;
+    glob->ops= &intScalar;
+    Unref(db);
+  }
+  SuperStore(glob, t, l, d);
+}
+
+void PushVarIncr(void)
+{
+  Symbol *var= &globTab[pc->index];
+  int sub= (pc[3].Action==&Subtract);
+  if (var->ops==&longScalar) {
+    var->value.l+= sub? -1L : 1L;
+  } else if (var->ops==&intScalar) {
+    var->value.i+= sub? -1 : 1;
+  } else if (var->ops==&doubleScalar) {
+    var->value.d+= sub? -1.0 : 1.0;
+  } else {
+    PushVariable();
+    return;
+  }
+  P_SOFTFPE_TEST;
+  pc+= 8;
+}
+
+void PushVarIndex(void)
+{
+  Symbol *var= &globTab[pc->index];
+  Array *array= (var->ops==&dataBlockSym)? (Array *)var->value.db : 0;
+  if (array && (array->ops==&doubleOps || array->ops==&longOps ||
+                array->ops==&intOps)) {
+    Dimension *dims= array->type.dims;
+    long i= 0;
+    if (pc[1].Action==&PushLong) {
+      i= pc[2].constant->value.l;
+    } else {
+      Symbol *s= &globTab[pc[2].index];
+      if (s->ops==&longScalar) i= s->value.l;
+      else if (s->ops==&intScalar) i= s->value.i;
+    }
+    /* only positive in-range index to 1D array with origin 1 */
+    if (i>0 && dims && !dims->next && i<=dims->number &&
+        (yForceOrigin || dims->origin==1L)) {
+      Symbol *spp= sp+1;
+      i--;
+      if (array->type.base==&doubleStruct) {
+        spp->value.d= array->value.d[i];
+        spp->ops= &doubleScalar;
+      } else if (array->type.base==&longStruct) {
+        spp->value.l= array->value.l[i];
+        spp->ops= &longScalar;
+      } else if (array->type.base==&intStruct) {
+        spp->value.i= array->value.i[i];
+        spp->ops= &intScalar;
+      } else {
+        PushVariable();
+        return;
+      }
+      sp= spp;
+      pc+= 5;
+      return;
+    }
+  }
+  PushVariable();
+}
+
+/* ------------------------------------------------------------------------ */
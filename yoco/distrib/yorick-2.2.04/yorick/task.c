@@ -118,20 +118,42 @@ int ym_dbenter = 0;
 #define Y_SUSPENDED 4
 #define Y_PENDING 8
 
+/* ticks of the sampling profiler while the virtual machine is running,
+ * counted by YProfTick and recorded by YRun between two instructions --
+ * p_signalling is left alone so that SIGINT and p_hinsert still work */
+static volatile long y_prof_vm_ticks= 0;
+static long y_prof_vm_taken= 0;
+extern BIFunction *yProfBuiltin;
+extern volatile long yProfTicks, yProfIdle;
+extern void YProfTick(void);
+extern void YProfSample(BIFunction *bif, long weight);
+
 void
 YRun(void)
 {
   register VMaction *Action;
   int run_state = ym_state & Y_RUNNING;
+  BIFunction *prof_builtin = yProfBuiltin;
   ym_state |= Y_RUNNING;
   ym_dbenter = 0;
+  yProfBuiltin = 0;   /* YRun may be called by a builtin */
 
   P_SOFTFPE_TEST;
 
-  while (!p_signalling) {
-    Action = (pc++)->Action;
-    Action();
+  for (;;) {
+    while (!p_signalling && y_prof_vm_ticks==y_prof_vm_taken) {
+      Action = (pc++)->Action;
+      Action();
+    }
+    if (y_prof_vm_ticks != y_prof_vm_taken) {
+      /* all ticks since the last sample fell in the same instruction */
+      long ticks = y_prof_vm_ticks - y_prof_vm_taken;
+      y_prof_vm_taken += ticks;
+      YProfSample(0, ticks);
+    }
+    if (p_signalling || !(ym_state&Y_RUNNING)) break;
   }
+  yProfBuiltin = prof_builtin;
   if (p_signalling==-1 && !(ym_state&Y_RUNNING))
     p_signalling = 0;      /* p_signalling set by YHalt (?? see below) */
 
@@ -144,6 +166,19 @@ YRun(void)
     p_abort();             /* p_signalling set by real signal */
 }
 
+/* called from a signal handler by the sampling profiler (see profile.c),
+ * so interrupt the virtual machine only between two instructions */
+void
+YProfTick(void)
+{
+  if (yProfBuiltin)
+    yProfTicks++;
+  else if (ym_state&Y_RUNNING)
+    y_prof_vm_ticks++;
+  else
+    yProfIdle++;
+}
+
 extern void ym_escape(void);
 void
 ym_escape(void)
@@ -1728,6 +1763,10 @@ YError(const char *msg)
   /* Clean up any Array temporaries (used for data format conversions).  */
   if (recursing<2) ClearTmpArray();
 
+  /* Any builtin the profiler was timing has been aborted.  */
+  yProfBuiltin= 0;
+  yProfTicks= 0;
+
   /* Clear out any pending keyboard input or tasks.  */
   if (recursing<3) {
     p_qclear();
@@ -18,7 +18,7 @@
    having to deal with pointers.  */
 extern Array *GrowArray(Array *array, long extra);
 
-extern BuiltIn Y_yorick_stats, Y_symbol_def, Y_symbol_set;
+extern BuiltIn Y_yorick_stats, Y_mempool, Y_symbol_def, Y_symbol_set;
 extern BuiltIn Y_symbol_names, Y_symbol_exists, Y_errs2caller;
 
 /* Required for FetchLValue, StoreLValue */
@@ -897,6 +897,29 @@ void Y_yorick_stats(int nArgs)
   result->value.l[13]= pointerStruct.references;
 }
 
+void Y_mempool(int nArgs)
+{
+  Array *result;
+  Dimension *dims;
+  if (nArgs>1) YError("mempool takes at most one argument");
+  if (nArgs==1 && YNotNil(sp)) {
+    long maxbytes= YGetInteger(sp);
+    if (maxbytes<0) YError("mempool max_bytes must be non-negative");
+    p_mmpool(maxbytes);
+  }
+  dims= tmpDims;
+  tmpDims= 0;
+  FreeDimension(dims);
+  tmpDims= NewDimension(6L, 1L, (Dimension *)0);
+  result= PushDataBlock(NewArray(&longStruct, tmpDims));
+  result->value.l[0]= p_nphit;
+  result->value.l[1]= p_npmiss;
+  result->value.l[2]= p_npool;
+  result->value.l[3]= p_apool;
+  result->value.l[4]= p_mpool;
+  result->value.l[5]= p_ahuge;
+}
+
 void Y_symbol_def(int nArgs)
 {
   long index;
@@ -206,7 +206,7 @@ func imgFitsReadImgData(file,&imgData,force_array=)
   imgData.hdr = oiFitsLoadOiHdr(fh,  struct_imgDataHdr());
   
   /* Read the bintable */
-  bintable = cfitsio_read_bintable(fh,bintitles);
+  bintable = imgFitsReadBintable(fh,bintitles);
   
   imgData.mjdObs         = double(cfitsio_get(fh,"MJD-OBS"));
   imgData.dateObs        = string(cfitsio_get(fh,"DATE-OBS"));
@@ -231,6 +231,74 @@ func imgFitsReadImgData(file,&imgData,force_array=)
 
 /* ------------------------------------------------------------------------ */
 
+func imgFitsReadBintable(fh,&bintitles)
+/* DOCUMENT bintable = imgFitsReadBintable(fh,&bintitles)
+
+   DESCRIPTION
+   Same as cfitsio_read_bintable, but if Yeti's unpack_bintable is
+   available, the whole table is read at once and decoded in compiled
+   code instead of reading each column through cfitsio.  Tables with
+   columns which need cfitsio's conversions (scaled, logical, bit or
+   variable length columns) are read by cfitsio_read_bintable.  If the
+   file is not compressed, it is mapped in memory by fits_mmap and the
+   columns are decoded directly from the mapped file (sequential access
+   is advised to the system).
+ */
+{
+  if (!is_func(unpack_bintable) || !is_func(cfitsio_read_tblbytes) ||
+      !is_func(__ffgtbb))
+    return cfitsio_read_bintable(fh,bintitles);
+  ncols = cfitsio_get_num_cols(fh);
+  nrows = cfitsio_get_num_rows(fh);
+  if (ncols<1 || nrows<1 || cfitsio_get(fh,"XTENSION")!="BINTABLE")
+    return cfitsio_read_bintable(fh,bintitles);
+
+  /* Formats, dimensions and names of the columns */
+  tform = tdim = bintitles = array(string,ncols);
+  for(i=1;i<=ncols;i++) {
+    tform(i) = cfitsio_get(fh,"TFORM"+pr1(i));
+    if (strgrep("^ *[1-9]?[0-9]*[ABIJEDCM] *$",tform(i))(2) < 0 ||
+        !is_void(cfitsio_get(fh,"TSCAL"+pr1(i))) ||
+        !is_void(cfitsio_get(fh,"TZERO"+pr1(i))))
+      return cfitsio_read_bintable(fh,bintitles);
+    dim = cfitsio_get(fh,"TDIM"+pr1(i));
+    if (!is_void(dim)) {
+      if (strmatch(tform(i),"A")) return cfitsio_read_bintable(fh,bintitles);
+      tdim(i) = dim;
+    }
+    bintitles(i) = cfitsio_get(fh,"TTYPE"+pr1(i));
+  }
+
+  /* Decode the columns directly from the mapped file if possible, the
+     row index is the last one */
+  fm = (is_func(fits_mmap) ? fits_mmap(cfitsio_file_name(fh),quiet=1) : []);
+  hdu = cfitsio_get_hdu_num(fh);
+  if (!is_void(fm) && hdu<=fm.nhdus &&
+      fits_mmap_get(fm,hdu,"NAXIS2")==nrows) {
+    /* The columns are decoded one after the other, each one visits all
+       the rows: ask for the whole table in advance */
+    fits_mmap_advise, fm, "willneed", hdu;
+    bintable = array(pointer,ncols);
+    for(i=1;i<=ncols;i++)
+      bintable(i) = &fits_mmap_column(fm,hdu,i,trim=1,last=1);
+  }
+
+  /* Otherwise, read and decode the whole table */
+  else
+    bintable = unpack_bintable(cfitsio_read_tblbytes(fh),tform,tdim,
+                               trim=1,last=1);
+  for(i=1;i<=ncols;i++) {
+    if (strmatch(tform(i),"A")) {
+      str = *bintable(i);
+      if (is_array((id=where(!str)))) str(id) = "";
+      bintable(i) = &str;
+    }
+  }
+  return bintable;
+}
+
+/* ------------------------------------------------------------------------ */
+
 func imgDecodeData(bintable,bintitles,nregion,force_array=)
 {
   local data; data = [];
@@ -968,8 +968,8 @@ int ffgcv( fitsfile *fptr, int datatype, int colnum, long firstrow,
 //             int *valid, int *status);
 // int ffcmph(fitsfile *fptr, int *status);
 
-// int ffgtbb(fitsfile *fptr, long firstrow, long firstchar, long nchars,
-//            unsigned char *values, int *status);
+int ffgtbb(fitsfile *fptr, long firstrow, long firstchar, long nchars,
+           unsigned char *values, int *status);
  
 /*------------ write primary array or image elements -------------*/
 int ffppx(fitsfile *fptr, int datatype, long  *firstpix, long nelem,
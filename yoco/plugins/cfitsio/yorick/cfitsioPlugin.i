@@ -2711,6 +2711,37 @@ func cfitsio_read_bintable(&fh, &bintitle, frow=, nrows=)
     return bintable;
 }
 
+func cfitsio_read_tblbytes(&fh, frow=, nrows=)
+/* DOCUMENT cfitsio_read_tblbytes(fh, frow=, nrows=)
+
+   DESCRIPTION:
+   Read the raw bytes of the rows of the binary table in the current HDU.
+   The result is a NAXIS1-by-NROWS array of char's with the rows as stored
+   in the file (big-endian values, no scaling), which can be decoded at once
+   by Yeti's unpack_bintable.
+
+   Optional arguments frow= and nrows= specify the first row (starting
+   at 1) and the number of rows to be read. Default is to read all.
+
+   SEE ALSO: cfitsio_read_bintable, unpack_bintable
+*/
+{
+    if ( is_void(frow) )
+    {
+        frow = 1;
+    }
+    if ( is_void(nrows) )
+    {
+        nrows = cfitsio_get_num_rows(fh) - frow + 1;
+    }
+    pitch = long(cfitsio_get(fh,"NAXIS1"));
+    if ( frow < 1 || nrows < 1 || pitch < 1 )
+    {
+        error,"Invalid number of rows to be read.";
+    }
+    return __ffgtbb(fh, long(frow), pitch, long(nrows));
+}
+
 func cfitsio_add_bintable(&fh, pcol, titles, units, extname)
 /* DOCUMENT cfitsio_add_bintable(&fh, pcol, titles, units, extname)
 
@@ -948,6 +948,29 @@ Y___ffgcv(int n)
 			  yarg_i(0,0), &status));
 }
 
+extern BuiltIn Y___ffgtbb;
+
+// extern int ffgtbb(long , long , long , long , unsigned char *, int *);
+void
+Y___ffgtbb(int n)
+{
+  if (n!=4) YError("__ffgtbb takes exactly 4 arguments");
+
+  /* push the rows as an array of nchars-by-nrows bytes */
+  int status=0;
+  long dims[3];
+  fitsfile *fptr = ygeta_fitsfile(3);
+  long frow  = yarg_sl(2);
+  dims[0] = (long)2;
+  dims[1] = yarg_sl(1);
+  dims[2] = yarg_sl(0);
+  if (dims[1] <= 0 || dims[2] <= 0) YError("invalid number of bytes to read");
+  unsigned char *values = (unsigned char *)ypush_c(dims);
+
+  CheckCfitsioStatus(ffgtbb(fptr, frow, (long)1, dims[1]*dims[2], values,
+                            &status));
+}
+
 extern BuiltIn Y___ffppx;
 
 // extern int ffppx(long , int , long *, long , void *, int *);
@@ -1326,6 +1326,15 @@ extern __ffgcv;
     int ffgcv  (fitsfile *fptr ,int datatype ,int colnum ,long firstrow ,long firstelem ,long nelem ,void *nulval ,void *array ,int *anynul ,int *status)
 */
 
+extern __ffgtbb;
+/* DOCUMENT  __ffgtbb( fh, firstrow, nchars, nrows )
+  Read NROWS rows of NCHARS bytes of a table starting at the first byte of
+  row FIRSTROW, the result is a NCHARS-by-NROWS array of char's.
+  * C-prototype:
+    ------------
+    int ffgtbb  (fitsfile *fptr ,long firstrow ,long firstchar ,long nchars ,unsigned char *values ,int *status)
+*/
+
 extern __ffppx;
 /* DOCUMENT  __ffppx( fh, datatype, fpixels, nelements, arrayc (pointer) )
   * C-prototype:
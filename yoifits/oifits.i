@@ -1674,6 +1674,45 @@ func oifits_new_corr(master,
   return db;
 }
 
+func _oifits_read_bintable(fh)
+/**DOCUMENT ptr = _oifits_read_bintable(fh);
+
+     Reads the binary table in current HDU of FITS handle FH like
+     fits_read_bintable.  If Yeti's unpack_bintable is available and the
+     table has no variable length arrays, the whole table is read with a
+     single call to _read and decoded by compiled code.
+
+   SEE ALSO: fits_read_bintable, unpack_bintable.
+ */
+{
+  if (! is_func(unpack_bintable) || fits_get_naxis(fh) != 2) {
+    return fits_read_bintable(fh);
+  }
+  pitch = fits_get(fh, "NAXIS1");
+  nrows = fits_get(fh, "NAXIS2");
+  tfields = fits_get(fh, "TFIELDS");
+  if (pitch <= 0 || nrows <= 0 || tfields <= 0) {
+    return fits_read_bintable(fh);
+  }
+  tform = tdim = array(string, tfields);
+  for (i = 1; i <= tfields; ++i) {
+    value = fits_get(fh, swrite(format="TFORM%d", i));
+    if (structof(value) != string || strmatch(value, "P") ||
+        strmatch(value, "Q")) {
+      /* Let fits_read_bintable deal with errors and heap data. */
+      return fits_read_bintable(fh);
+    }
+    tform(i) = value;
+    value = fits_get(fh, swrite(format="TDIM%d", i));
+    if (structof(value) == string) tdim(i) = value;
+  }
+  raw = array(char, pitch, nrows);
+  if (_read(_car(fh, 4), _car(fh, 3)(3), raw) != numberof(raw)) {
+    error, "short file";
+  }
+  return unpack_bintable(raw, tform, tdim);
+}
+
 /* NOTE: To simplify the code of the instance builder, we heavily rely on
    class definition tables.  This means that consistency of these tables is
    assumed and must be asserted at initialization time when _oifits_init is
@@ -1746,7 +1785,7 @@ func _oifits_datablock_builder(type, src, extname, hdu)
      the columns of the binary table and build a hash table for fast
      linking of the column index given its name.*/
   if (reading) {
-    ptr = fits_read_bintable(src);
+    ptr = _oifits_read_bintable(src);
     ttype = h_new();
     for (i = numberof(ptr); i >= 1; --i) {
       name = fits_get(src, swrite(format="TTYPE%d", i));
@@ -1,11 +1,18 @@
 autoload, "vops.i",
     vops_combine,
+    vops_combine_inner,
     vops_flops,
     vops_inner,
+    vops_lbfgs,
+    vops_lbfgs_apply,
+    vops_lbfgs_reset,
+    vops_lbfgs_update,
     vops_norm1,
     vops_norm2,
     vops_norminf,
     vops_scale,
     vops_tic,
     vops_toc,
-    vops_update;
+    vops_update,
+    vops_update_inner,
+    vops_update_norm2;
@@ -47,6 +47,92 @@ r4 = 1.0; r5 = []; eq_nocopy, r5, r4;
 vops_combine, r5, alpha, x, beta, y;
 if (&r5 == &r4) error, "unexpected re-use";
 
+// Fused operations and large arrays (split in chunks and possibly processed
+// by several threads).
+for (n = 1; n <= 2; ++n) {
+    len = (n == 1 ? dims : 300001);
+    a = random_n(len);
+    b = random_n(len);
+    c = random_n(len);
+    alpha = random_n();
+    beta = random_n();
+    r0 = a + alpha*b;
+    y1 = a;
+    r1 = vops_update_inner(y1, alpha, b, c);
+    y2 = a;
+    r2 = vops_update_norm2(y2, alpha, b);
+    d3 = [];
+    r3 = vops_combine_inner(d3, alpha, a, beta, b, c);
+    r4 = alpha*a + beta*b;
+    p = c;
+    r5 = vops_combine_inner(p, 1, a, beta, p, b);
+    r6 = a + beta*c;
+    write, format="%-37s max(|dif|) = %.1e / %.1e\n",
+        swrite(format="Fused ops. (n = %d):", len),
+        max(max(abs(y1 - r0)), max(abs(y2 - r0)),
+            max(abs(d3 - r4)), max(abs(p - r6))),
+        max(abs(r1 - sum(r0*c))/sum(abs(r0*c)),
+            abs(r2 - sqrt(sum(r0*r0)))/sqrt(sum(r0*r0)),
+            abs(r3 - sum(r4*c))/sum(abs(r4*c)),
+            abs(r5 - sum(r6*b))/sum(abs(r6*b)));
+    write, format="%-37s max(|dif|) = %.1e / %.1e / %.1e / %.1e\n",
+        swrite(format="Reductions (n = %d):", len),
+        abs(vops_norm1(a) - sum(abs(a)))/sum(abs(a)),
+        abs(vops_norm2(a) - sqrt(sum(a*a)))/sqrt(sum(a*a)),
+        abs(vops_norminf(a) - max(abs(a))),
+        abs(vops_inner(float(c), a, b) - sum(float(c)*a*b))/sum(abs(c*a*b));
+}
+
+// L-BFGS memory compared with the interpreted two-loop recursion.
+func lbfgs_apply(S, Y, g, f)
+{
+    d = g*f;
+    m = numberof(S);
+    alpha = rho = array(double, m);
+    gamma = 0.0;
+    for (i = m; i >= 1; --i) {
+        rho(i) = sum((*S(i))*f*(*Y(i)));
+        if (gamma <= 0) gamma = rho(i)/sum((f*(*Y(i)))^2);
+        alpha(i) = sum(d*(*S(i)))/rho(i);
+        d -= alpha(i)*f*(*Y(i));
+    }
+    d *= gamma;
+    for (i = 1; i <= m; ++i) {
+        d += (alpha(i) - sum(d*(*Y(i)))/rho(i))*f*(*S(i));
+    }
+    return d;
+}
+lbfgs = vops_lbfgs(3);
+S = Y = [];
+err = 0.0;
+for (k = 1; k <= 5; ++k) {
+    s = random_n(dims);
+    y = s + 0.3*random_n(dims);
+    if (!vops_lbfgs_update(lbfgs, s, y)) error, "pair should be accepted";
+    if (vops_lbfgs_update(lbfgs, s, -y)) error, "pair should be rejected";
+    grow, S, &s;
+    grow, Y, &y;
+    if (numberof(S) > lbfgs.m) {
+        S = S(2:0);
+        Y = Y(2:0);
+    }
+    g = random_n(dims);
+    f = double(random(dims) > 0.2);
+    local scaled;
+    d0 = lbfgs_apply(S, Y, g, 1.0);
+    d1 = lbfgs_apply(S, Y, g, f);
+    err = max(err, max(abs(vops_lbfgs_apply(lbfgs, g, scaled) - d0))/
+              max(abs(d0)),
+              max(abs(vops_lbfgs_apply(lbfgs, g, scaled, f) - d1))/
+              max(abs(d1)));
+    if (!scaled) error, "result should be scaled";
+}
+vops_lbfgs_reset, lbfgs;
+if (lbfgs.mp != 0 || anyof(vops_lbfgs_apply(lbfgs, g, scaled) != g) || scaled) {
+    error, "L-BFGS memory not reset";
+}
+write, format="%-37s max(|dif|) = %.1e\n", "L-BFGS recursion:", err;
+
 
 write, format="Test %s:\n", "empty";
 k = repeat; vops_warmup; while (--k >= 0) r0 = 0.0; vops_toc, repeat;
@@ -156,3 +242,40 @@ write, format="%35s: ", "vops_combine, z, alpha, x, beta, y";
 k = repeat; vops_warmup; while (--k >= 0) vops_combine, z3, alpha, x, beta, y;
 write, format="%7.3f Gflops / max(|dif|) = %g\n\n",
     vops_flops(nops*repeat)/1e9, max(abs(z3 - z1));
+
+// Update and inner product.
+nops = 4*numberof(x);
+alpha = 1e-6*random();
+
+y1 = y;
+write, format="%35s: ", "y += alpha*x; sum(y*w)";
+k = repeat; vops_warmup; while (--k >= 0) { y1 += alpha*x; r1 = sum(y1*w); }
+write, format="%7.3f Gflops\n", vops_flops(nops*repeat)/1e9;
+
+y2 = y;
+write, format="%35s: ", "vops_update, y, alpha, x; vops_inner(y, w)";
+k = repeat; vops_warmup;
+while (--k >= 0) { vops_update, y2, alpha, x; r2 = vops_inner(y2, w); }
+write, format="%7.3f Gflops\n", vops_flops(nops*repeat)/1e9;
+
+y3 = y;
+write, format="%35s: ", "vops_update_inner(y, alpha, x, w)";
+k = repeat; vops_warmup; while (--k >= 0) r3 = vops_update_inner(y3, alpha, x, w);
+write, format="%7.3f Gflops / max(|dif|) = %g\n\n",
+    vops_flops(nops*repeat)/1e9, max(abs(r2 - r1), abs(r3 - r1))/abs(r1);
+
+// Combine and inner product.
+nops = 5*numberof(x);
+alpha = random();
+beta = random();
+
+write, format="%35s: ", "vops_combine, z, ...; vops_inner(z, w)";
+k = repeat; vops_warmup;
+while (--k >= 0) { vops_combine, z3, alpha, x, beta, y; r1 = vops_inner(z3, w); }
+write, format="%7.3f Gflops\n", vops_flops(nops*repeat)/1e9;
+
+write, format="%35s: ", "vops_combine_inner(z, ..., w)";
+k = repeat; vops_warmup;
+while (--k >= 0) r2 = vops_combine_inner(z3, alpha, x, beta, y, w);
+write, format="%7.3f Gflops / max(|dif|) = %g\n\n",
+    vops_flops(nops*repeat)/1e9, abs(r2 - r1)/abs(r1);
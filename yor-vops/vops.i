@@ -59,9 +59,30 @@ local vops;
      factors `alpha` and `beta` efficiently; if called with 5 arguments,
      `vops_combine` automatically redefines or re-uses the contents of `dst`.
 
+     Fused operations save passes through memory in iterative algorithms:
+
+         vops_update_inner(y, alpha, x, z)      -->  sum((y += alpha*x)*z)
+         vops_update_norm2(y, alpha, x)         -->  sqrt(sum((y += alpha*x)^2))
+         vops_combine_inner(dst, alpha, x, beta, y, z)
+                                  -->  sum((dst = alpha*x + beta*y)*z)
+
+     Reductions are computed with multiple independent partial sums (for
+     SIMD instructions) and, for large arrays and if the plug-in has been
+     compiled with OpenMP support, by several threads.  The partial sums are
+     always combined in the same order so the result does not depend on the
+     number of threads.
+
+     Limited memory quasi-Newton methods are supported by an L-BFGS memory
+     object with contiguous storage and a compiled two-loop recursion:
+
+         lbfgs = vops_lbfgs(m)
+         vops_lbfgs_update(lbfgs, s, y)
+         d = vops_lbfgs_apply(lbfgs, g [, scaled, freevars])
+
 
    SEE ALSO: vops_norm1, vops_norm2, vops_norminf, vops_inner, vops_scale,
-             vops_update.
+             vops_update, vops_combine, vops_update_inner,
+             vops_update_norm2, vops_combine_inner, vops_lbfgs.
  */
 
 extern vops_norm1;
@@ -136,7 +157,27 @@ extern vops_update;
 
       The updated result `y` is returned if called as a function.
 
-   SEE ALSO: vops, vops_combine, vops_scale.
+   SEE ALSO: vops, vops_combine, vops_scale, vops_update_inner,
+             vops_update_norm2.
+ */
+
+extern vops_update_inner;
+extern vops_update_norm2;
+/* DOCUMENT res = vops_update_inner(y, alpha, x, z);
+         or nrm = vops_update_norm2(y, alpha, x);
+
+      Compute `y += alpha*x` as `vops_update` does and, in the same pass
+      through memory, the inner product of the updated `y` and `z` or the
+      Euclidean norm of the updated `y`.  That is:
+
+          vops_update, y, alpha, x;
+          res = vops_inner(y, z);
+          nrm = vops_norm2(y);
+
+      Array `z` must have the same dimensions as `x` and `y`, it may be the
+      same array as `x`.
+
+   SEE ALSO: vops, vops_update, vops_inner, vops_norm2.
  */
 
 extern vops_combine;
@@ -154,7 +195,64 @@ extern vops_combine;
       re-allocated but must not be an expression (i.e., `dst` must be a simple
       variable for the caller).
 
-   SEE ALSO: vops, vops_scale, vops_update.
+   SEE ALSO: vops, vops_scale, vops_update, vops_combine_inner.
+ */
+
+extern vops_combine_inner;
+/* DOCUMENT res = vops_combine_inner(dst, alpha, x, beta, y, z);
+
+      Compute `dst = alpha*x + beta*y` as `vops_combine` does and, in the same
+      pass through memory, the inner product of the result and `z`.  That is:
+
+          vops_combine, dst, alpha, x, beta, y;
+          res = vops_inner(dst, z);
+
+      Array `z` must have the same dimensions as `x` and `y`.  Any of `x`, `y`
+      or `z` may be the same array as `dst`, e.g. to compute `p = r + beta*p`
+      and `<p,q>` with `vops_combine_inner(p, 1, r, beta, p, q)`.
+
+   SEE ALSO: vops, vops_combine, vops_inner.
+ */
+
+extern vops_lbfgs;
+extern vops_lbfgs_update;
+extern vops_lbfgs_apply;
+extern vops_lbfgs_reset;
+/* DOCUMENT lbfgs = vops_lbfgs(m);
+         or accept = vops_lbfgs_update(lbfgs, s, y);
+         or d = vops_lbfgs_apply(lbfgs, g [, scaled [, freevars]]);
+         or vops_lbfgs_reset, lbfgs;
+
+      `vops_lbfgs(m)` creates a new L-BFGS memory object to store at most the
+      `m` last pairs of variable changes `s` and gradient changes `y`.  The
+      pairs are stored in contiguous memory allocated by the first accepted
+      update which also fixes the dimensions and the floating-point type
+      (`float` if `s` and `y` are both of type `float`, `double` otherwise).
+
+      `vops_lbfgs_update(lbfgs, s, y)` stores the pair `(s,y)` in the memory,
+      replacing the oldest one if `m` pairs are already memorized.  The pair
+      is only accepted if `<s,y> > 0`, in which case the scaling of the
+      gradient is set to `gamma = <s,y>/<y,y>`.  The returned value indicates
+      whether the pair has been accepted.
+
+      `vops_lbfgs_apply(lbfgs, g)` yields the result of applying the L-BFGS
+      approximation of the inverse Hessian to `g` by the two-loop recursion.
+      Optional argument `scaled` is set with a boolean indicating whether any
+      scaling was applied (if false, the result is just `g`).  If optional
+      argument `freevars` is specified, the recursion is restricted to the
+      subspace of the free variables: `freevars` is an array of the same
+      dimensions as `g` set to 1 for free variables and 0 for the others and
+      the result is zero for the blocked variables.
+
+      `vops_lbfgs_reset, lbfgs` forgets all memorized pairs.
+
+      Members `lbfgs.m`, `lbfgs.mp` (number of memorized pairs), `lbfgs.mrk`
+      (index of the last update), `lbfgs.gamma`, `lbfgs.rho` (the `<s,y>`),
+      `lbfgs.S` and `lbfgs.Y` (the pairs along the last dimension) can be
+      queried.  This object is used by `optm_vmlmb` when `optm.i` is loaded
+      with fast vectorized operations.
+
+   SEE ALSO: vops, optm_new_lbfgs.
  */
 
 local vops_tic, vops_toc, vops_flops, vops_time;
@@ -20,6 +20,10 @@
 #include <math.h>
 #include <float.h>
 
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
 #include <pstdlib.h>
 #include <play.h>
 #include <yapi.h>
@@ -64,15 +68,55 @@ static inline array* get_array(int iarg, array* arr)
     return arr;
 }
 
+// Push a new array of type `T` (`float` or `double`) and dimensions `dims`.
+// Unlike with `ypush_d`, a scalar is stored in a data block, hence its
+// contents may be shared with a variable.
+static void* push_array(int T, const long* dims)
+{
+    long one[2] = {1, 1};
+    const long* tmp = (dims == NULL || dims[0] == 0 ? one : dims);
+    void* ptr = (T == Y_FLOAT ? (void*)ypush_f((long*)tmp) :
+                 (void*)ypush_d((long*)tmp));
+    if (tmp != dims) {
+        yarg_reform(0, NULL);
+    }
+    return ptr;
+}
+
 static inline void coerce(int iarg, array* arr, int type)
 {
     if (arr->type != type) {
-        arr->data = ygeta_coerce(iarg, arr->data, arr->ntot, arr->dims,
-                                 arr->type, type);
+        if (arr->dims[0] == 0 && (type == Y_DOUBLE || type == Y_FLOAT)) {
+            // `ygeta_coerce` crashes for scalars not stored in a data block,
+            // replace the argument by a converted copy.
+            double val = ygets_d(iarg);
+            void* ptr = push_array(type, arr->dims);
+            if (type == Y_DOUBLE) {
+                *(double*)ptr = val;
+            } else {
+                *(float*)ptr = (float)val;
+            }
+            yarg_swap(0, iarg + 1);
+            yarg_drop(1);
+            arr->data = ptr;
+        } else {
+            arr->data = ygeta_coerce(iarg, arr->data, arr->ntot, arr->dims,
+                                     arr->type, type);
+        }
         arr->type = type;
     }
 }
 
+// Scalar `double` values may be stored in the stack rather than in a data
+// block, so the caller's variable `index` must be redefined after the
+// argument `iarg` has been modified in-place.
+static inline void sync_scalar(long index, int iarg, const array* arr)
+{
+    if (arr->dims[0] == 0 && index >= 0) {
+        yput_global(index, iarg);
+    }
+}
+
 static inline array* get_real_array(int iarg, array* arr, bool inplace)
 {
     long index;
@@ -144,19 +188,170 @@ ENCODE_(max_flt, float);
 ENCODE_(max_dbl, double);
 #undef ENCODE_
 
+#define add(a, b) ((a) + (b))
+
+//-----------------------------------------------------------------------------
+// PARALLEL AND SIMD DRIVERS
+//
+// Reductions accumulate their terms into `VOPS_LANES` independent partial
+// results: the `k`-th term always goes into the `(k % VOPS_LANES)`-th partial
+// result so that the innermost loops map directly onto SIMD registers (with
+// several registers in flight to hide the latency of the operations) without
+// re-associating floating-point operations.
+//
+// Large arrays are split into at most `VOPS_MAX_CHUNKS` chunks whose size
+// only depends on the number of elements.  Chunks are distributed among
+// threads (if compiled with OpenMP support) and their partial results are
+// combined in a fixed order, hence the result of a reduction does not depend
+// on the number of threads.
+
+#ifdef _OPENMP
+#  define VOPS_STRINGIFY(x) #x
+#  define VOPS_OMP(args) _Pragma(VOPS_STRINGIFY(omp args))
+#else
+#  define VOPS_OMP(args)
+#endif
+
+#define VOPS_LANES 16
+#define VOPS_MAX_CHUNKS 256
+#define VOPS_MIN_CHUNK_SIZE 8192
+#define VOPS_MIN_ELEMENTS_PER_THREAD 32768
+
+// Accumulate `term` (an expression of the index `k`) for all `k` in
+// `0:n-1` into `res` with the binary operation `op`.  Statement `body` is
+// executed for each `k` before evaluating `term`.
+#define VOPS_ACCUMULATE(T, res, n, k, body, op, term)   \
+    do {                                                \
+        T s_[VOPS_LANES] = {0};                         \
+        long j_ = 0, m_ = (n) - (n)%VOPS_LANES;         \
+        for (; j_ < m_; j_ += VOPS_LANES) {             \
+            for (int l_ = 0; l_ < VOPS_LANES; ++l_) {   \
+                long k = j_ + l_;                       \
+                body;                                   \
+                s_[l_] = op(s_[l_], term);              \
+            }                                           \
+        }                                               \
+        for (int l_ = 0; j_ < (n); ++j_, ++l_) {        \
+            long k = j_;                                \
+            body;                                       \
+            s_[l_] = op(s_[l_], term);                  \
+        }                                               \
+        for (int w_ = VOPS_LANES/2; w_ > 0; w_ /= 2) {  \
+            for (int l_ = 0; l_ < w_; ++l_) {           \
+                s_[l_] = op(s_[l_], s_[l_ + w_]);       \
+            }                                           \
+        }                                               \
+        res = s_[0];                                    \
+    } while (false)
+
+// Operands of the kernels applied by the drivers.
+typedef struct args {
+    void*       dst;
+    const void* w;
+    const void* x;
+    const void* y;
+    const void* z;
+    double      alpha;
+    double      beta;
+} args;
+
+// Kernels process `n` elements starting at index `i`.
+typedef double reducer(const args* a, long i, long n);
+typedef void   mapper(const args* a, long i, long n);
+
+static int nthreads_for(long n)
+{
+#ifdef _OPENMP
+    long m = n/VOPS_MIN_ELEMENTS_PER_THREAD;
+    if (m > 1) {
+        int nthreads = omp_get_max_threads();
+        return (m < nthreads ? (int)m : nthreads);
+    }
+#endif
+    return 1;
+}
+
+static long chunk_size(long n)
+{
+    long size = (n + VOPS_MAX_CHUNKS - 1)/VOPS_MAX_CHUNKS;
+    if (size < VOPS_MIN_CHUNK_SIZE) {
+        size = VOPS_MIN_CHUNK_SIZE;
+    }
+    return ((size + VOPS_LANES - 1)/VOPS_LANES)*VOPS_LANES;
+}
+
+static double reduce(reducer* func, const args* a, long n, bool maximum)
+{
+    double part[VOPS_MAX_CHUNKS];
+    long size = chunk_size(n);
+    long nchunks = (n + size - 1)/size;
+    int nthreads = nthreads_for(n);
+    VOPS_OMP(parallel for num_threads(nthreads) schedule(static) if(nthreads > 1))
+    for (long c = 0; c < nchunks; ++c) {
+        long i = c*size;
+        part[c] = func(a, i, (n - i < size ? n - i : size));
+    }
+    double res = 0;
+    for (long c = 0; c < nchunks; ++c) {
+        res = (maximum ? max_dbl(res, part[c]) : res + part[c]);
+    }
+    return res;
+}
+
+// Same as `reduce` but for kernels computing `nres ≤ VOPS_MAX_RESULTS` sums
+// at the same time.
+#define VOPS_MAX_RESULTS 3
+typedef void multi_reducer(const args* a, long i, long n, double* res);
+
+static void reduce_many(multi_reducer* func, const args* a, long n,
+                        int nres, double* res)
+{
+    double part[VOPS_MAX_CHUNKS][VOPS_MAX_RESULTS];
+    long size = chunk_size(n);
+    long nchunks = (n + size - 1)/size;
+    int nthreads = nthreads_for(n);
+    VOPS_OMP(parallel for num_threads(nthreads) schedule(static) if(nthreads > 1))
+    for (long c = 0; c < nchunks; ++c) {
+        long i = c*size;
+        func(a, i, (n - i < size ? n - i : size), part[c]);
+    }
+    for (int r = 0; r < nres; ++r) {
+        res[r] = 0;
+        for (long c = 0; c < nchunks; ++c) {
+            res[r] += part[c][r];
+        }
+    }
+}
+
+static void map(mapper* func, const args* a, long n)
+{
+    int nthreads = nthreads_for(n);
+    if (nthreads <= 1) {
+        func(a, 0, n);
+    } else {
+        long size = chunk_size(n);
+        long nchunks = (n + size - 1)/size;
+        VOPS_OMP(parallel for num_threads(nthreads) schedule(static))
+        for (long c = 0; c < nchunks; ++c) {
+            long i = c*size;
+            func(a, i, (n - i < size ? n - i : size));
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 // VOPS_NORM1
 
-#define ENCODE_(func, T, abs)               \
-    static T func(                          \
-        const T* x,                         \
-        long     n)                         \
-    {                                       \
-        T s = 0;                            \
-        for (long i = 0; i < n; ++i) {      \
-            s += abs(x[i]);                 \
-        }                                   \
-        return s;                           \
+#define ENCODE_(func, T, abs)                                           \
+    static double func(                                                 \
+        const args* a,                                                  \
+        long        i,                                                  \
+        long        n)                                                  \
+    {                                                                   \
+        const T* x = (const T*)a->x + i;                                \
+        T s;                                                            \
+        VOPS_ACCUMULATE(T, s, n, k, (void)0, add, abs(x[k]));       \
+        return s;                                                       \
     }
 ENCODE_(vops_norm1_flt, float, fabsf);
 ENCODE_(vops_norm1_dbl, double, fabs);
@@ -169,35 +364,28 @@ void Y_vops_norm1(int argc)
     }
     array x;
     get_real_array(0, &x, false);
-    double nrm;
-    if (x.type == Y_DOUBLE) {
-        nrm = vops_norm1_dbl(x.data, x.ntot);
-    } else {
-        nrm = vops_norm1_flt(x.data, x.ntot);
-    }
+    args a = {.x = x.data};
+    double nrm = reduce(x.type == Y_DOUBLE ? vops_norm1_dbl : vops_norm1_flt,
+                        &a, x.ntot, false);
     ypush_double(nrm);
 }
 
 //-----------------------------------------------------------------------------
 // VOPS_NORM2
 
-#define ENCODE_(func, T, abs, sqrt)             \
-    static T func(                              \
-        const T* x,                             \
-        long     n)                             \
-    {                                           \
-        if (n == 1) {                           \
-            return abs(x[0]);                   \
-        } else {                                \
-            T s = 0;                            \
-            for (long i = 0; i < n; ++i) {      \
-                s += x[i]*x[i];                 \
-            }                                   \
-            return sqrt(s);                     \
-        }                                       \
+#define ENCODE_(func, T)                                                \
+    static double func(                                                 \
+        const args* a,                                                  \
+        long        i,                                                  \
+        long        n)                                                  \
+    {                                                                   \
+        const T* x = (const T*)a->x + i;                                \
+        T s;                                                            \
+        VOPS_ACCUMULATE(T, s, n, k, (void)0, add, x[k]*x[k]);       \
+        return s;                                                       \
     }
-ENCODE_(vops_norm2_flt, float, fabsf, sqrtf);
-ENCODE_(vops_norm2_dbl, double, fabs, sqrt);
+ENCODE_(vops_norm2_flt, float);
+ENCODE_(vops_norm2_dbl, double);
 #undef ENCODE_
 
 void Y_vops_norm2(int argc)
@@ -208,10 +396,13 @@ void Y_vops_norm2(int argc)
     array x;
     get_real_array(0, &x, false);
     double nrm;
-    if (x.type == Y_DOUBLE) {
-        nrm = vops_norm2_dbl(x.data, x.ntot);
+    if (x.ntot == 1) {
+        nrm = (x.type == Y_DOUBLE ? fabs(((double*)x.data)[0]) :
+               fabsf(((float*)x.data)[0]));
     } else {
-        nrm = vops_norm2_flt(x.data, x.ntot);
+        args a = {.x = x.data};
+        nrm = sqrt(reduce(x.type == Y_DOUBLE ? vops_norm2_dbl : vops_norm2_flt,
+                          &a, x.ntot, false));
     }
     ypush_double(nrm);
 }
@@ -219,20 +410,16 @@ void Y_vops_norm2(int argc)
 //-----------------------------------------------------------------------------
 // VOPS_NORMINF
 
-#define ENCODE_(func, T, abs, max)              \
-    static T func(                              \
-        const T* x,                             \
-        long     n)                             \
-    {                                           \
-        if (n == 1) {                           \
-            return abs(x[0]);                   \
-        } else {                                \
-            T s = 0;                            \
-            for (long i = 0; i < n; ++i) {      \
-                s = max(s, abs(x[i]));          \
-            }                                   \
-            return s;                           \
-        }                                       \
+#define ENCODE_(func, T, abs, max)                                      \
+    static double func(                                                 \
+        const args* a,                                                  \
+        long        i,                                                  \
+        long        n)                                                  \
+    {                                                                   \
+        const T* x = (const T*)a->x + i;                                \
+        T s;                                                            \
+        VOPS_ACCUMULATE(T, s, n, k, (void)0, max, abs(x[k]));           \
+        return s;                                                       \
     }
 ENCODE_(vops_norminf_flt, float, fabsf, max_flt);
 ENCODE_(vops_norminf_dbl, double, fabs, max_dbl);
@@ -245,46 +432,43 @@ void Y_vops_norminf(int argc)
     }
     array x;
     get_real_array(0, &x, false);
-    double nrm;
-    if (x.type == Y_DOUBLE) {
-        nrm = vops_norminf_dbl(x.data, x.ntot);
-    } else {
-        nrm = vops_norminf_flt(x.data, x.ntot);
-    }
+    args a = {.x = x.data};
+    double nrm = reduce(x.type == Y_DOUBLE ? vops_norminf_dbl :
+                        vops_norminf_flt, &a, x.ntot, true);
     ypush_double(nrm);
 }
 
 //-----------------------------------------------------------------------------
 // VOPS_INNER
 
-#define ENCODE_(func, T)                        \
-    static T func(                              \
-        const T* restrict x,                    \
-        const T* restrict y,                    \
-        long n)                                 \
-    {                                           \
-        T s = 0;                                \
-        for (long i = 0; i < n; ++i) {          \
-            s += x[i]*y[i];                     \
-        }                                       \
-        return s;                               \
+#define ENCODE_(func, T)                                                \
+    static double func(                                                 \
+        const args* a,                                                  \
+        long        i,                                                  \
+        long        n)                                                  \
+    {                                                                   \
+        const T* restrict x = (const T*)a->x + i;                       \
+        const T* restrict y = (const T*)a->y + i;                       \
+        T s;                                                            \
+        VOPS_ACCUMULATE(T, s, n, k, (void)0, add, x[k]*y[k]);       \
+        return s;                                                       \
     }
 ENCODE_(vops_inner2_flt, float);
 ENCODE_(vops_inner2_dbl, double);
 #undef ENCODE_
 
-#define ENCODE_(func, T)                        \
-    static T func(                              \
-        const T* restrict w,                    \
-        const T* restrict x,                    \
-        const T* restrict y,                    \
-        long n)                                 \
-    {                                           \
-        T s = 0;                                \
-        for (long i = 0; i < n; ++i) {          \
-            s += w[i]*x[i]*y[i];                \
-        }                                       \
-        return s;                               \
+#define ENCODE_(func, T)                                                \
+    static double func(                                                 \
+        const args* a,                                                  \
+        long        i,                                                  \
+        long        n)                                                  \
+    {                                                                   \
+        const T* restrict w = (const T*)a->w + i;                       \
+        const T* restrict x = (const T*)a->x + i;                       \
+        const T* restrict y = (const T*)a->y + i;                       \
+        T s;                                                            \
+        VOPS_ACCUMULATE(T, s, n, k, (void)0, add, w[k]*x[k]*y[k]);  \
+        return s;                                                       \
     }
 ENCODE_(vops_inner3_flt, float);
 ENCODE_(vops_inner3_dbl, double);
@@ -336,19 +520,15 @@ void Y_vops_inner(int argc)
     double res;
     coerce(x_iarg, &x, T);
     coerce(y_iarg, &y, T);
+    args a = {.x = x.data, .y = y.data};
     if (argc > 2) {
-        coerce(w_iarg, &y, T);
-        if (T == Y_DOUBLE) {
-            res = vops_inner3_dbl(w.data, x.data, y.data, x.ntot);
-        } else {
-            res = vops_inner3_flt(w.data, x.data, y.data, x.ntot);
-        }
+        coerce(w_iarg, &w, T);
+        a.w = w.data;
+        res = reduce(T == Y_DOUBLE ? vops_inner3_dbl : vops_inner3_flt,
+                     &a, x.ntot, false);
     } else {
-        if (T == Y_DOUBLE) {
-            res = vops_inner2_dbl(x.data, y.data, x.ntot);
-        } else {
-            res = vops_inner2_flt(x.data, y.data, x.ntot);
-        }
+        res = reduce(T == Y_DOUBLE ? vops_inner2_dbl : vops_inner2_flt,
+                     &a, x.ntot, false);
     }
     ypush_double(res);
 }
@@ -387,6 +567,18 @@ ENCODE_(vops_scale_flt, float);
 ENCODE_(vops_scale_dbl, double);
 #undef ENCODE_
 
+#define ENCODE_(func, T, scale)                                         \
+    static void func(                                                   \
+        const args* a,                                                  \
+        long        i,                                                  \
+        long        n)                                                  \
+    {                                                                   \
+        scale((T*)a->dst + i, a->alpha, (const T*)a->x + i, n);         \
+    }
+ENCODE_(vops_scale_map_flt, float,  vops_scale_flt);
+ENCODE_(vops_scale_map_dbl, double, vops_scale_dbl);
+#undef ENCODE_
+
 void Y_vops_scale(int argc)
 {
     if (argc != 2) {
@@ -401,6 +593,7 @@ void Y_vops_scale(int argc)
         a_iarg = x_iarg;
         x_iarg = tmp;
     }
+    long x_index = (inplace ? yget_ref(x_iarg) : -1);
     array x;
     get_real_array(x_iarg, &x, inplace);
     double alpha = ygets_d(a_iarg);
@@ -413,10 +606,10 @@ void Y_vops_scale(int argc)
     } else {
         dst = ypush_d(x.dims);
     }
-    if (single) {
-        vops_scale_flt(dst, alpha, x.data, x.ntot);
-    } else {
-        vops_scale_dbl(dst, alpha, x.data, x.ntot);
+    args a = {.dst = dst, .x = x.data, .alpha = alpha};
+    map(single ? vops_scale_map_flt : vops_scale_map_dbl, &a, x.ntot);
+    if (inplace) {
+        sync_scalar(x_index, x_iarg, &x);
     }
 }
 
@@ -448,54 +641,154 @@ ENCODE_(vops_update_flt, float);
 ENCODE_(vops_update_dbl, double);
 #undef ENCODE_
 
-void Y_vops_update(int argc)
-{
-    if (argc != 3) {
-        y_error("usage: vops_update, y, alpha, x;");
+#define ENCODE_(func, T, update)                                        \
+    static void func(                                                   \
+        const args* a,                                                  \
+        long        i,                                                  \
+        long        n)                                                  \
+    {                                                                   \
+        update((T*)a->dst + i, a->alpha, (const T*)a->x + i, n);        \
     }
-    int y_iarg = argc - 1;
-    int a_iarg = argc - 2;
-    int x_iarg = argc - 3;
+ENCODE_(vops_update_map_flt, float,  vops_update_flt);
+ENCODE_(vops_update_map_dbl, double, vops_update_dbl);
+#undef ENCODE_
+
+// Get the arguments `y`, `alpha`, and `x` of an update `y += alpha*x`.
+// Arrays `x` and `y` are converted to their common floating-point type which
+// is returned.  The caller's variable `y` (whose index is stored in
+// `*y_index`) is redefined if its type changes.
+static int get_update_args(
+    int     y_iarg,
+    int     a_iarg,
+    int     x_iarg,
+    array*  y,
+    double* alpha,
+    array*  x,
+    long*   y_index_ptr)
+{
     long y_index = yget_ref(y_iarg);
-    array y;
-    get_array(y_iarg, &y);
-    if ((unsigned)y.type > Y_DOUBLE) {
+    *y_index_ptr = y_index;
+    get_array(y_iarg, y);
+    if ((unsigned)y->type > Y_DOUBLE) {
         y_error("argument `y` is not real-valued");
     }
-    double alpha = ygets_d(a_iarg);
-    array x;
-    get_array(x_iarg, &x);
-    if ((unsigned)x.type > Y_DOUBLE) {
+    *alpha = ygets_d(a_iarg);
+    get_array(x_iarg, x);
+    if ((unsigned)x->type > Y_DOUBLE) {
         y_error("argument `x` is not real-valued");
     }
-    if (!same_dims(x.dims, y.dims)) {
+    if (!same_dims(x->dims, y->dims)) {
         y_error("arguments `x` and `y` must have the same dimensions");
     }
-    int T = promote_type(x.type, y.type);
+    int T = promote_type(x->type, y->type);
     if (T < 0) {
         y_error("arguments `x` and `y` have unsupported types");
     }
     if (T != Y_FLOAT) {
         T = Y_DOUBLE;
     }
-    if (y.type != T) {
+    if (y->type != T) {
         if (y_index < 0) {
             y_error("argument `y` must not be an expression or must have "
                     "correct element type (`float` if `x` and `y` both "
                     "have `float` elements, or `double` otherwise)");
         }
-        coerce(y_iarg, &y, T);
+        coerce(y_iarg, y, T);
         yput_global(y_index, y_iarg);
     }
-    coerce(x_iarg, &x, T);
-    if (T == Y_FLOAT) {
-        vops_update_flt(y.data, alpha, x.data, x.ntot);
-    } else {
-        vops_update_dbl(y.data, alpha, x.data, x.ntot);
+    coerce(x_iarg, x, T);
+    return T;
+}
+
+// Get an extra operand `z` of a fused operation and convert it to type `T`.
+static void get_extra_arg(int z_iarg, array* z, int T, const long* dims)
+{
+    get_array(z_iarg, z);
+    if ((unsigned)z->type > Y_DOUBLE) {
+        y_error("argument `z` is not real-valued");
     }
+    if (!same_dims(z->dims, dims)) {
+        y_error("arguments must have the same dimensions");
+    }
+    coerce(z_iarg, z, T);
+}
+
+void Y_vops_update(int argc)
+{
+    if (argc != 3) {
+        y_error("usage: vops_update, y, alpha, x;");
+    }
+    array x, y;
+    double alpha;
+    long y_index;
+    int T = get_update_args(argc - 1, argc - 2, argc - 3,
+                            &y, &alpha, &x, &y_index);
+    args a = {.dst = y.data, .x = x.data, .alpha = alpha};
+    map(T == Y_FLOAT ? vops_update_map_flt : vops_update_map_dbl,
+        &a, x.ntot);
+    sync_scalar(y_index, argc - 1, &y);
     yarg_drop(argc - 1);
 }
 
+//-----------------------------------------------------------------------------
+// VOPS_UPDATE_INNER and VOPS_UPDATE_NORM2
+
+// The updated values are written before being read for the inner product, so
+// `z` may be the same array as `x` or `y`.
+#define ENCODE_(func, T)                                                \
+    static double func(                                                 \
+        const args* a,                                                  \
+        long        i,                                                  \
+        long        n)                                                  \
+    {                                                                   \
+        T* y = (T*)a->dst + i;                                          \
+        const T* x = (const T*)a->x + i;                                \
+        const T* z = (const T*)a->z + i;                                \
+        const T alpha = a->alpha;                                       \
+        T s;                                                            \
+        VOPS_ACCUMULATE(T, s, n, k, y[k] += alpha*x[k],                 \
+                        add, y[k]*z[k]);                            \
+        return s;                                                       \
+    }
+ENCODE_(vops_update_inner_flt, float);
+ENCODE_(vops_update_inner_dbl, double);
+#undef ENCODE_
+
+void Y_vops_update_inner(int argc)
+{
+    if (argc != 4) {
+        y_error("usage: vops_update_inner(y, alpha, x, z)");
+    }
+    array x, y, z;
+    double alpha;
+    long y_index;
+    int T = get_update_args(argc - 1, argc - 2, argc - 3,
+                            &y, &alpha, &x, &y_index);
+    get_extra_arg(argc - 4, &z, T, x.dims);
+    args a = {.dst = y.data, .x = x.data, .z = z.data, .alpha = alpha};
+    double res = reduce(T == Y_FLOAT ? vops_update_inner_flt :
+                        vops_update_inner_dbl, &a, x.ntot, false);
+    sync_scalar(y_index, argc - 1, &y);
+    ypush_double(res);
+}
+
+void Y_vops_update_norm2(int argc)
+{
+    if (argc != 3) {
+        y_error("usage: vops_update_norm2(y, alpha, x)");
+    }
+    array x, y;
+    double alpha;
+    long y_index;
+    int T = get_update_args(argc - 1, argc - 2, argc - 3,
+                            &y, &alpha, &x, &y_index);
+    args a = {.dst = y.data, .x = x.data, .z = y.data, .alpha = alpha};
+    double res = reduce(T == Y_FLOAT ? vops_update_inner_flt :
+                        vops_update_inner_dbl, &a, x.ntot, false);
+    sync_scalar(y_index, argc - 1, &y);
+    ypush_double(sqrt(res));
+}
+
 //-----------------------------------------------------------------------------
 // VOPS_COMBINE
 
@@ -555,67 +848,82 @@ ENCODE_(vops_combine_flt, float,  vops_scale_flt);
 ENCODE_(vops_combine_dbl, double, vops_scale_dbl);
 #undef ENCODE_
 
-void Y_vops_combine(int argc)
-{
-    int d_iarg, a_iarg, x_iarg, b_iarg, y_iarg;
-    long d_index;
-    if (argc == 5) {
-        d_iarg = argc - 1;
-        a_iarg = argc - 2;
-        x_iarg = argc - 3;
-        b_iarg = argc - 4;
-        y_iarg = argc - 5;
-        d_index = yget_ref(d_iarg); // before any other operations
-    } else if (argc == 4 && !yarg_subroutine()) {
-        d_iarg = -1;
-        a_iarg = argc - 1;
-        x_iarg = argc - 2;
-        b_iarg = argc - 3;
-        y_iarg = argc - 4;
-        d_index = -1;
-    } else {
-        y_error(yarg_subroutine() ?
-                "usage: vops_combine, dst, alpha, x, beta, y;":
-                "usage: vops_combine([dst,] alpha, x, beta, y)");
-        return;
+#define ENCODE_(func, T, combine)                                       \
+    static void func(                                                   \
+        const args* a,                                                  \
+        long        i,                                                  \
+        long        n)                                                  \
+    {                                                                   \
+        combine((T*)a->dst + i, a->alpha, (const T*)a->x + i,           \
+                a->beta, (const T*)a->y + i, n);                        \
     }
+ENCODE_(vops_combine_map_flt, float,  vops_combine_flt);
+ENCODE_(vops_combine_map_dbl, double, vops_combine_dbl);
+#undef ENCODE_
 
-    // Get input arguments.
-    double alpha = ygets_d(a_iarg);
-    array x;
-    get_array(x_iarg, &x);
-    if ((unsigned)x.type > Y_DOUBLE) {
+// Get the arguments `alpha`, `x`, `beta`, and `y` of a linear combination
+// `alpha*x + beta*y`.  Arrays `x` and `y` are converted to their common
+// floating-point type which is returned.
+static int get_combine_args(
+    int     a_iarg,
+    int     x_iarg,
+    int     b_iarg,
+    int     y_iarg,
+    double* alpha,
+    array*  x,
+    double* beta,
+    array*  y)
+{
+    *alpha = ygets_d(a_iarg);
+    get_array(x_iarg, x);
+    if ((unsigned)x->type > Y_DOUBLE) {
         y_error("argument `x` is not real-valued");
     }
-    double beta = ygets_d(b_iarg);
-    array y;
-    get_array(y_iarg, &y);
-    if ((unsigned)y.type > Y_DOUBLE) {
+    *beta = ygets_d(b_iarg);
+    get_array(y_iarg, y);
+    if ((unsigned)y->type > Y_DOUBLE) {
         y_error("argument `y` is not real-valued");
     }
-    if (!same_dims(x.dims, y.dims)) {
+    if (!same_dims(x->dims, y->dims)) {
         y_error("arguments `x` and `y` must have the same dimensions");
     }
-    int T = promote_type(x.type, y.type);
+    int T = promote_type(x->type, y->type);
     if (T < 0) {
         y_error("arguments `x` and `y` have unsupported types");
     }
     if (T != Y_FLOAT) {
         T = Y_DOUBLE;
     }
+    coerce(x_iarg, x, T);
+    coerce(y_iarg, y, T);
+    return T;
+}
 
-    // Get/create output array.
-    int drop = 0;
+// Get the destination for the result of a linear combination of arrays of
+// type `T` and dimensions `dims`.  If `d_iarg` is nonnegative, the contents of
+// this argument is re-used if it has the correct type and dimensions;
+// otherwise, a new array is pushed on top of the stack and, if `d_index` is
+// nonnegative, the caller's variable is redefined.  On return, `*drop` is the
+// number of stack elements to drop to leave the destination on top of the
+// stack.
+static void* get_destination(
+    int         d_iarg,
+    long        d_index,
+    int         T,
+    const long* dims,
+    int*        drop)
+{
     void* dst = NULL;
+    *drop = 0;
     if (d_iarg >= 0) {
         int d_type = yarg_typeid(d_iarg);
-        if (d_type == T && yarg_rank(d_iarg) == x.dims[0]) {
+        if (d_type == T && yarg_rank(d_iarg) == dims[0]) {
             array d;
             get_array(d_iarg, &d);
-            if (same_dims(x.dims, d.dims)) {
+            if (same_dims(dims, d.dims)) {
                 // Re-use the destination.
                 dst = d.data;
-                drop = d_iarg;
+                *drop = d_iarg;
             }
         }
         if (dst == NULL) {
@@ -635,26 +943,618 @@ void Y_vops_combine(int argc)
     }
     if (dst == NULL) {
         // Allocate output array.
-        if (T == Y_FLOAT) {
-            dst = ypush_f(x.dims);
-        } else {
-            dst = ypush_d(x.dims);
-        }
+        dst = push_array(T, dims);
         if (d_index >= 0) {
             yput_global(d_index, 0);
         }
     }
+    return dst;
+}
 
-    // Convert input arrays and call function.
-    coerce(x_iarg, &x, T);
-    coerce(y_iarg, &y, T);
-    if (T == Y_FLOAT) {
-        vops_combine_flt(dst, alpha, x.data, beta, y.data, x.ntot);
+void Y_vops_combine(int argc)
+{
+    int d_iarg, a_iarg, x_iarg, b_iarg, y_iarg;
+    long d_index;
+    if (argc == 5) {
+        d_iarg = argc - 1;
+        a_iarg = argc - 2;
+        x_iarg = argc - 3;
+        b_iarg = argc - 4;
+        y_iarg = argc - 5;
+        d_index = yget_ref(d_iarg); // before any other operations
+    } else if (argc == 4 && !yarg_subroutine()) {
+        d_iarg = -1;
+        a_iarg = argc - 1;
+        x_iarg = argc - 2;
+        b_iarg = argc - 3;
+        y_iarg = argc - 4;
+        d_index = -1;
     } else {
-        vops_combine_dbl(dst, alpha, x.data, beta, y.data, x.ntot);
+        y_error(yarg_subroutine() ?
+                "usage: vops_combine, dst, alpha, x, beta, y;":
+                "usage: vops_combine([dst,] alpha, x, beta, y)");
+        return;
     }
+
+    // Get and convert input arguments, then get/create output array.
+    array x, y;
+    double alpha, beta;
+    int T = get_combine_args(a_iarg, x_iarg, b_iarg, y_iarg,
+                             &alpha, &x, &beta, &y);
+    int drop;
+    void* dst = get_destination(d_iarg, d_index, T, x.dims, &drop);
+
+    // Call function.
+    args a = {.dst = dst, .x = x.data, .y = y.data,
+              .alpha = alpha, .beta = beta};
+    map(T == Y_FLOAT ? vops_combine_map_flt : vops_combine_map_dbl,
+        &a, x.ntot);
     if (drop > 0) {
         // Leave result on top of the stack.
-        yarg_drop(d_iarg);
+        yarg_drop(drop);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// VOPS_COMBINE_INNER
+
+// The combination is written before being read for the inner product, so
+// `z` and the destination may be the same array as `x` or `y`.
+#define ENCODE_(func, T)                                                \
+    static double func(                                                 \
+        const args* a,                                                  \
+        long        i,                                                  \
+        long        n)                                                  \
+    {                                                                   \
+        T* dst = (T*)a->dst + i;                                        \
+        const T* x = (const T*)a->x + i;                                \
+        const T* y = (const T*)a->y + i;                                \
+        const T* z = (const T*)a->z + i;                                \
+        const T alpha = a->alpha;                                       \
+        const T beta = a->beta;                                         \
+        T s;                                                            \
+        VOPS_ACCUMULATE(T, s, n, k, dst[k] = alpha*x[k] + beta*y[k],    \
+                        add, dst[k]*z[k]);                          \
+        return s;                                                       \
+    }
+ENCODE_(vops_combine_inner_flt, float);
+ENCODE_(vops_combine_inner_dbl, double);
+#undef ENCODE_
+
+void Y_vops_combine_inner(int argc)
+{
+    if (argc != 6) {
+        y_error("usage: vops_combine_inner(dst, alpha, x, beta, y, z)");
+    }
+    int d_iarg = argc - 1;
+    long d_index = yget_ref(d_iarg); // before any other operations
+    array x, y, z;
+    double alpha, beta;
+    int T = get_combine_args(argc - 2, argc - 3, argc - 4, argc - 5,
+                             &alpha, &x, &beta, &y);
+    get_extra_arg(argc - 6, &z, T, x.dims);
+    int drop;
+    void* dst = get_destination(d_iarg, d_index, T, x.dims, &drop);
+    args a = {.dst = dst, .x = x.data, .y = y.data, .z = z.data,
+              .alpha = alpha, .beta = beta};
+    double res = reduce(T == Y_FLOAT ? vops_combine_inner_flt :
+                        vops_combine_inner_dbl, &a, x.ntot, false);
+    ypush_double(res);
+}
+
+//-----------------------------------------------------------------------------
+// VOPS_LBFGS
+//
+// L-BFGS memory with contiguous storage for the `m` pairs `(s,y)` of
+// variable and gradient changes and compiled two-loop recursion.  Storage is
+// allocated by the first update which fixes the type and the dimensions of
+// the variables.
+
+typedef struct lbfgs {
+    long    m;                // maximum number of memorized pairs
+    long    mp;               // current number of memorized pairs
+    long    mrk;              // 1-based index of last update, 0 if none
+    long    n;                // number of variables, 0 if not yet known
+    int     type;             // type of the variables
+    long    dims[Y_DIMSIZE];  // dimensions of the variables
+    double  gamma;            // gradient scaling
+    double* rho;              // memorized values of `<s,y>`
+    void*   S;                // memorized variable changes
+    void*   Y;                // memorized gradient changes
+} lbfgs;
+
+#define LBFGS_TYPE_NAME "L-BFGS memory"
+
+static void lbfgs_release(lbfgs* obj)
+{
+    if (obj->S != NULL) {
+        p_free(obj->S);
+        obj->S = NULL;
+    }
+    if (obj->Y != NULL) {
+        p_free(obj->Y);
+        obj->Y = NULL;
+    }
+    obj->n = 0;
+    obj->dims[0] = 0;
+}
+
+static void lbfgs_free(void* addr)
+{
+    lbfgs* obj = addr;
+    lbfgs_release(obj);
+    if (obj->rho != NULL) {
+        p_free(obj->rho);
+    }
+}
+
+static void lbfgs_print(void* addr)
+{
+    lbfgs* obj = addr;
+    char buffer[100];
+    snprintf(buffer, sizeof(buffer), " (m = %ld, mp = %ld, n = %ld)",
+             obj->m, obj->mp, obj->n);
+    buffer[sizeof(buffer)-1] = 0;
+    y_print(LBFGS_TYPE_NAME, 0);
+    y_print(buffer, 1);
+}
+
+// Push a copy of the memorized pairs as an array of dimensions `(dims..,m)`.
+static void lbfgs_push_pairs(const lbfgs* obj, const void* src)
+{
+    if (obj->n == 0 || obj->m == 0) {
+        ypush_nil();
+        return;
+    }
+    long ndims = obj->dims[0];
+    if (ndims + 1 >= Y_DIMSIZE) {
+        y_error("too many dimensions");
+    }
+    long dims[Y_DIMSIZE];
+    memcpy(dims, obj->dims, (ndims + 1)*sizeof(long));
+    dims[0] = ndims + 1;
+    dims[ndims + 1] = obj->m;
+    size_t size = (obj->type == Y_FLOAT ? sizeof(float) : sizeof(double));
+    memcpy(push_array(obj->type, dims), src, obj->m*obj->n*size);
+}
+
+static void lbfgs_extract(void* addr, char* name)
+{
+    lbfgs* obj = addr;
+    if (strcmp(name, "m") == 0) {
+        ypush_long(obj->m);
+    } else if (strcmp(name, "mp") == 0) {
+        ypush_long(obj->mp);
+    } else if (strcmp(name, "mrk") == 0) {
+        ypush_long(obj->mrk);
+    } else if (strcmp(name, "n") == 0) {
+        ypush_long(obj->n);
+    } else if (strcmp(name, "gamma") == 0) {
+        ypush_double(obj->gamma);
+    } else if (strcmp(name, "rho") == 0) {
+        if (obj->m > 0) {
+            long dims[2] = {1, obj->m};
+            memcpy(ypush_d(dims), obj->rho, obj->m*sizeof(double));
+        } else {
+            ypush_nil();
+        }
+    } else if (strcmp(name, "S") == 0) {
+        lbfgs_push_pairs(obj, obj->S);
+    } else if (strcmp(name, "Y") == 0) {
+        lbfgs_push_pairs(obj, obj->Y);
+    } else {
+        y_error("unknown L-BFGS memory member");
+    }
+}
+
+static y_userobj_t lbfgs_type = {
+    LBFGS_TYPE_NAME,
+    lbfgs_free,
+    lbfgs_print,
+    NULL,
+    lbfgs_extract,
+    NULL
+};
+
+// Compute `<s,y>` and `<y,y>`.
+#define ENCODE_(func, T)                                                \
+    static void func(                                                   \
+        const args* a,                                                  \
+        long        i,                                                  \
+        long        n,                                                  \
+        double*     res)                                                \
+    {                                                                   \
+        const T* s = (const T*)a->x + i;                                \
+        const T* y = (const T*)a->y + i;                                \
+        T sty[VOPS_LANES] = {0}, yty[VOPS_LANES] = {0};                 \
+        long j = 0, m = n - n%VOPS_LANES;                               \
+        for (; j < m; j += VOPS_LANES) {                                \
+            for (int l = 0; l < VOPS_LANES; ++l) {                      \
+                sty[l] += s[j+l]*y[j+l];                                \
+                yty[l] += y[j+l]*y[j+l];                                \
+            }                                                           \
+        }                                                               \
+        for (int l = 0; j < n; ++j, ++l) {                              \
+            sty[l] += s[j]*y[j];                                        \
+            yty[l] += y[j]*y[j];                                        \
+        }                                                               \
+        for (int w = VOPS_LANES/2; w > 0; w /= 2) {                     \
+            for (int l = 0; l < w; ++l) {                               \
+                sty[l] += sty[l + w];                                   \
+                yty[l] += yty[l + w];                                   \
+            }                                                           \
+        }                                                               \
+        res[0] = sty[0];                                                \
+        res[1] = yty[0];                                                \
+    }
+ENCODE_(lbfgs_dots_flt, float);
+ENCODE_(lbfgs_dots_dbl, double);
+#undef ENCODE_
+
+// Compute `<s,w*y>`, `<w*y,w*y>`, and `<d,s>` for the recursion restricted
+// to the free variables given by the weights `w`.
+#define ENCODE_(func, T)                                                \
+    static void func(                                                   \
+        const args* a,                                                  \
+        long        i,                                                  \
+        long        n,                                                  \
+        double*     res)                                                \
+    {                                                                   \
+        const T* w = (const T*)a->w + i;                                \
+        const T* s = (const T*)a->x + i;                                \
+        const T* y = (const T*)a->y + i;                                \
+        const T* d = (const T*)a->z + i;                                \
+        T sty[VOPS_LANES] = {0}, yty[VOPS_LANES] = {0};                 \
+        T dts[VOPS_LANES] = {0};                                        \
+        long j = 0, m = n - n%VOPS_LANES;                               \
+        for (; j < m; j += VOPS_LANES) {                                \
+            for (int l = 0; l < VOPS_LANES; ++l) {                      \
+                T wy = w[j+l]*y[j+l];                                   \
+                sty[l] += s[j+l]*wy;                                    \
+                yty[l] += wy*wy;                                        \
+                dts[l] += d[j+l]*s[j+l];                                \
+            }                                                           \
+        }                                                               \
+        for (int l = 0; j < n; ++j, ++l) {                              \
+            T wy = w[j]*y[j];                                           \
+            sty[l] += s[j]*wy;                                          \
+            yty[l] += wy*wy;                                            \
+            dts[l] += d[j]*s[j];                                        \
+        }                                                               \
+        for (int k = VOPS_LANES/2; k > 0; k /= 2) {                     \
+            for (int l = 0; l < k; ++l) {                               \
+                sty[l] += sty[l + k];                                   \
+                yty[l] += yty[l + k];                                   \
+                dts[l] += dts[l + k];                                   \
+            }                                                           \
+        }                                                               \
+        res[0] = sty[0];                                                \
+        res[1] = yty[0];                                                \
+        res[2] = dts[0];                                                \
+    }
+ENCODE_(lbfgs_masked_dots_flt, float);
+ENCODE_(lbfgs_masked_dots_dbl, double);
+#undef ENCODE_
+
+// Compute `dst = w*x`.
+#define ENCODE_(func, T)                                                \
+    static void func(                                                   \
+        const args* a,                                                  \
+        long        i,                                                  \
+        long        n)                                                  \
+    {                                                                   \
+        T* restrict dst = (T*)a->dst + i;                               \
+        const T* restrict w = (const T*)a->w + i;                       \
+        const T* restrict x = (const T*)a->x + i;                       \
+        for (long k = 0; k < n; ++k) {                                  \
+            dst[k] = w[k]*x[k];                                         \
+        }                                                               \
+    }
+ENCODE_(lbfgs_mask_flt, float);
+ENCODE_(lbfgs_mask_dbl, double);
+#undef ENCODE_
+
+// Compute `dst += alpha*w*x`.
+#define ENCODE_(func, T)                                                \
+    static void func(                                                   \
+        const args* a,                                                  \
+        long        i,                                                  \
+        long        n)                                                  \
+    {                                                                   \
+        T* restrict dst = (T*)a->dst + i;                               \
+        const T* restrict w = (const T*)a->w + i;                       \
+        const T* restrict x = (const T*)a->x + i;                       \
+        const T alpha = a->alpha;                                       \
+        for (long k = 0; k < n; ++k) {                                  \
+            dst[k] += alpha*w[k]*x[k];                                  \
+        }                                                               \
+    }
+ENCODE_(lbfgs_masked_update_flt, float);
+ENCODE_(lbfgs_masked_update_dbl, double);
+#undef ENCODE_
+
+// Address of the `j`-th most recent pair (`j = 1` for the last one).
+static inline const void* lbfgs_pair(const lbfgs* obj, const void* base,
+                                     long j)
+{
+    long k = (obj->mrk - j + obj->m)%obj->m;
+    size_t size = (obj->type == Y_FLOAT ? sizeof(float) : sizeof(double));
+    return (const char*)base + k*obj->n*size;
+}
+
+static inline long lbfgs_slot(const lbfgs* obj, long j)
+{
+    return (obj->mrk - j + obj->m)%obj->m;
+}
+
+void Y_vops_lbfgs(int argc)
+{
+    if (argc != 1) {
+        y_error("usage: vops_lbfgs(m)");
+    }
+    long m = ygets_l(0);
+    if (m < 0) {
+        y_error("invalid number of previous steps to memorize");
+    }
+    lbfgs* obj = ypush_obj(&lbfgs_type, sizeof(lbfgs));
+    obj->m = m;
+    if (m > 0) {
+        obj->rho = p_malloc(m*sizeof(double));
+        if (obj->rho == NULL) {
+            y_error("not enough memory");
+        }
+        memset(obj->rho, 0, m*sizeof(double));
+    }
+}
+
+void Y_vops_lbfgs_reset(int argc)
+{
+    if (argc != 1) {
+        y_error("usage: vops_lbfgs_reset, lbfgs;");
+    }
+    lbfgs* obj = yget_obj(0, &lbfgs_type);
+    obj->mp = 0;
+    obj->mrk = 0;
+    obj->gamma = 0.0;
+    lbfgs_release(obj);
+}
+
+void Y_vops_lbfgs_update(int argc)
+{
+    if (argc != 3) {
+        y_error("usage: vops_lbfgs_update(lbfgs, s, y)");
+    }
+    lbfgs* obj = yget_obj(argc - 1, &lbfgs_type);
+    int s_iarg = argc - 2;
+    int y_iarg = argc - 3;
+    array s, y;
+    get_array(s_iarg, &s);
+    if ((unsigned)s.type > Y_DOUBLE) {
+        y_error("argument `s` is not real-valued");
+    }
+    get_array(y_iarg, &y);
+    if ((unsigned)y.type > Y_DOUBLE) {
+        y_error("argument `y` is not real-valued");
+    }
+    if (!same_dims(s.dims, y.dims)) {
+        y_error("arguments `s` and `y` must have the same dimensions");
+    }
+    int T;
+    if (obj->n > 0) {
+        if (!same_dims(s.dims, obj->dims)) {
+            y_error("arguments `s` and `y` have incompatible dimensions "
+                    "with the L-BFGS memory");
+        }
+        T = obj->type;
+    } else {
+        T = (s.type == Y_FLOAT && y.type == Y_FLOAT ? Y_FLOAT : Y_DOUBLE);
+    }
+    coerce(s_iarg, &s, T);
+    coerce(y_iarg, &y, T);
+
+    // Check whether the pair is acceptable.
+    args a = {.x = s.data, .y = y.data};
+    double res[2];
+    reduce_many(T == Y_FLOAT ? lbfgs_dots_flt : lbfgs_dots_dbl,
+                &a, s.ntot, 2, res);
+    double sty = res[0], yty = res[1];
+    int accept = (sty > 0);
+    if (accept) {
+        obj->gamma = sty/yty;
+        if (obj->m >= 1) {
+            size_t size = (T == Y_FLOAT ? sizeof(float) : sizeof(double));
+            if (obj->n == 0) {
+                // First update, allocate storage.
+                obj->S = p_malloc(obj->m*s.ntot*size);
+                obj->Y = p_malloc(obj->m*s.ntot*size);
+                if (obj->S == NULL || obj->Y == NULL) {
+                    lbfgs_release(obj);
+                    y_error("not enough memory for L-BFGS pairs");
+                }
+                obj->n = s.ntot;
+                obj->type = T;
+                memcpy(obj->dims, s.dims, (s.dims[0] + 1)*sizeof(long));
+            }
+            long k = obj->mrk%obj->m;
+            memcpy((char*)obj->S + k*obj->n*size, s.data, obj->n*size);
+            memcpy((char*)obj->Y + k*obj->n*size, y.data, obj->n*size);
+            obj->rho[k] = sty;
+            obj->mrk = k + 1;
+            if (obj->mp < obj->m) {
+                ++obj->mp;
+            }
+        }
+    }
+    ypush_int(accept);
+}
+
+void Y_vops_lbfgs_apply(int argc)
+{
+    if (argc < 2 || argc > 4) {
+        y_error("usage: d = vops_lbfgs_apply(lbfgs, g [, scaled, freevars])");
+    }
+    lbfgs* obj = yget_obj(argc - 1, &lbfgs_type);
+    int g_iarg = argc - 2;
+    long scaled_index = -1;
+    if (argc >= 3 && (scaled_index = yget_ref(argc - 3)) < 0 &&
+        !yarg_nil(argc - 3)) {
+        y_error("argument `scaled` must be a simple variable");
+    }
+    int w_iarg = (argc >= 4 && !yarg_nil(argc - 4) ? argc - 4 : -1);
+
+    // Get the vector `g` to which the inverse Hessian approximation is
+    // applied and the optional weights `w` of the free variables.
+    array g, w;
+    get_array(g_iarg, &g);
+    if ((unsigned)g.type > Y_DOUBLE) {
+        y_error("argument `g` is not real-valued");
+    }
+    int T;
+    if (obj->n > 0) {
+        if (!same_dims(g.dims, obj->dims)) {
+            y_error("argument `g` has incompatible dimensions with the "
+                    "L-BFGS memory");
+        }
+        T = obj->type;
+    } else {
+        T = (g.type == Y_FLOAT ? Y_FLOAT : Y_DOUBLE);
+    }
+    coerce(g_iarg, &g, T);
+    if (w_iarg >= 0) {
+        get_array(w_iarg, &w);
+        if ((unsigned)w.type > Y_DOUBLE) {
+            y_error("argument `freevars` is not real-valued");
+        }
+        if (!same_dims(w.dims, g.dims)) {
+            y_error("arguments `g` and `freevars` must have the same "
+                    "dimensions");
+        }
+        coerce(w_iarg, &w, T);
+    }
+
+    // Push the result and workspace for the coefficients of the recursion.
+    long n = g.ntot;
+    void* d = push_array(T, g.dims);
+    long mp = obj->mp;
+    double* alpha = NULL;
+    double* rho = NULL;
+    if (mp >= 1) {
+        long dims[2] = {1, 2*obj->m};
+        alpha = ypush_d(dims);
+        rho = alpha + obj->m;
+    }
+    bool single = (T == Y_FLOAT);
+    double gamma;
+    args a = {.dst = d};
+    if (w_iarg < 0) {
+        // Regular recursion.  In both loops, the inner product needed by the
+        // next step is computed while updating `d`.
+        double dot = 0;
+        if (mp >= 1) {
+            a.x = a.y = g.data;
+            a.z = lbfgs_pair(obj, obj->S, 1);
+            a.alpha = 1;
+            a.beta = 0;
+            dot = reduce(single ? vops_combine_inner_flt :
+                         vops_combine_inner_dbl, &a, n, false);
+        } else {
+            a.x = g.data;
+            a.alpha = 1;
+            map(single ? vops_scale_map_flt : vops_scale_map_dbl, &a, n);
+        }
+        for (long j = 1; j <= mp; ++j) {
+            long i = lbfgs_slot(obj, j);
+            alpha[i] = dot/obj->rho[i];
+            a.x = lbfgs_pair(obj, obj->Y, j);
+            a.alpha = -alpha[i];
+            if (j < mp) {
+                a.z = lbfgs_pair(obj, obj->S, j + 1);
+                dot = reduce(single ? vops_update_inner_flt :
+                             vops_update_inner_dbl, &a, n, false);
+            } else {
+                map(single ? vops_update_map_flt : vops_update_map_dbl,
+                    &a, n);
+            }
+        }
+        gamma = obj->gamma;
+        if (gamma > 0 && gamma != 1) {
+            a.x = d;
+            a.alpha = gamma;
+            map(single ? vops_scale_map_flt : vops_scale_map_dbl, &a, n);
+        }
+        if (mp >= 1) {
+            a.x = d;
+            a.y = lbfgs_pair(obj, obj->Y, mp);
+            dot = reduce(single ? vops_inner2_flt : vops_inner2_dbl,
+                         &a, n, false);
+        }
+        for (long j = mp; j >= 1; --j) {
+            long i = lbfgs_slot(obj, j);
+            double beta = dot/obj->rho[i];
+            a.x = lbfgs_pair(obj, obj->S, j);
+            a.alpha = alpha[i] - beta;
+            if (j > 1) {
+                a.z = lbfgs_pair(obj, obj->Y, j - 1);
+                dot = reduce(single ? vops_update_inner_flt :
+                             vops_update_inner_dbl, &a, n, false);
+            } else {
+                map(single ? vops_update_map_flt : vops_update_map_dbl,
+                    &a, n);
+            }
+        }
+    } else {
+        // Recursion restricted to the free variables.  The coefficients
+        // `rho` are recomputed for the restricted gradient changes `w*y`.
+        a.w = w.data;
+        a.x = g.data;
+        map(single ? lbfgs_mask_flt : lbfgs_mask_dbl, &a, n);
+        gamma = 0.0;
+        for (long j = 1; j <= mp; ++j) {
+            long i = lbfgs_slot(obj, j);
+            double res[3];
+            a.x = lbfgs_pair(obj, obj->S, j);
+            a.y = lbfgs_pair(obj, obj->Y, j);
+            a.z = d;
+            reduce_many(single ? lbfgs_masked_dots_flt :
+                        lbfgs_masked_dots_dbl, &a, n, 3, res);
+            rho[i] = res[0];
+            if (rho[i] > 0) {
+                if (gamma <= 0) {
+                    gamma = rho[i]/res[1];
+                }
+                alpha[i] = res[2]/rho[i];
+                a.x = a.y;
+                a.alpha = -alpha[i];
+                map(single ? lbfgs_masked_update_flt :
+                    lbfgs_masked_update_dbl, &a, n);
+            }
+        }
+        if (gamma > 0 && gamma != 1) {
+            a.x = d;
+            a.alpha = gamma;
+            map(single ? vops_scale_map_flt : vops_scale_map_dbl, &a, n);
+        }
+        for (long j = mp; j >= 1; --j) {
+            long i = lbfgs_slot(obj, j);
+            if (rho[i] > 0) {
+                a.x = d;
+                a.y = lbfgs_pair(obj, obj->Y, j);
+                double beta = reduce(single ? vops_inner2_flt :
+                                     vops_inner2_dbl, &a, n, false)/rho[i];
+                a.x = lbfgs_pair(obj, obj->S, j);
+                a.alpha = alpha[i] - beta;
+                map(single ? lbfgs_masked_update_flt :
+                    lbfgs_masked_update_dbl, &a, n);
+            }
+        }
+    }
+
+    // Store `scaled` and leave the result on top of the stack.
+    int drop = (mp >= 1 ? 1 : 0);
+    if (scaled_index >= 0) {
+        ypush_int(gamma > 0);
+        yput_global(scaled_index, 0);
+        ++drop;
     }
+    yarg_drop(drop);
 }